@@ -13,6 +13,9 @@
 #include <stddef.h>
 #include "cpuintrf.h"
 #include "drcfe.h"
+#include "fileio.h"
+#include "emuopts.h"
+#include <zlib.h>
 
 
 /***************************************************************************
@@ -21,6 +24,17 @@
 
 #define MAX_STACK_DEPTH		100
 
+/* analysis cache parameters */
+#define CACHE_HASH_SIZE		4096						/* number of hash buckets for cached sequences */
+#define CACHE_MAX_SEQUENCES	16384						/* maximum sequences kept in memory */
+#define CACHE_MAX_SAVED		4096						/* maximum sequences written to disk */
+#define CACHE_FILE_MAGIC	"MAMEDRC"					/* magic string at the start of cache files */
+#define CACHE_FILE_VERSION	1							/* version of the cache file format */
+#define CACHE_MAX_DELAY_SLOTS	4						/* most delay slots a cached branch may have */
+
+/* each window position holds at most one opcode plus its delay slots */
+#define CACHE_MAX_DESCS(drcfe)	(((drcfe)->window_start + (drcfe)->window_end) * (1 + CACHE_MAX_DELAY_SLOTS))
+
 
 
 /***************************************************************************
@@ -36,6 +50,52 @@ struct _pc_stack_entry
 };
 
 
+/* a serialized opcode description; delay slots follow their branch */
+typedef struct _cached_desc cached_desc;
+struct _cached_desc
+{
+	offs_t				pc;							/* PC of this opcode */
+	offs_t				physpc;						/* physical PC of this opcode */
+	offs_t				targetpc;					/* target PC if we are a branch */
+	UINT8				length;						/* length in bytes of this opcode */
+	UINT8				delayslots;					/* number of delay slots */
+	UINT8				skipslots;					/* number of skip slots */
+	UINT8				delaycount;					/* number of descriptions in our delay chain */
+	UINT32				flags;						/* OPFLAG_* opcode flags */
+	UINT32				cycles;						/* number of cycles needed to execute */
+	drc_reginfo			gpr;						/* register info for GPRs */
+	drc_reginfo			fpr;						/* register info for FPRs */
+};
+
+
+/* a cached analysis of one code window, keyed by start PC */
+typedef struct _cached_sequence cached_sequence;
+struct _cached_sequence
+{
+	cached_sequence *	next;						/* next sequence in this hash bucket */
+	offs_t				startpc;					/* PC the analysis was started from */
+	UINT32				crc;						/* CRC of the opcode bytes covered */
+	UINT32				hits;						/* number of times the analysis was requested */
+	UINT32				count;						/* number of descriptions */
+	cached_desc			desc[1];					/* descriptions, in list order */
+};
+
+
+/* header of a cache file */
+typedef struct _cache_file_header cache_file_header;
+struct _cache_file_header
+{
+	char				magic[8];					/* CACHE_FILE_MAGIC */
+	UINT32				version;					/* CACHE_FILE_VERSION */
+	UINT32				descsize;					/* sizeof(cached_desc), to reject foreign files */
+	UINT32				cpuid;						/* CRC of the name of the CPU the cache belongs to */
+	UINT32				window_start;				/* analysis parameters the cache was built with */
+	UINT32				window_end;
+	UINT32				max_sequence;
+	UINT32				count;						/* number of sequences that follow */
+};
+
+
 /* internal state */
 struct _drcfe_state
 {
@@ -56,6 +116,13 @@ struct _drcfe_state
 	opcode_desc *		desc_free_list;				/* head of list of free descriptions */
 	opcode_desc **		desc_array;					/* array of descriptions in PC order */
 	UINT32 				desc_array_size;			/* size of the array */
+
+	/* persistent analysis cache */
+	cached_sequence **	cache;						/* hash table of cached sequences, or NULL if disabled */
+	UINT32				cache_count;				/* number of cached sequences */
+	int					cpunum;						/* CPU we belong to */
+	UINT32				cpuid;						/* CRC of the CPU name */
+	char				cache_name[64];				/* name of the cache file */
 };
 
 
@@ -69,6 +136,15 @@ static opcode_desc **build_sequence(drcfe_state *drcfe, opcode_desc **tailptr, i
 static void accumulate_live_info_forwards(opcode_desc *desc, UINT64 *gprread, UINT64 *gprwrite, UINT64 *fprread, UINT64 *fprwrite);
 static void accumulate_live_info_backwards(opcode_desc *desc, UINT64 *gprread, UINT64 *gprwrite, UINT64 *fprread, UINT64 *fprwrite);
 static void release_descriptions(drcfe_state *drcfe, opcode_desc *desc);
+static int cache_validate_sequence(drcfe_state *drcfe, const cached_sequence *seq);
+static const opcode_desc *cache_restore_sequence(drcfe_state *drcfe, offs_t startpc);
+static void cache_add_sequence(drcfe_state *drcfe, offs_t startpc, const opcode_desc *desclist);
+static int cache_check_sequence(drcfe_state *drcfe, const cached_sequence *seq);
+static void cache_load(drcfe_state *drcfe);
+static void cache_save(drcfe_state *drcfe);
+static void cache_flush(drcfe_state *drcfe);
+static void cache_free(drcfe_state *drcfe);
+static cached_sequence **cache_sorted_list(drcfe_state *drcfe);
 
 
 
@@ -105,6 +181,17 @@ INLINE void desc_free(drcfe_state *drcfe, opcode_desc *desc)
 }
 
 
+/*-------------------------------------------------
+    cache_hash - return the hash bucket for a
+    start PC
+-------------------------------------------------*/
+
+INLINE cached_sequence **cache_hash(drcfe_state *drcfe, offs_t startpc)
+{
+	return &drcfe->cache[(startpc ^ (startpc >> 12)) % CACHE_HASH_SIZE];
+}
+
+
 
 /***************************************************************************
     CORE IMPLEMENTATION
@@ -136,6 +223,17 @@ drcfe_state *drcfe_init(const drcfe_config *config, void *param)
 	/* initialize the state */
 	drcfe->pageshift = activecpu_page_shift(ADDRESS_SPACE_PROGRAM);
 	drcfe->translate = (cpufunc_translate)activecpu_get_info_fct(CPUINFO_PTR_TRANSLATE);
+	drcfe->cpunum = cpu_getactivecpu();
+	drcfe->cpuid = crc32(0, (const Bytef *)activecpu_name(), strlen(activecpu_name()));
+
+	/* set up the analysis cache and pick up anything left from last time */
+	if (options_get_bool(mame_options(), OPTION_DRCCACHE))
+	{
+		drcfe->cache = malloc_or_die(CACHE_HASH_SIZE * sizeof(*drcfe->cache));
+		memset(drcfe->cache, 0, CACHE_HASH_SIZE * sizeof(*drcfe->cache));
+		sprintf(drcfe->cache_name, "%s" PATH_SEPARATOR "cpu%d.drc", Machine->basename, drcfe->cpunum);
+		cache_load(drcfe);
+	}
 
 	return drcfe;
 }
@@ -150,6 +248,13 @@ void drcfe_exit(drcfe_state *drcfe)
 	/* release any descriptions we've accumulated */
 	release_descriptions(drcfe, drcfe->desc_live_list);
 
+	/* write out and release the analysis cache */
+	if (drcfe->cache != NULL)
+	{
+		cache_save(drcfe);
+		cache_free(drcfe);
+	}
+
 	/* free our free list of descriptions */
 	while (drcfe->desc_free_list != NULL)
 	{
@@ -185,6 +290,14 @@ const opcode_desc *drcfe_describe_code(drcfe_state *drcfe, offs_t startpc)
 	release_descriptions(drcfe, drcfe->desc_live_list);
 	drcfe->desc_live_list = NULL;
 
+	/* if we analyzed this window before and the code is unchanged, reuse the result */
+	if (drcfe->cache != NULL)
+	{
+		drcfe->desc_live_list = (opcode_desc *)cache_restore_sequence(drcfe, startpc);
+		if (drcfe->desc_live_list != NULL)
+			return drcfe->desc_live_list;
+	}
+
 	/* add the initial PC to the stack */
 	pcstackptr->srcpc = 0;
 	pcstackptr->targetpc = startpc;
@@ -248,10 +361,39 @@ const opcode_desc *drcfe_describe_code(drcfe_state *drcfe, offs_t startpc)
 	/* first from startpc -> maxpc, then from minpc -> startpc */
 	tailptr = build_sequence(drcfe, &drcfe->desc_live_list, startpc - minpc, maxpc - minpc, OPFLAG_REDISPATCH);
 	tailptr = build_sequence(drcfe, tailptr, minpc - minpc, startpc - minpc, OPFLAG_RETURN_TO_START);
+
+	/* remember the analysis for next time */
+	if (drcfe->cache != NULL)
+		cache_add_sequence(drcfe, startpc, drcfe->desc_live_list);
 	return drcfe->desc_live_list;
 }
 
 
+/*-------------------------------------------------
+    drcfe_get_hot_pcs - fill in a list of the
+    start PCs of cached sequences whose code is
+    still present, most frequently used first
+-------------------------------------------------*/
+
+int drcfe_get_hot_pcs(drcfe_state *drcfe, offs_t *pclist, int maxcount)
+{
+	cached_sequence **seqlist;
+	int count = 0;
+	UINT32 seqnum;
+
+	if (drcfe->cache == NULL || drcfe->cache_count == 0)
+		return 0;
+
+	/* walk the sequences from hottest to coldest, keeping the ones that still match memory */
+	seqlist = cache_sorted_list(drcfe);
+	for (seqnum = 0; seqnum < drcfe->cache_count && count < maxcount; seqnum++)
+		if (cache_validate_sequence(drcfe, seqlist[seqnum]))
+			pclist[count++] = seqlist[seqnum]->startpc;
+	free(seqlist);
+	return count;
+}
+
+
 
 /***************************************************************************
     INTERNAL HELPERS
@@ -518,3 +660,460 @@ static void release_descriptions(drcfe_state *drcfe, opcode_desc *desc)
 		desc_free(drcfe, freeme);
 	}
 }
+
+
+
+/***************************************************************************
+    ANALYSIS CACHE
+***************************************************************************/
+
+/*-------------------------------------------------
+    cache_validate_sequence - verify that the
+    code a cached sequence was built from is
+    still mapped at the same place and unchanged
+-------------------------------------------------*/
+
+static int cache_validate_sequence(drcfe_state *drcfe, const cached_sequence *seq)
+{
+	UINT32 crc = 0;
+	UINT32 descnum;
+
+	for (descnum = 0; descnum < seq->count; descnum++)
+	{
+		const cached_desc *cdesc = &seq->desc[descnum];
+		offs_t physpc = cdesc->pc;
+		void *opptr;
+
+		/* the translation must be the same as when we analyzed it */
+		if (drcfe->translate != NULL && (!(*drcfe->translate)(ADDRESS_SPACE_PROGRAM, &physpc) || physpc != cdesc->physpc))
+			return FALSE;
+
+		/* and so must the bytes */
+		memory_set_opbase(physpc);
+		opptr = cpu_opptr(physpc);
+		if (opptr == NULL)
+			return FALSE;
+		crc = crc32(crc, opptr, cdesc->length);
+	}
+	return (crc == seq->crc);
+}
+
+
+/*-------------------------------------------------
+    cache_build_desc - recreate a description and
+    its delay slots from serialized form
+-------------------------------------------------*/
+
+static opcode_desc *cache_build_desc(drcfe_state *drcfe, const cached_desc **cdescptr, opcode_desc *branch)
+{
+	const cached_desc *cdesc = (*cdescptr)++;
+	opcode_desc *desc = desc_alloc(drcfe);
+	opcode_desc **tailptr = &desc->delay;
+	UINT8 slotnum;
+
+	/* copy in the basic information */
+	memset(desc, 0, sizeof(*desc));
+	desc->branch = branch;
+	desc->pc = cdesc->pc;
+	desc->physpc = cdesc->physpc;
+	desc->targetpc = cdesc->targetpc;
+	desc->length = cdesc->length;
+	desc->delayslots = cdesc->delayslots;
+	desc->skipslots = cdesc->skipslots;
+	desc->flags = cdesc->flags;
+	desc->cycles = cdesc->cycles;
+	desc->gpr = cdesc->gpr;
+	desc->fpr = cdesc->fpr;
+
+	/* the opcode pointer is the only thing that can differ between sessions */
+	memory_set_opbase(desc->physpc);
+	desc->opptr.v = cpu_opptr(desc->physpc);
+
+	/* rebuild the delay slot chain */
+	for (slotnum = 0; slotnum < cdesc->delaycount; slotnum++)
+	{
+		*tailptr = cache_build_desc(drcfe, cdescptr, desc);
+		tailptr = &(*tailptr)->next;
+	}
+	return desc;
+}
+
+
+/*-------------------------------------------------
+    cache_restore_sequence - return a description
+    list from the cache if we have a valid one
+    for the given start PC
+-------------------------------------------------*/
+
+static const opcode_desc *cache_restore_sequence(drcfe_state *drcfe, offs_t startpc)
+{
+	cached_sequence **seqptr, *seq;
+	const cached_desc *cdesc, *cdescend;
+	opcode_desc *head = NULL;
+	opcode_desc **tailptr = &head;
+
+	/* find the sequence */
+	for (seqptr = cache_hash(drcfe, startpc); *seqptr != NULL; seqptr = &(*seqptr)->next)
+		if ((*seqptr)->startpc == startpc)
+			break;
+	seq = *seqptr;
+	if (seq == NULL)
+		return NULL;
+
+	/* if the code changed underneath us, toss it so it gets re-analyzed */
+	if (!cache_validate_sequence(drcfe, seq))
+	{
+		*seqptr = seq->next;
+		free(seq);
+		drcfe->cache_count--;
+		return NULL;
+	}
+
+	/* rebuild the list */
+	seq->hits++;
+	cdescend = &seq->desc[seq->count];
+	for (cdesc = &seq->desc[0]; cdesc < cdescend; )
+	{
+		*tailptr = cache_build_desc(drcfe, &cdesc, NULL);
+		tailptr = &(*tailptr)->next;
+	}
+	return head;
+}
+
+
+/*-------------------------------------------------
+    cache_count_descs - count descriptions in a
+    list, including delay slots
+-------------------------------------------------*/
+
+static UINT32 cache_count_descs(const opcode_desc *desc)
+{
+	UINT32 count = 0;
+
+	for ( ; desc != NULL; desc = desc->next)
+		count += 1 + cache_count_descs(desc->delay);
+	return count;
+}
+
+
+/*-------------------------------------------------
+    cache_serialize_list - flatten a description
+    list, accumulating a CRC of the opcode bytes;
+    returns FALSE if the list can't be cached
+-------------------------------------------------*/
+
+static int cache_serialize_list(const opcode_desc *desc, cached_desc **cdescptr, UINT32 *crc)
+{
+	for ( ; desc != NULL; desc = desc->next)
+	{
+		cached_desc *cdesc = (*cdescptr)++;
+		const opcode_desc *delay;
+
+		/* page faults depend on the TLB state at the time; don't remember them */
+		if (desc->flags & (OPFLAG_COMPILER_PAGE_FAULT | OPFLAG_COMPILER_UNMAPPED))
+			return FALSE;
+
+		/* nor anything cache_load would refuse */
+		if (desc->delayslots > CACHE_MAX_DELAY_SLOTS)
+			return FALSE;
+
+		memset(cdesc, 0, sizeof(*cdesc));
+		cdesc->pc = desc->pc;
+		cdesc->physpc = desc->physpc;
+		cdesc->targetpc = desc->targetpc;
+		cdesc->length = desc->length;
+		cdesc->delayslots = desc->delayslots;
+		cdesc->skipslots = desc->skipslots;
+		cdesc->flags = desc->flags;
+		cdesc->cycles = desc->cycles;
+		cdesc->gpr = desc->gpr;
+		cdesc->fpr = desc->fpr;
+		for (delay = desc->delay; delay != NULL; delay = delay->next)
+			cdesc->delaycount++;
+		*crc = crc32(*crc, desc->opptr.b, desc->length);
+
+		/* delay slots follow immediately */
+		if (!cache_serialize_list(desc->delay, cdescptr, crc))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+
+/*-------------------------------------------------
+    cache_add_sequence - add a freshly analyzed
+    description list to the cache
+-------------------------------------------------*/
+
+static void cache_add_sequence(drcfe_state *drcfe, offs_t startpc, const opcode_desc *desclist)
+{
+	UINT32 count = cache_count_descs(desclist);
+	cached_sequence **bucket;
+	cached_sequence *seq;
+	cached_desc *cdesc;
+	UINT32 crc = 0;
+
+	/* don't grow without bound */
+	if (count == 0 || count > CACHE_MAX_DESCS(drcfe) || drcfe->cache_count >= CACHE_MAX_SEQUENCES)
+		return;
+
+	/* flatten the list */
+	seq = malloc_or_die(sizeof(*seq) + (count - 1) * sizeof(seq->desc[0]));
+	cdesc = &seq->desc[0];
+	if (!cache_serialize_list(desclist, &cdesc, &crc))
+	{
+		free(seq);
+		return;
+	}
+	seq->startpc = startpc;
+	seq->crc = crc;
+	seq->hits = 1;
+	seq->count = count;
+
+	/* link it in */
+	bucket = cache_hash(drcfe, startpc);
+	seq->next = *bucket;
+	*bucket = seq;
+	drcfe->cache_count++;
+}
+
+
+/*-------------------------------------------------
+    cache_compare_hits - compare two sequences by
+    descending hit count
+-------------------------------------------------*/
+
+static int CLIB_DECL cache_compare_hits(const void *item1, const void *item2)
+{
+	const cached_sequence *seq1 = *(const cached_sequence * const *)item1;
+	const cached_sequence *seq2 = *(const cached_sequence * const *)item2;
+
+	if (seq1->hits != seq2->hits)
+		return (seq1->hits > seq2->hits) ? -1 : 1;
+	return (seq1->startpc < seq2->startpc) ? -1 : (seq1->startpc > seq2->startpc);
+}
+
+
+/*-------------------------------------------------
+    cache_sorted_list - return an allocated array
+    of all cached sequences, hottest first
+-------------------------------------------------*/
+
+static cached_sequence **cache_sorted_list(drcfe_state *drcfe)
+{
+	cached_sequence **seqlist = malloc_or_die(drcfe->cache_count * sizeof(*seqlist));
+	UINT32 seqcount = 0;
+	int bucket;
+
+	for (bucket = 0; bucket < CACHE_HASH_SIZE; bucket++)
+	{
+		cached_sequence *seq;
+		for (seq = drcfe->cache[bucket]; seq != NULL; seq = seq->next)
+			seqlist[seqcount++] = seq;
+	}
+	qsort(seqlist, seqcount, sizeof(*seqlist), cache_compare_hits);
+	return seqlist;
+}
+
+
+/*-------------------------------------------------
+    cache_check_desc - verify that a serialized
+    description and its delay chain fit within
+    the sequence and the analysis limits
+-------------------------------------------------*/
+
+static int cache_check_desc(drcfe_state *drcfe, const cached_sequence *seq, UINT32 *descnum)
+{
+	const cached_desc *cdesc;
+	UINT8 slotnum;
+
+	if (*descnum >= seq->count)
+		return FALSE;
+	cdesc = &seq->desc[(*descnum)++];
+
+	/* lengths and delay slots must be ones the analysis could have produced */
+	if (cdesc->length == 0 || cdesc->length > drcfe->window_start + drcfe->window_end)
+		return FALSE;
+	if (cdesc->delayslots > CACHE_MAX_DELAY_SLOTS || cdesc->delayslots > drcfe->max_sequence || cdesc->delaycount > cdesc->delayslots)
+		return FALSE;
+
+	/* the delay chain must fit in what's left of the sequence */
+	for (slotnum = 0; slotnum < cdesc->delaycount; slotnum++)
+		if (!cache_check_desc(drcfe, seq, descnum))
+			return FALSE;
+	return TRUE;
+}
+
+
+/*-------------------------------------------------
+    cache_check_sequence - verify that a sequence
+    read from disk is structurally sound before
+    anything walks it
+-------------------------------------------------*/
+
+static int cache_check_sequence(drcfe_state *drcfe, const cached_sequence *seq)
+{
+	offs_t minpc = seq->startpc - drcfe->window_start;
+	UINT32 window = drcfe->window_start + drcfe->window_end;
+	UINT32 descnum = 0;
+
+	while (descnum < seq->count)
+	{
+		/* top-level descriptions come from the window around the start PC */
+		if (seq->desc[descnum].pc - minpc >= window)
+			return FALSE;
+		if (!cache_check_desc(drcfe, seq, &descnum))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+
+/*-------------------------------------------------
+    cache_load - read the cache file from a
+    previous session
+-------------------------------------------------*/
+
+static void cache_load(drcfe_state *drcfe)
+{
+	cache_file_header header;
+	mame_file *file;
+	UINT32 seqnum, maxcount;
+
+	if (mame_fopen(SEARCHPATH_DRC, drcfe->cache_name, OPEN_FLAG_READ, &file) != FILERR_NONE)
+		return;
+
+	/* make sure it's ours and was written by a compatible build */
+	if (mame_fread(file, &header, sizeof(header)) != sizeof(header) ||
+		memcmp(header.magic, CACHE_FILE_MAGIC, sizeof(CACHE_FILE_MAGIC)) != 0 ||
+		header.version != CACHE_FILE_VERSION ||
+		header.descsize != sizeof(cached_desc) ||
+		header.cpuid != drcfe->cpuid ||
+		header.window_start != drcfe->window_start ||
+		header.window_end != drcfe->window_end ||
+		header.max_sequence != drcfe->max_sequence)
+	{
+		mame_fclose(file);
+		return;
+	}
+
+	/* read the sequences */
+	maxcount = CACHE_MAX_DESCS(drcfe);
+	for (seqnum = 0; seqnum < header.count && drcfe->cache_count < CACHE_MAX_SEQUENCES; seqnum++)
+	{
+		cached_sequence **bucket;
+		cached_sequence *seq;
+		UINT32 info[4];
+
+		/* startpc, crc, hits and count come first */
+		if (mame_fread(file, info, sizeof(info)) != sizeof(info) || info[3] == 0 || info[3] > maxcount)
+			break;
+		seq = malloc_or_die(sizeof(*seq) + (info[3] - 1) * sizeof(seq->desc[0]));
+		seq->startpc = info[0];
+		seq->count = info[3];
+
+		/* a short read or a malformed sequence means the file can't be trusted at all */
+		if (mame_fread(file, seq->desc, info[3] * sizeof(seq->desc[0])) != info[3] * sizeof(seq->desc[0]) || !cache_check_sequence(drcfe, seq))
+		{
+			free(seq);
+			break;
+		}
+
+		/* halve the hit counts so that code that is no longer hot fades away */
+		seq->crc = info[1];
+		seq->hits = (info[2] + 1) / 2;
+
+		bucket = cache_hash(drcfe, seq->startpc);
+		seq->next = *bucket;
+		*bucket = seq;
+		drcfe->cache_count++;
+	}
+	mame_fclose(file);
+
+	/* if we stopped early, throw away everything we read */
+	if (seqnum < header.count && drcfe->cache_count < CACHE_MAX_SEQUENCES)
+	{
+		logerror("Ignoring damaged recompiler cache %s\n", drcfe->cache_name);
+		cache_flush(drcfe);
+	}
+}
+
+
+/*-------------------------------------------------
+    cache_save - write the hottest sequences out
+    to the cache file
+-------------------------------------------------*/
+
+static void cache_save(drcfe_state *drcfe)
+{
+	cache_file_header header;
+	cached_sequence **seqlist;
+	mame_file *file;
+	UINT32 seqnum;
+
+	if (drcfe->cache_count == 0)
+		return;
+	if (mame_fopen(SEARCHPATH_DRC, drcfe->cache_name, OPEN_FLAG_WRITE | OPEN_FLAG_CREATE | OPEN_FLAG_CREATE_PATHS, &file) != FILERR_NONE)
+		return;
+
+	/* write the header */
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, CACHE_FILE_MAGIC, sizeof(CACHE_FILE_MAGIC));
+	header.version = CACHE_FILE_VERSION;
+	header.descsize = sizeof(cached_desc);
+	header.cpuid = drcfe->cpuid;
+	header.window_start = drcfe->window_start;
+	header.window_end = drcfe->window_end;
+	header.max_sequence = drcfe->max_sequence;
+	header.count = MIN(drcfe->cache_count, CACHE_MAX_SAVED);
+	mame_fwrite(file, &header, sizeof(header));
+
+	/* followed by the sequences, hottest first */
+	seqlist = cache_sorted_list(drcfe);
+	for (seqnum = 0; seqnum < header.count; seqnum++)
+	{
+		cached_sequence *seq = seqlist[seqnum];
+		UINT32 info[4];
+
+		info[0] = seq->startpc;
+		info[1] = seq->crc;
+		info[2] = seq->hits;
+		info[3] = seq->count;
+		mame_fwrite(file, info, sizeof(info));
+		mame_fwrite(file, seq->desc, seq->count * sizeof(seq->desc[0]));
+	}
+	free(seqlist);
+	mame_fclose(file);
+}
+
+
+/*-------------------------------------------------
+    cache_flush - discard all cached sequences
+-------------------------------------------------*/
+
+static void cache_flush(drcfe_state *drcfe)
+{
+	int bucket;
+
+	for (bucket = 0; bucket < CACHE_HASH_SIZE; bucket++)
+		while (drcfe->cache[bucket] != NULL)
+		{
+			cached_sequence *seq = drcfe->cache[bucket];
+			drcfe->cache[bucket] = seq->next;
+			free(seq);
+		}
+	drcfe->cache_count = 0;
+}
+
+
+/*-------------------------------------------------
+    cache_free - release all cached sequences
+    and the hash table
+-------------------------------------------------*/
+
+static void cache_free(drcfe_state *drcfe)
+{
+	cache_flush(drcfe);
+	free(drcfe->cache);
+	drcfe->cache = NULL;
+}
@@ -184,5 +184,8 @@ void drcfe_exit(drcfe_state *drcfe);
 /* describe a sequence of code that falls within the configured window relative to the specified startpc */
 const opcode_desc *drcfe_describe_code(drcfe_state *drcfe, offs_t startpc);
 
+/* return the start PCs of cached sequences that are still valid, most frequently used first */
+int drcfe_get_hot_pcs(drcfe_state *drcfe, offs_t *pclist, int maxcount);
+
 
 #endif
@@ -485,6 +485,22 @@ static void mips3drc_exit(void)
 }
 
 
+/*-------------------------------------------------
+    mips3drc_precompile - recompile code that was
+    hot in previous sessions
+-------------------------------------------------*/
+
+static void mips3drc_precompile(void)
+{
+	offs_t pclist[PRECOMPILE_MAX_SEQUENCES];
+	int count;
+
+	count = drcfe_get_hot_pcs(mips3.drcfe, pclist, ARRAY_LENGTH(pclist));
+	if (count > 0)
+		drc_precompile(mips3.drc, pclist, count);
+}
+
+
 
 /***************************************************************************
     RECOMPILER CALLBACKS
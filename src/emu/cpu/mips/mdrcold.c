@@ -271,6 +271,17 @@ static void mips3drc_exit(void)
 }
 
 
+/*-------------------------------------------------
+    mips3drc_precompile - recompile code that was
+    hot in previous sessions; the x86 core does
+    not support this
+-------------------------------------------------*/
+
+static void mips3drc_precompile(void)
+{
+}
+
+
 
 /***************************************************************************
     RECOMPILER CALLBACKS
@@ -955,7 +966,7 @@ static void append_check_sw_interrupts(drc_core *drc, int inline_generate)
 
 static void append_branch_or_dispatch(drc_core *drc, UINT32 newpc, int cycles)
 {
-	void *code = drc_get_code_at_pc(drc, newpc);
+	void *code = drc_get_linkable_code_at_pc(drc, newpc);
 	emit_mov_r32_imm(DRCTOP, REG_EDI, newpc);												// mov  edi,newpc
 	drc_append_standard_epilogue(drc, cycles, 0, 1);										// <epilogue>
 
@@ -51,6 +51,9 @@ extern unsigned dasmmips3(char *buffer, unsigned pc, UINT32 op);
 #define COMPILE_MAX_INSTRUCTIONS		((COMPILE_BACKWARDS_BYTES/4) + (COMPILE_FORWARDS_BYTES/4))
 #define COMPILE_MAX_SEQUENCE			64
 
+/* maximum number of sequences to precompile at reset */
+#define PRECOMPILE_MAX_SEQUENCES		1024
+
 /* hack when running comparison against the C core */
 #if COMPARE_AGAINST_C
 #undef  MIPS3_COUNT_READ_CYCLES
@@ -146,6 +149,7 @@ struct _mips3_regs
 
 static void mips3drc_init(void);
 static void mips3drc_exit(void);
+static void mips3drc_precompile(void);
 
 #if COMPARE_AGAINST_C
 static void execute_c_version(void);
@@ -216,6 +220,9 @@ static void mips3_reset(void)
 	mips3com_reset(mips3.core);
 	drc_cache_reset(mips3.drc);
 
+	/* get a head start on code that was hot last time */
+	mips3drc_precompile();
+
 #if COMPARE_AGAINST_C
 	mips3c_reset();
 #endif
@@ -467,7 +467,7 @@ static void append_check_interrupts(drc_core *drc, int inline_generate)
 
 static void append_branch_or_dispatch(drc_core *drc, UINT32 newpc, int cycles)
 {
-	void *code = drc_get_code_at_pc(drc, newpc);
+	void *code = drc_get_linkable_code_at_pc(drc, newpc);
 	emit_mov_r32_imm(DRCTOP, REG_EDI, newpc);
 
 	update_counters(drc);
@@ -64,11 +64,25 @@
 #include "cpuintrf.h"
 #include "x64drc.h"
 #include "debugger.h"
+#ifdef MAME_DEBUG
+#include "debug/debugcon.h"
+#endif
 
 #include <stddef.h>
 
 
 
+/***************************************************************************
+    CONSTANTS
+***************************************************************************/
+
+#define BLOCK_MARGIN		65536			/* space that must be free before compiling a block */
+#define MAX_BLOCKS			32768			/* maximum number of live blocks */
+#define MAX_ZONES			8				/* maximum number of zones the cache is divided into */
+#define HOT_MIN_HITS		64				/* minimum entries for a block to survive eviction */
+
+
+
 /***************************************************************************
     MACROS
 ***************************************************************************/
@@ -77,6 +91,29 @@
 
 
 
+/***************************************************************************
+    TYPE DEFINITIONS
+***************************************************************************/
+
+/* a hot block that is recompiled when its zone is reclaimed */
+typedef struct _hot_block hot_block;
+struct _hot_block
+{
+	UINT32			pc;						/* start PC of the block */
+	UINT32			hits;					/* entries counted while it was live */
+	UINT32			generation;				/* generation of the evicted block */
+};
+
+
+
+/***************************************************************************
+    GLOBAL VARIABLES
+***************************************************************************/
+
+static drc_core *live_drc[MAX_CPU];
+
+
+
 /***************************************************************************
     FUNCTION PROTOTYPES
 ***************************************************************************/
@@ -86,6 +123,14 @@ static void append_exit_point(drc_core *drc);
 static void recompile_code(drc_core *drc);
 static void append_recompile(drc_core *drc);
 static void append_flush(drc_core *drc);
+static void setup_zones(drc_core *drc);
+static drc_block *compile_block(drc_core *drc, UINT32 pc);
+static void reclaim_zone(drc_core *drc);
+static void evict_block(drc_core *drc, drc_block *block);
+static void format_stats(drc_core *drc, char *buffer);
+#ifdef MAME_DEBUG
+static void execute_drcstats(int ref, int params, const char **param);
+#endif
 
 
 
@@ -109,6 +154,36 @@ INLINE void allocate_l2_table(drc_core *drc, UINT32 l1index)
 }
 
 
+/*-------------------------------------------------
+    add_block_entry - note an entry point in the
+    block being compiled and count entries to it
+-------------------------------------------------*/
+
+INLINE void add_block_entry(drc_core *drc, UINT32 pc)
+{
+	drc_block *block = &drc->block_list[drc->block_current];
+
+	/* grow the entry array if needed */
+	if (block->entries == block->entryalloc)
+	{
+		UINT32 *newentry;
+
+		block->entryalloc = (block->entryalloc == 0) ? 16 : block->entryalloc * 2;
+		newentry = malloc_or_die(block->entryalloc * sizeof(*newentry));
+		if (block->entry != NULL)
+		{
+			memcpy(newentry, block->entry, block->entries * sizeof(*newentry));
+			free(block->entry);
+		}
+		block->entry = newentry;
+	}
+	block->entry[block->entries++] = pc;
+
+	/* have the generated code count its entries */
+	emit_add_m32_imm(DRCTOP, MDRC(&drc->block_hits[drc->block_current]), 1);		// add  [hits],1
+}
+
+
 /***************************************************************************
     EXTERNAL INTERFACES
 ***************************************************************************/
@@ -135,12 +210,14 @@ drc_core *drc_init(UINT8 cpunum, drc_config *config)
 	drc->cb_recompile = config->cb_recompile;
 	drc->cb_entrygen  = config->cb_entrygen;
 	drc->mxcsr_curr   = MXCSR_VALUE(FPRND_NEAR);
+	drc->cpunum       = cpunum;
+	drc->block_current = -1;
 
 	/* configure cache */
 	drc->cache_base = (UINT8 *)config->cache_base + sizeof(*drc);
 	drc->cache_size = config->cache_size - sizeof(*drc);
 	drc->cache_end = drc->cache_base + drc->cache_size;
-	drc->cache_danger = drc->cache_end - 65536;
+	drc->cache_danger = drc->cache_end - BLOCK_MARGIN;
 
 	/* compute shifts and masks */
 	drc->l1bits = effective_address_bits / 2;
@@ -172,6 +249,28 @@ drc_core *drc_init(UINT8 cpunum, drc_config *config)
 	if (drc->tentative_list == NULL)
 		goto error;
 
+	/* allocate the block ring; the hit counters must be reachable from generated code */
+	drc->block_max = MAX_BLOCKS;
+	drc->block_hits = drc_alloc(drc, drc->block_max * sizeof(*drc->block_hits));
+	drc->block_list = malloc(drc->block_max * sizeof(*drc->block_list));
+	if (drc->block_hits == NULL || drc->block_list == NULL)
+		goto error;
+	memset(drc->block_list, 0, drc->block_max * sizeof(*drc->block_list));
+
+	/* register the statistics command with the debugger the first time through */
+#ifdef MAME_DEBUG
+	if (Machine->debug_mode)
+	{
+		for (i = 0; i < MAX_CPU; i++)
+			if (live_drc[i] != NULL)
+				break;
+		if (i == MAX_CPU)
+			debug_console_register_command("drcstats", CMDFLAG_NONE, 0, 0, 0, execute_drcstats);
+	}
+#endif
+	if (cpunum < MAX_CPU)
+		live_drc[cpunum] = drc;
+
 	/* get pointers to external C functions */
 #ifdef MAME_DEBUG
 	drc->mame_debug_hook = (x86code *)mame_debug_hook;
@@ -205,6 +304,15 @@ void *drc_alloc(drc_core *drc, size_t amount)
 	/* adjust the end and danger values downward */
 	drc->cache_end -= amount;
 	drc->cache_danger -= amount;
+
+	/* once the zones have wrapped, live code can sit anywhere below zone_end; if the new */
+	/* table cut into them, flush everything and carve smaller zones below the new danger */
+	if (drc->zone_count != 0 && drc->cache_danger < drc->zone_end)
+		drc_cache_reset(drc);
+
+	/* without zones, just keep the linear fill below the new danger */
+	else if (drc->zone_count == 0)
+		drc->zone_end = drc->zone_limit = drc->cache_danger;
 	return drc->cache_end;
 }
 
@@ -251,6 +359,13 @@ void drc_cache_reset(drc_core *drc)
 	/* call back to the host */
 	if (drc->cb_reset != NULL)
 		(*drc->cb_reset)(drc);
+
+	/* forget all the blocks and divide the rest of the cache into zones */
+	if (drc->block_count != 0)
+		drc->stats.flushes++;
+	drc->block_head = drc->block_count = 0;
+	drc->block_current = -1;
+	setup_zones(drc);
 }
 
 
@@ -271,11 +386,32 @@ void drc_execute(drc_core *drc)
 
 void drc_exit(drc_core *drc)
 {
+	UINT32 blocknum;
+
+	/* report how the cache did */
+	if (drc->block_list != NULL)
+	{
+		char buffer[256];
+		format_stats(drc, buffer);
+		mame_printf_verbose("DRC CPU #%d: %s\n", drc->cpunum, buffer);
+	}
+	if (drc->cpunum < MAX_CPU && live_drc[drc->cpunum] == drc)
+		live_drc[drc->cpunum] = NULL;
+
 	/* free the lists */
 	if (drc->sequence_list != NULL)
 		free(drc->sequence_list);
 	if (drc->tentative_list != NULL)
 		free(drc->tentative_list);
+
+	/* free the blocks */
+	if (drc->block_list != NULL)
+	{
+		for (blocknum = 0; blocknum < drc->block_max; blocknum++)
+			if (drc->block_list[blocknum].entry != NULL)
+				free(drc->block_list[blocknum].entry);
+		free(drc->block_list);
+	}
 }
 
 
@@ -317,7 +453,11 @@ int drc_add_entry_point(drc_core *drc, UINT32 pc, int override)
 
 	/* note the current location for this instruction */
 	if (!was_occupied || override)
+	{
 		drc->lookup_l1[l1index][l2index] = drc->cache_top;
+		if (drc->block_current != -1)
+			add_block_entry(drc, pc);
+	}
 	return was_occupied;
 }
 
@@ -413,6 +553,44 @@ void drc_invalidate_code_range(drc_core *drc, UINT32 startpc, UINT32 endpc)
 }
 
 
+/*------------------------------------------------------------------
+    drc_precompile
+------------------------------------------------------------------*/
+
+void drc_precompile(drc_core *drc, const UINT32 *pclist, int count)
+{
+	x86code *limit = drc->zone_base + (drc->zone_end - drc->zone_base) / 2;
+	UINT32 savedpc = *drc->pcptr;
+	int pcnum;
+
+	/* compile each PC that doesn't have code yet, leaving half the cache for new code */
+	for (pcnum = 0; pcnum < count && drc->cache_top < limit; pcnum++)
+		if (drc_get_code_at_pc(drc, pclist[pcnum]) == NULL)
+			compile_block(drc, pclist[pcnum]);
+
+	/* restore the real PC */
+	*drc->pcptr = savedpc;
+}
+
+
+/*------------------------------------------------------------------
+    drc_get_live_bytes
+------------------------------------------------------------------*/
+
+UINT32 drc_get_live_bytes(drc_core *drc)
+{
+	UINT32 bytes = 0;
+	UINT32 blocknum;
+
+	for (blocknum = 0; blocknum < drc->block_count; blocknum++)
+	{
+		drc_block *block = &drc->block_list[(drc->block_head + blocknum) % drc->block_max];
+		bytes += block->end - block->base;
+	}
+	return bytes;
+}
+
+
 /*------------------------------------------------------------------
     drc_append_call_debugger
 ------------------------------------------------------------------*/
@@ -590,12 +768,8 @@ static void append_exit_point(drc_core *drc)
 
 static void recompile_code(drc_core *drc)
 {
-	/* if we're above the danger line, flush the cache before recompiling */
-	if (drc->cache_top >= drc->cache_danger)
-		drc_cache_reset(drc);
-
-	/* call the recompile callback */
-	(*drc->cb_recompile)(drc);
+	/* compile a new block at the current PC */
+	compile_block(drc, *drc->pcptr);
 }
 
 
@@ -627,3 +801,258 @@ static void append_flush(drc_core *drc)
 	emit_mov_r32_m32(DRCTOP, REG_P1, MDRC(drc->pcptr));								// mov  p1,[pc]
 	drc_append_dispatcher(drc);														// dispatch
 }
+
+
+
+/***************************************************************************
+    BLOCK MANAGEMENT
+***************************************************************************/
+
+/*------------------------------------------------------------------
+    setup_zones
+------------------------------------------------------------------*/
+
+static void setup_zones(drc_core *drc)
+{
+	x86code *start = drc->cache_top;
+	size_t avail = drc->cache_danger - start;
+	size_t usable = avail - avail / 16;
+	int zones;
+
+	/* keep a little space at the end for lookup tables allocated later */
+	for (zones = MAX_ZONES; zones > 1; zones--)
+		if (usable / zones >= 4 * BLOCK_MARGIN)
+			break;
+
+	/* if the cache is too small for zones, we just flush when it's full */
+	drc->zone_base = start;
+	drc->zone_current = 0;
+	if (zones < 2)
+	{
+		drc->zone_count = 0;
+		drc->zone_size = avail;
+		drc->zone_end = drc->cache_danger;
+		drc->zone_limit = drc->cache_danger;
+		return;
+	}
+
+	drc->zone_count = zones;
+	drc->zone_size = usable / zones;
+	drc->zone_end = start + drc->zone_size * zones;
+	drc->zone_limit = start + drc->zone_size - BLOCK_MARGIN;
+}
+
+
+/*------------------------------------------------------------------
+    compile_block
+------------------------------------------------------------------*/
+
+static drc_block *compile_block(drc_core *drc, UINT32 pc)
+{
+	UINT32 flushes;
+	drc_block *block;
+	UINT32 blocknum;
+
+	/* if this zone is full, reclaim the next one; don't recurse while already reclaiming */
+	if (drc->cache_top >= drc->zone_limit || drc->cache_top >= drc->cache_danger || drc->block_count >= drc->block_max)
+	{
+		if (drc->block_reclaiming)
+			return NULL;
+		reclaim_zone(drc);
+	}
+
+	/* start a new block */
+	blocknum = (drc->block_head + drc->block_count++) % drc->block_max;
+	block = &drc->block_list[blocknum];
+	block->base = block->end = drc->cache_top;
+	block->startpc = pc;
+	block->generation = 0;
+	block->entries = 0;
+	drc->block_hits[blocknum] = 0;
+	drc->block_current = blocknum;
+
+	/* call the recompile callback */
+	flushes = drc->stats.flushes;
+	*drc->pcptr = pc;
+	(*drc->cb_recompile)(drc);
+
+	/* if a lookup table allocation flushed the cache mid-compile, nothing here is tracked; flush again */
+	if (drc->stats.flushes != flushes)
+	{
+		drc_cache_reset(drc);
+		return NULL;
+	}
+
+	/* finish the block */
+	block->end = drc->cache_top;
+	drc->block_current = -1;
+	drc->stats.blocks_compiled++;
+	drc->stats.bytes_compiled += block->end - block->base;
+	return block;
+}
+
+
+/*------------------------------------------------------------------
+    compare_hot_blocks
+------------------------------------------------------------------*/
+
+static int CLIB_DECL compare_hot_blocks(const void *item1, const void *item2)
+{
+	const hot_block *hot1 = item1;
+	const hot_block *hot2 = item2;
+	return (hot1->hits > hot2->hits) ? -1 : (hot1->hits < hot2->hits);
+}
+
+
+/*------------------------------------------------------------------
+    reclaim_zone
+------------------------------------------------------------------*/
+
+static void reclaim_zone(drc_core *drc)
+{
+	x86code *zonestart, *zoneend;
+	UINT32 evicted, hotcount, hotnum;
+	UINT64 totalhits = 0;
+	UINT32 threshold;
+	hot_block *hotlist;
+	UINT32 savedpc;
+
+	/* without zones, fall back to flushing everything */
+	if (drc->zone_count == 0)
+	{
+		drc_cache_reset(drc);
+		return;
+	}
+
+	/* move on to the next zone */
+	drc->zone_current = (drc->zone_current + 1) % drc->zone_count;
+	zonestart = drc->zone_base + drc->zone_current * drc->zone_size;
+	zoneend = zonestart + drc->zone_size;
+	drc->stats.zone_reclaims++;
+
+	/* blocks are allocated in zone order, so the ones in this zone are the oldest */
+	for (evicted = 0; evicted < drc->block_count; evicted++)
+	{
+		drc_block *block = &drc->block_list[(drc->block_head + evicted) % drc->block_max];
+		if (block->base < zonestart || block->base >= zoneend)
+			break;
+		totalhits += drc->block_hits[(drc->block_head + evicted) % drc->block_max];
+	}
+
+	/* anything entered well above the zone's average is worth keeping */
+	threshold = (evicted == 0) ? 0 : (UINT32)MIN(totalhits * 2 / evicted, 0xffffffff);
+	threshold = MAX(threshold, HOT_MIN_HITS);
+	hotlist = (evicted == 0) ? NULL : malloc_or_die(evicted * sizeof(*hotlist));
+	hotcount = 0;
+
+	/* evict them all, remembering the hot ones */
+	while (evicted-- > 0)
+	{
+		drc_block *block = &drc->block_list[drc->block_head];
+		UINT32 hits = drc->block_hits[drc->block_head];
+
+		if (hits >= threshold)
+		{
+			hotlist[hotcount].pc = block->startpc;
+			hotlist[hotcount].hits = hits;
+			hotlist[hotcount].generation = block->generation;
+			hotcount++;
+		}
+		evict_block(drc, block);
+		drc->block_head = (drc->block_head + 1) % drc->block_max;
+		drc->block_count--;
+		drc->stats.blocks_evicted++;
+	}
+
+	/* start filling the zone from the bottom */
+	drc->cache_top = zonestart;
+	drc->zone_limit = zoneend - BLOCK_MARGIN;
+
+	/* if the ring is still full the blocks are tiny; give up and flush */
+	if (drc->block_count >= drc->block_max)
+	{
+		if (hotlist != NULL)
+			free(hotlist);
+		drc_cache_reset(drc);
+		return;
+	}
+
+	/* recompile the hot blocks into the fresh zone, hottest first, using at most half of it */
+	if (hotcount > 0)
+	{
+		qsort(hotlist, hotcount, sizeof(*hotlist), compare_hot_blocks);
+		savedpc = *drc->pcptr;
+		drc->block_reclaiming = TRUE;
+		for (hotnum = 0; hotnum < hotcount && drc->cache_top < zonestart + drc->zone_size / 2; hotnum++)
+			if (drc_get_code_at_pc(drc, hotlist[hotnum].pc) == NULL)
+			{
+				drc_block *block = compile_block(drc, hotlist[hotnum].pc);
+				if (block == NULL)
+					break;
+				block->generation = hotlist[hotnum].generation + 1;
+				drc->stats.blocks_retained++;
+			}
+		drc->block_reclaiming = FALSE;
+		*drc->pcptr = savedpc;
+	}
+	if (hotlist != NULL)
+		free(hotlist);
+}
+
+
+/*------------------------------------------------------------------
+    evict_block
+------------------------------------------------------------------*/
+
+static void evict_block(drc_core *drc, drc_block *block)
+{
+	UINT32 entrynum;
+
+	/* point any entries still referring to this block back at the recompiler */
+	for (entrynum = 0; entrynum < block->entries; entrynum++)
+	{
+		UINT32 pc = block->entry[entrynum];
+		x86code **l2table = drc->lookup_l1[pc >> drc->l1shift];
+		UINT32 l2index = ((pc & drc->l2mask) * drc->l2scale) / sizeof(x86code *);
+
+		if (l2table != drc->lookup_l2_recompile && l2table[l2index] >= block->base && l2table[l2index] < block->end)
+			l2table[l2index] = drc->recompile;
+	}
+	block->entries = 0;
+}
+
+
+/*------------------------------------------------------------------
+    format_stats
+------------------------------------------------------------------*/
+
+static void format_stats(drc_core *drc, char *buffer)
+{
+	double seconds = attotime_to_double(timer_get_time());
+
+	sprintf(buffer, "%u blocks live (%uk), %u compiled (%.1f/sec), %u evicted, %u retained, %u zones reclaimed, %u flushes",
+			drc->block_count, drc_get_live_bytes(drc) / 1024,
+			(UINT32)drc->stats.blocks_compiled, (seconds > 0) ? (double)drc->stats.blocks_compiled / seconds : 0.0,
+			(UINT32)drc->stats.blocks_evicted, (UINT32)drc->stats.blocks_retained,
+			drc->stats.zone_reclaims, drc->stats.flushes);
+}
+
+
+/*------------------------------------------------------------------
+    execute_drcstats
+------------------------------------------------------------------*/
+
+#ifdef MAME_DEBUG
+static void execute_drcstats(int ref, int params, const char **param)
+{
+	int cpunum;
+
+	for (cpunum = 0; cpunum < MAX_CPU; cpunum++)
+		if (live_drc[cpunum] != NULL)
+		{
+			char buffer[256];
+			format_stats(live_drc[cpunum], buffer);
+			debug_console_printf("CPU #%d: %s\n", cpunum, buffer);
+		}
+}
+#endif
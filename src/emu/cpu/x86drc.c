@@ -12,21 +12,49 @@
 #include "cpuintrf.h"
 #include "x86drc.h"
 #include "debugger.h"
+#ifdef MAME_DEBUG
+#include "debug/debugcon.h"
+#endif
 
 #define LOG_DISPATCHES				0
 #define BREAK_ON_MODIFIED_CODE		0
 
+#define BLOCK_MARGIN				65536			/* space that must be free before compiling a block */
+#define MAX_BLOCKS					32768			/* maximum number of live blocks */
+#define MAX_ZONES					8				/* maximum number of zones the cache is divided into */
+#define HOT_MIN_HITS				64				/* minimum entries for a block to survive eviction */
+
+
+
+/* a hot block that is recompiled when its zone is reclaimed */
+typedef struct _hot_block hot_block;
+struct _hot_block
+{
+	UINT32		pc;						/* start PC of the block */
+	UINT32		hits;					/* entries counted while it was live */
+	UINT32		generation;				/* generation of the evicted block */
+};
 
 
 
 static const UINT16 fp_control[4] = { 0x023f, 0x063f, 0x0a3f, 0x0e3f };
 static const UINT32 sse_control[4] = { 0x9fc0, 0xbfc0, 0xdfc0, 0xffc0 };
 
+static drc_core *live_drc[MAX_CPU];
+
 
 static void append_entry_point(drc_core *drc);
 static void append_recompile(drc_core *drc);
 static void append_flush(drc_core *drc);
 static void append_out_of_cycles(drc_core *drc);
+static void setup_zones(drc_core *drc);
+static drc_block *compile_block(drc_core *drc, UINT32 pc);
+static void reclaim_zone(drc_core *drc);
+static void evict_block(drc_core *drc, drc_block *block);
+static void format_stats(drc_core *drc, char *buffer);
+#ifdef MAME_DEBUG
+static void execute_drcstats(int ref, int params, const char **param);
+#endif
 
 #if LOG_DISPATCHES
 static void log_dispatch(drc_core *drc);
@@ -75,12 +103,14 @@ drc_core *drc_init(UINT8 cpunum, drc_config *config)
 	drc->icount_in_memory = config->icount_in_memory;
 	drc->fpcw_curr    = fp_control[0];
 	drc->mxcsr_curr   = sse_control[0];
+	drc->cpunum       = cpunum;
+	drc->block_current = -1;
 
 	/* configure cache */
 	drc->cache_base = (UINT8 *)config->cache_base + sizeof(*drc);
 	drc->cache_size = config->cache_size - sizeof(*drc);
 	drc->cache_end = drc->cache_base + drc->cache_size;
-	drc->cache_danger = drc->cache_end - 65536;
+	drc->cache_danger = drc->cache_end - BLOCK_MARGIN;
 	drc->cache_allocated = cache_allocated;
 
 	/* compute shifts and masks */
@@ -109,6 +139,30 @@ drc_core *drc_init(UINT8 cpunum, drc_config *config)
 	if (!drc->tentative_list)
 		return NULL;
 
+	/* allocate the block ring and the hit counters bumped by generated code */
+	drc->block_max = MAX_BLOCKS;
+	drc->block_hits = malloc(drc->block_max * sizeof(*drc->block_hits));
+	drc->block_list = malloc(drc->block_max * sizeof(*drc->block_list));
+	if (drc->block_hits == NULL || drc->block_list == NULL)
+		goto error;
+	memset(drc->block_list, 0, drc->block_max * sizeof(*drc->block_list));
+
+	/* register the statistics command with the debugger the first time through */
+#ifdef MAME_DEBUG
+	if (Machine->debug_mode)
+	{
+		int i;
+
+		for (i = 0; i < MAX_CPU; i++)
+			if (live_drc[i] != NULL)
+				break;
+		if (i == MAX_CPU)
+			debug_console_register_command("drcstats", CMDFLAG_NONE, 0, 0, 0, execute_drcstats);
+	}
+#endif
+	if (cpunum < MAX_CPU)
+		live_drc[cpunum] = drc;
+
 	return drc;
 
 error:
@@ -136,6 +190,15 @@ void *drc_alloc(drc_core *drc, size_t amount)
 	/* adjust the end and danger values downward */
 	drc->cache_end -= amount;
 	drc->cache_danger -= amount;
+
+	/* once the zones have wrapped, live code can sit anywhere below zone_end; if the new */
+	/* data cut into them, flush everything and carve smaller zones below the new danger */
+	if (drc->zone_count != 0 && drc->cache_danger < drc->zone_end)
+		drc_cache_reset(drc);
+
+	/* without zones, just keep the linear fill below the new danger */
+	else if (drc->zone_count == 0)
+		drc->zone_end = drc->zone_limit = drc->cache_danger;
 	return drc->cache_end;
 }
 
@@ -185,6 +248,13 @@ void drc_cache_reset(drc_core *drc)
 	/* call back to the host */
 	if (drc->cb_reset)
 		(*drc->cb_reset)(drc);
+
+	/* forget all the blocks and divide the rest of the cache into zones */
+	if (drc->block_count != 0)
+		drc->stats.flushes++;
+	drc->block_head = drc->block_count = 0;
+	drc->block_current = -1;
+	setup_zones(drc);
 }
 
 
@@ -204,8 +274,19 @@ void drc_execute(drc_core *drc)
 
 void drc_exit(drc_core *drc)
 {
+	UINT32 blocknum;
 	int i;
 
+	/* report how the cache did */
+	if (drc->block_list != NULL)
+	{
+		char buffer[256];
+		format_stats(drc, buffer);
+		mame_printf_verbose("DRC CPU #%d: %s\n", drc->cpunum, buffer);
+	}
+	if (drc->cpunum < MAX_CPU && live_drc[drc->cpunum] == drc)
+		live_drc[drc->cpunum] = NULL;
+
 	/* free all the l2 tables allocated */
 	for (i = 0; i < (1 << drc->l1bits); i++)
 		if (drc->lookup_l1[i] != drc->lookup_l2_recompile)
@@ -225,6 +306,17 @@ void drc_exit(drc_core *drc)
 	if (drc->tentative_list)
 		free(drc->tentative_list);
 
+	/* free the blocks */
+	if (drc->block_list != NULL)
+	{
+		for (blocknum = 0; blocknum < drc->block_max; blocknum++)
+			if (drc->block_list[blocknum].entry != NULL)
+				free(drc->block_list[blocknum].entry);
+		free(drc->block_list);
+	}
+	if (drc->block_hits != NULL)
+		free(drc->block_hits);
+
 	/* and the drc itself */
 	if (drc->cache_allocated)
 		osd_free_executable(drc, drc->cache_size + sizeof(*drc));
@@ -264,6 +356,28 @@ void drc_begin_sequence(drc_core *drc, UINT32 pc)
 
 	/* note the current location for this instruction */
 	drc->lookup_l1[l1index][l2index] = drc->cache_top;
+
+	/* remember the entry so eviction can unhook it, and count entries to the block */
+	if (drc->block_current != -1)
+	{
+		drc_block *block = &drc->block_list[drc->block_current];
+
+		if (block->entries == block->entryalloc)
+		{
+			UINT32 *newentry;
+
+			block->entryalloc = (block->entryalloc == 0) ? 4 : block->entryalloc * 2;
+			newentry = malloc_or_die(block->entryalloc * sizeof(*newentry));
+			if (block->entry != NULL)
+			{
+				memcpy(newentry, block->entry, block->entries * sizeof(*newentry));
+				free(block->entry);
+			}
+			block->entry = newentry;
+		}
+		block->entry[block->entries++] = pc;
+		emit_add_m32_imm(DRCTOP, MABS(&drc->block_hits[drc->block_current]), 1);	// add  [hits],1
+	}
 }
 
 
@@ -315,6 +429,46 @@ void *drc_get_code_at_pc(drc_core *drc, UINT32 pc)
 }
 
 
+/*------------------------------------------------------------------
+    drc_get_linkable_code_at_pc
+
+    Like drc_get_code_at_pc, but only returns code that is safe to
+    jump to directly from the block being compiled: once zones are
+    reclaimed individually, code in other blocks may be evicted
+    while we still point at it, so those must go through the lookup
+------------------------------------------------------------------*/
+
+void *drc_get_linkable_code_at_pc(drc_core *drc, UINT32 pc)
+{
+	x86code *code = drc_get_code_at_pc(drc, pc);
+
+	if (code != NULL && drc->zone_count != 0)
+	{
+		if (drc->block_current == -1 || code < drc->block_list[drc->block_current].base || code >= drc->cache_top)
+			return NULL;
+	}
+	return code;
+}
+
+
+/*------------------------------------------------------------------
+    drc_get_live_bytes
+------------------------------------------------------------------*/
+
+UINT32 drc_get_live_bytes(drc_core *drc)
+{
+	UINT32 bytes = 0;
+	UINT32 blocknum;
+
+	for (blocknum = 0; blocknum < drc->block_count; blocknum++)
+	{
+		drc_block *block = &drc->block_list[(drc->block_head + blocknum) % drc->block_max];
+		bytes += block->end - block->base;
+	}
+	return bytes;
+}
+
+
 /*------------------------------------------------------------------
     drc_append_verify_code
 ------------------------------------------------------------------*/
@@ -665,9 +819,8 @@ static void append_entry_point(drc_core *drc)
 
 static void recompile_code(drc_core *drc)
 {
-	if (drc->cache_top >= drc->cache_danger)
-		drc_cache_reset(drc);
-	(*drc->cb_recompile)(drc);
+	/* compile a new block at the current PC */
+	compile_block(drc, *drc->pcptr);
 }
 
 
@@ -717,6 +870,261 @@ static void append_out_of_cycles(drc_core *drc)
 
 
 
+/***************************************************************************
+    BLOCK MANAGEMENT
+***************************************************************************/
+
+/*------------------------------------------------------------------
+    setup_zones
+------------------------------------------------------------------*/
+
+static void setup_zones(drc_core *drc)
+{
+	x86code *start = drc->cache_top;
+	size_t avail = drc->cache_danger - start;
+	size_t usable = avail - avail / 16;
+	int zones;
+
+	/* keep a little space at the end for data allocated later */
+	for (zones = MAX_ZONES; zones > 1; zones--)
+		if (usable / zones >= 4 * BLOCK_MARGIN)
+			break;
+
+	/* if the cache is too small for zones, we just flush when it's full */
+	drc->zone_base = start;
+	drc->zone_current = 0;
+	if (zones < 2)
+	{
+		drc->zone_count = 0;
+		drc->zone_size = avail;
+		drc->zone_end = drc->cache_danger;
+		drc->zone_limit = drc->cache_danger;
+		return;
+	}
+
+	drc->zone_count = zones;
+	drc->zone_size = usable / zones;
+	drc->zone_end = start + drc->zone_size * zones;
+	drc->zone_limit = start + drc->zone_size - BLOCK_MARGIN;
+}
+
+
+/*------------------------------------------------------------------
+    compile_block
+------------------------------------------------------------------*/
+
+static drc_block *compile_block(drc_core *drc, UINT32 pc)
+{
+	UINT32 flushes;
+	drc_block *block;
+	UINT32 blocknum;
+
+	/* if this zone is full, reclaim the next one; don't recurse while already reclaiming */
+	if (drc->cache_top >= drc->zone_limit || drc->cache_top >= drc->cache_danger || drc->block_count >= drc->block_max)
+	{
+		if (drc->block_reclaiming)
+			return NULL;
+		reclaim_zone(drc);
+	}
+
+	/* start a new block */
+	blocknum = (drc->block_head + drc->block_count++) % drc->block_max;
+	block = &drc->block_list[blocknum];
+	block->base = block->end = drc->cache_top;
+	block->startpc = pc;
+	block->generation = 0;
+	block->entries = 0;
+	drc->block_hits[blocknum] = 0;
+	drc->block_current = blocknum;
+
+	/* call the recompile callback */
+	flushes = drc->stats.flushes;
+	*drc->pcptr = pc;
+	(*drc->cb_recompile)(drc);
+
+	/* if the core flushed the cache mid-compile, nothing here is tracked; flush again */
+	if (drc->stats.flushes != flushes)
+	{
+		drc_cache_reset(drc);
+		return NULL;
+	}
+
+	/* finish the block */
+	block->end = drc->cache_top;
+	drc->block_current = -1;
+	drc->stats.blocks_compiled++;
+	drc->stats.bytes_compiled += block->end - block->base;
+	return block;
+}
+
+
+/*------------------------------------------------------------------
+    compare_hot_blocks
+------------------------------------------------------------------*/
+
+static int CLIB_DECL compare_hot_blocks(const void *item1, const void *item2)
+{
+	const hot_block *hot1 = item1;
+	const hot_block *hot2 = item2;
+	return (hot1->hits > hot2->hits) ? -1 : (hot1->hits < hot2->hits);
+}
+
+
+/*------------------------------------------------------------------
+    reclaim_zone
+------------------------------------------------------------------*/
+
+static void reclaim_zone(drc_core *drc)
+{
+	x86code *zonestart, *zoneend;
+	UINT32 evicted, hotcount, hotnum;
+	UINT64 totalhits = 0;
+	UINT32 threshold;
+	hot_block *hotlist;
+	UINT32 savedpc;
+
+	/* without zones, fall back to flushing everything */
+	if (drc->zone_count == 0)
+	{
+		drc_cache_reset(drc);
+		return;
+	}
+
+	/* move on to the next zone */
+	drc->zone_current = (drc->zone_current + 1) % drc->zone_count;
+	zonestart = drc->zone_base + drc->zone_current * drc->zone_size;
+	zoneend = zonestart + drc->zone_size;
+	drc->stats.zone_reclaims++;
+
+	/* blocks are allocated in zone order, so the ones in this zone are the oldest */
+	for (evicted = 0; evicted < drc->block_count; evicted++)
+	{
+		drc_block *block = &drc->block_list[(drc->block_head + evicted) % drc->block_max];
+		if (block->base < zonestart || block->base >= zoneend)
+			break;
+		totalhits += drc->block_hits[(drc->block_head + evicted) % drc->block_max];
+	}
+
+	/* anything entered well above the zone's average is worth keeping */
+	threshold = (evicted == 0) ? 0 : (UINT32)MIN(totalhits * 2 / evicted, 0xffffffff);
+	threshold = MAX(threshold, HOT_MIN_HITS);
+	hotlist = (evicted == 0) ? NULL : malloc_or_die(evicted * sizeof(*hotlist));
+	hotcount = 0;
+
+	/* evict them all, remembering the hot ones */
+	while (evicted-- > 0)
+	{
+		drc_block *block = &drc->block_list[drc->block_head];
+		UINT32 hits = drc->block_hits[drc->block_head];
+
+		if (hits >= threshold)
+		{
+			hotlist[hotcount].pc = block->startpc;
+			hotlist[hotcount].hits = hits;
+			hotlist[hotcount].generation = block->generation;
+			hotcount++;
+		}
+		evict_block(drc, block);
+		drc->block_head = (drc->block_head + 1) % drc->block_max;
+		drc->block_count--;
+		drc->stats.blocks_evicted++;
+	}
+
+	/* start filling the zone from the bottom */
+	drc->cache_top = zonestart;
+	drc->zone_limit = zoneend - BLOCK_MARGIN;
+
+	/* if the ring is still full the blocks are tiny; give up and flush */
+	if (drc->block_count >= drc->block_max)
+	{
+		if (hotlist != NULL)
+			free(hotlist);
+		drc_cache_reset(drc);
+		return;
+	}
+
+	/* recompile the hot blocks into the fresh zone, hottest first, using at most half of it */
+	if (hotcount > 0)
+	{
+		qsort(hotlist, hotcount, sizeof(*hotlist), compare_hot_blocks);
+		savedpc = *drc->pcptr;
+		drc->block_reclaiming = TRUE;
+		for (hotnum = 0; hotnum < hotcount && drc->cache_top < zonestart + drc->zone_size / 2; hotnum++)
+			if (drc_get_code_at_pc(drc, hotlist[hotnum].pc) == NULL)
+			{
+				drc_block *block = compile_block(drc, hotlist[hotnum].pc);
+				if (block == NULL)
+					break;
+				block->generation = hotlist[hotnum].generation + 1;
+				drc->stats.blocks_retained++;
+			}
+		drc->block_reclaiming = FALSE;
+		*drc->pcptr = savedpc;
+	}
+	if (hotlist != NULL)
+		free(hotlist);
+}
+
+
+/*------------------------------------------------------------------
+    evict_block
+------------------------------------------------------------------*/
+
+static void evict_block(drc_core *drc, drc_block *block)
+{
+	UINT32 entrynum;
+
+	/* point any entries still referring to this block back at the recompiler */
+	for (entrynum = 0; entrynum < block->entries; entrynum++)
+	{
+		UINT32 pc = block->entry[entrynum];
+		x86code **l2table = drc->lookup_l1[pc >> drc->l1shift];
+		UINT32 l2index = ((pc & drc->l2mask) * drc->l2scale) / 4;
+
+		if (l2table != drc->lookup_l2_recompile && l2table[l2index] >= block->base && l2table[l2index] < block->end)
+			l2table[l2index] = drc->recompile;
+	}
+	block->entries = 0;
+}
+
+
+/*------------------------------------------------------------------
+    format_stats
+------------------------------------------------------------------*/
+
+static void format_stats(drc_core *drc, char *buffer)
+{
+	double seconds = attotime_to_double(timer_get_time());
+
+	sprintf(buffer, "%u blocks live (%uk), %u compiled (%.1f/sec), %u evicted, %u retained, %u zones reclaimed, %u flushes",
+			drc->block_count, drc_get_live_bytes(drc) / 1024,
+			(UINT32)drc->stats.blocks_compiled, (seconds > 0) ? (double)drc->stats.blocks_compiled / seconds : 0.0,
+			(UINT32)drc->stats.blocks_evicted, (UINT32)drc->stats.blocks_retained,
+			drc->stats.zone_reclaims, drc->stats.flushes);
+}
+
+
+/*------------------------------------------------------------------
+    execute_drcstats
+------------------------------------------------------------------*/
+
+#ifdef MAME_DEBUG
+static void execute_drcstats(int ref, int params, const char **param)
+{
+	int cpunum;
+
+	for (cpunum = 0; cpunum < MAX_CPU; cpunum++)
+		if (live_drc[cpunum] != NULL)
+		{
+			char buffer[256];
+			format_stats(live_drc[cpunum], buffer);
+			debug_console_printf("CPU #%d: %s\n", cpunum, buffer);
+		}
+}
+#endif
+
+
+
 /*------------------------------------------------------------------
     drc_x86_get_features()
 ------------------------------------------------------------------*/
@@ -31,6 +31,33 @@ struct _pc_ptr_pair
 };
 
 
+/* a block of code generated by a single recompile */
+typedef struct _drc_block drc_block;
+struct _drc_block
+{
+	x86code *	base;					/* start of the block's code */
+	x86code *	end;					/* end of the block's code */
+	UINT32		startpc;				/* PC that caused the block to be compiled */
+	UINT32		generation;				/* number of evictions the block has survived */
+	UINT32 *	entry;					/* PCs of the block's entry points */
+	UINT32		entries;				/* number of entry points */
+	UINT32		entryalloc;				/* allocated size of the entry array */
+};
+
+
+/* statistics about the code cache */
+typedef struct _drc_stats drc_stats;
+struct _drc_stats
+{
+	UINT64		blocks_compiled;		/* total blocks compiled */
+	UINT64		blocks_evicted;			/* total blocks evicted */
+	UINT64		blocks_retained;		/* hot blocks recompiled into a younger zone on eviction */
+	UINT64		bytes_compiled;			/* total bytes of code generated */
+	UINT32		zone_reclaims;			/* number of zones reclaimed */
+	UINT32		flushes;				/* number of full cache flushes */
+};
+
+
 /* core interface structure for the drc common code */
 typedef struct _drc_core drc_core;
 struct _drc_core
@@ -76,6 +103,24 @@ struct _drc_core
 	UINT32		tentative_count;		/* number of tentative branches */
 	UINT32		tentative_count_max;	/* max number of tentative branches */
 
+	drc_block *	block_list;				/* ring of live blocks, oldest first */
+	UINT32 *	block_hits;				/* per-block entry counters, updated by generated code */
+	UINT32		block_head;				/* index of the oldest live block */
+	UINT32		block_count;			/* number of live blocks */
+	UINT32		block_max;				/* size of the block ring */
+	INT32		block_current;			/* index of the block being compiled, or -1 */
+	UINT8		block_reclaiming;		/* TRUE while recompiling hot blocks during a reclaim */
+
+	x86code *	zone_base;				/* start of the first zone */
+	x86code *	zone_end;				/* end of the last zone */
+	x86code *	zone_limit;				/* cache_top limit for the current zone */
+	UINT32		zone_size;				/* size of each zone */
+	UINT8		zone_count;				/* number of zones; 0 means flush when full */
+	UINT8		zone_current;			/* index of the zone being filled */
+
+	UINT8		cpunum;					/* CPU we belong to */
+	drc_stats	stats;					/* cache statistics */
+
 	void 		(*cb_reset)(struct _drc_core *drc);		/* callback when the cache is reset */
 	void 		(*cb_recompile)(struct _drc_core *drc);	/* callback when code needs to be recompiled */
 	void 		(*cb_entrygen)(struct _drc_core *drc);	/* callback before generating the dispatcher on entry */
@@ -164,6 +209,8 @@ void drc_begin_sequence(drc_core *drc, UINT32 pc);
 void drc_end_sequence(drc_core *drc);
 void drc_register_code_at_cache_top(drc_core *drc, UINT32 pc);
 void *drc_get_code_at_pc(drc_core *drc, UINT32 pc);
+void *drc_get_linkable_code_at_pc(drc_core *drc, UINT32 pc);
+UINT32 drc_get_live_bytes(drc_core *drc);
 
 /* standard appendages */
 void drc_append_dispatcher(drc_core *drc);
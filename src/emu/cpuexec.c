@@ -105,6 +105,17 @@ struct _cpuexec_data
 };
 
 
+/* a group of CPUs that runs its timeslice independently of the others */
+typedef struct _cpu_group cpu_group;
+struct _cpu_group
+{
+	int		cpunum[MAX_CPU];		/* CPUs in this group, in execution order */
+	int		count;					/* number of CPUs in the group */
+	attotime base;					/* start of the current timeslice */
+	attotime target;				/* end of the current timeslice for this group */
+};
+
+
 
 /*************************************
  *
@@ -118,8 +129,15 @@ static UINT8 vblank;
 static UINT32 current_frame;
 static INT32 watchdog_counter;
 
-static int cycles_running;
-static int cycles_stolen;
+static DECL_THREAD_LOCAL int cycles_running;
+static DECL_THREAD_LOCAL int cycles_stolen;
+
+static cpu_group groups[MAX_CPU_GROUPS];
+static int group_count;
+static int cpu_groupnum[MAX_CPU];
+static UINT8 group_parallel;
+static osd_work_queue *group_queue;
+static osd_lock *group_lock;
 
 
 
@@ -165,6 +183,9 @@ static TIMER_CALLBACK( cpu_updatecallback );
 static TIMER_CALLBACK( end_interleave_boost );
 static void compute_perfect_interleave(void);
 static void watchdog_setup(int alloc_new);
+static void setup_groups(running_machine *machine);
+static attotime execute_cpus(cpu_group *group);
+static void *execute_group(void *param, int threadid);
 
 
 
@@ -266,6 +287,9 @@ void cpuexec_init(running_machine *machine)
 	/* compute the perfect interleave factor */
 	compute_perfect_interleave();
 
+	/* sort the CPUs into groups that can run in parallel */
+	setup_groups(machine);
+
 	/* save some stuff in the default tag */
 	state_save_push_tag(0);
 	state_save_register_item("cpu", 0, vblank);
@@ -326,6 +350,14 @@ static void cpuexec_exit(running_machine *machine)
 {
 	int cpunum;
 
+	/* shut down the parallel groups */
+	if (group_queue != NULL)
+		osd_work_queue_free(group_queue);
+	group_queue = NULL;
+	if (group_lock != NULL)
+		osd_lock_free(group_lock);
+	group_lock = NULL;
+
 	/* shut down the CPU cores */
 	for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
 		cpuintrf_exit_cpu(cpunum);
@@ -333,6 +365,142 @@ static void cpuexec_exit(running_machine *machine)
 
 
 
+/*************************************
+ *
+ *  Sort the CPUs into parallel
+ *  groups
+ *
+ *************************************/
+
+static void setup_groups(running_machine *machine)
+{
+	int drvgroup[MAX_CPU];
+	int groupmap[MAX_CPU_GROUPS];
+	int cpunum, othernum, groupnum;
+	int parallel = TRUE;
+
+	/* validate the driver's group numbers */
+	for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
+	{
+		drvgroup[cpunum] = machine->drv->cpu[cpunum].group;
+		if (drvgroup[cpunum] < 0 || drvgroup[cpunum] >= MAX_CPU_GROUPS)
+			fatalerror("CPU #%d has invalid parallel group %d", cpunum, drvgroup[cpunum]);
+	}
+
+	/* writes aren't deferred between groups, so CPUs that share RAM or banks must run together */
+	for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
+		for (othernum = 0; othernum < cpunum; othernum++)
+			if (drvgroup[cpunum] != drvgroup[othernum] && memory_cpus_share_memory(othernum, cpunum))
+			{
+				int oldgroup = MAX(drvgroup[cpunum], drvgroup[othernum]);
+				int newgroup = MIN(drvgroup[cpunum], drvgroup[othernum]);
+				int mergenum;
+
+				logerror("CPUs #%d and #%d share memory; merging group %d into group %d\n", othernum, cpunum, oldgroup, newgroup);
+				for (mergenum = 0; mergenum < cpu_gettotalcpu(); mergenum++)
+					if (drvgroup[mergenum] == oldgroup)
+						drvgroup[mergenum] = newgroup;
+			}
+
+	/* map the group numbers to groups; the group containing CPU 0 runs on this thread */
+	memset(groups, 0, sizeof(groups));
+	for (groupnum = 0; groupnum < MAX_CPU_GROUPS; groupnum++)
+		groupmap[groupnum] = -1;
+	group_count = 0;
+	for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
+	{
+		if (groupmap[drvgroup[cpunum]] == -1)
+			groupmap[drvgroup[cpunum]] = group_count++;
+		groupnum = groupmap[drvgroup[cpunum]];
+		groups[groupnum].cpunum[groups[groupnum].count++] = cpunum;
+		cpu_groupnum[cpunum] = groupnum;
+	}
+
+	/* CPUs in different groups can't share a core, since cores keep their context in globals */
+	for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
+		for (othernum = 0; othernum < cpunum; othernum++)
+			if (drvgroup[cpunum] != drvgroup[othernum] &&
+				!strcmp(cputype_core_file(machine->drv->cpu[cpunum].type), cputype_core_file(machine->drv->cpu[othernum].type)))
+			{
+				logerror("CPUs #%d and #%d share a core; running all CPUs serially\n", othernum, cpunum);
+				parallel = FALSE;
+			}
+
+	/* the debugger expects to see every CPU stop, and we need per-thread state */
+#ifdef NO_THREAD_LOCAL
+	parallel = FALSE;
+#endif
+	if (machine->debug_mode)
+		parallel = FALSE;
+
+	/* allocate a queue to run the extra groups on */
+	if (group_count > 1 && parallel)
+	{
+		group_queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI | WORK_QUEUE_FLAG_HIGH_FREQ);
+		group_lock = osd_lock_alloc();
+		if (group_queue == NULL || group_lock == NULL)
+			parallel = FALSE;
+	}
+
+	/* if we can't go parallel, put everyone back in one group in CPU order */
+	if (group_count > 1 && !parallel)
+	{
+		memset(groups, 0, sizeof(groups));
+		for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
+		{
+			groups[0].cpunum[groups[0].count++] = cpunum;
+			cpu_groupnum[cpunum] = 0;
+		}
+		group_count = 1;
+	}
+	if (group_count > 1)
+		mame_printf_verbose("Running %d CPU groups in parallel\n", group_count);
+}
+
+
+
+/*************************************
+ *
+ *  Lock shared scheduler state
+ *  while groups run in parallel
+ *
+ *************************************/
+
+void cpuexec_lock(void)
+{
+	if (group_parallel)
+		osd_lock_acquire(group_lock);
+}
+
+
+void cpuexec_unlock(void)
+{
+	if (group_parallel)
+		osd_lock_release(group_lock);
+}
+
+
+
+/*************************************
+ *
+ *  Return whether a CPU can be
+ *  touched from the executing
+ *  CPU's thread
+ *
+ *************************************/
+
+int cpuexec_in_executing_group(int cpunum)
+{
+	int executing = cpu_getexecutingcpu();
+
+	/* outside a parallel timeslice everything runs on this thread */
+	if (!group_parallel)
+		return TRUE;
+	return (executing >= 0 && cpu_groupnum[executing] == cpu_groupnum[cpunum]);
+}
+
+
+
 
 #if 0
 #pragma mark -
@@ -459,32 +627,21 @@ void watchdog_enable(int enable)
 
 /*************************************
  *
- *  Execute all the CPUs for one
- *  timeslice
+ *  Execute a group of CPUs up to
+ *  its target time
  *
  *************************************/
 
-void cpuexec_timeslice(void)
+static attotime execute_cpus(cpu_group *group)
 {
-	attotime target = timer_next_fire_time();
-	attotime base = timer_get_time();
-	int cpunum, ran;
-
-	LOG(("------------------\n"));
-	LOG(("cpu_timeslice: target = %s\n", attotime_string(target, 9)));
-
-	/* process any pending suspends */
-	for (cpunum = 0; Machine->drv->cpu[cpunum].type != CPU_DUMMY; cpunum++)
-	{
-		if (cpu[cpunum].suspend != cpu[cpunum].nextsuspend)
-			LOG(("--> updated CPU%d suspend from %X to %X\n", cpunum, cpu[cpunum].suspend, cpu[cpunum].nextsuspend));
-		cpu[cpunum].suspend = cpu[cpunum].nextsuspend;
-		cpu[cpunum].eatcycles = cpu[cpunum].nexteatcycles;
-	}
+	attotime target = group->target;
+	int cpuindex, ran;
 
 	/* loop over CPUs */
-	for (cpunum = 0; Machine->drv->cpu[cpunum].type != CPU_DUMMY; cpunum++)
+	for (cpuindex = 0; cpuindex < group->count; cpuindex++)
 	{
+		int cpunum = group->cpunum[cpuindex];
+
 		/* only process if we're not suspended */
 		if (!cpu[cpunum].suspend)
 		{
@@ -495,7 +652,9 @@ void cpuexec_timeslice(void)
 			/* run for the requested number of cycles */
 			if (cycles_running > 0)
 			{
-				profiler_mark(PROFILER_CPU1 + cpunum);
+				/* the profiler isn't thread safe, so only track serial execution */
+				if (!group_parallel)
+					profiler_mark(PROFILER_CPU1 + cpunum);
 
 				/* note that this global variable cycles_stolen can be modified */
 				/* via the call to the cpunum_execute */
@@ -508,7 +667,8 @@ void cpuexec_timeslice(void)
 #endif /* MAME_DEBUG */
 
 				ran -= cycles_stolen;
-				profiler_mark(PROFILER_END);
+				if (!group_parallel)
+					profiler_mark(PROFILER_END);
 
 				/* account for these cycles */
 				cpu[cpunum].totalcycles += ran;
@@ -518,15 +678,84 @@ void cpuexec_timeslice(void)
 				/* if the new local CPU time is less than our target, move the target up */
 				if (attotime_compare(cpu[cpunum].localtime, target) < 0)
 				{
-					if (attotime_compare(cpu[cpunum].localtime, base) > 0)
+					if (attotime_compare(cpu[cpunum].localtime, group->base) > 0)
 						target = cpu[cpunum].localtime;
 					else
-						target = base;
+						target = group->base;
 					LOG(("         (new target)\n"));
 				}
 			}
 		}
 	}
+	return target;
+}
+
+
+static void *execute_group(void *param, int threadid)
+{
+	cpu_group *group = param;
+
+	/* run the CPUs, then give up the memory context so the next thread can take it */
+	group->target = execute_cpus(group);
+	memory_release_context();
+	return NULL;
+}
+
+
+
+/*************************************
+ *
+ *  Execute all the CPUs for one
+ *  timeslice
+ *
+ *************************************/
+
+void cpuexec_timeslice(void)
+{
+	attotime target = timer_next_fire_time();
+	attotime base = timer_get_time();
+	int cpunum, groupnum;
+
+	LOG(("------------------\n"));
+	LOG(("cpu_timeslice: target = %s\n", attotime_string(target, 9)));
+
+	/* process any pending suspends */
+	for (cpunum = 0; Machine->drv->cpu[cpunum].type != CPU_DUMMY; cpunum++)
+	{
+		if (cpu[cpunum].suspend != cpu[cpunum].nextsuspend)
+			LOG(("--> updated CPU%d suspend from %X to %X\n", cpunum, cpu[cpunum].suspend, cpu[cpunum].nextsuspend));
+		cpu[cpunum].suspend = cpu[cpunum].nextsuspend;
+		cpu[cpunum].eatcycles = cpu[cpunum].nexteatcycles;
+	}
+
+	/* set up each group for this timeslice */
+	for (groupnum = 0; groupnum < group_count; groupnum++)
+	{
+		groups[groupnum].base = base;
+		groups[groupnum].target = target;
+	}
+
+	/* with a single group, just run everyone in order */
+	if (group_count == 1)
+		target = execute_cpus(&groups[0]);
+
+	/* otherwise, hand the extra groups to the work queue and run the first one ourself */
+	else
+	{
+		/* our memory context must be written back before another thread picks up a CPU */
+		memory_release_context();
+		group_parallel = TRUE;
+		osd_work_item_queue_multiple(group_queue, execute_group, group_count - 1, &groups[1], sizeof(groups[1]), WORK_ITEM_FLAG_AUTO_RELEASE);
+		execute_group(&groups[0], 0);
+		if (!osd_work_queue_wait(group_queue, osd_ticks_per_second() * 100))
+			fatalerror("cpuexec_timeslice: CPU groups never completed");
+		group_parallel = FALSE;
+
+		/* the slice ends at the earliest point any group stopped */
+		for (groupnum = 0; groupnum < group_count; groupnum++)
+			if (attotime_compare(groups[groupnum].target, target) < 0)
+				target = groups[groupnum].target;
+	}
 
 	/* update the local times of all CPUs */
 	for (cpunum = 0; Machine->drv->cpu[cpunum].type != CPU_DUMMY; cpunum++)
@@ -618,8 +847,10 @@ void cpunum_suspend(int cpunum, int reason, int eatcycles)
 	LOG(("cpunum_suspend (CPU=%d, r=%X, eat=%d)\n", cpunum, reason, eatcycles));
 
 	/* set the pending suspend bits, and force a resync */
+	cpuexec_lock();
 	cpu[cpunum].nextsuspend |= reason;
 	cpu[cpunum].nexteatcycles = eatcycles;
+	cpuexec_unlock();
 	if (cpu_getexecutingcpu() >= 0)
 		activecpu_abort_timeslice();
 }
@@ -639,7 +870,9 @@ void cpunum_resume(int cpunum, int reason)
 	LOG(("cpunum_resume (CPU=%d, r=%X)\n", cpunum, reason));
 
 	/* clear the pending suspend bits, and force a resync */
+	cpuexec_lock();
 	cpu[cpunum].nextsuspend &= ~reason;
+	cpuexec_unlock();
 	if (cpu_getexecutingcpu() >= 0)
 		activecpu_abort_timeslice();
 }
@@ -967,6 +1200,7 @@ void cpu_trigger(int trigger)
 		activecpu_abort_timeslice();
 
 	/* look for suspended CPUs waiting for this trigger and unsuspend them */
+	cpuexec_lock();
 	for (cpunum = 0; cpunum < MAX_CPU; cpunum++)
 	{
 		/* if this is a dummy, stop looking */
@@ -980,6 +1214,7 @@ void cpu_trigger(int trigger)
 			cpu[cpunum].trigger = 0;
 		}
 	}
+	cpuexec_unlock();
 }
 
 
@@ -229,6 +229,7 @@ struct _cpu_config
 	attoseconds_t timed_interrupt_period;	/* period for periodic interrupts */
 	const void *reset_param;				/* parameter for cpu_reset */
 	const char *tag;
+	int			group;					/* parallel execution group (0 = run with the main CPU) */
 };
 
 
@@ -247,6 +248,10 @@ enum
 };
 
 
+/* maximum number of parallel CPU groups */
+#define MAX_CPU_GROUPS	4
+
+
 
 
 /*************************************
@@ -261,6 +266,13 @@ void cpuexec_init(running_machine *machine);
 /* Execute for a single timeslice */
 void cpuexec_timeslice(void);
 
+/* Serialize access to shared scheduler state while CPU groups run in parallel */
+void cpuexec_lock(void);
+void cpuexec_unlock(void);
+
+/* Return whether a CPU runs on the same thread as the executing CPU */
+int cpuexec_in_executing_group(int cpunum);
+
 
 
 /*************************************
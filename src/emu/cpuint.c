@@ -298,7 +298,11 @@ void cpunum_set_input_line_and_vector(int cpunum, int line, int state, int vecto
 	if (line >= 0 && line < MAX_INPUT_LINES)
 	{
 		INT32 input_event = (state & 0xff) | (vector << 8);
-		int event_index = input_event_index[cpunum][line]++;
+		int event_index;
+
+		/* CPUs in other parallel groups may be queueing events too */
+		cpuexec_lock();
+		event_index = input_event_index[cpunum][line]++;
 
 		LOG(("cpunum_set_input_line_and_vector(%d,%d,%d,%02x)\n", cpunum, line, state, vector));
 
@@ -306,6 +310,14 @@ void cpunum_set_input_line_and_vector(int cpunum, int line, int state, int vecto
 		if (event_index >= MAX_INPUT_EVENTS)
 		{
 			input_event_index[cpunum][line]--;
+
+			/* a CPU in another parallel group may be running right now; drop the event and let the resynch flush */
+			if (!cpuexec_in_executing_group(cpunum))
+			{
+				logerror("Exceeded pending input line event queue on CPU %d; dropping event\n", cpunum);
+				cpuexec_unlock();
+				return;
+			}
 			cpunum_empty_event_queue(Machine, NULL, cpunum | (line << 8));
 			event_index = input_event_index[cpunum][line]++;
 			logerror("Exceeded pending input line event queue on CPU %d!\n", cpunum);
@@ -320,6 +332,7 @@ void cpunum_set_input_line_and_vector(int cpunum, int line, int state, int vecto
 			if (event_index == 0)
 				timer_call_after_resynch(NULL, cpunum | (line << 8), cpunum_empty_event_queue);
 		}
+		cpuexec_unlock();
 	}
 }
 
@@ -804,15 +804,16 @@ static const struct
  *
  *************************************/
 
-int activecpu;		/* index of active CPU (or -1) */
-int executingcpu;	/* index of executing CPU (or -1) */
+/* the active and executing CPUs are per-thread so that CPU groups can run in parallel */
+DECL_THREAD_LOCAL int activecpu = -1;		/* index of active CPU (or -1) */
+DECL_THREAD_LOCAL int executingcpu = -1;	/* index of executing CPU (or -1) */
 int totalcpu;		/* total number of CPUs */
 
 static cpuintrf_data cpu[MAX_CPU];
 
 static int cpu_active_context[CPU_COUNT];
-static int cpu_context_stack[4];
-static int cpu_context_stack_ptr;
+static DECL_THREAD_LOCAL int cpu_context_stack[4];
+static DECL_THREAD_LOCAL int cpu_context_stack_ptr;
 
 static offs_t (*cpu_dasm_override[CPU_COUNT])(char *buffer, offs_t pc, const UINT8 *oprom, const UINT8 *opram);
 
@@ -485,7 +485,7 @@ INLINE const cpu_interface *cputype_get_interface(cpu_type cputype)
 /* return a the index of the active CPU */
 INLINE int cpu_getactivecpu(void)
 {
-	extern int activecpu;
+	extern DECL_THREAD_LOCAL int activecpu;
 	return activecpu;
 }
 
@@ -493,7 +493,7 @@ INLINE int cpu_getactivecpu(void)
 /* return a the index of the executing CPU */
 INLINE int cpu_getexecutingcpu(void)
 {
-	extern int executingcpu;
+	extern DECL_THREAD_LOCAL int executingcpu;
 	return executingcpu;
 }
 
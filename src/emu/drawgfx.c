@@ -13,6 +13,8 @@
 
 #include "driver.h"
 #include "profiler.h"
+#include "eminline.h"
+#include "gfxsimd.h"
 
 
 /***************************************************************************
@@ -31,6 +33,44 @@
 #define SHIFT0 24
 #endif
 
+/* sprite lists are split into at most this many bands of scanlines */
+#define SPRITE_LIST_MAX_BANDS	8
+
+/* bands are never shorter than this many scanlines */
+#define SPRITE_LIST_MIN_ROWS	16
+
+/* lists shorter than this are always drawn on the calling thread */
+#define SPRITE_LIST_MIN_THREADED	32
+
+/* layout classes, from fastest to slowest decoding */
+enum
+{
+	DECODE_CHUNKY,				/* each pixel's planes are adjacent bits of a nibble or byte */
+	DECODE_PLANAR,				/* each plane is stored as byte-aligned runs of 8 pixels */
+	DECODE_GENERIC				/* anything else; decoded a bit at a time */
+};
+
+
+
+/***************************************************************************
+    TYPE DEFINITIONS
+***************************************************************************/
+
+/* one band of scanlines from a sprite list, drawn by a single work item */
+typedef struct _sprite_band sprite_band;
+struct _sprite_band
+{
+	mame_bitmap *		dest;				/* destination bitmap */
+	rectangle			clip;				/* scanlines covered by this band */
+	const gfx_sprite *	list;				/* the full sprite list */
+	const UINT32 *		index;				/* indexes of the sprites touching this band, in order */
+	UINT32				count;				/* number of sprites touching this band */
+	int					transparency;		/* transparency mode for the whole list */
+	int					transparent_color;	/* transparent color for the whole list */
+	mame_bitmap *		pri_buffer;			/* priority bitmap, or NULL */
+	UINT32				pri_or;				/* bits to OR into each sprite's priority mask */
+};
+
 
 
 /***************************************************************************
@@ -42,8 +82,24 @@ UINT8 gfx_alpharange_table[256];
 
 static UINT8 is_raw[TRANSPARENCY_MODES];
 
+/* 8 pixels of one plane, expanded to a 0 or 1 in each byte */
+static UINT64 planar_expand[256];
+
 alpha_cache drawgfx_alpha_cache;
 
+static osd_work_queue *sprite_queue;
+static UINT32 *sprite_index;
+static UINT32 sprite_index_size;
+
+
+
+/***************************************************************************
+    FUNCTION PROTOTYPES
+***************************************************************************/
+
+static void drawgfx_exit(running_machine *machine);
+static void *sprite_band_draw(void *param, int threadid);
+
 
 
 /***************************************************************************
@@ -95,6 +151,8 @@ INLINE int readbit(const UINT8 *src, unsigned int bitnum)
 
 void drawgfx_init(running_machine *machine)
 {
+	int bits, pixel;
+
 	/* fill in the raw drawing mode table */
 	is_raw[TRANSPARENCY_NONE_RAW]      = 1;
 	is_raw[TRANSPARENCY_PEN_RAW]       = 1;
@@ -104,6 +162,33 @@ void drawgfx_init(running_machine *machine)
 
 	/* initialize the alpha drawing table */
 	alpha_set_level(255);
+
+	/* build the planar expansion table; leftmost pixel is the high bit */
+	for (bits = 0; bits < 256; bits++)
+		for (pixel = 0; pixel < 8; pixel++)
+			((UINT8 *)&planar_expand[bits])[pixel] = (bits >> (7 - pixel)) & 1;
+
+	/* large sprite lists are drawn in bands on a work queue */
+	sprite_queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI | WORK_QUEUE_FLAG_HIGH_FREQ);
+	sprite_index = NULL;
+	sprite_index_size = 0;
+	add_exit_callback(machine, drawgfx_exit);
+}
+
+
+/*-------------------------------------------------
+    drawgfx_exit - free the sprite list state
+-------------------------------------------------*/
+
+static void drawgfx_exit(running_machine *machine)
+{
+	if (sprite_queue != NULL)
+		osd_work_queue_free(sprite_queue);
+	sprite_queue = NULL;
+	if (sprite_index != NULL)
+		free(sprite_index);
+	sprite_index = NULL;
+	sprite_index_size = 0;
 }
 
 
@@ -157,22 +242,116 @@ static void calc_penusage(gfx_element *gfx, int num)
 
 
 /*-------------------------------------------------
-    decodechar - decode a single character based
-    on a specified layout
+    classify_layout - determine which decoder
+    can handle a given layout
 -------------------------------------------------*/
 
-void decodechar(gfx_element *gfx, int num, const UINT8 *src, const gfx_layout *gl)
+static int classify_layout(const gfx_element *gfx, const gfx_layout *gl)
+{
+	const UINT32 *xoffset = gl->extxoffs ? gl->extxoffs : gl->xoffset;
+	const UINT32 *yoffset = gl->extyoffs ? gl->extyoffs : gl->yoffset;
+	int plane, x, y;
+
+	/* packed elements and non-standard modulos always go the slow way */
+	if ((gfx->flags & GFX_ELEMENT_PACKED) || gfx->line_modulo != gfx->width)
+		return DECODE_GENERIC;
+
+	/* chunky layouts have 4 or 8 adjacent plane bits per pixel, aligned to a whole pixel */
+	if (gl->planes == 4 || gl->planes == 8)
+	{
+		int aligned = (gl->charincrement % gl->planes == 0 && gl->planeoffset[0] % gl->planes == 0);
+
+		for (plane = 1; plane < gl->planes; plane++)
+			if (gl->planeoffset[plane] != gl->planeoffset[0] + plane)
+				aligned = FALSE;
+		for (x = 0; x < gfx->width; x++)
+			if (xoffset[x] % gl->planes != 0)
+				aligned = FALSE;
+		for (y = 0; y < gfx->height; y++)
+			if (yoffset[y] % gl->planes != 0)
+				aligned = FALSE;
+		if (aligned)
+			return DECODE_CHUNKY;
+	}
+
+	/* planar layouts have each row of each plane in byte-aligned runs of 8 pixels */
+	if (gfx->width % 8 != 0 || gl->charincrement % 8 != 0)
+		return DECODE_GENERIC;
+	for (plane = 0; plane < gl->planes; plane++)
+		if (gl->planeoffset[plane] % 8 != 0)
+			return DECODE_GENERIC;
+	for (y = 0; y < gfx->height; y++)
+		if (yoffset[y] % 8 != 0)
+			return DECODE_GENERIC;
+	for (x = 0; x < gfx->width; x++)
+		if (xoffset[x] != xoffset[x & ~7] + (x & 7) || xoffset[x & ~7] % 8 != 0)
+			return DECODE_GENERIC;
+	return DECODE_PLANAR;
+}
+
+
+/*-------------------------------------------------
+    decodechar_class - decode a single character
+    using the decoder for the layout's class
+-------------------------------------------------*/
+
+static void decodechar_class(gfx_element *gfx, int num, const UINT8 *src, const gfx_layout *gl, int layoutclass)
 {
 	const UINT32 *xoffset = gl->extxoffs ? gl->extxoffs : gl->xoffset;
 	const UINT32 *yoffset = gl->extyoffs ? gl->extyoffs : gl->yoffset;
 	UINT8 *dp = gfx->gfxdata + num * gfx->char_modulo;
 	int plane, x, y;
 
+	/* chunky case: every pixel is a whole nibble or byte, so no need to clear first */
+	if (layoutclass == DECODE_CHUNKY)
+	{
+		for (y = 0; y < gfx->height; y++)
+		{
+			int yoffs = num * gl->charincrement + gl->planeoffset[0] + yoffset[y];
+
+			dp = gfx->gfxdata + num * gfx->char_modulo + y * gfx->line_modulo;
+			if (gl->planes == 8)
+			{
+				for (x = 0; x < gfx->width; x++)
+					dp[x] = src[(yoffs + xoffset[x]) / 8];
+			}
+			else
+			{
+				for (x = 0; x < gfx->width; x++)
+				{
+					int bitnum = yoffs + xoffset[x];
+					dp[x] = (src[bitnum / 8] >> (~bitnum & 4)) & 0x0f;
+				}
+			}
+		}
+		calc_penusage(gfx, num);
+		return;
+	}
+
 	/* zap the data to 0 */
 	memset(dp, 0, gfx->char_modulo);
 
+	/* planar case: expand 8 pixels of a plane at a time */
+	if (layoutclass == DECODE_PLANAR)
+	{
+		for (plane = 0; plane < gl->planes; plane++)
+		{
+			int planebit = 1 << (gl->planes - 1 - plane);
+			int planeoffs = num * gl->charincrement + gl->planeoffset[plane];
+
+			for (y = 0; y < gfx->height; y++)
+			{
+				int yoffs = planeoffs + yoffset[y];
+
+				dp = gfx->gfxdata + num * gfx->char_modulo + y * gfx->line_modulo;
+				for (x = 0; x < gfx->width; x += 8)
+					*(UINT64 *)&dp[x] |= planar_expand[src[(yoffs + xoffset[x]) / 8]] * planebit;
+			}
+		}
+	}
+
 	/* packed case */
-	if (gfx->flags & GFX_ELEMENT_PACKED)
+	else if (gfx->flags & GFX_ELEMENT_PACKED)
 	{
 		for (plane = 0; plane < gl->planes; plane++)
 		{
@@ -220,6 +399,17 @@ void decodechar(gfx_element *gfx, int num, const UINT8 *src, const gfx_layout *g
 }
 
 
+/*-------------------------------------------------
+    decodechar - decode a single character based
+    on a specified layout
+-------------------------------------------------*/
+
+void decodechar(gfx_element *gfx, int num, const UINT8 *src, const gfx_layout *gl)
+{
+	decodechar_class(gfx, num, src, gl, classify_layout(gfx, gl));
+}
+
+
 
 /***************************************************************************
     GRAPHICS SETS
@@ -320,8 +510,10 @@ void decodegfx(gfx_element *gfx, const UINT8 *src, UINT32 first, UINT32 count)
 	/* otherwise, we get to manually decode */
 	else
 	{
+		int layoutclass = classify_layout(gfx, &gfx->layout);
+
 		for (c = first; c <= last; c++)
-			decodechar(gfx, c, src, &gfx->layout);
+			decodechar_class(gfx, c, src, &gfx->layout, layoutclass);
 	}
 }
 
@@ -681,6 +873,8 @@ int pdrawgfx_shadow_lowpri = 0;
 	blockmove_##function##_pri##8 args
 #define BLOCKMOVERAWPRI(function,args) \
 	blockmove_##function##_raw_pri##8 args
+#define BLOCKMOVESIMD(args) \
+	(FALSE)
 #include "drawgfx.c"
 #undef DECLARE
 #undef DECLARE_SWAP_RAW_PRI
@@ -690,6 +884,7 @@ int pdrawgfx_shadow_lowpri = 0;
 #undef BLOCKMOVERAW
 #undef BLOCKMOVEPRI
 #undef BLOCKMOVERAWPRI
+#undef BLOCKMOVESIMD
 
 #undef DEPTH
 #undef DATA_TYPE
@@ -774,6 +969,8 @@ int pdrawgfx_shadow_lowpri = 0;
 	blockmove_##function##_pri##16 args
 #define BLOCKMOVERAWPRI(function,args) \
 	blockmove_##function##_raw_pri##16 args
+#define BLOCKMOVESIMD(args) \
+	gfxsimd_blockmove16 args
 #include "drawgfx.c"
 #undef DECLARE
 #undef DECLARE_SWAP_RAW_PRI
@@ -783,6 +980,7 @@ int pdrawgfx_shadow_lowpri = 0;
 #undef BLOCKMOVERAW
 #undef BLOCKMOVEPRI
 #undef BLOCKMOVERAWPRI
+#undef BLOCKMOVESIMD
 
 #undef DEPTH
 #undef DATA_TYPE
@@ -874,6 +1072,8 @@ INLINE UINT32 SHADOW32(pen_t *shadow_table, UINT32 c) {
 	blockmove_##function##_pri##32 args
 #define BLOCKMOVERAWPRI(function,args) \
 	blockmove_##function##_raw_pri##32 args
+#define BLOCKMOVESIMD(args) \
+	gfxsimd_blockmove32 args
 #include "drawgfx.c"
 #undef DECLARE
 #undef DECLARE_SWAP_RAW_PRI
@@ -883,6 +1083,7 @@ INLINE UINT32 SHADOW32(pen_t *shadow_table, UINT32 c) {
 #undef BLOCKMOVERAW
 #undef BLOCKMOVEPRI
 #undef BLOCKMOVERAWPRI
+#undef BLOCKMOVESIMD
 
 #undef DEPTH
 #undef DATA_TYPE
@@ -3340,6 +3541,135 @@ void mdrawgfxzoom( mame_bitmap *dest_bmp,const gfx_element *gfx,
 }
 
 
+/*-------------------------------------------------
+    drawgfx_sprite_list - draw a list of sprites
+    in order, as if by a series of drawgfxzoom
+    (or pdrawgfxzoom with DRAWGFX_LIST_PRIORITY)
+    calls; the list is culled and clipped once,
+    then split into bands of scanlines which may
+    be drawn on worker threads
+-------------------------------------------------*/
+
+void drawgfx_sprite_list(mame_bitmap *dest, const rectangle *clip, const gfx_sprite *list, int count,
+		int transparency, int transparent_color, UINT32 flags)
+{
+	sprite_band band[SPRITE_LIST_MAX_BANDS];
+	UINT32 bandstart[SPRITE_LIST_MAX_BANDS];
+	rectangle myclip;
+	int numbands = 1;
+	int rows, bandnum, spritenum;
+	UINT32 total;
+
+	profiler_mark(PROFILER_DRAWGFX);
+
+	/* clip to the bitmap */
+	myclip.min_x = 0;
+	myclip.max_x = dest->width - 1;
+	myclip.min_y = 0;
+	myclip.max_y = dest->height - 1;
+	if (clip != NULL)
+		sect_rect(&myclip, clip);
+	if (count <= 0 || myclip.min_x > myclip.max_x || myclip.min_y > myclip.max_y)
+	{
+		profiler_mark(PROFILER_END);
+		return;
+	}
+
+	/* only go wide when every band can be drawn independently; the pen table */
+	/* modes temporarily change afterdrawmask, which is shared */
+	rows = myclip.max_y - myclip.min_y + 1;
+	if ((flags & DRAWGFX_LIST_THREADED) && sprite_queue != NULL && count >= SPRITE_LIST_MIN_THREADED &&
+			transparency != TRANSPARENCY_PEN_TABLE && transparency != TRANSPARENCY_PEN_TABLE_RAW)
+		numbands = MAX(1, MIN(SPRITE_LIST_MAX_BANDS, rows / SPRITE_LIST_MIN_ROWS));
+
+	/* make sure there is room for every sprite to touch every band */
+	if (sprite_index_size < count * numbands)
+	{
+		if (sprite_index != NULL)
+			free(sprite_index);
+		sprite_index_size = count * numbands;
+		sprite_index = malloc_or_die(sprite_index_size * sizeof(sprite_index[0]));
+	}
+
+	/* set up the bands */
+	for (bandnum = 0; bandnum < numbands; bandnum++)
+	{
+		band[bandnum].dest = dest;
+		band[bandnum].clip = myclip;
+		band[bandnum].clip.min_y = myclip.min_y + rows * bandnum / numbands;
+		band[bandnum].clip.max_y = myclip.min_y + rows * (bandnum + 1) / numbands - 1;
+		band[bandnum].list = list;
+		band[bandnum].count = 0;
+		band[bandnum].transparency = transparency;
+		band[bandnum].transparent_color = transparent_color;
+		band[bandnum].pri_buffer = (flags & DRAWGFX_LIST_PRIORITY) ? priority_bitmap : NULL;
+		band[bandnum].pri_or = (flags & DRAWGFX_LIST_PRIORITY) ? (1 << 31) : 0;
+		bandstart[bandnum] = count * bandnum;
+	}
+
+	/* cull each sprite once and file it with every band it touches, keeping the list order */
+	for (spritenum = 0; spritenum < count; spritenum++)
+	{
+		const gfx_sprite *sprite = &list[spritenum];
+		int width, height, miny, maxy;
+
+		if (sprite->scalex == 0 || sprite->scaley == 0)
+			continue;
+		width = (sprite->scalex == 0x10000) ? sprite->gfx->width : ((sprite->scalex * sprite->gfx->width + 0x8000) >> 16);
+		height = (sprite->scaley == 0x10000) ? sprite->gfx->height : ((sprite->scaley * sprite->gfx->height + 0x8000) >> 16);
+		if (width == 0 || height == 0 || sprite->sx > myclip.max_x || sprite->sx + width - 1 < myclip.min_x)
+			continue;
+		miny = MAX(sprite->sy, myclip.min_y);
+		maxy = MIN(sprite->sy + height - 1, myclip.max_y);
+
+		for (bandnum = 0; bandnum < numbands; bandnum++)
+			if (miny <= band[bandnum].clip.max_y && maxy >= band[bandnum].clip.min_y)
+				sprite_index[bandstart[bandnum] + band[bandnum].count++] = spritenum;
+	}
+
+	/* draw the bands */
+	total = 0;
+	for (bandnum = 0; bandnum < numbands; bandnum++)
+	{
+		band[bandnum].index = &sprite_index[bandstart[bandnum]];
+		total += band[bandnum].count;
+	}
+	if (numbands == 1)
+		sprite_band_draw(&band[0], 0);
+	else if (total > 0)
+	{
+		/* the bands live on our stack, so we can't return while they run */
+		osd_work_item_queue_multiple(sprite_queue, sprite_band_draw, numbands, band, sizeof(band[0]), WORK_ITEM_FLAG_AUTO_RELEASE);
+		if (!osd_work_queue_wait(sprite_queue, 100 * osd_ticks_per_second()))
+			fatalerror("drawgfx_sprite_list: sprite bands never completed");
+	}
+
+	profiler_mark(PROFILER_END);
+}
+
+
+/*-------------------------------------------------
+    sprite_band_draw - draw the sprites touching
+    one band, clipped to it
+-------------------------------------------------*/
+
+static void *sprite_band_draw(void *param, int threadid)
+{
+	sprite_band *band = param;
+	UINT32 entry;
+
+	for (entry = 0; entry < band->count; entry++)
+	{
+		const gfx_sprite *sprite = &band->list[band->index[entry]];
+
+		common_drawgfxzoom(band->dest, sprite->gfx, sprite->code, sprite->color, sprite->flipx, sprite->flipy, sprite->sx, sprite->sy,
+				&band->clip, band->transparency, band->transparent_color, sprite->scalex, sprite->scaley,
+				band->pri_buffer, sprite->pri_mask | band->pri_or);
+	}
+	return NULL;
+}
+
+
 #else /* DECLARE */
 
 /* -------------------- included inline section --------------------- */
@@ -4991,7 +5321,7 @@ DECLARE(drawgfx_core,(
 					else
 						BLOCKMOVELU(4toN_opaque,(sd,sw,sh,sm,ls,ts,flipx,flipy,dd,dw,dh,dm,paldata));
 				}
-				else
+				else if (!BLOCKMOVESIMD((sd,sw,sh,sm,ls,ts,flipx,flipy,dd,dw,dh,dm,paldata,0,pribuf,pri_mask,-1,afterdrawmask)))
 				{
 					if (pribuf)
 						BLOCKMOVEPRI(8toN_opaque,(sd,sw,sh,sm,ls,ts,flipx,flipy,dd,dw,dh,dm,paldata,pribuf,pri_mask));
@@ -5008,7 +5338,7 @@ DECLARE(drawgfx_core,(
 					else
 						BLOCKMOVERAW(4toN_opaque,(sd,sw,sh,sm,ls,ts,flipx,flipy,dd,dw,dh,dm,color));
 				}
-				else
+				else if (!BLOCKMOVESIMD((sd,sw,sh,sm,ls,ts,flipx,flipy,dd,dw,dh,dm,NULL,color,pribuf,pri_mask,-1,afterdrawmask)))
 				{
 					if (pribuf)
 						BLOCKMOVERAWPRI(8toN_opaque,(sd,sw,sh,sm,ls,ts,flipx,flipy,dd,dw,dh,dm,color,pribuf,pri_mask));
@@ -5025,7 +5355,7 @@ DECLARE(drawgfx_core,(
 					else
 						BLOCKMOVELU(4toN_transpen,(sd,sw,sh,sm,ls,ts,flipx,flipy,dd,dw,dh,dm,paldata,transparent_color));
 				}
-				else
+				else if (!BLOCKMOVESIMD((sd,sw,sh,sm,ls,ts,flipx,flipy,dd,dw,dh,dm,paldata,0,pribuf,pri_mask,transparent_color,afterdrawmask)))
 				{
 					if (pribuf)
 						BLOCKMOVEPRI(8toN_transpen,(sd,sw,sh,sm,ls,ts,flipx,flipy,dd,dw,dh,dm,paldata,pribuf,pri_mask,transparent_color));
@@ -5042,7 +5372,7 @@ DECLARE(drawgfx_core,(
 					else
 						BLOCKMOVERAW(4toN_transpen,(sd,sw,sh,sm,ls,ts,flipx,flipy,dd,dw,dh,dm,color,transparent_color));
 				}
-				else
+				else if (!BLOCKMOVESIMD((sd,sw,sh,sm,ls,ts,flipx,flipy,dd,dw,dh,dm,NULL,color,pribuf,pri_mask,transparent_color,afterdrawmask)))
 				{
 					if (pribuf)
 						BLOCKMOVERAWPRI(8toN_transpen,(sd,sw,sh,sm,ls,ts,flipx,flipy,dd,dw,dh,dm,color,pribuf,pri_mask,transparent_color));
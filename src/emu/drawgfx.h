@@ -32,6 +32,9 @@
 #define GFX_ELEMENT_PACKED		1	/* two 4bpp pixels are packed in one byte of gfxdata */
 #define GFX_ELEMENT_DONT_FREE	2	/* gfxdata was not malloc()ed, so don't free it on exit */
 
+#define DRAWGFX_LIST_PRIORITY	0x01	/* drawgfx_sprite_list: draw against priority_bitmap like pdrawgfx */
+#define DRAWGFX_LIST_THREADED	0x02	/* drawgfx_sprite_list: bands may be drawn on worker threads */
+
 #define GFX_RAW 				0x12345678
 /* When planeoffset[0] is set to GFX_RAW, the gfx data is left as-is, with no conversion.
    No buffer is allocated for the decoded data, and gfxdata is set to point to the source
@@ -161,6 +164,23 @@ struct _gfx_decode_entry
 };
 
 
+/* one entry in a list passed to drawgfx_sprite_list */
+typedef struct _gfx_sprite gfx_sprite;
+struct _gfx_sprite
+{
+	const gfx_element *gfx;				/* graphics element set to draw from */
+	UINT32			code;				/* element code */
+	UINT32			color;				/* color code */
+	UINT8			flipx;				/* non-zero to flip horizontally */
+	UINT8			flipy;				/* non-zero to flip vertically */
+	INT32			sx;					/* left edge in the destination */
+	INT32			sy;					/* top edge in the destination */
+	UINT32			scalex;				/* 16.16 horizontal scale; 0x10000 for none */
+	UINT32			scaley;				/* 16.16 vertical scale; 0x10000 for none */
+	UINT32			pri_mask;			/* priority mask, with DRAWGFX_LIST_PRIORITY */
+};
+
+
 typedef struct _alpha_cache alpha_cache;
 struct _alpha_cache
 {
@@ -224,6 +244,9 @@ void mdrawgfxzoom( mame_bitmap *dest_bmp,const gfx_element *gfx,
 		const rectangle *clip,int transparency,int transparent_color,int scalex,int scaley,
 		UINT32 priority_mask);
 
+void drawgfx_sprite_list(mame_bitmap *dest, const rectangle *clip, const gfx_sprite *list, int count,
+		int transparency, int transparent_color, UINT32 flags);
+
 
 void draw_scanline8(mame_bitmap *bitmap,int x,int y,int length,const UINT8 *src,const pen_t *pens,int transparent_pen);
 void draw_scanline16(mame_bitmap *bitmap,int x,int y,int length,const UINT16 *src,const pen_t *pens,int transparent_pen);
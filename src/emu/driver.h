@@ -296,6 +296,10 @@ struct _game_driver
 	if (cpu)															\
 		cpu->reset_param = &(config);									\
 
+#define MDRV_CPU_GROUP(_group)											\
+	if (cpu)															\
+		cpu->group = (_group);											\
+
 #define MDRV_CPU_PROGRAM_MAP(readmem, writemem)							\
 	if (cpu)															\
 	{																	\
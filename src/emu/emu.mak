@@ -212,7 +212,8 @@ $(LIBSOUND): $(SOUNDOBJS)
 
 $(EMUOBJ)/rendfont.o:	$(EMUOBJ)/uismall.fh
 
-$(EMUOBJ)/video.o:		$(EMUSRC)/rendersw.c
+$(EMUOBJ)/video.o:		$(EMUSRC)/rendersw.c $(EMUSRC)/rendsimd.h
+$(EMUOBJ)/streams.o:	$(EMUSRC)/sndsimd.h
 
 
 
@@ -53,6 +53,7 @@ const options_entry mame_core_options[] =
 	{ "snapshot_directory",          "snap",      0,                 "directory to save screenshots" },
 	{ "diff_directory",              "diff",      0,                 "directory to save hard drive image difference files" },
 	{ "comment_directory",           "comments",  0,                 "directory to save debugger comments" },
+	{ "drc_directory",               "drc",       0,                 "directory to save recompiler caches" },
 
 	/* filename options */
 	{ NULL,                          NULL,        OPTION_HEADER,     "CORE FILENAME OPTIONS" },
@@ -62,6 +63,9 @@ const options_entry mame_core_options[] =
 	{ NULL,                          NULL,        OPTION_HEADER,     "CORE STATE/PLAYBACK OPTIONS" },
 	{ "state",                       NULL,        0,                 "saved state to load" },
 	{ "autosave",                    "0",         OPTION_BOOLEAN,    "enable automatic restore at startup, and automatic save at exit time" },
+	{ "state_reference",             NULL,        0,                 "saved state that new states are delta-compressed against" },
+	{ "rewind",                      "0",         0,                 "number of in-memory states to keep for rewinding; 0 disables" },
+	{ "rewind_interval",             "60",        0,                 "number of frames between rewind states" },
 	{ "playback;pb",                 NULL,        0,                 "playback an input file" },
 	{ "record;rec",                  NULL,        0,                 "record an input file" },
 	{ "mngwrite",                    NULL,        0,                 "optional filename to write a MNG movie of the current session" },
@@ -76,6 +80,7 @@ const options_entry mame_core_options[] =
 	{ "sleep",                       "1",         OPTION_BOOLEAN,    "enable sleeping, which gives time back to other applications when idle" },
 	{ "speed(0.01-100)",             "1.0",       0,                 "controls the speed of gameplay, relative to realtime; smaller numbers are slower" },
 	{ "refreshspeed;rs",             "0",         OPTION_BOOLEAN,    "automatically adjusts the speed of gameplay to keep the refresh rate lower than the screen" },
+	{ "drccache",                    "0",         OPTION_BOOLEAN,    "keep recompiler code analysis between sessions and precompile hot code at startup" },
 
 	/* rotation options */
 	{ NULL,                          NULL,        OPTION_HEADER,     "CORE ROTATION OPTIONS" },
@@ -113,6 +118,7 @@ const options_entry mame_core_options[] =
 	{ "samplerate;sr(1000-1000000)", "48000",     0,                 "set sound output sample rate" },
 	{ "samples",                     "1",         OPTION_BOOLEAN,    "enable the use of external samples if available" },
 	{ "volume;vol",                  "0",         0,                 "sound volume in decibels (-32 min, 0 max)" },
+	{ "resample_sinc",               "0",         OPTION_BOOLEAN,    "resample sound streams through a windowed-sinc filter" },
 
 	/* input options */
 	{ NULL,                          NULL,        OPTION_HEADER,     "CORE INPUT OPTIONS" },
@@ -144,6 +150,7 @@ const options_entry mame_core_options[] =
 	{ "log",                         "0",         OPTION_BOOLEAN,    "generate an error.log file" },
 	{ "verbose;v",                   "0",         OPTION_BOOLEAN,    "display additional diagnostic information" },
 	{ "update_in_pause",             "0",         OPTION_BOOLEAN,    "keep calling video updates while in pause" },
+	{ "timerstats",                  "0",         OPTION_BOOLEAN,    "display per-callback timer insert/fire counts at exit" },
 #ifdef MAME_DEBUG
 	{ "debug;d",                     "1",         OPTION_BOOLEAN,    "enable/disable debugger" },
 	{ "debugscript",                 NULL,        0,                 "script for debugger" },
@@ -157,6 +164,7 @@ const options_entry mame_core_options[] =
 	{ "bios",                        "default",   0,                 "select the system BIOS to use" },
 	{ "cheat;c",                     "0",         OPTION_BOOLEAN,    "enable cheat subsystem" },
 	{ "skip_gameinfo",               "0",         OPTION_BOOLEAN,    "skip displaying the information screen at startup" },
+	{ "chd_cache(0-1024)",           "16",        0,                 "megabytes of hunks to cache per CHD file (raw data for A/V images)" },
 
 	{ NULL }
 };
@@ -54,6 +54,7 @@
 #define OPTION_SNAPSHOT_DIRECTORY	"snapshot_directory"
 #define OPTION_DIFF_DIRECTORY		"diff_directory"
 #define OPTION_COMMENT_DIRECTORY	"comment_directory"
+#define OPTION_DRC_DIRECTORY		"drc_directory"
 
 /* core filename options */
 #define OPTION_CHEAT_FILE			"cheat_file"
@@ -61,6 +62,9 @@
 /* core state/playback options */
 #define OPTION_STATE				"state"
 #define OPTION_AUTOSAVE				"autosave"
+#define OPTION_STATE_REFERENCE		"state_reference"
+#define OPTION_REWIND				"rewind"
+#define OPTION_REWIND_INTERVAL		"rewind_interval"
 #define OPTION_PLAYBACK				"playback"
 #define OPTION_RECORD				"record"
 #define OPTION_MNGWRITE				"mngwrite"
@@ -74,6 +78,7 @@
 #define OPTION_SLEEP				"sleep"
 #define OPTION_SPEED				"speed"
 #define OPTION_REFRESHSPEED			"refreshspeed"
+#define OPTION_DRCCACHE				"drccache"
 
 /* core rotation options */
 #define OPTION_ROTATE				"rotate"
@@ -106,6 +111,7 @@
 #define OPTION_SAMPLERATE			"samplerate"
 #define OPTION_SAMPLES				"samples"
 #define OPTION_VOLUME				"volume"
+#define OPTION_RESAMPLE_SINC		"resample_sinc"
 
 /* core input options */
 #define OPTION_CTRLR				"ctrlr"
@@ -134,11 +140,13 @@
 #define OPTION_DEBUG				"debug"
 #define OPTION_DEBUGSCRIPT			"debugscript"
 #define OPTION_UPDATEINPAUSE		"update_in_pause"
+#define OPTION_TIMERSTATS			"timerstats"
 
 /* core misc options */
 #define OPTION_BIOS					"bios"
 #define OPTION_CHEAT				"cheat"
 #define OPTION_SKIP_GAMEINFO		"skip_gameinfo"
+#define OPTION_CHD_CACHE			"chd_cache"
 
 
 
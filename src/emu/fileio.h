@@ -55,6 +55,7 @@
 #define SEARCHPATH_SCREENSHOT	OPTION_SNAPSHOT_DIRECTORY
 #define SEARCHPATH_MOVIE		OPTION_SNAPSHOT_DIRECTORY
 #define SEARCHPATH_COMMENT		OPTION_COMMENT_DIRECTORY
+#define SEARCHPATH_DRC			OPTION_DRC_DIRECTORY
 
 
 
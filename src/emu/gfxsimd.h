@@ -0,0 +1,611 @@
+/***************************************************************************
+
+    gfxsimd.h
+
+    SIMD blitters for opaque and transparent-pen drawgfx.
+
+    Copyright (c) 1996-2007, Nicola Salmoria and the MAME Team.
+    Visit http://mamedev.org for licensing and usage restrictions.
+
+****************************************************************************
+
+    These cover the blockmove_8toN_opaque and blockmove_8toN_transpen
+    families in drawgfx.c for 16bpp and 32bpp destinations, with and
+    without a priority bitmap, for both the raw and the palette lookup
+    variants. Each row is handled 16 source pixels at a time: the
+    transparency and priority tests produce a bitmask, and the pixels
+    are merged into the destination with a single masked store.
+    Palette lookups are still done one pixel at a time, since SSE2 has
+    no gather. The results match the C blitters exactly.
+
+    SSE2 is the baseline, selected at compile time the same way as in
+    rgbutil.h. The per-pixel priority test and the row reversal for
+    flipped sprites use SSSE3 byte shuffles; these are selected at
+    runtime when the compiler can target them and the CPU supports them.
+
+    Priority drawing is only vectorized while afterdrawmask has its
+    default value of 31; pdrawgfx_shadow modes take the C path.
+
+***************************************************************************/
+
+#ifndef __GFXSIMD_H__
+#define __GFXSIMD_H__
+
+/* use SSE on 64-bit implementations, where it can be assumed */
+#if (defined(__SSE2__) && defined(PTR64))
+#define GFXSIMD_AVAILABLE
+
+#include <emmintrin.h>
+
+/* SSSE3 kernels need per-function target support from the compiler */
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define GFXSIMD_SSSE3
+#include <tmmintrin.h>
+#define SSSE3_FUNC			__attribute__((target("ssse3")))
+#endif
+
+
+
+/***************************************************************************
+    CONSTANTS
+***************************************************************************/
+
+#define GFXSIMD_CHUNK		256			/* source pixels processed per pass */
+#define GFXSIMD_MIN_WIDTH	16			/* narrower blits aren't worth the setup */
+
+
+
+/***************************************************************************
+    TYPE DEFINITIONS
+***************************************************************************/
+
+/* per-blit parameters shared by the row kernels */
+typedef struct _gfxsimd_params gfxsimd_params;
+struct _gfxsimd_params
+{
+	const pen_t *	paldata;			/* palette for lookups, or NULL for raw */
+	UINT32			colorbase;			/* color base for raw drawing */
+	int				transpen;			/* transparent pen, or -1 for opaque */
+	UINT32			pmask;				/* priority mask */
+	const pen_t *	shadow_table;		/* shadow table for 16bpp priority drawing */
+};
+
+
+typedef struct _gfxsimd_ops gfxsimd_ops;
+struct _gfxsimd_ops
+{
+	void		(*pri_pass)(UINT16 *passbits, const UINT8 *pri, int count, UINT32 pmask);
+	void		(*reverse)(UINT8 *dst, const UINT8 *src, int count);
+};
+
+
+
+/***************************************************************************
+    INLINE FUNCTIONS
+***************************************************************************/
+
+/*-------------------------------------------------
+    gfxsimd_byte_mask - expand a 16-bit lane mask
+    into a vector with 0xff in each selected byte
+-------------------------------------------------*/
+
+INLINE __m128i gfxsimd_byte_mask(UINT32 bits)
+{
+	__m128i select = _mm_set_epi8(-128, 64, 32, 16, 8, 4, 2, 1, -128, 64, 32, 16, 8, 4, 2, 1);
+	__m128i spread = _mm_unpacklo_epi64(_mm_set1_epi8((char)(bits & 0xff)), _mm_set1_epi8((char)(bits >> 8)));
+	return _mm_cmpeq_epi8(_mm_and_si128(spread, select), select);
+}
+
+
+/*-------------------------------------------------
+    gfxsimd_select - return value where mask is
+    set and dest elsewhere
+-------------------------------------------------*/
+
+INLINE __m128i gfxsimd_select(__m128i mask, __m128i value, __m128i dest)
+{
+	return _mm_or_si128(_mm_and_si128(mask, value), _mm_andnot_si128(mask, dest));
+}
+
+
+/*-------------------------------------------------
+    gfxsimd_value - return the color for a single
+    source pixel
+-------------------------------------------------*/
+
+INLINE UINT32 gfxsimd_value(const gfxsimd_params *params, UINT8 col)
+{
+	return (params->paldata != NULL) ? params->paldata[col] : params->colorbase + col;
+}
+
+
+
+/***************************************************************************
+    C ROW OPERATIONS
+***************************************************************************/
+
+/*
+    These handle the tail of each row that doesn't fill a full vector,
+    and define the exact results the vector versions must reproduce.
+*/
+
+static void gfxsimd_row16_c(UINT16 *dest, UINT8 *pri, const UINT8 *src, int count, const gfxsimd_params *params)
+{
+	int x;
+
+	for (x = 0; x < count; x++)
+	{
+		UINT8 col = src[x];
+		UINT32 value;
+
+		if (col == params->transpen)
+			continue;
+		value = gfxsimd_value(params, col);
+		if (pri == NULL)
+			dest[x] = value;
+		else
+		{
+			if (((params->pmask >> (pri[x] & 0x1f)) & 1) == 0)
+				dest[x] = (pri[x] & 0x80) ? params->shadow_table[value] : value;
+			pri[x] = (pri[x] & 0x7f) | 31;
+		}
+	}
+}
+
+
+static void gfxsimd_row32_c(UINT32 *dest, UINT8 *pri, const UINT8 *src, int count, const gfxsimd_params *params)
+{
+	int x;
+
+	for (x = 0; x < count; x++)
+	{
+		UINT8 col = src[x];
+		UINT32 value;
+
+		if (col == params->transpen)
+			continue;
+		value = gfxsimd_value(params, col);
+		if (pri == NULL)
+			dest[x] = value;
+		else if (((params->pmask >> (pri[x] & 0x1f)) & 1) == 0)
+		{
+			dest[x] = value;
+			pri[x] = (pri[x] & 0x7f) | 0x1f;
+		}
+	}
+}
+
+
+static void gfxsimd_pri_pass_c(UINT16 *passbits, const UINT8 *pri, int count, UINT32 pmask)
+{
+	int x, lane;
+
+	for (x = 0; x + 16 <= count; x += 16)
+	{
+		UINT32 bits = 0;
+
+		for (lane = 0; lane < 16; lane++)
+			if (((pmask >> (pri[x + lane] & 0x1f)) & 1) == 0)
+				bits |= 1 << lane;
+		passbits[x / 16] = bits;
+	}
+}
+
+
+static void gfxsimd_reverse_c(UINT8 *dst, const UINT8 *src, int count)
+{
+	int x;
+
+	for (x = 0; x < count; x++)
+		dst[x] = src[count - 1 - x];
+}
+
+
+static const gfxsimd_ops gfxsimd_sse2_ops =
+{
+	gfxsimd_pri_pass_c,
+	gfxsimd_reverse_c
+};
+
+
+
+/***************************************************************************
+    SSE2 ROW OPERATIONS
+***************************************************************************/
+
+/*-------------------------------------------------
+    gfxsimd_row16_sse2 - draw one row of 8bpp
+    source pixels to a 16bpp destination
+-------------------------------------------------*/
+
+static void gfxsimd_row16_sse2(UINT16 *dest, UINT8 *pri, const UINT8 *src, const UINT16 *passbits, int count, const gfxsimd_params *params)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i transvec = _mm_set1_epi8((char)params->transpen);
+	__m128i basevec = _mm_set1_epi16((short)params->colorbase);
+	__m128i primask = _mm_set1_epi8(0x7f);
+	__m128i prifill = _mm_set1_epi8(0x1f);
+	int x;
+
+	for (x = 0; x + 16 <= count; x += 16)
+	{
+		__m128i pix = _mm_loadu_si128((const __m128i *)&src[x]);
+		UINT32 draw = 0xffff, write, shadow = 0;
+		__m128i lo, hi, prival = zero;
+
+		/* find the opaque pixels */
+		if (params->transpen >= 0)
+			draw = ~_mm_movemask_epi8(_mm_cmpeq_epi8(pix, transvec)) & 0xffff;
+		if (draw == 0)
+			continue;
+
+		/* apply the priority test; shadowed pixels are fixed up afterwards */
+		write = draw;
+		if (pri != NULL)
+		{
+			prival = _mm_loadu_si128((const __m128i *)&pri[x]);
+			write &= passbits[x / 16];
+			shadow = write & _mm_movemask_epi8(prival);
+		}
+
+		/* compute the colors */
+		if (params->paldata == NULL)
+		{
+			lo = _mm_add_epi16(_mm_unpacklo_epi8(pix, zero), basevec);
+			hi = _mm_add_epi16(_mm_unpackhi_epi8(pix, zero), basevec);
+		}
+		else
+		{
+			const UINT8 *s = &src[x];
+			const pen_t *pal = params->paldata;
+
+			lo = _mm_set_epi16(pal[s[7]], pal[s[6]], pal[s[5]], pal[s[4]], pal[s[3]], pal[s[2]], pal[s[1]], pal[s[0]]);
+			hi = _mm_set_epi16(pal[s[15]], pal[s[14]], pal[s[13]], pal[s[12]], pal[s[11]], pal[s[10]], pal[s[9]], pal[s[8]]);
+		}
+
+		/* merge them into the destination */
+		if ((write & ~shadow) == 0xffff)
+		{
+			_mm_storeu_si128((__m128i *)&dest[x + 0], lo);
+			_mm_storeu_si128((__m128i *)&dest[x + 8], hi);
+		}
+		else if ((write & ~shadow) != 0)
+		{
+			__m128i mask = gfxsimd_byte_mask(write & ~shadow);
+			__m128i destlo = _mm_loadu_si128((const __m128i *)&dest[x + 0]);
+			__m128i desthi = _mm_loadu_si128((const __m128i *)&dest[x + 8]);
+			_mm_storeu_si128((__m128i *)&dest[x + 0], gfxsimd_select(_mm_unpacklo_epi8(mask, mask), lo, destlo));
+			_mm_storeu_si128((__m128i *)&dest[x + 8], gfxsimd_select(_mm_unpackhi_epi8(mask, mask), hi, desthi));
+		}
+
+		/* update the priority of every opaque pixel */
+		if (pri != NULL)
+		{
+			__m128i newpri = _mm_or_si128(_mm_and_si128(prival, primask), prifill);
+			_mm_storeu_si128((__m128i *)&pri[x], gfxsimd_select(gfxsimd_byte_mask(draw), newpri, prival));
+
+			while (shadow != 0)
+			{
+				int lane = 31 - count_leading_zeros(shadow & (~shadow + 1));
+				dest[x + lane] = params->shadow_table[gfxsimd_value(params, src[x + lane])];
+				shadow &= shadow - 1;
+			}
+		}
+	}
+	gfxsimd_row16_c(&dest[x], (pri != NULL) ? &pri[x] : NULL, &src[x], count - x, params);
+}
+
+
+/*-------------------------------------------------
+    gfxsimd_row32_sse2 - draw one row of 8bpp
+    source pixels to a 32bpp destination
+-------------------------------------------------*/
+
+static void gfxsimd_row32_sse2(UINT32 *dest, UINT8 *pri, const UINT8 *src, const UINT16 *passbits, int count, const gfxsimd_params *params)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i transvec = _mm_set1_epi8((char)params->transpen);
+	__m128i basevec = _mm_set1_epi32(params->colorbase);
+	__m128i primask = _mm_set1_epi8(0x7f);
+	__m128i prifill = _mm_set1_epi8(0x1f);
+	int x;
+
+	for (x = 0; x + 16 <= count; x += 16)
+	{
+		__m128i pix = _mm_loadu_si128((const __m128i *)&src[x]);
+		UINT32 write = 0xffff;
+		__m128i val[4], prival = zero;
+		int quad;
+
+		/* find the opaque pixels that pass the priority test */
+		if (params->transpen >= 0)
+			write = ~_mm_movemask_epi8(_mm_cmpeq_epi8(pix, transvec)) & 0xffff;
+		if (pri != NULL)
+		{
+			prival = _mm_loadu_si128((const __m128i *)&pri[x]);
+			write &= passbits[x / 16];
+		}
+		if (write == 0)
+			continue;
+
+		/* compute the colors */
+		if (params->paldata == NULL)
+		{
+			__m128i lo = _mm_unpacklo_epi8(pix, zero);
+			__m128i hi = _mm_unpackhi_epi8(pix, zero);
+			val[0] = _mm_add_epi32(_mm_unpacklo_epi16(lo, zero), basevec);
+			val[1] = _mm_add_epi32(_mm_unpackhi_epi16(lo, zero), basevec);
+			val[2] = _mm_add_epi32(_mm_unpacklo_epi16(hi, zero), basevec);
+			val[3] = _mm_add_epi32(_mm_unpackhi_epi16(hi, zero), basevec);
+		}
+		else
+		{
+			const UINT8 *s = &src[x];
+			const pen_t *pal = params->paldata;
+
+			for (quad = 0; quad < 4; quad++, s += 4)
+				val[quad] = _mm_set_epi32(pal[s[3]], pal[s[2]], pal[s[1]], pal[s[0]]);
+		}
+
+		/* merge them into the destination */
+		if (write == 0xffff)
+		{
+			for (quad = 0; quad < 4; quad++)
+				_mm_storeu_si128((__m128i *)&dest[x + quad * 4], val[quad]);
+		}
+		else
+		{
+			__m128i mask = gfxsimd_byte_mask(write);
+			__m128i mask16[2];
+
+			mask16[0] = _mm_unpacklo_epi8(mask, mask);
+			mask16[1] = _mm_unpackhi_epi8(mask, mask);
+			for (quad = 0; quad < 4; quad++)
+			{
+				__m128i mask32 = (quad & 1) ? _mm_unpackhi_epi16(mask16[quad / 2], mask16[quad / 2]) : _mm_unpacklo_epi16(mask16[quad / 2], mask16[quad / 2]);
+				__m128i destval = _mm_loadu_si128((const __m128i *)&dest[x + quad * 4]);
+				_mm_storeu_si128((__m128i *)&dest[x + quad * 4], gfxsimd_select(mask32, val[quad], destval));
+			}
+		}
+
+		/* update the priority of every pixel drawn */
+		if (pri != NULL)
+		{
+			__m128i newpri = _mm_or_si128(_mm_and_si128(prival, primask), prifill);
+			_mm_storeu_si128((__m128i *)&pri[x], gfxsimd_select(gfxsimd_byte_mask(write), newpri, prival));
+		}
+	}
+	gfxsimd_row32_c(&dest[x], (pri != NULL) ? &pri[x] : NULL, &src[x], count - x, params);
+}
+
+
+
+/***************************************************************************
+    SSSE3 ROW OPERATIONS
+***************************************************************************/
+
+#ifdef GFXSIMD_SSSE3
+
+/*-------------------------------------------------
+    gfxsimd_pri_pass_ssse3 - look up the priority
+    mask bit for 16 pixels at a time with a pair
+    of byte shuffles
+-------------------------------------------------*/
+
+static SSSE3_FUNC void gfxsimd_pri_pass_ssse3(UINT16 *passbits, const UINT8 *pri, int count, UINT32 pmask)
+{
+	UINT8 table[32];
+	__m128i lotable, hitable;
+	__m128i lowbits = _mm_set1_epi8(0x0f);
+	__m128i highbit = _mm_set1_epi8(0x10);
+	int x, bit;
+
+	/* each table entry is 0xff if pixels at that priority can be drawn over */
+	for (bit = 0; bit < 32; bit++)
+		table[bit] = ((pmask >> bit) & 1) ? 0x00 : 0xff;
+	lotable = _mm_loadu_si128((const __m128i *)&table[0]);
+	hitable = _mm_loadu_si128((const __m128i *)&table[16]);
+
+	for (x = 0; x + 16 <= count; x += 16)
+	{
+		__m128i prival = _mm_loadu_si128((const __m128i *)&pri[x]);
+		__m128i index = _mm_and_si128(prival, lowbits);
+		__m128i upper = _mm_cmpeq_epi8(_mm_and_si128(prival, highbit), highbit);
+		__m128i pass = gfxsimd_select(upper, _mm_shuffle_epi8(hitable, index), _mm_shuffle_epi8(lotable, index));
+		passbits[x / 16] = _mm_movemask_epi8(pass);
+	}
+}
+
+
+/*-------------------------------------------------
+    gfxsimd_reverse_ssse3 - reverse a row of
+    source pixels for horizontally flipped blits
+-------------------------------------------------*/
+
+static SSSE3_FUNC void gfxsimd_reverse_ssse3(UINT8 *dst, const UINT8 *src, int count)
+{
+	__m128i order = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+	int x;
+
+	for (x = 0; x + 16 <= count; x += 16)
+		_mm_storeu_si128((__m128i *)&dst[x], _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&src[count - 16 - x]), order));
+	gfxsimd_reverse_c(&dst[x], src, count - x);
+}
+
+
+static const gfxsimd_ops gfxsimd_ssse3_ops =
+{
+	gfxsimd_pri_pass_ssse3,
+	gfxsimd_reverse_ssse3
+};
+
+#endif /* GFXSIMD_SSSE3 */
+
+
+
+/***************************************************************************
+    DISPATCH
+***************************************************************************/
+
+/*-------------------------------------------------
+    gfxsimd_get_ops - return the best set of
+    row operations for the running CPU
+-------------------------------------------------*/
+
+static const gfxsimd_ops *gfxsimd_get_ops(void)
+{
+	static const gfxsimd_ops *ops;
+
+	/* the choice never changes, so racing threads all store the same value */
+	if (ops == NULL)
+	{
+		const gfxsimd_ops *best = &gfxsimd_sse2_ops;
+#ifdef GFXSIMD_SSSE3
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("ssse3"))
+			best = &gfxsimd_ssse3_ops;
+#endif
+		ops = best;
+	}
+	return ops;
+}
+
+
+/*-------------------------------------------------
+    gfxsimd_blockmove - common implementation of
+    the 16bpp and 32bpp blits; dstdata points to
+    the top-left destination pixel and the source
+    is clipped the same way as in ADJUST_8
+-------------------------------------------------*/
+
+static void gfxsimd_blockmove(const UINT8 *srcdata, int srcwidth, int srcheight, int srcmodulo,
+		int leftskip, int topskip, int flipx, int flipy,
+		void *dstdata, int dstbytes, int dstwidth, int dstheight, int dstmodulo,
+		UINT8 *pridata, const gfxsimd_params *params)
+{
+	const gfxsimd_ops *ops = gfxsimd_get_ops();
+	UINT16 passbits[GFXSIMD_CHUNK / 16];
+	UINT8 buffer[GFXSIMD_CHUNK];
+	int ydir = 1;
+	int x;
+
+	/* find the first source row and walk the destination backwards if flipped */
+	if (flipy)
+	{
+		dstdata = (UINT8 *)dstdata + dstmodulo * (dstheight - 1) * dstbytes;
+		if (pridata != NULL)
+			pridata += dstmodulo * (dstheight - 1);
+		srcdata += (srcheight - dstheight - topskip) * srcmodulo;
+		ydir = -1;
+	}
+	else
+		srcdata += topskip * srcmodulo;
+
+	/* a flipped row reads from the other side of the source */
+	srcdata += flipx ? (srcwidth - dstwidth - leftskip) : leftskip;
+
+	while (dstheight--)
+	{
+		for (x = 0; x < dstwidth; x += GFXSIMD_CHUNK)
+		{
+			int count = MIN(dstwidth - x, GFXSIMD_CHUNK);
+			UINT8 *pri = (pridata != NULL) ? &pridata[x] : NULL;
+			const UINT8 *src = &srcdata[x];
+
+			/* flipped rows are reversed into a buffer so they can be drawn left to right */
+			if (flipx)
+			{
+				ops->reverse(buffer, &srcdata[dstwidth - x - count], count);
+				src = buffer;
+			}
+			if (pri != NULL)
+				ops->pri_pass(passbits, pri, count, params->pmask);
+
+			if (dstbytes == 2)
+				gfxsimd_row16_sse2((UINT16 *)dstdata + x, pri, src, passbits, count, params);
+			else
+				gfxsimd_row32_sse2((UINT32 *)dstdata + x, pri, src, passbits, count, params);
+		}
+
+		srcdata += srcmodulo;
+		dstdata = (UINT8 *)dstdata + ydir * dstmodulo * dstbytes;
+		if (pridata != NULL)
+			pridata += ydir * dstmodulo;
+	}
+}
+
+
+/*-------------------------------------------------
+    gfxsimd_setup - fill in the parameters for a
+    blit; returns FALSE if it must be handled by
+    the C blitters
+-------------------------------------------------*/
+
+INLINE int gfxsimd_setup(gfxsimd_params *params, int dstwidth, const pen_t *paldata, UINT32 colorbase,
+		UINT8 *pridata, UINT32 pmask, int transpen, int afterdrawmask)
+{
+	if (dstwidth < GFXSIMD_MIN_WIDTH || (pridata != NULL && afterdrawmask != 31))
+		return FALSE;
+
+	params->paldata = paldata;
+	params->colorbase = colorbase;
+	params->transpen = (transpen >= 0 && transpen <= 0xff) ? transpen : -1;
+	params->pmask = pmask;
+	params->shadow_table = Machine->shadow_table;
+	return TRUE;
+}
+
+
+/*-------------------------------------------------
+    gfxsimd_blockmove16 - draw an 8bpp element
+    to a 16bpp bitmap, opaque or with a single
+    transparent pen (-1 for none); returns FALSE
+    if not handled
+-------------------------------------------------*/
+
+INLINE int gfxsimd_blockmove16(const UINT8 *srcdata, int srcwidth, int srcheight, int srcmodulo,
+		int leftskip, int topskip, int flipx, int flipy,
+		UINT16 *dstdata, int dstwidth, int dstheight, int dstmodulo,
+		const pen_t *paldata, UINT32 colorbase, UINT8 *pridata, UINT32 pmask, int transpen, int afterdrawmask)
+{
+	gfxsimd_params params;
+
+	if (!gfxsimd_setup(&params, dstwidth, paldata, colorbase, pridata, pmask, transpen, afterdrawmask))
+		return FALSE;
+	gfxsimd_blockmove(srcdata, srcwidth, srcheight, srcmodulo, leftskip, topskip, flipx, flipy,
+			dstdata, 2, dstwidth, dstheight, dstmodulo, pridata, &params);
+	return TRUE;
+}
+
+
+/*-------------------------------------------------
+    gfxsimd_blockmove32 - draw an 8bpp element
+    to a 32bpp bitmap, opaque or with a single
+    transparent pen (-1 for none); returns FALSE
+    if not handled
+-------------------------------------------------*/
+
+INLINE int gfxsimd_blockmove32(const UINT8 *srcdata, int srcwidth, int srcheight, int srcmodulo,
+		int leftskip, int topskip, int flipx, int flipy,
+		UINT32 *dstdata, int dstwidth, int dstheight, int dstmodulo,
+		const pen_t *paldata, UINT32 colorbase, UINT8 *pridata, UINT32 pmask, int transpen, int afterdrawmask)
+{
+	gfxsimd_params params;
+
+	if (!gfxsimd_setup(&params, dstwidth, paldata, colorbase, pridata, pmask, transpen, afterdrawmask))
+		return FALSE;
+	gfxsimd_blockmove(srcdata, srcwidth, srcheight, srcmodulo, leftskip, topskip, flipx, flipy,
+			dstdata, 4, dstwidth, dstheight, dstmodulo, pridata, &params);
+	return TRUE;
+}
+
+
+#else /* !GFXSIMD_AVAILABLE */
+
+/* without SIMD support, everything goes through the C blitters */
+#define gfxsimd_blockmove16(a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p,q,r)	(FALSE)
+#define gfxsimd_blockmove32(a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p,q,r)	(FALSE)
+
+#endif /* GFXSIMD_AVAILABLE */
+
+#endif /* __GFXSIMD_H__ */
@@ -266,6 +266,7 @@ enum
 	IPT_UI_TOGGLE_DEBUG,
 	IPT_UI_SAVE_STATE,
 	IPT_UI_LOAD_STATE,
+	IPT_UI_REWIND,
 	IPT_UI_ADD_CHEAT,
 	IPT_UI_DELETE_CHEAT,
 	IPT_UI_SAVE_CHEAT,
@@ -155,6 +155,11 @@ struct _mame_private
 	/* load/save */
 	void 			(*saveload_schedule_callback)(running_machine *);
 	attotime		saveload_schedule_time;
+	UINT8			state_reference_loaded;
+
+	/* rewind */
+	int				rewind_interval;
+	int				rewind_frames;
 
 	/* array of memory regions */
 	region_info		mem_region[MAX_MEMORY_REGIONS];
@@ -272,6 +277,12 @@ static void free_callback_list(callback_item **cb);
 static void saveload_init(running_machine *machine);
 static void handle_save(running_machine *machine);
 static void handle_load(running_machine *machine);
+static void load_state_reference(running_machine *machine);
+static void save_state_tags(void);
+static void load_state_tags(void);
+static void rewind_frame_callback(running_machine *machine);
+static void handle_rewind_save(running_machine *machine);
+static void handle_rewind_load(running_machine *machine);
 
 static void logfile_callback(running_machine *machine, const char *buffer);
 
@@ -714,6 +725,25 @@ void mame_schedule_load(running_machine *machine, const char *filename)
 }
 
 
+/*-------------------------------------------------
+    mame_schedule_rewind - schedule a restore of
+    the most recent in-memory state
+-------------------------------------------------*/
+
+void mame_schedule_rewind(running_machine *machine)
+{
+	mame_private *mame = machine->mame_data;
+
+	/* a pending file save or load takes precedence */
+	if (mame->saveload_pending_file != NULL)
+		return;
+
+	/* replaces any pending rewind capture */
+	mame->saveload_schedule_callback = handle_rewind_load;
+	mame->saveload_schedule_time = timer_get_time();
+}
+
+
 /*-------------------------------------------------
     mame_is_scheduled_event_pending - is a
     scheduled event pending?
@@ -1657,6 +1687,117 @@ static void saveload_init(running_machine *machine)
 	/* if we're in autosave mode, schedule a load */
 	else if (options_get_bool(mame_options(), OPTION_AUTOSAVE) && (machine->gamedrv->flags & GAME_SUPPORTS_SAVE))
 		mame_schedule_load(machine, "auto");
+
+	/* set up the rewind buffer if requested */
+	if (options_get_int(mame_options(), OPTION_REWIND) > 0 && (machine->gamedrv->flags & GAME_SUPPORTS_SAVE))
+	{
+		mame_private *mame = machine->mame_data;
+
+		state_rewind_init(options_get_int(mame_options(), OPTION_REWIND));
+		mame->rewind_interval = MAX(options_get_int(mame_options(), OPTION_REWIND_INTERVAL), 1);
+		mame->rewind_frames = 0;
+		add_frame_callback(machine, rewind_frame_callback);
+	}
+}
+
+
+/*-------------------------------------------------
+    load_state_reference - load the state that
+    saves are delta-compressed against, the first
+    time it is needed
+-------------------------------------------------*/
+
+static void load_state_reference(running_machine *machine)
+{
+	mame_private *mame = machine->mame_data;
+	const char *reference = options_get_string(mame_options(), OPTION_STATE_REFERENCE);
+	astring *fname;
+	file_error filerr;
+	mame_file *file;
+
+	/* only try once per session */
+	if (mame->state_reference_loaded || reference == NULL || reference[0] == 0)
+		return;
+	mame->state_reference_loaded = TRUE;
+
+	/* open the file and hand it to the state system */
+	fname = astring_assemble_4(astring_alloc(), machine->basename, PATH_SEPARATOR, reference, ".sta");
+	filerr = mame_fopen(SEARCHPATH_STATE, astring_c(fname), OPEN_FLAG_READ, &file);
+	if (filerr == FILERR_NONE)
+	{
+		state_save_set_reference(file);
+		mame_fclose(file);
+	}
+	else
+		popmessage("Error: Failed to open reference state");
+	astring_free(fname);
+}
+
+
+/*-------------------------------------------------
+    save_state_tags - save the default tag and
+    each CPU's tag
+-------------------------------------------------*/
+
+static void save_state_tags(void)
+{
+	int cpunum;
+
+	/* write the default tag */
+	state_save_push_tag(0);
+	state_save_save_continue();
+	state_save_pop_tag();
+
+	/* loop over CPUs */
+	for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
+	{
+		cpuintrf_push_context(cpunum);
+
+		/* make sure banking is set */
+		activecpu_reset_banking();
+
+		/* save the CPU data */
+		state_save_push_tag(cpunum + 1);
+		state_save_save_continue();
+		state_save_pop_tag();
+
+		cpuintrf_pop_context();
+	}
+}
+
+
+/*-------------------------------------------------
+    load_state_tags - load the default tag and
+    each CPU's tag
+-------------------------------------------------*/
+
+static void load_state_tags(void)
+{
+	int cpunum;
+
+	/* read tag 0 */
+	state_save_push_tag(0);
+	state_save_load_continue();
+	state_save_pop_tag();
+
+	/* loop over CPUs */
+	for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
+	{
+		cpuintrf_push_context(cpunum);
+
+		/* make sure banking is set */
+		activecpu_reset_banking();
+
+		/* load the CPU data */
+		state_save_push_tag(cpunum + 1);
+		state_save_load_continue();
+		state_save_pop_tag();
+
+		/* make sure banking is set */
+		activecpu_reset_banking();
+
+		cpuintrf_pop_context();
+	}
 }
 
 
@@ -1689,12 +1830,13 @@ static void handle_save(running_machine *machine)
 		return;
 	}
 
+	/* make sure we have the reference state */
+	load_state_reference(machine);
+
 	/* open the file */
 	filerr = mame_fopen(SEARCHPATH_STATE, astring_c(mame->saveload_pending_file), OPEN_FLAG_WRITE | OPEN_FLAG_CREATE | OPEN_FLAG_CREATE_PATHS, &file);
 	if (filerr == FILERR_NONE)
 	{
-		int cpunum;
-
 		/* write the save state */
 		if (state_save_save_begin(file) != 0)
 		{
@@ -1702,30 +1844,15 @@ static void handle_save(running_machine *machine)
 			mame_fclose(file);
 			goto cancel;
 		}
+		save_state_tags();
 
-		/* write the default tag */
-		state_save_push_tag(0);
-		state_save_save_continue();
-		state_save_pop_tag();
-
-		/* loop over CPUs */
-		for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
+		/* finish and close */
+		if (state_save_save_finish() != 0)
 		{
-			cpuintrf_push_context(cpunum);
-
-			/* make sure banking is set */
-			activecpu_reset_banking();
-
-			/* save the CPU data */
-			state_save_push_tag(cpunum + 1);
-			state_save_save_continue();
-			state_save_pop_tag();
-
-			cpuintrf_pop_context();
+			mame_fclose(file);
+			popmessage("Error: Failed to write state");
+			goto cancel;
 		}
-
-		/* finish and close */
-		state_save_save_finish();
 		mame_fclose(file);
 
 		/* pop a warning if the game doesn't support saves */
@@ -1775,6 +1902,9 @@ static void handle_load(running_machine *machine)
 		return;
 	}
 
+	/* make sure we have the reference state */
+	load_state_reference(machine);
+
 	/* open the file */
 	filerr = mame_fopen(SEARCHPATH_STATE, astring_c(mame->saveload_pending_file), OPEN_FLAG_READ, &file);
 	if (filerr == FILERR_NONE)
@@ -1782,35 +1912,13 @@ static void handle_load(running_machine *machine)
 		/* start loading */
 		if (state_save_load_begin(file) == 0)
 		{
-			int cpunum;
-
-			/* read tag 0 */
-			state_save_push_tag(0);
-			state_save_load_continue();
-			state_save_pop_tag();
-
-			/* loop over CPUs */
-			for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
-			{
-				cpuintrf_push_context(cpunum);
-
-				/* make sure banking is set */
-				activecpu_reset_banking();
-
-				/* load the CPU data */
-				state_save_push_tag(cpunum + 1);
-				state_save_load_continue();
-				state_save_pop_tag();
-
-				/* make sure banking is set */
-				activecpu_reset_banking();
-
-				cpuintrf_pop_context();
-			}
+			load_state_tags();
 
 			/* finish and close */
-			state_save_load_finish();
-			popmessage("State successfully loaded.");
+			if (state_save_load_finish() != 0)
+				popmessage("Error: State file is truncated or corrupt");
+			else
+				popmessage("State successfully loaded.");
 		}
 		else
 			popmessage("Error: Failed to load state");
@@ -1827,6 +1935,92 @@ cancel:
 }
 
 
+/*-------------------------------------------------
+    rewind_frame_callback - schedule a rewind
+    capture every rewind_interval frames
+-------------------------------------------------*/
+
+static void rewind_frame_callback(running_machine *machine)
+{
+	mame_private *mame = machine->mame_data;
+
+	/* don't capture while paused, and don't step on other requests */
+	if (mame->paused || ++mame->rewind_frames < mame->rewind_interval)
+		return;
+	if (mame->saveload_schedule_callback != NULL)
+		return;
+
+	mame->rewind_frames = 0;
+	mame->saveload_schedule_callback = handle_rewind_save;
+	mame->saveload_schedule_time = timer_get_time();
+}
+
+
+/*-------------------------------------------------
+    handle_rewind_save - capture a state into
+    the rewind buffer
+-------------------------------------------------*/
+
+static void handle_rewind_save(running_machine *machine)
+{
+	mame_private *mame = machine->mame_data;
+
+	/* if there are anonymous timers, try again next time around */
+	if (timer_count_anonymous() > 0)
+	{
+		/* give up on this capture if it's been too long */
+		if (attotime_sub(timer_get_time(), mame->saveload_schedule_time).seconds > 0)
+			mame->saveload_schedule_callback = NULL;
+		return;
+	}
+
+	/* capture the state */
+	if (state_save_rewind_begin() == 0)
+	{
+		save_state_tags();
+		state_save_rewind_finish();
+	}
+	mame->saveload_schedule_callback = NULL;
+}
+
+
+/*-------------------------------------------------
+    handle_rewind_load - restore the most recent
+    state from the rewind buffer
+-------------------------------------------------*/
+
+static void handle_rewind_load(running_machine *machine)
+{
+	mame_private *mame = machine->mame_data;
+
+	/* if there are anonymous timers, we can't load just yet */
+	if (timer_count_anonymous() > 0)
+	{
+		/* if more than a second has passed, we're probably screwed */
+		if (attotime_sub(timer_get_time(), mame->saveload_schedule_time).seconds > 0)
+		{
+			popmessage("Unable to rewind due to pending anonymous timers. See error.log for details.");
+			mame->saveload_schedule_callback = NULL;
+		}
+		return;
+	}
+
+	/* restore the state */
+	if (state_save_rewind_load_begin() == 0)
+	{
+		load_state_tags();
+		state_save_rewind_load_finish();
+		popmessage("Rewound (%d states remaining)", state_rewind_count());
+	}
+	else
+		popmessage("Nothing to rewind to");
+
+	/* restart the capture interval from here */
+	mame->rewind_frames = 0;
+	mame->saveload_schedule_callback = NULL;
+}
+
+
 
 /***************************************************************************
     SYSTEM TIME
@@ -309,6 +309,9 @@ void mame_schedule_save(running_machine *machine, const char *filename);
 /* schedule a load */
 void mame_schedule_load(running_machine *machine, const char *filename);
 
+/* schedule a rewind to the most recent in-memory state */
+void mame_schedule_rewind(running_machine *machine);
+
 /* is a scheduled event pending? */
 int mame_is_scheduled_event_pending(running_machine *machine);
 
@@ -101,6 +101,9 @@
 #define VERBOSE			(0)
 #define ALLOW_ONLY_AUTO_MALLOC_BANKS	0
 
+#define DIRECT_MIN_PAGE_BITS	8		/* smallest page tracked by the direct tables */
+#define DIRECT_MAX_TABLE_BITS	16		/* largest number of pages in a direct table */
+
 
 #if VERBOSE
 #define VPRINTF(x)	mame_printf_debug x
@@ -132,6 +135,14 @@
     (such as RAM, ROM, NOP, and banking). Table values between 64 and 192
     are assigned dynamically at startup.
 
+    Before any of that, the accessors check a per-space direct table,
+    which holds one host pointer per page of the address space. Pages
+    that are entirely backed by a single bank (which is how all RAM and
+    ROM is mapped) get a pointer biased so that indexing it with the
+    address yields the data; everything else is NULL and falls through
+    to the lookup above. The direct tables are rebuilt whenever handlers
+    are installed and patched whenever a bank base changes.
+
 ***************************************************************************/
 
 /* macros for the profiler */
@@ -179,6 +190,15 @@ struct _memory_block
     UINT8 *					data;					/* pointer to the data for this block */
 };
 
+typedef struct _direct_ref direct_ref;
+struct _direct_ref
+{
+	UINT8 **				table;					/* direct table that references the bank */
+	UINT32					page;					/* page index within that table */
+	offs_t					pagebase;				/* address of the start of the page */
+	offs_t					bankoffs;				/* offset of the page within the bank */
+};
+
 typedef struct _bank_data bank_data;
 struct _bank_data
 {
@@ -193,6 +213,9 @@ struct _bank_data
 	UINT16					curentry;				/* current entry */
 	void *					entry[MAX_BANK_ENTRIES];/* array of entries for this bank */
 	void *					entryd[MAX_BANK_ENTRIES];/* array of decrypted entries for this bank */
+	direct_ref *			directref;				/* direct table pages mapping this bank */
+	int						directrefs;				/* number of valid direct references */
+	int						directrefalloc;			/* number of allocated direct references */
 };
 
 typedef union _rwhandlers rwhandlers;
@@ -243,6 +266,9 @@ struct _addrspace_data
 	UINT64					unmap;					/* unmapped value */
 	table_data				read;					/* memory read lookup table */
 	table_data				write;					/* memory write lookup table */
+	UINT8 **				readdirect;				/* direct read pointers, one per page */
+	UINT8 **				writedirect;			/* direct write pointers, one per page */
+	UINT8					directshift;			/* shift from address to page index */
 	const data_accessors *		accessors;				/* pointer to the memory accessors */
 	address_map *			map;					/* original memory map */
 	address_map *			adjmap;					/* adjusted memory map */
@@ -269,14 +295,14 @@ struct _cpu_data
     GLOBAL VARIABLES
 -------------------------------------------------*/
 
-UINT8 *						opcode_base;					/* opcode base */
-UINT8 *						opcode_arg_base;				/* opcode argument base */
-offs_t						opcode_mask;					/* mask to apply to the opcode address */
-offs_t						opcode_memory_min;				/* opcode memory minimum */
-offs_t						opcode_memory_max;				/* opcode memory maximum */
-UINT8		 				opcode_entry;					/* opcode readmem entry */
+DECL_THREAD_LOCAL UINT8 *	opcode_base;					/* opcode base */
+DECL_THREAD_LOCAL UINT8 *	opcode_arg_base;				/* opcode argument base */
+DECL_THREAD_LOCAL offs_t	opcode_mask;					/* mask to apply to the opcode address */
+DECL_THREAD_LOCAL offs_t	opcode_memory_min;				/* opcode memory minimum */
+DECL_THREAD_LOCAL offs_t	opcode_memory_max;				/* opcode memory maximum */
+DECL_THREAD_LOCAL UINT8		opcode_entry;					/* opcode readmem entry */
 
-address_space				active_address_space[ADDRESS_SPACES];/* address space data */
+DECL_THREAD_LOCAL address_space active_address_space[ADDRESS_SPACES];/* address space data */
 
 static UINT8 *				bank_ptr[STATIC_COUNT];			/* array of bank pointers */
 static UINT8 *				bankd_ptr[STATIC_COUNT];		/* array of decrypted bank pointers */
@@ -285,9 +311,9 @@ static void *				shared_ptr[MAX_SHARED_POINTERS];/* array of shared pointers */
 static memory_block 		memory_block_list[MAX_MEMORY_BLOCKS];/* array of memory blocks we are tracking */
 static int 					memory_block_count = 0;			/* number of memory_block[] entries used */
 
-static int					cur_context;					/* current CPU context */
+static DECL_THREAD_LOCAL int cur_context = -1;				/* current CPU context */
 
-static opbase_handler		opbasefunc;						/* opcode base override */
+static DECL_THREAD_LOCAL opbase_handler opbasefunc;			/* opcode base override */
 
 static int					debugger_access;				/* treat accesses as coming from the debugger */
 static int					log_unmap[ADDRESS_SPACES];		/* log unmapped memory accesses */
@@ -382,6 +408,8 @@ INLINE void force_opbase_update(void)
 -------------------------------------------------*/
 
 static void init_cpudata(void);
+static int cpu_writes_shared_memory(int writer, int reader);
+static int amentries_overlap(const address_map *map1, const address_map *map2);
 static void init_addrspace(UINT8 cpunum, UINT8 spacenum);
 static void preflight_memory(void);
 static void populate_memory(void);
@@ -402,6 +430,9 @@ static void register_for_save(int cpunum, int spacenum, offs_t start, void *base
 static address_map *assign_intersecting_blocks(addrspace_data *space, offs_t start, offs_t end, UINT8 *base);
 static void find_memory(void);
 static void *memory_find_base(int cpunum, int spacenum, int readwrite, offs_t offset);
+static void allocate_direct_tables(void);
+static void rebuild_direct_table(addrspace_data *space, int iswrite);
+static void update_bank_direct(int banknum);
 static genf *get_static_handler(int databits, int readorwrite, int spacenum, int which);
 static void memory_exit(running_machine *machine);
 
@@ -461,6 +492,9 @@ void memory_init(running_machine *machine)
 	/* find all the allocated pointers */
 	find_memory();
 
+	/* build the direct page tables now that everything is in place */
+	allocate_direct_tables();
+
 	/* dump the final memory configuration */
 	mem_dump();
 }
@@ -472,16 +506,31 @@ void memory_init(running_machine *machine)
 
 static void memory_exit(running_machine *machine)
 {
-	int cpunum, spacenum;
+	int cpunum, spacenum, banknum;
 
 	/* free all the tables */
 	for (cpunum = 0; cpunum < MAX_CPU; cpunum++)
 		for (spacenum = 0; spacenum < ADDRESS_SPACES; spacenum++)
 		{
-			if (cpudata[cpunum].space[spacenum].read.table)
-				free(cpudata[cpunum].space[spacenum].read.table);
-			if (cpudata[cpunum].space[spacenum].write.table)
-				free(cpudata[cpunum].space[spacenum].write.table);
+			addrspace_data *space = &cpudata[cpunum].space[spacenum];
+			if (space->read.table)
+				free(space->read.table);
+			if (space->write.table)
+				free(space->write.table);
+			if (space->readdirect)
+				free(space->readdirect);
+			if (space->writedirect)
+				free(space->writedirect);
+			space->readdirect = space->writedirect = NULL;
+		}
+
+	/* free the bank references to the direct tables */
+	for (banknum = 0; banknum < STATIC_COUNT; banknum++)
+		if (bankdata[banknum].directref)
+		{
+			free(bankdata[banknum].directref);
+			bankdata[banknum].directref = NULL;
+			bankdata[banknum].directrefs = bankdata[banknum].directrefalloc = 0;
 		}
 }
 
@@ -517,6 +566,9 @@ void memory_set_context(int activecpu)
 	active_address_space[ADDRESS_SPACE_PROGRAM].writelookup = cpudata[activecpu].space[ADDRESS_SPACE_PROGRAM].write.table;
 	active_address_space[ADDRESS_SPACE_PROGRAM].readhandlers = cpudata[activecpu].space[ADDRESS_SPACE_PROGRAM].read.handlers;
 	active_address_space[ADDRESS_SPACE_PROGRAM].writehandlers = cpudata[activecpu].space[ADDRESS_SPACE_PROGRAM].write.handlers;
+	active_address_space[ADDRESS_SPACE_PROGRAM].readdirect = cpudata[activecpu].space[ADDRESS_SPACE_PROGRAM].readdirect;
+	active_address_space[ADDRESS_SPACE_PROGRAM].writedirect = cpudata[activecpu].space[ADDRESS_SPACE_PROGRAM].writedirect;
+	active_address_space[ADDRESS_SPACE_PROGRAM].directshift = cpudata[activecpu].space[ADDRESS_SPACE_PROGRAM].directshift;
 	active_address_space[ADDRESS_SPACE_PROGRAM].accessors = cpudata[activecpu].space[ADDRESS_SPACE_PROGRAM].accessors;
 
 	/* data address space */
@@ -527,6 +579,9 @@ void memory_set_context(int activecpu)
 		active_address_space[ADDRESS_SPACE_DATA].writelookup = cpudata[activecpu].space[ADDRESS_SPACE_DATA].write.table;
 		active_address_space[ADDRESS_SPACE_DATA].readhandlers = cpudata[activecpu].space[ADDRESS_SPACE_DATA].read.handlers;
 		active_address_space[ADDRESS_SPACE_DATA].writehandlers = cpudata[activecpu].space[ADDRESS_SPACE_DATA].write.handlers;
+		active_address_space[ADDRESS_SPACE_DATA].readdirect = cpudata[activecpu].space[ADDRESS_SPACE_DATA].readdirect;
+		active_address_space[ADDRESS_SPACE_DATA].writedirect = cpudata[activecpu].space[ADDRESS_SPACE_DATA].writedirect;
+		active_address_space[ADDRESS_SPACE_DATA].directshift = cpudata[activecpu].space[ADDRESS_SPACE_DATA].directshift;
 		active_address_space[ADDRESS_SPACE_DATA].accessors = cpudata[activecpu].space[ADDRESS_SPACE_DATA].accessors;
 	}
 
@@ -538,6 +593,9 @@ void memory_set_context(int activecpu)
 		active_address_space[ADDRESS_SPACE_IO].writelookup = cpudata[activecpu].space[ADDRESS_SPACE_IO].write.table;
 		active_address_space[ADDRESS_SPACE_IO].readhandlers = cpudata[activecpu].space[ADDRESS_SPACE_IO].read.handlers;
 		active_address_space[ADDRESS_SPACE_IO].writehandlers = cpudata[activecpu].space[ADDRESS_SPACE_IO].write.handlers;
+		active_address_space[ADDRESS_SPACE_IO].readdirect = cpudata[activecpu].space[ADDRESS_SPACE_IO].readdirect;
+		active_address_space[ADDRESS_SPACE_IO].writedirect = cpudata[activecpu].space[ADDRESS_SPACE_IO].writedirect;
+		active_address_space[ADDRESS_SPACE_IO].directshift = cpudata[activecpu].space[ADDRESS_SPACE_IO].directshift;
 		active_address_space[ADDRESS_SPACE_IO].accessors = cpudata[activecpu].space[ADDRESS_SPACE_IO].accessors;
 	}
 
@@ -555,6 +613,27 @@ void memory_set_context(int activecpu)
 }
 
 
+/*-------------------------------------------------
+    memory_release_context - write the opcode
+    state of the current context back and leave
+    this thread without a context
+-------------------------------------------------*/
+
+void memory_release_context(void)
+{
+	if (cur_context != -1)
+	{
+		cpudata[cur_context].op_ram = opcode_arg_base;
+		cpudata[cur_context].op_rom = opcode_base;
+		cpudata[cur_context].op_mask = opcode_mask;
+		cpudata[cur_context].op_mem_min = opcode_memory_min;
+		cpudata[cur_context].op_mem_max = opcode_memory_max;
+		cpudata[cur_context].opcode_entry = opcode_entry;
+	}
+	cur_context = -1;
+}
+
+
 /*-------------------------------------------------
     memory_get_map - return a pointer to a CPU's
     memory map
@@ -566,6 +645,18 @@ const address_map *memory_get_map(int cpunum, int spacenum)
 }
 
 
+/*-------------------------------------------------
+    memory_cpus_share_memory - return TRUE if
+    either CPU can write memory or banks that
+    the other one maps
+-------------------------------------------------*/
+
+int memory_cpus_share_memory(int cpunum1, int cpunum2)
+{
+	return cpu_writes_shared_memory(cpunum1, cpunum2) || cpu_writes_shared_memory(cpunum2, cpunum1);
+}
+
+
 /*-------------------------------------------------
     memory_set_opbase_handler - change op-code
     memory base
@@ -865,6 +956,7 @@ void memory_set_bank(int banknum, int entrynum)
 	bankdata[banknum].curentry = entrynum;
 	bank_ptr[banknum] = bankdata[banknum].entry[entrynum];
 	bankd_ptr[banknum] = bankdata[banknum].entryd[entrynum];
+	update_bank_direct(banknum);
 
 	/* if we're executing out of this bank, adjust the opbase pointer */
 	if (opcode_entry == banknum && cpu_getactivecpu() >= 0)
@@ -891,6 +983,7 @@ void memory_set_bankptr(int banknum, void *base)
 
 	/* set the base */
 	bank_ptr[banknum] = base;
+	update_bank_direct(banknum);
 
 	/* if we're executing out of this bank, adjust the opbase pointer */
 	if (opcode_entry == banknum && cpu_getactivecpu() >= 0)
@@ -1587,6 +1680,10 @@ static void install_mem_handler(addrspace_data *space, int iswrite, int databits
 		}
 	}
 
+	/* if the direct tables are live, bring them up to date */
+	if (space->readdirect != NULL)
+		rebuild_direct_table(space, iswrite);
+
 	/* if this is being installed to a live CPU, update the context */
 	if (space->cpunum == cur_context)
 		memory_set_context(cur_context);
@@ -2018,6 +2115,63 @@ static int amentry_needs_backing_store(int cpunum, int spacenum, const address_m
 }
 
 
+/*-------------------------------------------------
+    cpu_writes_shared_memory - return TRUE if any
+    RAM or bank that one CPU writes directly is
+    also mapped by another
+-------------------------------------------------*/
+
+static int cpu_writes_shared_memory(int writer, int reader)
+{
+	int wspacenum, rspacenum;
+
+	for (wspacenum = 0; wspacenum < ADDRESS_SPACES; wspacenum++)
+		if (cpudata[writer].spacemask & (1 << wspacenum))
+		{
+			const address_map *wmap;
+
+			for (wmap = cpudata[writer].space[wspacenum].adjmap; !IS_AMENTRY_END(wmap); wmap++)
+				if (!IS_AMENTRY_EXTENDED(wmap) && (HANDLER_IS_RAM(wmap->write.handler) || HANDLER_IS_BANK(wmap->write.handler)))
+					for (rspacenum = 0; rspacenum < ADDRESS_SPACES; rspacenum++)
+						if (cpudata[reader].spacemask & (1 << rspacenum))
+						{
+							const address_map *rmap;
+
+							for (rmap = cpudata[reader].space[rspacenum].adjmap; !IS_AMENTRY_END(rmap); rmap++)
+								if (!IS_AMENTRY_EXTENDED(rmap) && amentries_overlap(wmap, rmap))
+									return TRUE;
+						}
+		}
+	return FALSE;
+}
+
+
+/*-------------------------------------------------
+    amentries_overlap - return TRUE if a directly
+    written map entry touches the same memory as
+    another entry
+-------------------------------------------------*/
+
+static int amentries_overlap(const address_map *wmap, const address_map *rmap)
+{
+	const UINT8 *wstart, *rstart;
+	size_t wlength, rlength;
+
+	/* a bank is shared wherever it is mapped */
+	if (HANDLER_IS_BANK(wmap->write.handler))
+		return ((FPTR)rmap->read.handler == (FPTR)wmap->write.handler || (FPTR)rmap->write.handler == (FPTR)wmap->write.handler);
+
+	/* otherwise, compare the backing memory */
+	if (wmap->memory == NULL || rmap->memory == NULL)
+		return FALSE;
+	wstart = wmap->memory;
+	rstart = rmap->memory;
+	wlength = IS_AMENTRY_MATCH_MASK(wmap) ? wmap->mask + 1 : wmap->end - wmap->start + 1;
+	rlength = IS_AMENTRY_MATCH_MASK(rmap) ? rmap->mask + 1 : rmap->end - rmap->start + 1;
+	return (wstart < rstart + rlength && rstart < wstart + wlength);
+}
+
+
 /*-------------------------------------------------
     allocate_memory - allocate memory for
     CPU address spaces
@@ -2244,7 +2398,10 @@ static void reattach_banks(void)
 		{
 			/* if this entry has a changed entry, set the appropriate pointer */
 			if (bankdata[banknum].curentry != MAX_BANK_ENTRIES)
+			{
 				bank_ptr[banknum] = bankdata[banknum].entry[bankdata[banknum].curentry];
+				update_bank_direct(banknum);
+			}
 		}
 }
 
@@ -2359,6 +2516,180 @@ static void *memory_find_base(int cpunum, int spacenum, int readwrite, offs_t of
 }
 
 
+/*-------------------------------------------------
+    allocate_direct_tables - allocate and build
+    the direct page tables for every space
+-------------------------------------------------*/
+
+static void allocate_direct_tables(void)
+{
+	int cpunum, spacenum;
+
+	/* loop over CPUs and address spaces */
+	for (cpunum = 0; cpunum < MAX_CPU && Machine->drv->cpu[cpunum].type != CPU_DUMMY; cpunum++)
+		for (spacenum = 0; spacenum < ADDRESS_SPACES; spacenum++)
+			if (cpudata[cpunum].spacemask & (1 << spacenum))
+			{
+				addrspace_data *space = &cpudata[cpunum].space[spacenum];
+				int addrbits, pages;
+
+				/* pick a page size that keeps the table to a reasonable size */
+				for (addrbits = 32; addrbits > 0 && !(space->mask & ((offs_t)1 << (addrbits - 1))); addrbits--) ;
+				space->directshift = MAX(DIRECT_MIN_PAGE_BITS, addrbits - DIRECT_MAX_TABLE_BITS);
+				pages = (space->mask >> space->directshift) + 1;
+
+				/* allocate the tables and fill them in */
+				space->readdirect = malloc_or_die(pages * sizeof(space->readdirect[0]));
+				space->writedirect = malloc_or_die(pages * sizeof(space->writedirect[0]));
+				rebuild_direct_table(space, FALSE);
+				rebuild_direct_table(space, TRUE);
+			}
+
+	/* make sure the active context picks them up */
+	if (cur_context != -1)
+		memory_set_context(cur_context);
+}
+
+
+/*-------------------------------------------------
+    direct_page_entry - return the single handler
+    entry covering a page, or STATIC_INVALID if
+    the page is split between several
+-------------------------------------------------*/
+
+static UINT8 direct_page_entry(table_data *tabledata, offs_t start, offs_t end)
+{
+	offs_t l1index = LEVEL1_INDEX(start);
+	UINT8 entry = tabledata->table[l1index];
+	offs_t address;
+
+	/* pages larger than a level 1 entry need all of them to match, with no subtables */
+	if (LEVEL1_INDEX(end) != l1index)
+	{
+		if (entry >= SUBTABLE_BASE)
+			return STATIC_INVALID;
+		for (l1index++; l1index <= LEVEL1_INDEX(end); l1index++)
+			if (tabledata->table[l1index] != entry)
+				return STATIC_INVALID;
+		return entry;
+	}
+
+	/* pages within a level 1 entry are uniform unless it's a subtable */
+	if (entry < SUBTABLE_BASE)
+		return entry;
+	{
+		UINT8 subentry = tabledata->table[LEVEL2_INDEX(entry, start)];
+		for (address = start + 1; address <= end && address != 0; address++)
+			if (tabledata->table[LEVEL2_INDEX(entry, address)] != subentry)
+				return STATIC_INVALID;
+		return subentry;
+	}
+}
+
+
+/*-------------------------------------------------
+    rebuild_direct_table - recompute the direct
+    page pointers for one side of a space
+-------------------------------------------------*/
+
+static void rebuild_direct_table(addrspace_data *space, int iswrite)
+{
+	table_data *tabledata = iswrite ? &space->write : &space->read;
+	UINT8 **direct = iswrite ? space->writedirect : space->readdirect;
+	offs_t pagesize = 1 << space->directshift;
+	UINT32 pages = (space->mask >> space->directshift) + 1;
+	UINT32 page;
+	int banknum;
+
+	/* drop any bank references to this table */
+	for (banknum = STATIC_BANK1; banknum <= STATIC_BANKMAX; banknum++)
+	{
+		bank_data *bdata = &bankdata[banknum];
+		int src, dst;
+
+		for (src = dst = 0; src < bdata->directrefs; src++)
+			if (bdata->directref[src].table != direct)
+				bdata->directref[dst++] = bdata->directref[src];
+		bdata->directrefs = dst;
+	}
+
+	/* walk the pages, mapping the ones wholly backed by one bank */
+	for (page = 0; page < pages; page++)
+	{
+		offs_t start = page << space->directshift;
+		UINT8 entry = direct_page_entry(tabledata, start, start + pagesize - 1);
+		handler_data *handler;
+		bank_data *bdata;
+		offs_t bankoffs;
+
+		direct[page] = NULL;
+		if (entry < STATIC_BANK1 || entry > STATIC_BANKMAX)
+			continue;
+
+		/* the handler's offset and mask must not scramble addresses within the page */
+		handler = &tabledata->handlers[entry];
+		bankoffs = (start - handler->offset) & handler->mask;
+		if ((handler->mask & (pagesize - 1)) != pagesize - 1 || (bankoffs & (pagesize - 1)) != 0)
+			continue;
+
+		/* remember the page so that bank switches can patch it */
+		bdata = &bankdata[entry];
+		if (bdata->directrefs == bdata->directrefalloc)
+		{
+			direct_ref *newref;
+
+			bdata->directrefalloc = (bdata->directrefalloc == 0) ? 16 : bdata->directrefalloc * 2;
+			newref = malloc_or_die(bdata->directrefalloc * sizeof(*newref));
+			if (bdata->directref != NULL)
+			{
+				memcpy(newref, bdata->directref, bdata->directrefs * sizeof(*newref));
+				free(bdata->directref);
+			}
+			bdata->directref = newref;
+		}
+		bdata->directref[bdata->directrefs].table = direct;
+		bdata->directref[bdata->directrefs].page = page;
+		bdata->directref[bdata->directrefs].pagebase = start;
+		bdata->directref[bdata->directrefs].bankoffs = bankoffs;
+		bdata->directrefs++;
+
+		/* the pointer is biased so that it can be indexed by the full address */
+		if (bank_ptr[entry] != NULL)
+			direct[page] = bank_ptr[entry] + bankoffs - start;
+	}
+}
+
+
+/*-------------------------------------------------
+    update_bank_direct - repoint all the direct
+    pages that map a bank after its base changes
+-------------------------------------------------*/
+
+static void update_bank_direct(int banknum)
+{
+	bank_data *bdata = &bankdata[banknum];
+	UINT8 *base = bank_ptr[banknum];
+	int refnum;
+
+	for (refnum = 0; refnum < bdata->directrefs; refnum++)
+	{
+		direct_ref *ref = &bdata->directref[refnum];
+		ref->table[ref->page] = (base != NULL) ? base + ref->bankoffs - ref->pagebase : NULL;
+	}
+}
+
+
+/*-------------------------------------------------
+    PERFORM_DIRECT_LOOKUP - fetch the direct page
+    pointer for an address
+-------------------------------------------------*/
+
+#define PERFORM_DIRECT_LOOKUP(direct_table,space,extraand)								\
+	/* mask the address and look up its page */										\
+	address &= space.addrmask & extraand;												\
+	direct = space.direct_table[address >> space.directshift];							\
+
+
 /*-------------------------------------------------
     PERFORM_LOOKUP - common lookup procedure
 -------------------------------------------------*/
@@ -2380,10 +2711,17 @@ UINT8 name(offs_t original_address)														\
 {																						\
 	offs_t address = original_address;													\
 	UINT32 entry;																		\
+	UINT8 *direct;																		\
 	MEMREADSTART();																		\
-	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~0);						\
+	PERFORM_DIRECT_LOOKUP(readdirect,active_address_space[spacenum],~0);				\
 	DEBUG_HOOK_READ(spacenum, 1, address);												\
 																						\
+	/* handle directly-mapped pages inline */											\
+	if (direct != NULL)																	\
+		MEMREADEND(direct[address]);													\
+																						\
+	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~0);						\
+																						\
 	/* handle banks inline */															\
 	address = (address - active_address_space[spacenum].readhandlers[entry].offset) & active_address_space[spacenum].readhandlers[entry].mask;\
 	if (entry < STATIC_RAM) 															\
@@ -2400,10 +2738,17 @@ UINT8 name(offs_t original_address)														\
 {																						\
 	offs_t address = original_address;													\
 	UINT32 entry;																		\
+	UINT8 *direct;																		\
 	MEMREADSTART();																		\
-	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~0);						\
+	PERFORM_DIRECT_LOOKUP(readdirect,active_address_space[spacenum],~0);				\
 	DEBUG_HOOK_READ(spacenum, 1, address);												\
 																						\
+	/* handle directly-mapped pages inline */											\
+	if (direct != NULL)																	\
+		MEMREADEND(direct[xormacro(address)]);											\
+																						\
+	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~0);						\
+																						\
 	/* handle banks inline */															\
 	address = (address - active_address_space[spacenum].readhandlers[entry].offset) & active_address_space[spacenum].readhandlers[entry].mask;\
 	if (entry < STATIC_RAM)																\
@@ -2436,10 +2781,17 @@ UINT16 name(offs_t original_address)													\
 {																						\
 	offs_t address = original_address;													\
 	UINT32 entry;																		\
+	UINT8 *direct;																		\
 	MEMREADSTART();																		\
-	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~1);						\
+	PERFORM_DIRECT_LOOKUP(readdirect,active_address_space[spacenum],~1);				\
 	DEBUG_HOOK_READ(spacenum, 2, address);												\
 																						\
+	/* handle directly-mapped pages inline */											\
+	if (direct != NULL)																	\
+		MEMREADEND(*(UINT16 *)&direct[address]);										\
+																						\
+	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~1);						\
+																						\
 	/* handle banks inline */															\
 	address = (address - active_address_space[spacenum].readhandlers[entry].offset) & active_address_space[spacenum].readhandlers[entry].mask;\
 	if (entry < STATIC_RAM)																\
@@ -2456,10 +2808,17 @@ UINT16 name(offs_t original_address)													\
 {																						\
 	offs_t address = original_address;													\
 	UINT32 entry;																		\
+	UINT8 *direct;																		\
 	MEMREADSTART();																		\
-	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~1);						\
+	PERFORM_DIRECT_LOOKUP(readdirect,active_address_space[spacenum],~1);				\
 	DEBUG_HOOK_READ(spacenum, 2, address);												\
 																						\
+	/* handle directly-mapped pages inline */											\
+	if (direct != NULL)																	\
+		MEMREADEND(*(UINT16 *)&direct[xormacro(address)]);								\
+																						\
+	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~1);						\
+																						\
 	/* handle banks inline */															\
 	address = (address - active_address_space[spacenum].readhandlers[entry].offset) & active_address_space[spacenum].readhandlers[entry].mask;\
 	if (entry < STATIC_RAM)																\
@@ -2490,10 +2849,17 @@ UINT32 name(offs_t original_address)													\
 {																						\
 	offs_t address = original_address;													\
 	UINT32 entry;																		\
+	UINT8 *direct;																		\
 	MEMREADSTART();																		\
-	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~3);						\
+	PERFORM_DIRECT_LOOKUP(readdirect,active_address_space[spacenum],~3);				\
 	DEBUG_HOOK_READ(spacenum, 4, address);												\
 																						\
+	/* handle directly-mapped pages inline */											\
+	if (direct != NULL)																	\
+		MEMREADEND(*(UINT32 *)&direct[address]);										\
+																						\
+	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~3);						\
+																						\
 	/* handle banks inline */															\
 	address = (address - active_address_space[spacenum].readhandlers[entry].offset) & active_address_space[spacenum].readhandlers[entry].mask;\
 	if (entry < STATIC_RAM)																\
@@ -2510,10 +2876,17 @@ UINT32 name(offs_t original_address, UINT32 mem_mask)									\
 {																						\
 	offs_t address = original_address;													\
 	UINT32 entry;																		\
+	UINT8 *direct;																		\
 	MEMREADSTART();																		\
-	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~3);						\
+	PERFORM_DIRECT_LOOKUP(readdirect,active_address_space[spacenum],~3);				\
 	DEBUG_HOOK_READ(spacenum, 4, address);												\
 																						\
+	/* handle directly-mapped pages inline */											\
+	if (direct != NULL)																	\
+		MEMREADEND(*(UINT32 *)&direct[address]);										\
+																						\
+	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~3);						\
+																						\
 	/* handle banks inline */															\
 	address = (address - active_address_space[spacenum].readhandlers[entry].offset) & active_address_space[spacenum].readhandlers[entry].mask;\
 	if (entry < STATIC_RAM)																\
@@ -2530,10 +2903,17 @@ UINT32 name(offs_t original_address)													\
 {																						\
 	offs_t address = original_address;													\
 	UINT32 entry;																		\
+	UINT8 *direct;																		\
 	MEMREADSTART();																		\
-	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~3);						\
+	PERFORM_DIRECT_LOOKUP(readdirect,active_address_space[spacenum],~3);				\
 	DEBUG_HOOK_READ(spacenum, 4, address);												\
 																						\
+	/* handle directly-mapped pages inline */											\
+	if (direct != NULL)																	\
+		MEMREADEND(*(UINT32 *)&direct[xormacro(address)]);								\
+																						\
+	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~3);						\
+																						\
 	/* handle banks inline */															\
 	address = (address - active_address_space[spacenum].readhandlers[entry].offset) & active_address_space[spacenum].readhandlers[entry].mask;\
 	if (entry < STATIC_RAM)																\
@@ -2562,10 +2942,17 @@ UINT64 name(offs_t original_address)													\
 {																						\
 	offs_t address = original_address;													\
 	UINT32 entry;																		\
+	UINT8 *direct;																		\
 	MEMREADSTART();																		\
-	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~7);						\
+	PERFORM_DIRECT_LOOKUP(readdirect,active_address_space[spacenum],~7);				\
 	DEBUG_HOOK_READ(spacenum, 8, address);												\
 																						\
+	/* handle directly-mapped pages inline */											\
+	if (direct != NULL)																	\
+		MEMREADEND(*(UINT64 *)&direct[address]);										\
+																						\
+	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~7);						\
+																						\
 	/* handle banks inline */															\
 	address = (address - active_address_space[spacenum].readhandlers[entry].offset) & active_address_space[spacenum].readhandlers[entry].mask;\
 	if (entry < STATIC_RAM)																\
@@ -2582,10 +2969,17 @@ UINT64 name(offs_t original_address, UINT64 mem_mask)									\
 {																						\
 	offs_t address = original_address;													\
 	UINT32 entry;																		\
+	UINT8 *direct;																		\
 	MEMREADSTART();																		\
-	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~7);						\
+	PERFORM_DIRECT_LOOKUP(readdirect,active_address_space[spacenum],~7);				\
 	DEBUG_HOOK_READ(spacenum, 8, address);												\
 																						\
+	/* handle directly-mapped pages inline */											\
+	if (direct != NULL)																	\
+		MEMREADEND(*(UINT64 *)&direct[address]);										\
+																						\
+	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~7);						\
+																						\
 	/* handle banks inline */															\
 	address = (address - active_address_space[spacenum].readhandlers[entry].offset) & active_address_space[spacenum].readhandlers[entry].mask;\
 	if (entry < STATIC_RAM)																\
@@ -2607,10 +3001,17 @@ void name(offs_t original_address, UINT8 data)											\
 {																						\
 	offs_t address = original_address;													\
 	UINT32 entry;																		\
+	UINT8 *direct;																		\
 	MEMWRITESTART();																	\
-	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~0);						\
+	PERFORM_DIRECT_LOOKUP(writedirect,active_address_space[spacenum],~0);				\
 	DEBUG_HOOK_WRITE(spacenum, 1, address, data);										\
 																						\
+	/* handle directly-mapped pages inline */											\
+	if (direct != NULL)																	\
+		MEMWRITEEND(direct[address] = data);											\
+																						\
+	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~0);						\
+																						\
 	/* handle banks inline */															\
 	address = (address - active_address_space[spacenum].writehandlers[entry].offset) & active_address_space[spacenum].writehandlers[entry].mask;\
 	if (entry < STATIC_RAM)																\
@@ -2626,10 +3027,17 @@ void name(offs_t original_address, UINT8 data)											\
 {																						\
 	offs_t address = original_address;													\
 	UINT32 entry;																		\
+	UINT8 *direct;																		\
 	MEMWRITESTART();																	\
-	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~0);						\
+	PERFORM_DIRECT_LOOKUP(writedirect,active_address_space[spacenum],~0);				\
 	DEBUG_HOOK_WRITE(spacenum, 1, address, data);										\
 																						\
+	/* handle directly-mapped pages inline */											\
+	if (direct != NULL)																	\
+		MEMWRITEEND(direct[xormacro(address)] = data);									\
+																						\
+	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~0);						\
+																						\
 	/* handle banks inline */															\
 	address = (address - active_address_space[spacenum].writehandlers[entry].offset) & active_address_space[spacenum].writehandlers[entry].mask;\
 	if (entry < STATIC_RAM)																\
@@ -2661,10 +3069,17 @@ void name(offs_t original_address, UINT16 data)											\
 {																						\
 	offs_t address = original_address;													\
 	UINT32 entry;																		\
+	UINT8 *direct;																		\
 	MEMWRITESTART();																	\
-	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~1);						\
+	PERFORM_DIRECT_LOOKUP(writedirect,active_address_space[spacenum],~1);				\
 	DEBUG_HOOK_WRITE(spacenum, 2, address, data);										\
 																						\
+	/* handle directly-mapped pages inline */											\
+	if (direct != NULL)																	\
+		MEMWRITEEND(*(UINT16 *)&direct[address] = data);								\
+																						\
+	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~1);						\
+																						\
 	/* handle banks inline */															\
 	address = (address - active_address_space[spacenum].writehandlers[entry].offset) & active_address_space[spacenum].writehandlers[entry].mask;\
 	if (entry < STATIC_RAM)																\
@@ -2680,10 +3095,17 @@ void name(offs_t original_address, UINT16 data)											\
 {																						\
 	offs_t address = original_address;													\
 	UINT32 entry;																		\
+	UINT8 *direct;																		\
 	MEMWRITESTART();																	\
-	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~1);						\
+	PERFORM_DIRECT_LOOKUP(writedirect,active_address_space[spacenum],~1);				\
 	DEBUG_HOOK_WRITE(spacenum, 2, address, data);										\
 																						\
+	/* handle directly-mapped pages inline */											\
+	if (direct != NULL)																	\
+		MEMWRITEEND(*(UINT16 *)&direct[xormacro(address)] = data);						\
+																						\
+	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~1);						\
+																						\
 	/* handle banks inline */															\
 	address = (address - active_address_space[spacenum].writehandlers[entry].offset) & active_address_space[spacenum].writehandlers[entry].mask;\
 	if (entry < STATIC_RAM)																\
@@ -2713,10 +3135,17 @@ void name(offs_t original_address, UINT32 data)											\
 {																						\
 	offs_t address = original_address;													\
 	UINT32 entry;																		\
+	UINT8 *direct;																		\
 	MEMWRITESTART();																	\
-	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~3);						\
+	PERFORM_DIRECT_LOOKUP(writedirect,active_address_space[spacenum],~3);				\
 	DEBUG_HOOK_WRITE(spacenum, 4, address, data);										\
 																						\
+	/* handle directly-mapped pages inline */											\
+	if (direct != NULL)																	\
+		MEMWRITEEND(*(UINT32 *)&direct[address] = data);								\
+																						\
+	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~3);						\
+																						\
 	/* handle banks inline */															\
 	address = (address - active_address_space[spacenum].writehandlers[entry].offset) & active_address_space[spacenum].writehandlers[entry].mask;\
 	if (entry < STATIC_RAM)																\
@@ -2732,10 +3161,20 @@ void name(offs_t original_address, UINT32 data, UINT32 mem_mask)						\
 {																						\
 	offs_t address = original_address;													\
 	UINT32 entry;																		\
+	UINT8 *direct;																		\
 	MEMWRITESTART();																	\
-	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~3);						\
+	PERFORM_DIRECT_LOOKUP(writedirect,active_address_space[spacenum],~3);				\
 	DEBUG_HOOK_WRITE(spacenum, 4, address, data);										\
 																						\
+	/* handle directly-mapped pages inline */											\
+	if (direct != NULL)																	\
+	{																					\
+		UINT32 *dest = (UINT32 *)&direct[address];										\
+		MEMWRITEEND(*dest = (*dest & mem_mask) | (data & ~mem_mask));					\
+	}																					\
+																						\
+	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~3);						\
+																						\
 	/* handle banks inline */															\
 	address = (address - active_address_space[spacenum].writehandlers[entry].offset) & active_address_space[spacenum].writehandlers[entry].mask;\
 	if (entry < STATIC_RAM)																\
@@ -2754,10 +3193,17 @@ void name(offs_t original_address, UINT32 data)											\
 {																						\
 	offs_t address = original_address;													\
 	UINT32 entry;																		\
+	UINT8 *direct;																		\
 	MEMWRITESTART();																	\
-	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~3);						\
+	PERFORM_DIRECT_LOOKUP(writedirect,active_address_space[spacenum],~3);				\
 	DEBUG_HOOK_WRITE(spacenum, 4, address, data);										\
 																						\
+	/* handle directly-mapped pages inline */											\
+	if (direct != NULL)																	\
+		MEMWRITEEND(*(UINT32 *)&direct[xormacro(address)] = data);						\
+																						\
+	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~3);						\
+																						\
 	/* handle banks inline */															\
 	address = (address - active_address_space[spacenum].writehandlers[entry].offset) & active_address_space[spacenum].writehandlers[entry].mask;\
 	if (entry < STATIC_RAM)																\
@@ -2785,10 +3231,17 @@ void name(offs_t original_address, UINT64 data)											\
 {																						\
 	offs_t address = original_address;													\
 	UINT32 entry;																		\
+	UINT8 *direct;																		\
 	MEMWRITESTART();																	\
-	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~7);						\
+	PERFORM_DIRECT_LOOKUP(writedirect,active_address_space[spacenum],~7);				\
 	DEBUG_HOOK_WRITE(spacenum, 8, address, data);										\
 																						\
+	/* handle directly-mapped pages inline */											\
+	if (direct != NULL)																	\
+		MEMWRITEEND(*(UINT64 *)&direct[address] = data);								\
+																						\
+	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~7);						\
+																						\
 	/* handle banks inline */															\
 	address = (address - active_address_space[spacenum].writehandlers[entry].offset) & active_address_space[spacenum].writehandlers[entry].mask;\
 	if (entry < STATIC_RAM)																\
@@ -2804,10 +3257,20 @@ void name(offs_t original_address, UINT64 data, UINT64 mem_mask)						\
 {																						\
 	offs_t address = original_address;													\
 	UINT32 entry;																		\
+	UINT8 *direct;																		\
 	MEMWRITESTART();																	\
-	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~7);						\
+	PERFORM_DIRECT_LOOKUP(writedirect,active_address_space[spacenum],~7);				\
 	DEBUG_HOOK_WRITE(spacenum, 8, address, data);										\
 																						\
+	/* handle directly-mapped pages inline */											\
+	if (direct != NULL)																	\
+	{																					\
+		UINT64 *dest = (UINT64 *)&direct[address];										\
+		MEMWRITEEND(*dest = (*dest & mem_mask) | (data & ~mem_mask));					\
+	}																					\
+																						\
+	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~7);						\
+																						\
 	/* handle banks inline */															\
 	address = (address - active_address_space[spacenum].writehandlers[entry].offset) & active_address_space[spacenum].writehandlers[entry].mask;\
 	if (entry < STATIC_RAM)																\
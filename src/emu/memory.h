@@ -591,6 +591,9 @@ struct _address_space
 	UINT8 *				writelookup;		/* write table lookup */
 	handler_data *		readhandlers;		/* read handlers */
 	handler_data *		writehandlers;		/* write handlers */
+	UINT8 **			readdirect;			/* direct read pointers, one per page */
+	UINT8 **			writedirect;		/* direct write pointers, one per page */
+	UINT8				directshift;		/* shift from address to page index */
 	const data_accessors *	accessors;			/* pointers to the data access handlers */
 };
 
@@ -933,9 +936,11 @@ void io_write_masked_64le(offs_t address, UINT64 data, UINT64 mem_mask);
 /* ----- memory setup function ----- */
 void		memory_init(running_machine *machine);
 void		memory_set_context(int activecpu);
+void		memory_release_context(void);
 
 /* ----- address map functions ----- */
 const address_map *memory_get_map(int cpunum, int spacenum);
+int memory_cpus_share_memory(int cpunum1, int cpunum2);
 
 /* ----- opcode base control ---- */
 opbase_handler memory_set_opbase_handler(int cpunum, opbase_handler function);
@@ -993,13 +998,14 @@ const char *memory_get_handler_string(int read0_or_write1, int cpunum, int space
     GLOBAL VARIABLES
 ***************************************************************************/
 
-extern UINT8 			opcode_entry;				/* current entry for opcode fetching */
-extern UINT8 *			opcode_base;				/* opcode ROM base */
-extern UINT8 *			opcode_arg_base;			/* opcode RAM base */
-extern offs_t			opcode_mask;				/* mask to apply to the opcode address */
-extern offs_t			opcode_memory_min;			/* opcode memory minimum */
-extern offs_t			opcode_memory_max;			/* opcode memory maximum */
-extern address_space	active_address_space[];		/* address spaces */
+/* these track the active CPU, so each thread running CPUs has its own copy */
+extern DECL_THREAD_LOCAL UINT8 			opcode_entry;				/* current entry for opcode fetching */
+extern DECL_THREAD_LOCAL UINT8 *		opcode_base;				/* opcode ROM base */
+extern DECL_THREAD_LOCAL UINT8 *		opcode_arg_base;			/* opcode RAM base */
+extern DECL_THREAD_LOCAL offs_t			opcode_mask;				/* mask to apply to the opcode address */
+extern DECL_THREAD_LOCAL offs_t			opcode_memory_min;			/* opcode memory minimum */
+extern DECL_THREAD_LOCAL offs_t			opcode_memory_max;			/* opcode memory maximum */
+extern DECL_THREAD_LOCAL address_space	active_address_space[];		/* address spaces */
 #define construct_map_0 NULL
 
 
@@ -58,6 +58,9 @@
 #define NUM_PRIMLISTS			2
 
 #define MAX_CLEAR_EXTENTS		1000
+#define MAX_CLEAR_QUADS			64
+
+#define PRIMITIVE_CHUNK_SIZE	256
 
 #define INTERNAL_FLAG_CHAR		0x00000001
 
@@ -98,6 +101,8 @@ enum
 typedef struct _object_transform object_transform;
 typedef struct _scaled_texture scaled_texture;
 typedef struct _container_item container_item;
+typedef struct _primitive_chunk primitive_chunk;
+typedef struct _element_cache_entry element_cache_entry;
 
 
 /* a render_ref is an abstract reference to an internal object of some sort */
@@ -108,6 +113,36 @@ struct _render_ref
 };
 
 
+/* a primitive_chunk is a block of primitives within an arena */
+struct _primitive_chunk
+{
+	primitive_chunk *	next;				/* next chunk in the arena */
+	render_primitive	prim[PRIMITIVE_CHUNK_SIZE];	/* primitives in this chunk */
+};
+
+
+/* a render_primitive_arena holds the primitives for a list; they are all released at once */
+struct _render_primitive_arena
+{
+	primitive_chunk *	chunklist;			/* all the chunks we have allocated */
+	primitive_chunk *	curchunk;			/* chunk we are currently allocating from */
+	int					curindex;			/* index of the next free primitive in the chunk */
+};
+
+
+/* an element_cache_entry remembers the primitive generated for a layout element item */
+struct _element_cache_entry
+{
+	const layout_element *element;			/* element the primitive was built for */
+	int					state;				/* state the primitive was built for */
+	int					blendmode;			/* blend mode the primitive was built for */
+	UINT8				valid;				/* is this entry valid? */
+	UINT8				visible;			/* did the primitive survive clipping? */
+	void *				ref;				/* texture bitmap the primitive references */
+	render_primitive	prim;				/* the primitive itself */
+};
+
+
 /* an object_transform is used to track transformations when building an object list */
 struct _object_transform
 {
@@ -163,6 +198,15 @@ struct _render_target
 	int					base_layerconfig;	/* the layer configuration at the time of first frame */
 	int					maxtexwidth;		/* maximum width of a texture */
 	int					maxtexheight;		/* maximum height of a texture */
+	element_cache_entry *elemcache;			/* cached primitives for layout elements */
+	int					elemcache_alloc;	/* number of cache entries allocated */
+	render_ref *		elemcache_refs;		/* textures referenced by the cache */
+	layout_view *		elemcache_view;		/* view the cache was built for */
+	object_transform	elemcache_xform;	/* root transform the cache was built for */
+	render_bounds		elemcache_bounds;	/* target bounds the cache was built for */
+	int					elemcache_layerconfig;/* layer configuration the cache was built for */
+	int					elemcache_maxtexwidth;/* maximum texture width the cache was built for */
+	int					elemcache_maxtexheight;/* maximum texture height the cache was built for */
 };
 
 
@@ -215,7 +259,6 @@ static render_target *ui_target;
 static int (*rescale_notify)(running_machine *, int, int);
 
 /* free lists */
-static render_primitive *render_primitive_free_list;
 static container_item *container_item_free_list;
 static render_ref *render_ref_free_list;
 static render_texture *render_texture_free_list;
@@ -257,14 +300,16 @@ static void render_save(int config_type, xml_data_node *parentnode);
 static void release_render_list(render_primitive_list *list);
 static int load_layout_files(render_target *target, const char *layoutfile, int singlefile);
 static void add_container_primitives(render_target *target, render_primitive_list *list, const object_transform *xform, render_container *container, int blendmode);
-static void add_element_primitives(render_target *target, render_primitive_list *list, const object_transform *xform, const layout_element *element, int state, int blendmode);
+static void add_element_primitives(render_target *target, render_primitive_list *list, int cacheindex, const object_transform *xform, const layout_element *element, int state, int blendmode);
+static int build_element_primitive(render_target *target, render_primitive_list *list, const object_transform *xform, const layout_element *element, int state, int blendmode, render_primitive *prim, void **ref);
+static void invalidate_element_cache(render_target *target);
 static void add_clear_and_optimize_primitive_list(render_target *target, render_primitive_list *list);
 
 /* render references */
 static void invalidate_all_render_ref(void *refptr);
 
 /* render textures */
-static int render_texture_get_scaled(render_texture *texture, UINT32 dwidth, UINT32 dheight, render_texinfo *texinfo, render_ref **reflist);
+static int render_texture_get_scaled(render_texture *texture, UINT32 dwidth, UINT32 dheight, render_texinfo *texinfo, render_ref **reflist, void **refptr);
 
 /* render containers */
 static render_container *render_container_alloc(void);
@@ -358,18 +403,38 @@ INLINE void free_container_item(container_item *item)
 
 /*-------------------------------------------------
     alloc_render_primitive - allocate a new empty
-    element object
+    element object from the list's arena
 -------------------------------------------------*/
 
-INLINE render_primitive *alloc_render_primitive(int type)
+INLINE render_primitive *alloc_render_primitive(render_primitive_list *list, int type)
 {
-	render_primitive *result = render_primitive_free_list;
+	render_primitive_arena *arena = list->arena;
+	render_primitive *result;
 
-	/* allocate from the free list if we can; otherwise, malloc a new item */
-	if (result != NULL)
-		render_primitive_free_list = result->next;
-	else
-		result = malloc_or_die(sizeof(*result));
+	/* allocate the arena the first time through */
+	if (arena == NULL)
+	{
+		arena = list->arena = malloc_or_die(sizeof(*arena));
+		memset(arena, 0, sizeof(*arena));
+	}
+
+	/* move to the next chunk if this one is full, allocating a new one if needed */
+	if (arena->curchunk == NULL || arena->curindex == PRIMITIVE_CHUNK_SIZE)
+	{
+		primitive_chunk *next = (arena->curchunk == NULL) ? arena->chunklist : arena->curchunk->next;
+		if (next == NULL)
+		{
+			next = malloc_or_die(sizeof(*next));
+			next->next = NULL;
+			if (arena->curchunk == NULL)
+				arena->chunklist = next;
+			else
+				arena->curchunk->next = next;
+		}
+		arena->curchunk = next;
+		arena->curindex = 0;
+	}
+	result = &arena->curchunk->prim[arena->curindex++];
 
 	/* clear to 0 */
 	memset(result, 0, sizeof(*result));
@@ -392,13 +457,17 @@ INLINE void append_render_primitive(render_primitive_list *list, render_primitiv
 
 /*-------------------------------------------------
     free_render_primitive - free a previously
-    allocated render element object
+    allocated render element object; only the
+    most recent allocation is actually reclaimed
+    before the arena is reset
 -------------------------------------------------*/
 
-INLINE void free_render_primitive(render_primitive *element)
+INLINE void free_render_primitive(render_primitive_list *list, render_primitive *element)
 {
-	element->next = render_primitive_free_list;
-	render_primitive_free_list = element;
+	render_primitive_arena *arena = list->arena;
+
+	if (arena->curindex > 0 && element == &arena->curchunk->prim[arena->curindex - 1])
+		arena->curindex--;
 }
 
 
@@ -479,7 +548,6 @@ void render_init(running_machine *machine)
 	targetlist = NULL;
 
 	/* zap the free lists */
-	render_primitive_free_list = NULL;
 	container_item_free_list = NULL;
 
 	/* zap more variables */
@@ -536,14 +604,6 @@ static void render_exit(running_machine *machine)
 		free(temp);
 	}
 
-	/* free the render primitives */
-	while (render_primitive_free_list != NULL)
-	{
-		render_primitive *temp = render_primitive_free_list;
-		render_primitive_free_list = temp->next;
-		free(temp);
-	}
-
 	/* free the render refs */
 	while (render_ref_free_list != NULL)
 	{
@@ -1054,13 +1114,30 @@ void render_target_free(render_target *target)
 	for (curr = &targetlist; *curr != target; curr = &(*curr)->next) ;
 	*curr = target->next;
 
-	/* free any primitives */
+	/* free any primitives and their arenas */
 	for (listnum = 0; listnum < NUM_PRIMLISTS; listnum++)
 	{
+		render_primitive_arena *arena = target->primlist[listnum].arena;
+
 		release_render_list(&target->primlist[listnum]);
 		osd_lock_free(target->primlist[listnum].lock);
+		if (arena != NULL)
+		{
+			while (arena->chunklist != NULL)
+			{
+				primitive_chunk *temp = arena->chunklist;
+				arena->chunklist = temp->next;
+				free(temp);
+			}
+			free(arena);
+		}
 	}
 
+	/* free the element cache */
+	invalidate_element_cache(target);
+	if (target->elemcache != NULL)
+		free(target->elemcache);
+
 	/* free the layout files */
 	while (target->filelist != NULL)
 	{
@@ -1427,6 +1504,7 @@ const render_primitive_list *render_target_get_primitives(render_target *target)
 	const int *layer_order;
 	INT32 viswidth, visheight;
 	int layernum, listnum;
+	int cacheindex = 0;
 
 	/* remember the base values if this is the first frame */
 	if (target->base_view == NULL)
@@ -1451,6 +1529,20 @@ const render_primitive_list *render_target_get_primitives(render_target *target)
 	root_xform.color.r = root_xform.color.g = root_xform.color.b = root_xform.color.a = 1.0f;
 	root_xform.orientation = target->orientation;
 
+	/* the cached element primitives are only good for the geometry they were built with */
+	if (target->elemcache_view != target->curview || memcmp(&target->elemcache_xform, &root_xform, sizeof(root_xform)) != 0 ||
+		memcmp(&target->elemcache_bounds, &target->bounds, sizeof(target->bounds)) != 0 || target->elemcache_layerconfig != target->layerconfig ||
+		target->elemcache_maxtexwidth != target->maxtexwidth || target->elemcache_maxtexheight != target->maxtexheight)
+	{
+		invalidate_element_cache(target);
+		target->elemcache_view = target->curview;
+		target->elemcache_xform = root_xform;
+		target->elemcache_bounds = target->bounds;
+		target->elemcache_layerconfig = target->layerconfig;
+		target->elemcache_maxtexwidth = target->maxtexwidth;
+		target->elemcache_maxtexheight = target->maxtexheight;
+	}
+
 	/*
         if we have multiple backdrop pieces and no overlays, render:
             backdrop (add) + screens (add) + bezels (alpha)
@@ -1508,7 +1600,7 @@ const render_primitive_list *render_target_get_primitives(render_target *target)
 					if (item->element != NULL)
 					{
 						int state = (item->name[0] == 0) ? 0 : output_get_value(item->name);
-						add_element_primitives(target, &target->primlist[listnum], &item_xform, item->element, state, blendmode);
+						add_element_primitives(target, &target->primlist[listnum], cacheindex++, &item_xform, item->element, state, blendmode);
 					}
 					else
 						add_container_primitives(target, &target->primlist[listnum], &item_xform, screen_container[item->index], blendmode);
@@ -1524,14 +1616,14 @@ const render_primitive_list *render_target_get_primitives(render_target *target)
 	{
 		render_primitive *prim;
 
-		prim = alloc_render_primitive(RENDER_PRIMITIVE_QUAD);
+		prim = alloc_render_primitive(&target->primlist[listnum], RENDER_PRIMITIVE_QUAD);
 		set_render_bounds_xy(&prim->bounds, 0.0f, 0.0f, (float)target->width, (float)target->height);
 		set_render_color(&prim->color, 1.0f, 1.0f, 1.0f, 1.0f);
 		prim->texture.base = NULL;
 		prim->flags = PRIMFLAG_BLENDMODE(BLENDMODE_ALPHA);
 		append_render_primitive(&target->primlist[listnum], prim);
 
-		prim = alloc_render_primitive(RENDER_PRIMITIVE_QUAD);
+		prim = alloc_render_primitive(&target->primlist[listnum], RENDER_PRIMITIVE_QUAD);
 		set_render_bounds_xy(&prim->bounds, 1.0f, 1.0f, (float)(target->width - 1), (float)(target->height - 1));
 		set_render_color(&prim->color, 1.0f, 0.0f, 0.0f, 0.0f);
 		prim->texture.base = NULL;
@@ -1639,14 +1731,14 @@ static void release_render_list(render_primitive_list *list)
 	/* take the lock */
 	osd_lock_acquire(list->lock);
 
-	/* free everything on the list */
-	while (list->head != NULL)
+	/* everything on the list came from the arena, so just reset it */
+	list->head = NULL;
+	list->nextptr = &list->head;
+	if (list->arena != NULL)
 	{
-		render_primitive *temp = list->head;
-		list->head = temp->next;
-		free_render_primitive(temp);
+		list->arena->curchunk = NULL;
+		list->arena->curindex = 0;
 	}
-	list->nextptr = &list->head;
 
 	/* release all our references */
 	while (list->reflist != NULL)
@@ -1711,7 +1803,7 @@ static void add_container_primitives(render_target *target, render_primitive_lis
 		apply_orientation(&bounds, container_xform.orientation);
 
 		/* allocate the primitive and set the transformed bounds/color data */
-		prim = alloc_render_primitive(0);
+		prim = alloc_render_primitive(list, 0);
 		prim->bounds.x0 = render_round_nearest(container_xform.xoffs + bounds.x0 * container_xform.xscale);
 		prim->bounds.y0 = render_round_nearest(container_xform.yoffs + bounds.y0 * container_xform.yscale);
 		if (item->internal & INTERNAL_FLAG_CHAR)
@@ -1770,7 +1862,7 @@ static void add_container_primitives(render_target *target, render_primitive_lis
 					height = (finalorient & ORIENTATION_SWAP_XY) ? (prim->bounds.x1 - prim->bounds.x0) : (prim->bounds.y1 - prim->bounds.y0);
 					width = MIN(width, target->maxtexwidth);
 					height = MIN(height, target->maxtexheight);
-					if (render_texture_get_scaled(item->texture, width, height, &prim->texture, &list->reflist))
+					if (render_texture_get_scaled(item->texture, width, height, &prim->texture, &list->reflist, NULL))
 					{
 						/* override the palette with our adjusted palette */
 						switch (item->texture->format)
@@ -1819,7 +1911,7 @@ static void add_container_primitives(render_target *target, render_primitive_lis
 		if (!clipped)
 			append_render_primitive(list, prim);
 		else
-			free_render_primitive(prim);
+			free_render_primitive(list, prim);
 	}
 
 	/* add the overlay if it exists */
@@ -1828,14 +1920,14 @@ static void add_container_primitives(render_target *target, render_primitive_lis
 		INT32 width, height;
 
 		/* allocate a primitive */
-		prim = alloc_render_primitive(RENDER_PRIMITIVE_QUAD);
+		prim = alloc_render_primitive(list, RENDER_PRIMITIVE_QUAD);
 		set_render_bounds_wh(&prim->bounds, xform->xoffs, xform->yoffs, xform->xscale, xform->yscale);
 		prim->color = container_xform.color;
 		width = render_round_nearest(prim->bounds.x1) - render_round_nearest(prim->bounds.x0);
 		height = render_round_nearest(prim->bounds.y1) - render_round_nearest(prim->bounds.y0);
 		if (render_texture_get_scaled(container->overlaytexture,
 				(container_xform.orientation & ORIENTATION_SWAP_XY) ? height : width,
-				(container_xform.orientation & ORIENTATION_SWAP_XY) ? width : height, &prim->texture, &list->reflist))
+				(container_xform.orientation & ORIENTATION_SWAP_XY) ? width : height, &prim->texture, &list->reflist, NULL))
 		{
 			/* determine UV coordinates */
 			prim->texcoords = oriented_texcoords[container_xform.orientation];
@@ -1847,17 +1939,71 @@ static void add_container_primitives(render_target *target, render_primitive_lis
 			append_render_primitive(list, prim);
 		}
 		else
-			free_render_primitive(prim);
+			free_render_primitive(list, prim);
 	}
 }
 
 
 /*-------------------------------------------------
     add_element_primitives - add the primitive
-    for an element in the current state
+    for an element in the current state, reusing
+    the cached one if nothing has changed
+-------------------------------------------------*/
+
+static void add_element_primitives(render_target *target, render_primitive_list *list, int cacheindex, const object_transform *xform, const layout_element *element, int state, int blendmode)
+{
+	element_cache_entry *entry;
+
+	/* grow the cache if needed */
+	if (cacheindex >= target->elemcache_alloc)
+	{
+		int newalloc = MAX(cacheindex + 1, target->elemcache_alloc * 2);
+		element_cache_entry *newcache = malloc_or_die(newalloc * sizeof(*newcache));
+
+		memset(newcache, 0, newalloc * sizeof(*newcache));
+		if (target->elemcache != NULL)
+		{
+			memcpy(newcache, target->elemcache, target->elemcache_alloc * sizeof(*newcache));
+			free(target->elemcache);
+		}
+		target->elemcache = newcache;
+		target->elemcache_alloc = newalloc;
+	}
+	entry = &target->elemcache[cacheindex];
+
+	/* rebuild the primitive if the element, its state, or the blending changed */
+	if (!entry->valid || entry->element != element || entry->state != state || entry->blendmode != blendmode)
+	{
+		entry->element = element;
+		entry->state = state;
+		entry->blendmode = blendmode;
+		entry->ref = NULL;
+		entry->visible = build_element_primitive(target, list, xform, element, state, blendmode, &entry->prim, &entry->ref);
+		entry->valid = TRUE;
+		if (entry->ref != NULL)
+			add_render_ref(&target->elemcache_refs, entry->ref);
+	}
+
+	/* copy the primitive into the list */
+	if (entry->visible)
+	{
+		render_primitive *prim = alloc_render_primitive(list, RENDER_PRIMITIVE_QUAD);
+		*prim = entry->prim;
+		prim->next = NULL;
+		if (entry->ref != NULL)
+			add_render_ref(&list->reflist, entry->ref);
+		append_render_primitive(list, prim);
+	}
+}
+
+
+/*-------------------------------------------------
+    build_element_primitive - compute the
+    primitive for an element in a given state;
+    returns FALSE if nothing is visible
 -------------------------------------------------*/
 
-static void add_element_primitives(render_target *target, render_primitive_list *list, const object_transform *xform, const layout_element *element, int state, int blendmode)
+static int build_element_primitive(render_target *target, render_primitive_list *list, const object_transform *xform, const layout_element *element, int state, int blendmode, render_primitive *prim, void **ref)
 {
 	INT32 width = render_round_nearest(xform->xscale);
 	INT32 height = render_round_nearest(xform->yscale);
@@ -1867,47 +2013,63 @@ static void add_element_primitives(render_target *target, render_primitive_list
 
 	/* if we're out of range, bail */
 	if (state > element->maxstate)
-		return;
+		return FALSE;
 	if (state < 0)
 		state = 0;
 
 	/* get a pointer to the relevant texture */
 	texture = element->elemtex[state].texture;
-	if (texture != NULL)
+	if (texture == NULL)
+		return FALSE;
+
+	/* configure the basics */
+	memset(prim, 0, sizeof(*prim));
+	prim->type = RENDER_PRIMITIVE_QUAD;
+	prim->color = xform->color;
+	prim->flags = PRIMFLAG_TEXORIENT(xform->orientation) | PRIMFLAG_BLENDMODE(blendmode) | PRIMFLAG_TEXFORMAT(texture->format);
+
+	/* compute the bounds */
+	set_render_bounds_wh(&prim->bounds, render_round_nearest(xform->xoffs), render_round_nearest(xform->yoffs), width, height);
+	if (xform->orientation & ORIENTATION_SWAP_XY)
+		ISWAP(width, height);
+	width = MIN(width, target->maxtexwidth);
+	height = MIN(height, target->maxtexheight);
+
+	/* get the scaled texture, noting which bitmap it refers to */
+	if (render_texture_get_scaled(texture, width, height, &prim->texture, &list->reflist, ref))
 	{
-		render_primitive *prim = alloc_render_primitive(RENDER_PRIMITIVE_QUAD);
+		/* compute the clip rect */
+		cliprect.x0 = render_round_nearest(xform->xoffs);
+		cliprect.y0 = render_round_nearest(xform->yoffs);
+		cliprect.x1 = render_round_nearest(xform->xoffs + xform->xscale);
+		cliprect.y1 = render_round_nearest(xform->yoffs + xform->yscale);
+		sect_render_bounds(&cliprect, &target->bounds);
+
+		/* determine UV coordinates and apply clipping */
+		prim->texcoords = oriented_texcoords[xform->orientation];
+		clipped = render_clip_quad(&prim->bounds, &cliprect, &prim->texcoords);
+	}
+	return !clipped;
+}
 
-		/* configure the basics */
-		prim->color = xform->color;
-		prim->flags = PRIMFLAG_TEXORIENT(xform->orientation) | PRIMFLAG_BLENDMODE(blendmode) | PRIMFLAG_TEXFORMAT(texture->format);
 
-		/* compute the bounds */
-		set_render_bounds_wh(&prim->bounds, render_round_nearest(xform->xoffs), render_round_nearest(xform->yoffs), width, height);
-		if (xform->orientation & ORIENTATION_SWAP_XY)
-			ISWAP(width, height);
-		width = MIN(width, target->maxtexwidth);
-		height = MIN(height, target->maxtexheight);
+/*-------------------------------------------------
+    invalidate_element_cache - throw away all the
+    cached element primitives for a target
+-------------------------------------------------*/
 
-		/* get the scaled texture and append it */
-		if (render_texture_get_scaled(texture, width, height, &prim->texture, &list->reflist))
-		{
-			/* compute the clip rect */
-			cliprect.x0 = render_round_nearest(xform->xoffs);
-			cliprect.y0 = render_round_nearest(xform->yoffs);
-			cliprect.x1 = render_round_nearest(xform->xoffs + xform->xscale);
-			cliprect.y1 = render_round_nearest(xform->yoffs + xform->yscale);
-			sect_render_bounds(&cliprect, &target->bounds);
-
-			/* determine UV coordinates and apply clipping */
-			prim->texcoords = oriented_texcoords[xform->orientation];
-			clipped = render_clip_quad(&prim->bounds, &cliprect, &prim->texcoords);
-		}
+static void invalidate_element_cache(render_target *target)
+{
+	int entrynum;
 
-		/* add to the list or free if we're clipped out */
-		if (!clipped)
-			append_render_primitive(list, prim);
-		else
-			free_render_primitive(prim);
+	for (entrynum = 0; entrynum < target->elemcache_alloc; entrynum++)
+		target->elemcache[entrynum].valid = FALSE;
+
+	while (target->elemcache_refs != NULL)
+	{
+		render_ref *temp = target->elemcache_refs;
+		target->elemcache_refs = temp->next;
+		free_render_ref(temp);
 	}
 }
 
@@ -2094,7 +2256,7 @@ static void add_clear_extents(render_primitive_list *list)
 			/* only add entries for non-zero widths */
 			if (x1 - x0 > 0)
 			{
-				render_primitive *prim = alloc_render_primitive(RENDER_PRIMITIVE_QUAD);
+				render_primitive *prim = alloc_render_primitive(list, RENDER_PRIMITIVE_QUAD);
 				set_render_bounds_xy(&prim->bounds, (float)x0, (float)y0, (float)x1, (float)y1);
 				set_render_color(&prim->color, 1.0f, 0.0f, 0.0f, 0.0f);
 				prim->texture.base = NULL;
@@ -2128,11 +2290,15 @@ static void add_clear_and_optimize_primitive_list(render_target *target, render_
 {
 	render_primitive *prim;
 
+	int quads = 0;
+
 	/* start with the assumption that we need to clear the whole screen */
 	init_clear_extents(target->width, target->height);
 
-	/* scan the list until we hit an intersection quad or a line */
-	for (prim = list->head; prim != NULL; prim = prim->next)
+	/* scan the list until we hit an intersection quad or a line; every quad we remove */
+	/* can split the extents further, so stop after a reasonable number (layouts with */
+	/* hundreds of lamps would otherwise spend more time here than drawing) */
+	for (prim = list->head; prim != NULL && quads < MAX_CLEAR_QUADS; prim = prim->next, quads++)
 	{
 		/* switch off the type */
 		switch (prim->type)
@@ -2197,6 +2363,7 @@ static void invalidate_all_render_ref(void *refptr)
 
 	/* loop over targets */
 	for (target = targetlist; target != NULL; target = target->next)
+	{
 		for (listnum = 0; listnum < NUM_PRIMLISTS; listnum++)
 		{
 			render_primitive_list *list = &target->primlist[listnum];
@@ -2205,6 +2372,11 @@ static void invalidate_all_render_ref(void *refptr)
 				release_render_list(list);
 			osd_lock_release(list->lock);
 		}
+
+		/* cached element primitives can't refer to it either */
+		if (has_render_ref(target->elemcache_refs, refptr))
+			invalidate_element_cache(target);
+	}
 }
 
 
@@ -2323,7 +2495,7 @@ void render_texture_set_bitmap(render_texture *texture, mame_bitmap *bitmap, con
     bitmap (if we can)
 -------------------------------------------------*/
 
-static int render_texture_get_scaled(render_texture *texture, UINT32 dwidth, UINT32 dheight, render_texinfo *texinfo, render_ref **reflist)
+static int render_texture_get_scaled(render_texture *texture, UINT32 dwidth, UINT32 dheight, render_texinfo *texinfo, render_ref **reflist, void **refptr)
 {
 	UINT8 bpp = (texture->format == TEXFORMAT_PALETTE16 || texture->format == TEXFORMAT_PALETTEA16 || texture->format == TEXFORMAT_RGB15 || texture->format == TEXFORMAT_YUY16) ? 16 : 32;
 	const rgb_t *palbase = (texture->format == TEXFORMAT_PALETTE16 || texture->format == TEXFORMAT_PALETTEA16) ? palette_entry_list_adjusted(Machine->palette) + texture->palettebase : NULL;
@@ -2344,6 +2516,8 @@ static int render_texture_get_scaled(render_texture *texture, UINT32 dwidth, UIN
 	{
 		/* add a reference and set up the source bitmap */
 		add_render_ref(reflist, texture->bitmap);
+		if (refptr != NULL)
+			*refptr = texture->bitmap;
 		texinfo->base = (UINT8 *)texture->bitmap->base + (texture->sbounds.min_y * texture->bitmap->rowpixels + texture->sbounds.min_x) * (bpp / 8);
 		texinfo->rowpixels = texture->bitmap->rowpixels;
 		texinfo->width = swidth;
@@ -2396,6 +2570,8 @@ static int render_texture_get_scaled(render_texture *texture, UINT32 dwidth, UIN
 
 	/* finally fill out the new info */
 	add_render_ref(reflist, scaled->bitmap);
+	if (refptr != NULL)
+		*refptr = scaled->bitmap;
 	texinfo->base = scaled->bitmap->base;
 	texinfo->rowpixels = scaled->bitmap->rowpixels;
 	texinfo->width = dwidth;
@@ -284,6 +284,7 @@ struct _render_primitive
     a list head plus a lock
 -------------------------------------------------*/
 
+typedef struct _render_primitive_arena render_primitive_arena;
 typedef struct _render_primitive_list render_primitive_list;
 struct _render_primitive_list
 {
@@ -291,6 +292,7 @@ struct _render_primitive_list
 	render_primitive **	nextptr;			/* pointer to the next tail pointer */
 	osd_lock *			lock;				/* should only should be accessed under this lock */
 	render_ref *		reflist;			/* list of references */
+	render_primitive_arena *arena;			/* memory the primitives are allocated from (internal) */
 };
 
 
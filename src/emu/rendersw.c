@@ -54,6 +54,7 @@
 #include "mamecore.h"
 #include "eminline.h"
 #include "render.h"
+#include "rendsimd.h"
 #include <math.h>
 
 
@@ -70,6 +71,9 @@
 #define IS_OPAQUE(a)		(a >= (NO_DEST_READ ? 0.5f : 1.0f))
 #define IS_TRANSPARENT(a)	(a <  (NO_DEST_READ ? 0.5f : 0.0001f))
 
+#define BAND_HEIGHT_MIN		32			/* smallest band handed to a worker thread */
+#define MAX_BANDS			64			/* maximum number of bands per frame */
+
 
 
 /***************************************************************************
@@ -86,6 +90,17 @@ struct _quad_setup_data
 };
 
 
+typedef struct _band_data band_data;
+struct _band_data
+{
+	const render_primitive *primlist;	/* list of primitives to draw */
+	void *			dstdata;			/* base of the destination buffer */
+	INT32			width, height;		/* full size of the destination */
+	UINT32			pitch;				/* destination pitch in pixels */
+	INT32			miny, maxy;			/* rows covered by this band */
+};
+
+
 
 /***************************************************************************
     GLOBAL VARIABLES
@@ -171,6 +186,9 @@ INLINE UINT32 ycc_to_rgb(UINT8 y, UINT8 cb, UINT8 cr)
 #define DEST_ASSEMBLE_RGB(r,g,b)	(((r) << DSTSHIFT_R) | ((g) << DSTSHIFT_G) | ((b) << DSTSHIFT_B))
 #define DEST_RGB_TO_PIXEL(r,g,b)	DEST_ASSEMBLE_RGB((r) >> SRCSHIFT_R, (g) >> SRCSHIFT_G, (b) >> SRCSHIFT_B)
 
+/* blended components can exceed the channel when a color factor is out of range; saturate them */
+#define DEST_ASSEMBLE_RGB_CLAMP(r,g,b)	DEST_ASSEMBLE_RGB(MIN(r, 0xff >> SRCSHIFT_R), MIN(g, 0xff >> SRCSHIFT_G), MIN(b, 0xff >> SRCSHIFT_B))
+
 /* destination pixel masks are based on the macros as well */
 #define DEST_R(pix)			(((pix) >> DSTSHIFT_R) & (0xff >> SRCSHIFT_R))
 #define DEST_G(pix)			(((pix) >> DSTSHIFT_G) & (0xff >> SRCSHIFT_G))
@@ -194,6 +212,15 @@ INLINE UINT32 ycc_to_rgb(UINT8 y, UINT8 cb, UINT8 cr)
 #endif
 #endif
 
+/* native 32bpp destinations can use the SIMD span kernels */
+#define QUAD_SPANS				0
+#if defined(RENDSIMD_AVAILABLE) && !defined(VARIABLE_SHIFT) && !NO_DEST_READ
+#if (SRCSHIFT_R == 0) && (SRCSHIFT_G == 0) && (SRCSHIFT_B == 0) && (DSTSHIFT_R == 16) && (DSTSHIFT_G == 8) && (DSTSHIFT_B == 0)
+#undef QUAD_SPANS
+#define QUAD_SPANS				1
+#endif
+#endif
+
 
 
 /***************************************************************************
@@ -393,7 +420,7 @@ static void FUNC_PREFIX(draw_line)(const render_primitive *prim, void *dstdata,
     draw_rect - draw a solid rectangle
 -------------------------------------------------*/
 
-static void FUNC_PREFIX(draw_rect)(const render_primitive *prim, void *dstdata, INT32 width, INT32 height, UINT32 pitch)
+static void FUNC_PREFIX(draw_rect)(const render_primitive *prim, void *dstdata, INT32 width, INT32 height, UINT32 pitch, INT32 miny, INT32 maxy)
 {
 	render_bounds fpos = prim->bounds;
 	INT32 startx, starty, endx, endy;
@@ -418,6 +445,10 @@ static void FUNC_PREFIX(draw_rect)(const render_primitive *prim, void *dstdata,
 	if (endy < 0) endy = 0;
 	if (endy >= height) endy = height;
 
+	/* clip to the band we are drawing */
+	if (starty < miny) starty = miny;
+	if (endy > maxy) endy = maxy;
+
 	/* bail if nothing left */
 	if (fpos.x0 > fpos.x1 || fpos.y0 > fpos.y1)
 		return;
@@ -512,6 +543,13 @@ static void FUNC_PREFIX(draw_quad_palette16_none)(const render_primitive *prim,
 	INT32 endx = setup->endx;
 	INT32 x, y;
 
+#if QUAD_SPANS
+	/* hand the common cases to the SIMD span kernels */
+	if (rendsimd_draw_quad(prim, dstdata, pitch, setup->startx, setup->starty, setup->endx, setup->endy,
+			setup->startu, setup->startv, dudx, dvdx, setup->dudy, setup->dvdy, RENDSIMD_FETCH_PALETTE16, RENDSIMD_BLEND_NONE))
+		return;
+#endif
+
 	/* ensure all parameters are valid */
 	assert(palbase != NULL);
 
@@ -600,7 +638,7 @@ static void FUNC_PREFIX(draw_quad_palette16_none)(const render_primitive *prim,
 				UINT32 g = (SOURCE32_G(pix) * sg + DEST_G(dpix) * invsa) >> 8;
 				UINT32 b = (SOURCE32_B(pix) * sb + DEST_B(dpix) * invsa) >> 8;
 
-				*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+				*dest++ = DEST_ASSEMBLE_RGB_CLAMP(r, g, b);
 				curu += dudx;
 				curv += dvdx;
 			}
@@ -624,6 +662,13 @@ static void FUNC_PREFIX(draw_quad_palette16_add)(const render_primitive *prim, v
 	INT32 endx = setup->endx;
 	INT32 x, y;
 
+#if QUAD_SPANS
+	/* hand the common cases to the SIMD span kernels */
+	if (rendsimd_draw_quad(prim, dstdata, pitch, setup->startx, setup->starty, setup->endx, setup->endy,
+			setup->startu, setup->startv, dudx, dvdx, setup->dudy, setup->dvdy, RENDSIMD_FETCH_PALETTE16, RENDSIMD_BLEND_ADD))
+		return;
+#endif
+
 	/* ensure all parameters are valid */
 	assert(palbase != NULL);
 
@@ -952,7 +997,7 @@ static void FUNC_PREFIX(draw_quad_yuy16_none)(const render_primitive *prim, void
 					UINT32 g = (SOURCE32_G(pix) * sg + DEST_G(dpix) * invsa) >> 8;
 					UINT32 b = (SOURCE32_B(pix) * sb + DEST_B(dpix) * invsa) >> 8;
 
-					*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest++ = DEST_ASSEMBLE_RGB_CLAMP(r, g, b);
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -971,7 +1016,7 @@ static void FUNC_PREFIX(draw_quad_yuy16_none)(const render_primitive *prim, void
 					UINT32 g = (SOURCE32_G(pix) * sg + DEST_G(dpix) * invsa) >> 8;
 					UINT32 b = (SOURCE32_B(pix) * sb + DEST_B(dpix) * invsa) >> 8;
 
-					*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest++ = DEST_ASSEMBLE_RGB_CLAMP(r, g, b);
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -1130,7 +1175,7 @@ static void FUNC_PREFIX(draw_quad_rgb15)(const render_primitive *prim, void *dst
 					UINT32 g = (SOURCE15_G(pix) * sg + DEST_G(dpix) * invsa) >> 8;
 					UINT32 b = (SOURCE15_B(pix) * sb + DEST_B(dpix) * invsa) >> 8;
 
-					*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest++ = DEST_ASSEMBLE_RGB_CLAMP(r, g, b);
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -1148,7 +1193,7 @@ static void FUNC_PREFIX(draw_quad_rgb15)(const render_primitive *prim, void *dst
 					UINT32 g = ((palbase[(pix >> 5) & 0x1f] >> SRCSHIFT_G) * sg + DEST_G(dpix) * invsa) >> 8;
 					UINT32 b = ((palbase[(pix >> 0) & 0x1f] >> SRCSHIFT_B) * sb + DEST_B(dpix) * invsa) >> 8;
 
-					*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest++ = DEST_ASSEMBLE_RGB_CLAMP(r, g, b);
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -1178,6 +1223,13 @@ static void FUNC_PREFIX(draw_quad_rgb32)(const render_primitive *prim, void *dst
 	INT32 endx = setup->endx;
 	INT32 x, y;
 
+#if QUAD_SPANS
+	/* hand the common cases to the SIMD span kernels */
+	if (palbase == NULL && rendsimd_draw_quad(prim, dstdata, pitch, setup->startx, setup->starty, setup->endx, setup->endy,
+			setup->startu, setup->startv, dudx, dvdx, setup->dudy, setup->dvdy, RENDSIMD_FETCH_RGB32, RENDSIMD_BLEND_NONE))
+		return;
+#endif
+
 	/* fast case: no coloring, no alpha */
 	if (prim->color.r >= 1.0f && prim->color.g >= 1.0f && prim->color.b >= 1.0f && IS_OPAQUE(prim->color.a))
 	{
@@ -1308,7 +1360,7 @@ static void FUNC_PREFIX(draw_quad_rgb32)(const render_primitive *prim, void *dst
 					UINT32 g = (SOURCE32_G(pix) * sg + DEST_G(dpix) * invsa) >> 8;
 					UINT32 b = (SOURCE32_B(pix) * sb + DEST_B(dpix) * invsa) >> 8;
 
-					*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest++ = DEST_ASSEMBLE_RGB_CLAMP(r, g, b);
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -1326,7 +1378,7 @@ static void FUNC_PREFIX(draw_quad_rgb32)(const render_primitive *prim, void *dst
 					UINT32 g = ((palbase[(pix >> 8) & 0xff] >> SRCSHIFT_G) * sg + DEST_G(dpix) * invsa) >> 8;
 					UINT32 b = ((palbase[(pix >> 0) & 0xff] >> SRCSHIFT_B) * sb + DEST_B(dpix) * invsa) >> 8;
 
-					*dest++ = DEST_ASSEMBLE_RGB(r, g, b);
+					*dest++ = DEST_ASSEMBLE_RGB_CLAMP(r, g, b);
 					curu += dudx;
 					curv += dvdx;
 				}
@@ -1356,6 +1408,13 @@ static void FUNC_PREFIX(draw_quad_argb32_alpha)(const render_primitive *prim, vo
 	INT32 endx = setup->endx;
 	INT32 x, y;
 
+#if QUAD_SPANS
+	/* hand the common cases to the SIMD span kernels */
+	if (palbase == NULL && rendsimd_draw_quad(prim, dstdata, pitch, setup->startx, setup->starty, setup->endx, setup->endy,
+			setup->startu, setup->startv, dudx, dvdx, setup->dudy, setup->dvdy, RENDSIMD_FETCH_RGB32, RENDSIMD_BLEND_ALPHA))
+		return;
+#endif
+
 	/* fast case: no coloring, no alpha */
 	if (prim->color.r >= 1.0f && prim->color.g >= 1.0f && prim->color.b >= 1.0f && IS_OPAQUE(prim->color.a))
 	{
@@ -1505,6 +1564,13 @@ static void FUNC_PREFIX(draw_quad_argb32_multiply)(const render_primitive *prim,
 	INT32 endx = setup->endx;
 	INT32 x, y;
 
+#if QUAD_SPANS
+	/* hand the common cases to the SIMD span kernels */
+	if (palbase == NULL && rendsimd_draw_quad(prim, dstdata, pitch, setup->startx, setup->starty, setup->endx, setup->endy,
+			setup->startu, setup->startv, dudx, dvdx, setup->dudy, setup->dvdy, RENDSIMD_FETCH_RGB32, RENDSIMD_BLEND_MULTIPLY))
+		return;
+#endif
+
 	/* simply can't do this without reading from the dest */
 	if (NO_DEST_READ)
 		return;
@@ -1627,6 +1693,13 @@ static void FUNC_PREFIX(draw_quad_argb32_add)(const render_primitive *prim, void
 	INT32 endx = setup->endx;
 	INT32 x, y;
 
+#if QUAD_SPANS
+	/* hand the common cases to the SIMD span kernels */
+	if (palbase == NULL && rendsimd_draw_quad(prim, dstdata, pitch, setup->startx, setup->starty, setup->endx, setup->endy,
+			setup->startu, setup->startv, dudx, dvdx, setup->dudy, setup->dvdy, RENDSIMD_FETCH_RGB32, RENDSIMD_BLEND_ADD_ALPHA))
+		return;
+#endif
+
 	/* simply can't do this without reading from the dest */
 	if (NO_DEST_READ)
 		return;
@@ -1779,7 +1852,7 @@ static void FUNC_PREFIX(draw_quad_argb32_add)(const render_primitive *prim, void
     drawing routine
 -------------------------------------------------*/
 
-static void FUNC_PREFIX(setup_and_draw_textured_quad)(const render_primitive *prim, void *dstdata, INT32 width, INT32 height, UINT32 pitch)
+static void FUNC_PREFIX(setup_and_draw_textured_quad)(const render_primitive *prim, void *dstdata, INT32 width, INT32 height, UINT32 pitch, INT32 miny, INT32 maxy)
 {
 	float fdudx, fdvdx, fdudy, fdvdy;
 	quad_setup_data setup;
@@ -1821,6 +1894,18 @@ static void FUNC_PREFIX(setup_and_draw_textured_quad)(const render_primitive *pr
 	setup.startu += (setup.dudx + setup.dudy) / 2;
 	setup.startv += (setup.dvdx + setup.dvdy) / 2;
 
+	/* clip to the band we are drawing, stepping U/V down to the first row */
+	if (setup.starty < miny)
+	{
+		setup.startu += (miny - setup.starty) * setup.dudy;
+		setup.startv += (miny - setup.starty) * setup.dvdy;
+		setup.starty = miny;
+	}
+	if (setup.endy > maxy)
+		setup.endy = maxy;
+	if (setup.starty >= setup.endy)
+		return;
+
 	/* render based on the texture coordinates */
 	switch (prim->flags & (PRIMFLAG_TEXFORMAT_MASK | PRIMFLAG_BLENDMODE_MASK))
 	{
@@ -1873,7 +1958,35 @@ static void FUNC_PREFIX(setup_and_draw_textured_quad)(const render_primitive *pr
 
 
 /***************************************************************************
-    PRIMARY ENTRY POINT
+    BAND RENDERING
+***************************************************************************/
+
+/*-------------------------------------------------
+    draw_band - work item callback that renders
+    all the quads in a primitive list clipped to
+    a single horizontal band
+-------------------------------------------------*/
+
+static void *FUNC_PREFIX(draw_band)(void *param, int threadid)
+{
+	const band_data *band = param;
+	const render_primitive *prim;
+
+	for (prim = band->primlist; prim != NULL; prim = prim->next)
+		if (prim->type == RENDER_PRIMITIVE_QUAD)
+		{
+			if (!prim->texture.base)
+				FUNC_PREFIX(draw_rect)(prim, band->dstdata, band->width, band->height, band->pitch, band->miny, band->maxy);
+			else
+				FUNC_PREFIX(setup_and_draw_textured_quad)(prim, band->dstdata, band->width, band->height, band->pitch, band->miny, band->maxy);
+		}
+	return NULL;
+}
+
+
+
+/***************************************************************************
+    PRIMARY ENTRY POINTS
 ***************************************************************************/
 
 /*-------------------------------------------------
@@ -1895,14 +2008,64 @@ void FUNC_PREFIX(draw_primitives)(const render_primitive *primlist, void *dstdat
 
 			case RENDER_PRIMITIVE_QUAD:
 				if (!prim->texture.base)
-					FUNC_PREFIX(draw_rect)(prim, dstdata, width, height, pitch);
+					FUNC_PREFIX(draw_rect)(prim, dstdata, width, height, pitch, 0, height);
 				else
-					FUNC_PREFIX(setup_and_draw_textured_quad)(prim, dstdata, width, height, pitch);
+					FUNC_PREFIX(setup_and_draw_textured_quad)(prim, dstdata, width, height, pitch, 0, height);
 				break;
 		}
 }
 
 
+/*-------------------------------------------------
+    draw_primitives_banded - draw a series of
+    primitives by splitting the target into
+    horizontal bands and rendering each band on
+    the given work queue; output is identical to
+    draw_primitives
+-------------------------------------------------*/
+
+void FUNC_PREFIX(draw_primitives_banded)(const render_primitive *primlist, void *dstdata, UINT32 width, UINT32 height, UINT32 pitch, osd_work_queue *queue)
+{
+	band_data band[MAX_BANDS];
+	const render_primitive *prim;
+	UINT32 bandheight, bandcount, bandnum;
+
+	/* small targets aren't worth the overhead */
+	if (queue == NULL || height < 2 * BAND_HEIGHT_MIN)
+	{
+		FUNC_PREFIX(draw_primitives)(primlist, dstdata, width, height, pitch);
+		return;
+	}
+
+	/* lines are not clipped per band, so any list containing them is drawn serially */
+	for (prim = primlist; prim != NULL; prim = prim->next)
+		if (prim->type == RENDER_PRIMITIVE_LINE)
+		{
+			FUNC_PREFIX(draw_primitives)(primlist, dstdata, width, height, pitch);
+			return;
+		}
+
+	/* carve the target into bands */
+	bandheight = MAX(BAND_HEIGHT_MIN, (height + MAX_BANDS - 1) / MAX_BANDS);
+	bandcount = (height + bandheight - 1) / bandheight;
+	for (bandnum = 0; bandnum < bandcount; bandnum++)
+	{
+		band[bandnum].primlist = primlist;
+		band[bandnum].dstdata = dstdata;
+		band[bandnum].width = width;
+		band[bandnum].height = height;
+		band[bandnum].pitch = pitch;
+		band[bandnum].miny = bandnum * bandheight;
+		band[bandnum].maxy = MIN(height, (bandnum + 1) * bandheight);
+	}
+
+	/* queue them all and wait; the band array lives on our stack, so we can't return while they run */
+	osd_work_item_queue_multiple(queue, FUNC_PREFIX(draw_band), bandcount, band, sizeof(band[0]), WORK_ITEM_FLAG_AUTO_RELEASE);
+	if (!osd_work_queue_wait(queue, osd_ticks_per_second() * 100))
+		fatalerror("draw_primitives_banded: bands never completed");
+}
+
+
 
 /***************************************************************************
     MACRO UNDOING
@@ -1918,6 +2081,7 @@ void FUNC_PREFIX(draw_primitives)(const render_primitive *primlist, void *dstdat
 
 #undef DEST_ASSEMBLE_RGB
 #undef DEST_RGB_TO_PIXEL
+#undef DEST_ASSEMBLE_RGB_CLAMP
 
 #undef DEST_R
 #undef DEST_G
@@ -1940,3 +2104,5 @@ void FUNC_PREFIX(draw_primitives)(const render_primitive *primlist, void *dstdat
 #undef NO_DEST_READ
 
 #undef VARIABLE_SHIFT
+
+#undef QUAD_SPANS
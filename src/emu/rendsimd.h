@@ -0,0 +1,673 @@
+/***************************************************************************
+
+    rendsimd.h
+
+    SIMD span kernels for the software rasterizer.
+
+    Copyright (c) 1996-2007, Nicola Salmoria and the MAME Team.
+    Visit http://mamedev.org for licensing and usage restrictions.
+
+****************************************************************************
+
+    These kernels cover the point-sampled quad rasterizers in rendersw.c
+    when the destination is 32bpp in MAME's native xRGB layout and the
+    texture needs no per-channel lookup. Each row is processed in chunks: the
+    texels are fetched into a small buffer and then combined with the
+    destination by one of the span operations below.
+
+    SSE2 is the baseline, selected at compile time the same way as in
+    rgbutil.h. An AVX2 variant of the hottest kernels is selected at
+    runtime when the compiler can target it and the CPU supports it.
+
+***************************************************************************/
+
+#ifndef __RENDSIMD_H__
+#define __RENDSIMD_H__
+
+/* use SSE on 64-bit implementations, where it can be assumed */
+#if (defined(__SSE2__) && defined(PTR64))
+#define RENDSIMD_AVAILABLE
+
+#include <emmintrin.h>
+
+/* AVX2 kernels need per-function target support from the compiler */
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define RENDSIMD_AVX2
+#include <immintrin.h>
+#define AVX2_FUNC			__attribute__((target("avx2")))
+#endif
+
+
+
+/***************************************************************************
+    CONSTANTS
+***************************************************************************/
+
+#define RENDSIMD_CHUNK		256			/* texels fetched per pass */
+
+/* texel fetch types */
+enum
+{
+	RENDSIMD_FETCH_RGB32,				/* 32bpp texture, no lookup */
+	RENDSIMD_FETCH_PALETTE16			/* 16bpp palettized texture */
+};
+
+/* span blending types */
+enum
+{
+	RENDSIMD_BLEND_NONE,				/* replace, with optional coloring/alpha */
+	RENDSIMD_BLEND_ALPHA,				/* per-texel alpha blend */
+	RENDSIMD_BLEND_MULTIPLY,			/* RGB multiply */
+	RENDSIMD_BLEND_ADD_ALPHA,			/* RGB add scaled by texel alpha */
+	RENDSIMD_BLEND_ADD					/* RGB add, black is transparent */
+};
+
+
+
+/***************************************************************************
+    TYPE DEFINITIONS
+***************************************************************************/
+
+typedef struct _rendsimd_ops rendsimd_ops;
+struct _rendsimd_ops
+{
+	void		(*fetch_rgb32)(UINT32 *dst, const UINT32 *texbase, UINT32 texrp, INT32 curu, INT32 curv, INT32 dudx, INT32 dvdx, int count);
+	void		(*modulate)(UINT32 *dest, const UINT32 *src, int count, UINT32 sr, UINT32 sg, UINT32 sb);
+	void		(*blend_const)(UINT32 *dest, const UINT32 *src, int count, UINT32 sr, UINT32 sg, UINT32 sb, UINT32 invsa);
+	void		(*blend_alpha)(UINT32 *dest, const UINT32 *src, int count);
+	void		(*multiply)(UINT32 *dest, const UINT32 *src, int count);
+	void		(*add_alpha)(UINT32 *dest, const UINT32 *src, int count);
+	void		(*add)(UINT32 *dest, const UINT32 *src, int count);
+};
+
+
+
+/***************************************************************************
+    INLINE FUNCTIONS
+***************************************************************************/
+
+/*-------------------------------------------------
+    rendsimd_clamp_scale - clamp a color scale
+    factor to the 0-256 range
+-------------------------------------------------*/
+
+INLINE UINT32 rendsimd_clamp_scale(UINT32 scale)
+{
+	if (scale > 0x100) { if ((INT32)scale < 0) scale = 0; else scale = 0x100; }
+	return scale;
+}
+
+
+/*-------------------------------------------------
+    rendsimd_select_dest - return dest where mask
+    is set and value elsewhere
+-------------------------------------------------*/
+
+INLINE __m128i rendsimd_select_dest(__m128i mask, __m128i dest, __m128i value)
+{
+	return _mm_or_si128(_mm_and_si128(mask, dest), _mm_andnot_si128(mask, value));
+}
+
+
+/*-------------------------------------------------
+    rendsimd_lerp_pixels - compute
+    (src * sfactor + dest * dfactor) >> 8 for two
+    pixels, given interleaved 16-bit channels and
+    interleaved factors for each pixel
+-------------------------------------------------*/
+
+INLINE __m128i rendsimd_lerp_pixels(__m128i src16, __m128i dst16, __m128i factor0, __m128i factor1)
+{
+	__m128i pix0 = _mm_srli_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(src16, dst16), factor0), 8);
+	__m128i pix1 = _mm_srli_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(src16, dst16), factor1), 8);
+	return _mm_packs_epi32(pix0, pix1);
+}
+
+
+
+/***************************************************************************
+    C SPAN OPERATIONS
+***************************************************************************/
+
+/*
+    These handle the tail of each span that doesn't fill a full vector,
+    and define the exact results the vector versions must reproduce.
+*/
+
+static void rendsimd_fetch_rgb32_c(UINT32 *dst, const UINT32 *texbase, UINT32 texrp, INT32 curu, INT32 curv, INT32 dudx, INT32 dvdx, int count)
+{
+	int x;
+
+	/* unscaled horizontal spans are a straight copy */
+	if (dudx == 0x10000 && dvdx == 0)
+	{
+		memcpy(dst, &texbase[(curv >> 16) * texrp + (curu >> 16)], count * sizeof(*dst));
+		return;
+	}
+
+	for (x = 0; x < count; x++)
+	{
+		dst[x] = texbase[(curv >> 16) * texrp + (curu >> 16)];
+		curu += dudx;
+		curv += dvdx;
+	}
+}
+
+
+static void rendsimd_fetch_palette16(UINT32 *dst, const UINT16 *texbase, const rgb_t *palbase, UINT32 texrp, INT32 curu, INT32 curv, INT32 dudx, INT32 dvdx, int count)
+{
+	int x;
+
+	for (x = 0; x < count; x++)
+	{
+		dst[x] = palbase[texbase[(curv >> 16) * texrp + (curu >> 16)]];
+		curu += dudx;
+		curv += dvdx;
+	}
+}
+
+
+static void rendsimd_modulate_c(UINT32 *dest, const UINT32 *src, int count, UINT32 sr, UINT32 sg, UINT32 sb)
+{
+	int x;
+
+	for (x = 0; x < count; x++)
+	{
+		UINT32 pix = src[x];
+		UINT32 r = (RGB_RED(pix) * sr) >> 8;
+		UINT32 g = (RGB_GREEN(pix) * sg) >> 8;
+		UINT32 b = (RGB_BLUE(pix) * sb) >> 8;
+		dest[x] = (r << 16) | (g << 8) | b;
+	}
+}
+
+
+static void rendsimd_blend_const_c(UINT32 *dest, const UINT32 *src, int count, UINT32 sr, UINT32 sg, UINT32 sb, UINT32 invsa)
+{
+	int x;
+
+	for (x = 0; x < count; x++)
+	{
+		UINT32 pix = src[x];
+		UINT32 dpix = dest[x];
+		UINT32 r = (RGB_RED(pix) * sr + RGB_RED(dpix) * invsa) >> 8;
+		UINT32 g = (RGB_GREEN(pix) * sg + RGB_GREEN(dpix) * invsa) >> 8;
+		UINT32 b = (RGB_BLUE(pix) * sb + RGB_BLUE(dpix) * invsa) >> 8;
+		dest[x] = (MIN(r, 0xff) << 16) | (MIN(g, 0xff) << 8) | MIN(b, 0xff);
+	}
+}
+
+
+static void rendsimd_blend_alpha_c(UINT32 *dest, const UINT32 *src, int count)
+{
+	int x;
+
+	for (x = 0; x < count; x++)
+	{
+		UINT32 pix = src[x];
+		UINT32 ta = pix >> 24;
+		if (ta != 0)
+		{
+			UINT32 dpix = dest[x];
+			UINT32 invta = 0x100 - ta;
+			UINT32 r = (RGB_RED(pix) * ta + RGB_RED(dpix) * invta) >> 8;
+			UINT32 g = (RGB_GREEN(pix) * ta + RGB_GREEN(dpix) * invta) >> 8;
+			UINT32 b = (RGB_BLUE(pix) * ta + RGB_BLUE(dpix) * invta) >> 8;
+			dest[x] = (r << 16) | (g << 8) | b;
+		}
+	}
+}
+
+
+static void rendsimd_multiply_c(UINT32 *dest, const UINT32 *src, int count)
+{
+	int x;
+
+	for (x = 0; x < count; x++)
+	{
+		UINT32 pix = src[x];
+		UINT32 dpix = dest[x];
+		UINT32 r = (RGB_RED(pix) * RGB_RED(dpix)) >> 8;
+		UINT32 g = (RGB_GREEN(pix) * RGB_GREEN(dpix)) >> 8;
+		UINT32 b = (RGB_BLUE(pix) * RGB_BLUE(dpix)) >> 8;
+		dest[x] = (r << 16) | (g << 8) | b;
+	}
+}
+
+
+static void rendsimd_add_alpha_c(UINT32 *dest, const UINT32 *src, int count)
+{
+	int x;
+
+	for (x = 0; x < count; x++)
+	{
+		UINT32 pix = src[x];
+		UINT32 ta = pix >> 24;
+		if (ta != 0)
+		{
+			UINT32 dpix = dest[x];
+			UINT32 r = ((RGB_RED(pix) * ta) >> 8) + RGB_RED(dpix);
+			UINT32 g = ((RGB_GREEN(pix) * ta) >> 8) + RGB_GREEN(dpix);
+			UINT32 b = ((RGB_BLUE(pix) * ta) >> 8) + RGB_BLUE(dpix);
+			dest[x] = (MIN(r, 0xff) << 16) | (MIN(g, 0xff) << 8) | MIN(b, 0xff);
+		}
+	}
+}
+
+
+static void rendsimd_add_c(UINT32 *dest, const UINT32 *src, int count)
+{
+	int x;
+
+	for (x = 0; x < count; x++)
+	{
+		UINT32 pix = src[x];
+		if ((pix & 0xffffff) != 0)
+		{
+			UINT32 dpix = dest[x];
+			UINT32 r = RGB_RED(pix) + RGB_RED(dpix);
+			UINT32 g = RGB_GREEN(pix) + RGB_GREEN(dpix);
+			UINT32 b = RGB_BLUE(pix) + RGB_BLUE(dpix);
+			dest[x] = (MIN(r, 0xff) << 16) | (MIN(g, 0xff) << 8) | MIN(b, 0xff);
+		}
+	}
+}
+
+
+
+/***************************************************************************
+    SSE2 SPAN OPERATIONS
+***************************************************************************/
+
+static void rendsimd_fetch_rgb32_sse2(UINT32 *dst, const UINT32 *texbase, UINT32 texrp, INT32 curu, INT32 curv, INT32 dudx, INT32 dvdx, int count)
+{
+	int x;
+
+	/* unscaled spans and rows with a constant V are the common cases */
+	if (dudx == 0x10000 && dvdx == 0)
+	{
+		rendsimd_fetch_rgb32_c(dst, texbase, texrp, curu, curv, dudx, dvdx, count);
+		return;
+	}
+	if (dvdx == 0)
+	{
+		const UINT32 *row = &texbase[(curv >> 16) * texrp];
+		for (x = 0; x + 4 <= count; x += 4)
+		{
+			_mm_storeu_si128((__m128i *)&dst[x], _mm_set_epi32(row[(curu + 3 * dudx) >> 16], row[(curu + 2 * dudx) >> 16], row[(curu + dudx) >> 16], row[curu >> 16]));
+			curu += 4 * dudx;
+		}
+		for ( ; x < count; x++)
+		{
+			dst[x] = row[curu >> 16];
+			curu += dudx;
+		}
+		return;
+	}
+	rendsimd_fetch_rgb32_c(dst, texbase, texrp, curu, curv, dudx, dvdx, count);
+}
+
+
+static void rendsimd_modulate_sse2(UINT32 *dest, const UINT32 *src, int count, UINT32 sr, UINT32 sg, UINT32 sb)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i scale = _mm_set_epi16(0, sr, sg, sb, 0, sr, sg, sb);
+	int x;
+
+	for (x = 0; x + 4 <= count; x += 4)
+	{
+		__m128i pix = _mm_loadu_si128((const __m128i *)&src[x]);
+		__m128i lo = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(pix, zero), scale), 8);
+		__m128i hi = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(pix, zero), scale), 8);
+		_mm_storeu_si128((__m128i *)&dest[x], _mm_packus_epi16(lo, hi));
+	}
+	rendsimd_modulate_c(&dest[x], &src[x], count - x, sr, sg, sb);
+}
+
+
+static void rendsimd_blend_const_sse2(UINT32 *dest, const UINT32 *src, int count, UINT32 sr, UINT32 sg, UINT32 sb, UINT32 invsa)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i factor = _mm_set_epi16(0, 0, invsa, sr, invsa, sg, invsa, sb);
+	int x;
+
+	for (x = 0; x + 4 <= count; x += 4)
+	{
+		__m128i pix = _mm_loadu_si128((const __m128i *)&src[x]);
+		__m128i dpix = _mm_loadu_si128((const __m128i *)&dest[x]);
+		__m128i lo = rendsimd_lerp_pixels(_mm_unpacklo_epi8(pix, zero), _mm_unpacklo_epi8(dpix, zero), factor, factor);
+		__m128i hi = rendsimd_lerp_pixels(_mm_unpackhi_epi8(pix, zero), _mm_unpackhi_epi8(dpix, zero), factor, factor);
+		_mm_storeu_si128((__m128i *)&dest[x], _mm_packus_epi16(lo, hi));
+	}
+	rendsimd_blend_const_c(&dest[x], &src[x], count - x, sr, sg, sb, invsa);
+}
+
+
+static void rendsimd_blend_alpha_sse2(UINT32 *dest, const UINT32 *src, int count)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i alphamask = _mm_set1_epi32(0xff000000);
+	__m128i rgbfactors = _mm_set_epi32(0, -1, -1, -1);
+	__m128i full = _mm_set1_epi16(0x100);
+	int x;
+
+	for (x = 0; x + 4 <= count; x += 4)
+	{
+		__m128i pix = _mm_loadu_si128((const __m128i *)&src[x]);
+		__m128i dpix = _mm_loadu_si128((const __m128i *)&dest[x]);
+		__m128i skip = _mm_cmpeq_epi32(_mm_and_si128(pix, alphamask), zero);
+		__m128i pixlo = _mm_unpacklo_epi8(pix, zero);
+		__m128i pixhi = _mm_unpackhi_epi8(pix, zero);
+		__m128i alo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixlo, 0xff), 0xff);
+		__m128i ahi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixhi, 0xff), 0xff);
+		__m128i invalo = _mm_sub_epi16(full, alo);
+		__m128i invahi = _mm_sub_epi16(full, ahi);
+		__m128i lo = rendsimd_lerp_pixels(pixlo, _mm_unpacklo_epi8(dpix, zero),
+				_mm_and_si128(_mm_unpacklo_epi16(alo, invalo), rgbfactors), _mm_and_si128(_mm_unpackhi_epi16(alo, invalo), rgbfactors));
+		__m128i hi = rendsimd_lerp_pixels(pixhi, _mm_unpackhi_epi8(dpix, zero),
+				_mm_and_si128(_mm_unpacklo_epi16(ahi, invahi), rgbfactors), _mm_and_si128(_mm_unpackhi_epi16(ahi, invahi), rgbfactors));
+		_mm_storeu_si128((__m128i *)&dest[x], rendsimd_select_dest(skip, dpix, _mm_packus_epi16(lo, hi)));
+	}
+	rendsimd_blend_alpha_c(&dest[x], &src[x], count - x);
+}
+
+
+static void rendsimd_multiply_sse2(UINT32 *dest, const UINT32 *src, int count)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i rgbmask = _mm_set1_epi32(0x00ffffff);
+	int x;
+
+	for (x = 0; x + 4 <= count; x += 4)
+	{
+		__m128i pix = _mm_and_si128(_mm_loadu_si128((const __m128i *)&src[x]), rgbmask);
+		__m128i dpix = _mm_loadu_si128((const __m128i *)&dest[x]);
+		__m128i lo = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(pix, zero), _mm_unpacklo_epi8(dpix, zero)), 8);
+		__m128i hi = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(pix, zero), _mm_unpackhi_epi8(dpix, zero)), 8);
+		_mm_storeu_si128((__m128i *)&dest[x], _mm_packus_epi16(lo, hi));
+	}
+	rendsimd_multiply_c(&dest[x], &src[x], count - x);
+}
+
+
+static void rendsimd_add_alpha_sse2(UINT32 *dest, const UINT32 *src, int count)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i rgbmask = _mm_set1_epi32(0x00ffffff);
+	int x;
+
+	for (x = 0; x + 4 <= count; x += 4)
+	{
+		__m128i pix = _mm_loadu_si128((const __m128i *)&src[x]);
+		__m128i dpix = _mm_loadu_si128((const __m128i *)&dest[x]);
+		__m128i skip = _mm_cmpeq_epi32(_mm_andnot_si128(rgbmask, pix), zero);
+		__m128i pixlo = _mm_unpacklo_epi8(pix, zero);
+		__m128i pixhi = _mm_unpackhi_epi8(pix, zero);
+		__m128i lo = _mm_srli_epi16(_mm_mullo_epi16(pixlo, _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixlo, 0xff), 0xff)), 8);
+		__m128i hi = _mm_srli_epi16(_mm_mullo_epi16(pixhi, _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixhi, 0xff), 0xff)), 8);
+		__m128i result = _mm_and_si128(_mm_adds_epu8(_mm_packus_epi16(lo, hi), dpix), rgbmask);
+		_mm_storeu_si128((__m128i *)&dest[x], rendsimd_select_dest(skip, dpix, result));
+	}
+	rendsimd_add_alpha_c(&dest[x], &src[x], count - x);
+}
+
+
+static void rendsimd_add_sse2(UINT32 *dest, const UINT32 *src, int count)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i rgbmask = _mm_set1_epi32(0x00ffffff);
+	int x;
+
+	for (x = 0; x + 4 <= count; x += 4)
+	{
+		__m128i pix = _mm_and_si128(_mm_loadu_si128((const __m128i *)&src[x]), rgbmask);
+		__m128i dpix = _mm_loadu_si128((const __m128i *)&dest[x]);
+		__m128i skip = _mm_cmpeq_epi32(pix, zero);
+		__m128i result = _mm_and_si128(_mm_adds_epu8(pix, dpix), rgbmask);
+		_mm_storeu_si128((__m128i *)&dest[x], rendsimd_select_dest(skip, dpix, result));
+	}
+	rendsimd_add_c(&dest[x], &src[x], count - x);
+}
+
+
+static const rendsimd_ops rendsimd_sse2_ops =
+{
+	rendsimd_fetch_rgb32_sse2,
+	rendsimd_modulate_sse2,
+	rendsimd_blend_const_sse2,
+	rendsimd_blend_alpha_sse2,
+	rendsimd_multiply_sse2,
+	rendsimd_add_alpha_sse2,
+	rendsimd_add_sse2
+};
+
+
+
+/***************************************************************************
+    AVX2 SPAN OPERATIONS
+***************************************************************************/
+
+#ifdef RENDSIMD_AVX2
+
+static AVX2_FUNC void rendsimd_fetch_rgb32_avx2(UINT32 *dst, const UINT32 *texbase, UINT32 texrp, INT32 curu, INT32 curv, INT32 dudx, INT32 dvdx, int count)
+{
+	__m256i steps = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+	__m256i u, v, du, dv, rp;
+	int x;
+
+	/* a straight copy beats a gather */
+	if (dudx == 0x10000 && dvdx == 0)
+	{
+		rendsimd_fetch_rgb32_c(dst, texbase, texrp, curu, curv, dudx, dvdx, count);
+		return;
+	}
+
+	/* gather 8 texels at a time */
+	u = _mm256_add_epi32(_mm256_set1_epi32(curu), _mm256_mullo_epi32(steps, _mm256_set1_epi32(dudx)));
+	v = _mm256_add_epi32(_mm256_set1_epi32(curv), _mm256_mullo_epi32(steps, _mm256_set1_epi32(dvdx)));
+	du = _mm256_set1_epi32(dudx * 8);
+	dv = _mm256_set1_epi32(dvdx * 8);
+	rp = _mm256_set1_epi32(texrp);
+	for (x = 0; x + 8 <= count; x += 8)
+	{
+		__m256i index = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_srai_epi32(v, 16), rp), _mm256_srai_epi32(u, 16));
+		_mm256_storeu_si256((__m256i *)&dst[x], _mm256_i32gather_epi32((const int *)texbase, index, 4));
+		u = _mm256_add_epi32(u, du);
+		v = _mm256_add_epi32(v, dv);
+	}
+	rendsimd_fetch_rgb32_c(&dst[x], texbase, texrp, curu + x * dudx, curv + x * dvdx, dudx, dvdx, count - x);
+}
+
+
+static AVX2_FUNC void rendsimd_blend_alpha_avx2(UINT32 *dest, const UINT32 *src, int count)
+{
+	__m256i zero = _mm256_setzero_si256();
+	__m256i alphamask = _mm256_set1_epi32(0xff000000);
+	__m256i rgbfactors = _mm256_set_epi32(0, -1, -1, -1, 0, -1, -1, -1);
+	__m256i full = _mm256_set1_epi16(0x100);
+	int x;
+
+	/* same arithmetic as the SSE2 version, 8 pixels at a time */
+	for (x = 0; x + 8 <= count; x += 8)
+	{
+		__m256i pix = _mm256_loadu_si256((const __m256i *)&src[x]);
+		__m256i dpix = _mm256_loadu_si256((const __m256i *)&dest[x]);
+		__m256i skip = _mm256_cmpeq_epi32(_mm256_and_si256(pix, alphamask), zero);
+		__m256i pixlo = _mm256_unpacklo_epi8(pix, zero);
+		__m256i pixhi = _mm256_unpackhi_epi8(pix, zero);
+		__m256i dpixlo = _mm256_unpacklo_epi8(dpix, zero);
+		__m256i dpixhi = _mm256_unpackhi_epi8(dpix, zero);
+		__m256i alo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(pixlo, 0xff), 0xff);
+		__m256i ahi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(pixhi, 0xff), 0xff);
+		__m256i invalo = _mm256_sub_epi16(full, alo);
+		__m256i invahi = _mm256_sub_epi16(full, ahi);
+		__m256i lo0 = _mm256_madd_epi16(_mm256_unpacklo_epi16(pixlo, dpixlo), _mm256_and_si256(_mm256_unpacklo_epi16(alo, invalo), rgbfactors));
+		__m256i lo1 = _mm256_madd_epi16(_mm256_unpackhi_epi16(pixlo, dpixlo), _mm256_and_si256(_mm256_unpackhi_epi16(alo, invalo), rgbfactors));
+		__m256i hi0 = _mm256_madd_epi16(_mm256_unpacklo_epi16(pixhi, dpixhi), _mm256_and_si256(_mm256_unpacklo_epi16(ahi, invahi), rgbfactors));
+		__m256i hi1 = _mm256_madd_epi16(_mm256_unpackhi_epi16(pixhi, dpixhi), _mm256_and_si256(_mm256_unpackhi_epi16(ahi, invahi), rgbfactors));
+		__m256i lo = _mm256_packs_epi32(_mm256_srli_epi32(lo0, 8), _mm256_srli_epi32(lo1, 8));
+		__m256i hi = _mm256_packs_epi32(_mm256_srli_epi32(hi0, 8), _mm256_srli_epi32(hi1, 8));
+		__m256i result = _mm256_packus_epi16(lo, hi);
+		_mm256_storeu_si256((__m256i *)&dest[x], _mm256_or_si256(_mm256_and_si256(skip, dpix), _mm256_andnot_si256(skip, result)));
+	}
+	rendsimd_blend_alpha_sse2(&dest[x], &src[x], count - x);
+}
+
+
+static const rendsimd_ops rendsimd_avx2_ops =
+{
+	rendsimd_fetch_rgb32_avx2,
+	rendsimd_modulate_sse2,
+	rendsimd_blend_const_sse2,
+	rendsimd_blend_alpha_avx2,
+	rendsimd_multiply_sse2,
+	rendsimd_add_alpha_sse2,
+	rendsimd_add_sse2
+};
+
+#endif /* RENDSIMD_AVX2 */
+
+
+
+/***************************************************************************
+    DISPATCH
+***************************************************************************/
+
+/*-------------------------------------------------
+    rendsimd_get_ops - return the best set of
+    span operations for the running CPU
+-------------------------------------------------*/
+
+static const rendsimd_ops *rendsimd_get_ops(void)
+{
+	static const rendsimd_ops *ops;
+
+	/* the choice never changes, so racing threads all store the same value */
+	if (ops == NULL)
+	{
+		const rendsimd_ops *best = &rendsimd_sse2_ops;
+#ifdef RENDSIMD_AVX2
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			best = &rendsimd_avx2_ops;
+#endif
+		ops = best;
+	}
+	return ops;
+}
+
+
+/*-------------------------------------------------
+    rendsimd_draw_quad_ops - draw a point-sampled
+    textured quad to a native 32bpp destination
+    using the given span operations; returns
+    FALSE if the combination of blending and
+    coloring must be handled by the generic
+    rasterizer
+-------------------------------------------------*/
+
+static int rendsimd_draw_quad_ops(const rendsimd_ops *ops, const render_primitive *prim, void *dstdata, UINT32 pitch, INT32 startx, INT32 starty, INT32 endx, INT32 endy,
+		INT32 startu, INT32 startv, INT32 dudx, INT32 dvdx, INT32 dudy, INT32 dvdy, int fetch, int blend)
+{
+	UINT32 buffer[RENDSIMD_CHUNK];
+	UINT32 sr = 0x100, sg = 0x100, sb = 0x100, invsa = 0;
+	int direct = FALSE, coloring = FALSE;
+	INT32 x, y;
+
+	/* only the fast case is vectorized for blending modes other than none */
+	if (prim->color.r >= 1.0f && prim->color.g >= 1.0f && prim->color.b >= 1.0f && prim->color.a >= 1.0f)
+		direct = (blend == RENDSIMD_BLEND_NONE);
+	else if (blend != RENDSIMD_BLEND_NONE)
+		return FALSE;
+
+	/* coloring-only case */
+	else if (prim->color.a >= 1.0f)
+	{
+		sr = rendsimd_clamp_scale((UINT32)(256.0f * prim->color.r));
+		sg = rendsimd_clamp_scale((UINT32)(256.0f * prim->color.g));
+		sb = rendsimd_clamp_scale((UINT32)(256.0f * prim->color.b));
+		coloring = TRUE;
+	}
+
+	/* alpha and/or coloring case */
+	else if (prim->color.a >= 0.0001f)
+	{
+		sr = rendsimd_clamp_scale((UINT32)(256.0f * prim->color.r * prim->color.a));
+		sg = rendsimd_clamp_scale((UINT32)(256.0f * prim->color.g * prim->color.a));
+		sb = rendsimd_clamp_scale((UINT32)(256.0f * prim->color.b * prim->color.a));
+		invsa = rendsimd_clamp_scale((UINT32)(256.0f * (1.0f - prim->color.a)));
+	}
+
+	/* fully transparent: nothing to draw */
+	else
+		return TRUE;
+
+	/* loop over rows */
+	for (y = starty; y < endy; y++)
+	{
+		UINT32 *dest = (UINT32 *)dstdata + y * pitch + startx;
+		INT32 curu = startu + (y - starty) * dudy;
+		INT32 curv = startv + (y - starty) * dvdy;
+
+		/* loop over chunks of the row */
+		for (x = startx; x < endx; x += RENDSIMD_CHUNK)
+		{
+			int count = MIN(RENDSIMD_CHUNK, endx - x);
+			UINT32 *src = direct ? dest : buffer;
+
+			/* fetch the texels */
+			if (fetch == RENDSIMD_FETCH_RGB32)
+				(*ops->fetch_rgb32)(src, prim->texture.base, prim->texture.rowpixels, curu, curv, dudx, dvdx, count);
+			else
+				rendsimd_fetch_palette16(src, prim->texture.base, prim->texture.palette, prim->texture.rowpixels, curu, curv, dudx, dvdx, count);
+
+			/* combine them with the destination */
+			switch (blend)
+			{
+				case RENDSIMD_BLEND_NONE:
+					if (coloring)
+						(*ops->modulate)(dest, src, count, sr, sg, sb);
+					else if (!direct)
+						(*ops->blend_const)(dest, src, count, sr, sg, sb, invsa);
+					break;
+
+				case RENDSIMD_BLEND_ALPHA:
+					(*ops->blend_alpha)(dest, src, count);
+					break;
+
+				case RENDSIMD_BLEND_MULTIPLY:
+					(*ops->multiply)(dest, src, count);
+					break;
+
+				case RENDSIMD_BLEND_ADD_ALPHA:
+					(*ops->add_alpha)(dest, src, count);
+					break;
+
+				case RENDSIMD_BLEND_ADD:
+					(*ops->add)(dest, src, count);
+					break;
+			}
+
+			dest += count;
+			curu += count * dudx;
+			curv += count * dvdx;
+		}
+	}
+	return TRUE;
+}
+
+
+/*-------------------------------------------------
+    rendsimd_draw_quad - draw a quad using the
+    best span operations for the running CPU
+-------------------------------------------------*/
+
+INLINE int rendsimd_draw_quad(const render_primitive *prim, void *dstdata, UINT32 pitch, INT32 startx, INT32 starty, INT32 endx, INT32 endy,
+		INT32 startu, INT32 startv, INT32 dudx, INT32 dvdx, INT32 dudy, INT32 dvdy, int fetch, int blend)
+{
+	return rendsimd_draw_quad_ops(rendsimd_get_ops(), prim, dstdata, pitch, startx, starty, endx, endy, startu, startv, dudx, dvdx, dudy, dvdy, fetch, blend);
+}
+
+#endif /* __SSE2__ && PTR64 */
+
+#endif /* __RENDSIMD_H__ */
@@ -1072,6 +1072,9 @@ void rom_init(running_machine *machine, const rom_entry *romp)
 	/* determine the correct biosset to load based on OPTION_BIOS string */
 	system_bios = determine_bios_rom(romp);
 
+	/* size the CHD hunk caches before any disks are opened */
+	chd_set_cache_size(options_get_int(mame_options(), OPTION_CHD_CACHE));
+
 	romdata.romstotal = count_roms(romp);
 
 	/* reset the disk list */
@@ -143,6 +143,7 @@ enum
 	SNDINFO_INT_FIRST = 0x00000,
 
 	SNDINFO_INT_ALIAS = SNDINFO_INT_FIRST,				/* R/O: alias to sound type for (type,index) identification */
+	SNDINFO_INT_PARALLEL,								/* R/O: TRUE if the stream callbacks can run alongside other chip families */
 
 	SNDINFO_INT_CORE_SPECIFIC = 0x08000,				/* R/W: core-specific values start here */
 
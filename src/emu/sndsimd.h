@@ -0,0 +1,340 @@
+/***************************************************************************
+
+    sndsimd.h
+
+    SIMD resampling kernels for the sound stream engine.
+
+    Copyright (c) 1996-2007, Nicola Salmoria and the MAME Team.
+    Visit http://mamedev.org for licensing and usage restrictions.
+
+****************************************************************************
+
+    These kernels cover the inner loops of generate_resampled_data in
+    streams.c: copying with gain, linear interpolation of undersampled
+    inputs, summing runs of oversampled inputs, and the dot product used
+    by the windowed-sinc filter. The integer kernels reproduce the C
+    versions exactly; the dot product only differs in summation order.
+
+    The C versions are always available. SSE2 is used on 64-bit builds,
+    where it can be assumed, and an AVX2 variant is selected at runtime
+    when the compiler can target it and the CPU supports it.
+
+    This file expects FRAC_BITS, FRAC_ONE and FRAC_MASK to be defined by
+    the includer.
+
+***************************************************************************/
+
+#ifndef __SNDSIMD_H__
+#define __SNDSIMD_H__
+
+/* use SSE on 64-bit implementations, where it can be assumed */
+#if (defined(__SSE2__) && defined(PTR64))
+#define SNDSIMD_SSE2
+
+#include <emmintrin.h>
+
+/* AVX2 kernels need per-function target support from the compiler */
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define SNDSIMD_AVX2
+#include <immintrin.h>
+#define AVX2_FUNC			__attribute__((target("avx2")))
+#endif
+
+#endif
+
+
+
+/***************************************************************************
+    TYPE DEFINITIONS
+***************************************************************************/
+
+typedef struct _sndsimd_ops sndsimd_ops;
+struct _sndsimd_ops
+{
+	void		(*gain)(stream_sample_t *dest, const stream_sample_t *src, int count, int gain);
+	void		(*lerp)(stream_sample_t *dest, const stream_sample_t *src, int count, UINT32 basefrac, UINT32 step, int gain);
+	INT32		(*sum)(const stream_sample_t *src, int count);
+	float		(*dot)(const stream_sample_t *src, const float *coeff, int taps);
+};
+
+
+
+/***************************************************************************
+    C OPERATIONS
+***************************************************************************/
+
+/*
+    These define the exact results the vector versions must reproduce, and
+    handle the tail of each run that doesn't fill a full vector. The dot
+    product is always called with a multiple of 8 taps.
+*/
+
+static void sndsimd_gain_c(stream_sample_t *dest, const stream_sample_t *src, int count, int gain)
+{
+	int x;
+
+	for (x = 0; x < count; x++)
+		dest[x] = (src[x] * gain) >> 8;
+}
+
+
+static void sndsimd_lerp_c(stream_sample_t *dest, const stream_sample_t *src, int count, UINT32 basefrac, UINT32 step, int gain)
+{
+	int x;
+
+	for (x = 0; x < count; x++)
+	{
+		int interp_frac = basefrac >> (FRAC_BITS - 12);
+		stream_sample_t sample = (src[0] * (0x1000 - interp_frac) + src[1] * interp_frac) >> 12;
+		dest[x] = (sample * gain) >> 8;
+
+		/* advance */
+		basefrac += step;
+		src += basefrac >> FRAC_BITS;
+		basefrac &= FRAC_MASK;
+	}
+}
+
+
+static INT32 sndsimd_sum_c(const stream_sample_t *src, int count)
+{
+	UINT32 sum = 0;
+	int x;
+
+	for (x = 0; x < count; x++)
+		sum += src[x];
+	return sum;
+}
+
+
+static float sndsimd_dot_c(const stream_sample_t *src, const float *coeff, int taps)
+{
+	float sum = 0;
+	int x;
+
+	for (x = 0; x < taps; x++)
+		sum += (float)src[x] * coeff[x];
+	return sum;
+}
+
+
+static const sndsimd_ops sndsimd_c_ops =
+{
+	sndsimd_gain_c,
+	sndsimd_lerp_c,
+	sndsimd_sum_c,
+	sndsimd_dot_c
+};
+
+
+
+/***************************************************************************
+    SSE2 OPERATIONS
+***************************************************************************/
+
+#ifdef SNDSIMD_SSE2
+
+/*-------------------------------------------------
+    sndsimd_mullo - multiply four 32-bit values,
+    keeping the low 32 bits of each product
+-------------------------------------------------*/
+
+INLINE __m128i sndsimd_mullo(__m128i a, __m128i b)
+{
+	__m128i even = _mm_mul_epu32(a, b);
+	__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0,0,2,0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0,0,2,0)));
+}
+
+
+static void sndsimd_gain_sse2(stream_sample_t *dest, const stream_sample_t *src, int count, int gain)
+{
+	__m128i vgain = _mm_set1_epi32(gain);
+	int x;
+
+	for (x = 0; x + 4 <= count; x += 4)
+	{
+		__m128i samples = _mm_loadu_si128((const __m128i *)&src[x]);
+		_mm_storeu_si128((__m128i *)&dest[x], _mm_srai_epi32(sndsimd_mullo(samples, vgain), 8));
+	}
+	sndsimd_gain_c(&dest[x], &src[x], count - x, gain);
+}
+
+
+static void sndsimd_lerp_sse2(stream_sample_t *dest, const stream_sample_t *src, int count, UINT32 basefrac, UINT32 step, int gain)
+{
+	__m128i vgain = _mm_set1_epi32(gain);
+	__m128i one = _mm_set1_epi32(0x1000);
+	__m128i mask = _mm_set1_epi32(FRAC_MASK);
+	__m128i lanes = _mm_set_epi32(3 * step, 2 * step, step, 0);
+	int x;
+
+	for (x = 0; x + 4 <= count; x += 4)
+	{
+		/* four positions fit comfortably in 32 bits since step < FRAC_ONE */
+		UINT32 pos1 = basefrac + step, pos2 = pos1 + step, pos3 = pos2 + step;
+		const stream_sample_t *src1 = &src[pos1 >> FRAC_BITS];
+		const stream_sample_t *src2 = &src[pos2 >> FRAC_BITS];
+		const stream_sample_t *src3 = &src[pos3 >> FRAC_BITS];
+		__m128i s0 = _mm_set_epi32(src3[0], src2[0], src1[0], src[0]);
+		__m128i s1 = _mm_set_epi32(src3[1], src2[1], src1[1], src[1]);
+		__m128i frac = _mm_srli_epi32(_mm_and_si128(_mm_add_epi32(_mm_set1_epi32(basefrac), lanes), mask), FRAC_BITS - 12);
+		__m128i sample;
+
+		/* interpolate and apply the gain */
+		sample = _mm_add_epi32(sndsimd_mullo(s0, _mm_sub_epi32(one, frac)), sndsimd_mullo(s1, frac));
+		sample = _mm_srai_epi32(sample, 12);
+		_mm_storeu_si128((__m128i *)&dest[x], _mm_srai_epi32(sndsimd_mullo(sample, vgain), 8));
+
+		/* advance */
+		basefrac = pos3 + step;
+		src += basefrac >> FRAC_BITS;
+		basefrac &= FRAC_MASK;
+	}
+	sndsimd_lerp_c(&dest[x], src, count - x, basefrac, step, gain);
+}
+
+
+static INT32 sndsimd_sum_sse2(const stream_sample_t *src, int count)
+{
+	__m128i sum = _mm_setzero_si128();
+	int x;
+
+	for (x = 0; x + 4 <= count; x += 4)
+		sum = _mm_add_epi32(sum, _mm_loadu_si128((const __m128i *)&src[x]));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1,0,3,2)));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2,3,0,1)));
+	return (UINT32)_mm_cvtsi128_si32(sum) + (UINT32)sndsimd_sum_c(&src[x], count - x);
+}
+
+
+static float sndsimd_dot_sse2(const stream_sample_t *src, const float *coeff, int taps)
+{
+	__m128 sum0 = _mm_setzero_ps();
+	__m128 sum1 = _mm_setzero_ps();
+	float result[4];
+	int x;
+
+	for (x = 0; x < taps; x += 8)
+	{
+		__m128 s0 = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)&src[x]));
+		__m128 s1 = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)&src[x + 4]));
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(s0, _mm_loadu_ps(&coeff[x])));
+		sum1 = _mm_add_ps(sum1, _mm_mul_ps(s1, _mm_loadu_ps(&coeff[x + 4])));
+	}
+	_mm_storeu_ps(result, _mm_add_ps(sum0, sum1));
+	return (result[0] + result[1]) + (result[2] + result[3]);
+}
+
+
+static const sndsimd_ops sndsimd_sse2_ops =
+{
+	sndsimd_gain_sse2,
+	sndsimd_lerp_sse2,
+	sndsimd_sum_sse2,
+	sndsimd_dot_sse2
+};
+
+#endif /* SNDSIMD_SSE2 */
+
+
+
+/***************************************************************************
+    AVX2 OPERATIONS
+***************************************************************************/
+
+#ifdef SNDSIMD_AVX2
+
+static AVX2_FUNC void sndsimd_lerp_avx2(stream_sample_t *dest, const stream_sample_t *src, int count, UINT32 basefrac, UINT32 step, int gain)
+{
+	__m256i vgain = _mm256_set1_epi32(gain);
+	__m256i one = _mm256_set1_epi32(0x1000);
+	__m256i mask = _mm256_set1_epi32(FRAC_MASK);
+	__m256i lanes = _mm256_mullo_epi32(_mm256_set1_epi32(step), _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+	int x;
+
+	for (x = 0; x + 8 <= count; x += 8)
+	{
+		/* eight positions still fit in 32 bits since step < FRAC_ONE */
+		__m256i pos = _mm256_add_epi32(_mm256_set1_epi32(basefrac), lanes);
+		__m256i index = _mm256_srli_epi32(pos, FRAC_BITS);
+		__m256i frac = _mm256_srli_epi32(_mm256_and_si256(pos, mask), FRAC_BITS - 12);
+		__m256i s0 = _mm256_i32gather_epi32((const int *)&src[0], index, 4);
+		__m256i s1 = _mm256_i32gather_epi32((const int *)&src[1], index, 4);
+		__m256i sample;
+
+		/* interpolate and apply the gain */
+		sample = _mm256_add_epi32(_mm256_mullo_epi32(s0, _mm256_sub_epi32(one, frac)), _mm256_mullo_epi32(s1, frac));
+		sample = _mm256_srai_epi32(sample, 12);
+		_mm256_storeu_si256((__m256i *)&dest[x], _mm256_srai_epi32(_mm256_mullo_epi32(sample, vgain), 8));
+
+		/* advance */
+		basefrac += 8 * step;
+		src += basefrac >> FRAC_BITS;
+		basefrac &= FRAC_MASK;
+	}
+	sndsimd_lerp_c(&dest[x], src, count - x, basefrac, step, gain);
+}
+
+
+static AVX2_FUNC float sndsimd_dot_avx2(const stream_sample_t *src, const float *coeff, int taps)
+{
+	__m256 sum = _mm256_setzero_ps();
+	__m128 half;
+	float result[4];
+	int x;
+
+	for (x = 0; x < taps; x += 8)
+	{
+		__m256 samples = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i *)&src[x]));
+		sum = _mm256_add_ps(sum, _mm256_mul_ps(samples, _mm256_loadu_ps(&coeff[x])));
+	}
+	half = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+	_mm_storeu_ps(result, half);
+	return (result[0] + result[1]) + (result[2] + result[3]);
+}
+
+
+static const sndsimd_ops sndsimd_avx2_ops =
+{
+	sndsimd_gain_sse2,
+	sndsimd_lerp_avx2,
+	sndsimd_sum_sse2,
+	sndsimd_dot_avx2
+};
+
+#endif /* SNDSIMD_AVX2 */
+
+
+
+/***************************************************************************
+    OPERATION SELECTION
+***************************************************************************/
+
+/*-------------------------------------------------
+    sndsimd_get_ops - return the best set of
+    resampling operations for the running CPU
+-------------------------------------------------*/
+
+static const sndsimd_ops *sndsimd_get_ops(void)
+{
+	static const sndsimd_ops *ops;
+
+	/* the choice never changes, so racing threads all store the same value */
+	if (ops == NULL)
+	{
+		const sndsimd_ops *best = &sndsimd_c_ops;
+#ifdef SNDSIMD_SSE2
+		best = &sndsimd_sse2_ops;
+#endif
+#ifdef SNDSIMD_AVX2
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			best = &sndsimd_avx2_ops;
+#endif
+		ops = best;
+	}
+	return ops;
+}
+
+#endif /* __SNDSIMD_H__ */
@@ -275,6 +275,31 @@ static void sound_exit(running_machine *machine)
     INITIALIZATION HELPERS
 ***************************************************************************/
 
+/*-------------------------------------------------
+    sound_parallel_group - return the stream group
+    for a chip type; chips of the same family
+    share core state, so they share a group
+-------------------------------------------------*/
+
+static int sound_parallel_group(sound_type type, const char **families, int *numfamilies)
+{
+	const char *family;
+	int group;
+
+	/* chips that haven't been vetted stay on the main thread */
+	if (!sndtype_get_info_int(type, SNDINFO_INT_PARALLEL))
+		return STREAM_GROUP_SERIAL;
+
+	/* find or add the family */
+	family = sndtype_core_family(type);
+	for (group = 0; group < *numfamilies; group++)
+		if (strcmp(families[group], family) == 0)
+			return group;
+	families[*numfamilies] = family;
+	return (*numfamilies)++;
+}
+
+
 /*-------------------------------------------------
     start_sound_chips - loop over all sound chips
     and initialize them
@@ -282,6 +307,8 @@ static void sound_exit(running_machine *machine)
 
 static void start_sound_chips(void)
 {
+	const char *families[MAX_SOUND];
+	int numfamilies = 0;
 	int sndnum;
 
 	/* reset the sound array */
@@ -311,8 +338,10 @@ static void start_sound_chips(void)
 		VPRINTF(("sndnum = %d -- sound_type = %d\n", sndnum, msound->type));
 		num_regs = state_save_get_reg_count();
 		streams_set_tag(Machine, info);
+		streams_set_group(Machine, sound_parallel_group(msound->type, families, &numfamilies));
 		if (sndintrf_init_sound(sndnum, msound->type, msound->clock, msound->config) != 0)
 			fatalerror("Sound chip #%d (%s) failed to initialize!", sndnum, sndnum_name(sndnum));
+		streams_set_group(Machine, STREAM_GROUP_SERIAL);
 
 		/* if no state registered for saving, we can't save */
 		num_regs = state_save_get_reg_count() - num_regs;
@@ -675,6 +704,9 @@ static TIMER_CALLBACK( sound_update )
 
 	profiler_mark(PROFILER_SOUND);
 
+	/* bring independent streams up to date in parallel; the speaker mixers below join them */
+	streams_update_parallel(machine);
+
 	/* force all the speaker streams to generate the proper number of samples */
 	for (spknum = 0; spknum < totalspeakers; spknum++)
 	{
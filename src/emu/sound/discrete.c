@@ -32,6 +32,13 @@
  * discrete_update()        - Update streams to current time
  * discrete_stream_update() - This does the real update to the sim
  *
+ * Once the nodes are linked, compile_nodes() builds the execution plan
+ * that discrete_stream_update() walks: a flat list of step functions
+ * and their nodes. Stateless nodes whose inputs are all fixed values
+ * are folded to constants; they are evaluated at reset and then left
+ * out of the list. Node contexts are allocated in a single block, in
+ * running order, so a pass over the list walks memory in sequence.
+ *
  ************************************************************************/
 
 #include "sndintrf.h"
@@ -59,6 +66,13 @@
  *
  *************************************/
 
+struct _discrete_step
+{
+	void (*step)(node_description *node);
+	node_description *node;
+};
+typedef struct _discrete_step discrete_step;
+
 struct _discrete_info
 {
 	/* emulation info */
@@ -72,6 +86,10 @@ struct _discrete_info
 	node_description **indexed_node;
 	node_description *node_list;
 
+	/* compiled execution plan */
+	int step_count;
+	discrete_step *step_list;
+
 	/* the input streams */
 	int discrete_input_streams;
 	stream_sample_t **input_stream_data[DISCRETE_MAX_OUTPUTS];
@@ -111,6 +129,7 @@ static discrete_info *discrete_current_context;
 
 static void init_nodes(discrete_info *info, discrete_sound_block *block_list);
 static void find_input_nodes(discrete_info *info, discrete_sound_block *block_list);
+static void compile_nodes(discrete_info *info);
 static void setup_output_nodes(discrete_info *info);
 static void setup_disc_logs(discrete_info *info);
 static void discrete_reset(void *chip);
@@ -347,6 +366,9 @@ static void *discrete_start(int sndindex, int clock, const void *config)
 	/* now go back and find pointers to all input nodes */
 	find_input_nodes(info, intf);
 
+	/* build the list of steps to run each sample */
+	compile_nodes(info);
+
 	/* then set up the output nodes */
 	setup_output_nodes(info);
 
@@ -434,7 +456,9 @@ static void discrete_reset(void *chip)
 static void discrete_stream_update(void *param, stream_sample_t **inputs, stream_sample_t **buffer, int length)
 {
 	discrete_info *info = param;
-	int samplenum, nodenum, outputnum;
+	const discrete_step *step_list = info->step_list;
+	int step_count = info->step_count;
+	int samplenum, nodenum, outputnum, stepnum;
 	double val;
 	INT16 wave_data_l, wave_data_r;
 
@@ -449,15 +473,9 @@ static void discrete_stream_update(void *param, stream_sample_t **inputs, stream
 	/* Now we must do length iterations of the node list, one output for each step */
 	for (samplenum = 0; samplenum < length; samplenum++)
 	{
-		/* loop over all nodes */
-		for (nodenum = 0; nodenum < info->node_count; nodenum++)
-		{
-			node_description *node = info->running_order[nodenum];
-
-			/* Now step the node */
-			if (node->module.step)
-				(*node->module.step)(node);
-		}
+		/* step all the nodes that aren't constant */
+		for (stepnum = 0; stepnum < step_count; stepnum++)
+			(*step_list[stepnum].step)(step_list[stepnum].node);
 
 		/* Add gain to the output and put into the buffers */
 		/* Clipping will be handled by the main sound system */
@@ -515,6 +533,7 @@ static void discrete_stream_update(void *param, stream_sample_t **inputs, stream
 
 static void init_nodes(discrete_info *info, discrete_sound_block *block_list)
 {
+	size_t context_total = 0;
 	int nodenum;
 
 	/* start with no outputs or input streams */
@@ -603,12 +622,8 @@ static void init_nodes(discrete_info *info, discrete_sound_block *block_list)
 			node->custom = custom->custom;
 		}
 
-		/* allocate memory if necessary */
-		if (node->module.contextsize)
-		{
-			node->context = auto_malloc(node->module.contextsize);
-			memset(node->context, 0, node->module.contextsize);
-		}
+		/* count up the context memory; it is allocated below */
+		context_total += (node->module.contextsize + 15) & ~15;
 
 		/* if we are an stream input node, track that */
 		if (block->type == DSS_INPUT_STREAM)
@@ -623,6 +638,23 @@ static void init_nodes(discrete_info *info, discrete_sound_block *block_list)
 	/* if no outputs, give an error */
 	if (info->discrete_outputs == 0)
 		fatalerror("init_nodes() - Couldn't find an output node");
+
+	/* allocate all the contexts in one block, in running order */
+	if (context_total != 0)
+	{
+		UINT8 *context_base = auto_malloc(context_total);
+		memset(context_base, 0, context_total);
+
+		for (nodenum = 0; nodenum < info->node_count; nodenum++)
+		{
+			node_description *node = info->running_order[nodenum];
+			if (node->module.contextsize)
+			{
+				node->context = context_base;
+				context_base += (node->module.contextsize + 15) & ~15;
+			}
+		}
+	}
 }
 
 
@@ -664,6 +696,81 @@ static void find_input_nodes(discrete_info *info, discrete_sound_block *block_li
 
 
 
+/*************************************
+ *
+ *  Build the execution plan
+ *
+ *************************************/
+
+static int node_is_stateless(const node_description *node)
+{
+	/* these modules compute their output from their inputs and */
+	/* constant configuration alone */
+	switch (node->module.type)
+	{
+		case DSS_CONSTANT:
+		case DST_ADDER:
+		case DST_CLAMP:
+		case DST_COMP_ADDER:
+		case DST_DIVIDE:
+		case DST_GAIN:
+		case DST_LOGIC_INV:
+		case DST_LOGIC_AND:
+		case DST_LOGIC_NAND:
+		case DST_LOGIC_OR:
+		case DST_LOGIC_NOR:
+		case DST_LOGIC_XOR:
+		case DST_LOGIC_NXOR:
+		case DST_SWITCH:
+		case DST_ASWITCH:
+		case DST_TRANSFORM:
+			return TRUE;
+	}
+	return FALSE;
+}
+
+
+static void compile_nodes(discrete_info *info)
+{
+	UINT8 *constant = malloc_or_die(info->node_count);
+	int nodenum, inputnum, folded = 0;
+
+	info->step_list = auto_malloc(info->node_count * sizeof(info->step_list[0]));
+	info->step_count = 0;
+
+	/* the running order follows the node list, so an index into one is an index into the other */
+	for (nodenum = 0; nodenum < info->node_count; nodenum++)
+	{
+		node_description *node = info->running_order[nodenum];
+		int is_constant = node_is_stateless(node);
+
+		/* every node input must be a constant that is evaluated before us at reset */
+		for (inputnum = 0; inputnum < node->active_inputs && is_constant; inputnum++)
+			if (node->input_is_node & (1 << inputnum))
+			{
+				int refnum = info->indexed_node[node->block->input_node[inputnum] - NODE_START] - info->node_list;
+				if (refnum >= nodenum || !constant[refnum])
+					is_constant = FALSE;
+			}
+		constant[nodenum] = is_constant;
+
+		/* constants are evaluated once by discrete_reset and never stepped again */
+		if (is_constant)
+			folded++;
+		else if (node->module.step)
+		{
+			info->step_list[info->step_count].step = node->module.step;
+			info->step_list[info->step_count].node = node;
+			info->step_count++;
+		}
+	}
+	free(constant);
+
+	discrete_log("compile_nodes() - %d nodes folded to constants, %d steps per sample", folded, info->step_count);
+}
+
+
+
 /*************************************
  *
  *  Set up the output nodes
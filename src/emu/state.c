@@ -12,11 +12,35 @@
     Save state file format:
 
      0.. 7  'MAMESAVE"
-     8      Format version (this is format 1)
+     8      Format version (this is format 2)
      9      Flags
      a..13  Game name padded with \0
     14..17  Signature
-    18..end Save game data
+    18..1b  CRC of the reference state, or 0 if none
+    1c..end zlib stream of entry records
+
+    Each entry record is the entry's index within the registry (32-bit
+    little endian) followed by one opcode byte per CHUNK_SIZE chunk of
+    the entry: CHUNK_LITERAL followed by the raw chunk data, or
+    CHUNK_REFERENCE if the chunk is identical to the same chunk of the
+    reference state. Records appear in the order the tags were saved,
+    which lets both saving and loading stream straight to and from
+    the registered memory.
+
+    Format 1 files are still loaded; they hold the raw save game data
+    laid out flat from offset 18 to the end.
+
+****************************************************************************
+
+    Rewind buffer:
+
+    In addition to file-based states, the registered entries can be
+    captured into a ring of preallocated in-memory snapshots. Each slot
+    holds a full-sized buffer plus, per entry, the index of the slot
+    whose buffer actually contains that entry's data. An entry that has
+    not changed since the previous snapshot simply points at the older
+    copy instead of being copied again; when a slot is reused, any data
+    still referenced by other snapshots is migrated out of it first.
 
 ***************************************************************************/
 
@@ -44,7 +68,13 @@
     CONSTANTS
 ***************************************************************************/
 
-#define SAVE_VERSION		1
+#define SAVE_VERSION		2
+#define SAVE_VERSION_RAW	1
+
+#define HEADER_SIZE			0x18
+
+#define CHUNK_SIZE			4096
+#define STREAM_BUFFER_SIZE	65536
 
 #define TAG_STACK_SIZE		4
 
@@ -61,6 +91,13 @@ enum
 	FUNC_PTRPARAM
 };
 
+/* chunk opcodes */
+enum
+{
+	CHUNK_LITERAL,
+	CHUNK_REFERENCE
+};
+
 
 
 /***************************************************************************
@@ -77,6 +114,7 @@ struct _ss_entry
 	UINT32			typecount;			/* number of items */
 	int				tag;				/* saving tag */
 	UINT32			offset;				/* offset within the final structure */
+	UINT32			index;				/* index within the registry */
 };
 
 
@@ -100,6 +138,14 @@ struct _ss_func
 };
 
 
+typedef struct _ss_rewind_slot ss_rewind_slot;
+struct _ss_rewind_slot
+{
+	UINT8 *			data;				/* full-sized snapshot buffer */
+	UINT16 *		owner;				/* per-entry index of the slot holding the data */
+};
+
+
 
 /***************************************************************************
     GLOBAL VARIABLES
@@ -118,6 +164,31 @@ static UINT8 ss_registration_allowed;
 static UINT8 *ss_dump_array;
 static mame_file *ss_dump_file;
 static UINT32 ss_dump_size;
+static UINT32 ss_entry_count;
+static UINT32 ss_registry_generation;
+
+static z_stream ss_zstream;
+static UINT8 *ss_stream_buffer;
+static UINT8 ss_stream_active;
+static UINT8 ss_stream_reference;
+static UINT8 ss_stream_error;
+static UINT8 ss_stream_ended;
+static UINT8 ss_stream_flags;
+
+static UINT8 *ss_reference_array;
+static UINT32 ss_reference_signature;
+static UINT32 ss_reference_crc;
+
+static ss_rewind_slot *ss_rewind_slot_list;
+static int ss_rewind_slots;
+static int ss_rewind_head;
+static int ss_rewind_valid;
+static int ss_rewind_target;
+static int ss_rewind_evicting;
+static UINT8 ss_rewind_active;
+static UINT32 ss_rewind_size;
+static UINT32 ss_rewind_entries;
+static UINT32 ss_rewind_generation;
 
 #ifdef MESS
 static const char ss_magic_num[8] = { 'M', 'E', 'S', 'S', 'S', 'A', 'V', 'E' };
@@ -137,6 +208,10 @@ static void ss_c8(UINT8 *, UINT32);
 
 static void (*const ss_conv[])(UINT8 *, UINT32) = { 0, 0, ss_c2, 0, ss_c4, 0, 0, 0, ss_c8 };
 
+static void state_exit(running_machine *machine);
+static void rewind_free(void);
+static void rewind_capture_entry(ss_entry *entry);
+
 
 
 /***************************************************************************
@@ -154,6 +229,24 @@ void state_init(running_machine *machine)
 	ss_current_tag = 0;
 	ss_tag_stack_index = 0;
 	ss_registration_allowed = FALSE;
+
+	add_exit_callback(machine, state_exit);
+}
+
+
+/*-------------------------------------------------
+    state_exit - release the rewind buffer
+-------------------------------------------------*/
+
+static void state_exit(running_machine *machine)
+{
+	rewind_free();
+	ss_rewind_slots = 0;
+
+	/* free the reference state */
+	if (ss_reference_array != NULL)
+		free(ss_reference_array);
+	ss_reference_array = NULL;
 }
 
 
@@ -286,6 +379,9 @@ void state_save_register_memory(const char *module, UINT32 instance, const char
 	(*entry)->typecount = valcount;
 	(*entry)->tag       = ss_current_tag;
 	restrack_register_object(OBJTYPE_STATEREG, *entry, 0, __FILE__, __LINE__);
+
+	/* any existing rewind snapshots no longer match the registry */
+	ss_registry_generation++;
 }
 
 
@@ -491,6 +587,7 @@ void state_destructor(void *ptr, size_t size)
 				*entry = (*entry)->next;
 				astring_free(entry_to_free->name);
 				free(entry_to_free);
+				ss_registry_generation++;
 				break;
 			}
 
@@ -578,12 +675,14 @@ static int compute_size_and_offsets(void)
 
 	/* start with the header size */
 	total_size = 0x18;
+	ss_entry_count = 0;
 
 	/* iterate over entries */
 	for (entry = ss_registry; entry; entry = entry->next)
 	{
 		/* note the offset and accumulate a total size */
 		entry->offset = total_size;
+		entry->index = ss_entry_count++;
 		total_size += entry->typesize * entry->typecount;
 	}
 
@@ -671,10 +770,10 @@ static int validate_header(const UINT8 *header, const char *gamename, UINT32 sig
 	}
 
 	/* check save state version */
-	if (header[8] != SAVE_VERSION)
+	if (header[8] != SAVE_VERSION && header[8] != SAVE_VERSION_RAW)
 	{
 		if (errormsg)
-			errormsg("%sWrong version in save file (%d, 1 expected)", error_prefix, header[8]);
+			errormsg("%sWrong version in save file (%d, %d or %d expected)", error_prefix, header[8], SAVE_VERSION_RAW, SAVE_VERSION);
 		return -1;
 	}
 
@@ -710,7 +809,7 @@ static int validate_header(const UINT8 *header, const char *gamename, UINT32 sig
 int state_save_check_file(mame_file *file, const char *gamename, int validate_signature, void (CLIB_DECL *errormsg)(const char *fmt, ...))
 {
 	UINT32 signature = 0;
-	UINT8 header[0x18];
+	UINT8 header[HEADER_SIZE];
 
 	/* if we want to validate the signature, compute it */
 	if (validate_signature)
@@ -731,6 +830,271 @@ int state_save_check_file(mame_file *file, const char *gamename, int validate_si
 
 
 
+/***************************************************************************
+    STREAM HELPERS
+***************************************************************************/
+
+/*-------------------------------------------------
+    stream_flush_output - write any compressed
+    data sitting in the stream buffer
+-------------------------------------------------*/
+
+static void stream_flush_output(void)
+{
+	UINT32 bytes = STREAM_BUFFER_SIZE - ss_zstream.avail_out;
+
+	if (bytes > 0 && mame_fwrite(ss_dump_file, ss_stream_buffer, bytes) != bytes)
+		ss_stream_error = TRUE;
+	ss_zstream.next_out = ss_stream_buffer;
+	ss_zstream.avail_out = STREAM_BUFFER_SIZE;
+}
+
+
+/*-------------------------------------------------
+    stream_write - compress data into the
+    output stream
+-------------------------------------------------*/
+
+static void stream_write(const void *data, UINT32 length)
+{
+	ss_zstream.next_in = (Bytef *)data;
+	ss_zstream.avail_in = length;
+	while (ss_zstream.avail_in > 0 && !ss_stream_error)
+	{
+		if (deflate(&ss_zstream, Z_NO_FLUSH) != Z_OK)
+			ss_stream_error = TRUE;
+		if (ss_zstream.avail_out == 0)
+			stream_flush_output();
+	}
+}
+
+
+/*-------------------------------------------------
+    stream_read - decompress up to length bytes
+    from the input stream, returning the number
+    of bytes actually read
+-------------------------------------------------*/
+
+static UINT32 stream_read(void *data, UINT32 length)
+{
+	ss_zstream.next_out = data;
+	ss_zstream.avail_out = length;
+	while (ss_zstream.avail_out > 0 && !ss_stream_ended)
+	{
+		int zerr;
+
+		/* refill the input buffer from the file as needed */
+		if (ss_zstream.avail_in == 0)
+		{
+			ss_zstream.next_in = ss_stream_buffer;
+			ss_zstream.avail_in = mame_fread(ss_dump_file, ss_stream_buffer, STREAM_BUFFER_SIZE);
+		}
+
+		zerr = inflate(&ss_zstream, Z_NO_FLUSH);
+		if (zerr == Z_STREAM_END)
+			ss_stream_ended = TRUE;
+		else if (zerr != Z_OK)
+			break;
+	}
+	return length - ss_zstream.avail_out;
+}
+
+
+/*-------------------------------------------------
+    stream_save_entry - write a single entry
+    record, referencing chunks that match the
+    reference state
+-------------------------------------------------*/
+
+static void stream_save_entry(ss_entry *entry)
+{
+	UINT32 size = entry->typesize * entry->typecount;
+	UINT32 index = LITTLE_ENDIANIZE_INT32(entry->index);
+	const UINT8 *data = entry->data;
+	UINT32 chunkoffs;
+
+	stream_write(&index, 4);
+	for (chunkoffs = 0; chunkoffs < size; chunkoffs += CHUNK_SIZE)
+	{
+		UINT32 chunklen = MIN(size - chunkoffs, CHUNK_SIZE);
+		UINT8 opcode = CHUNK_LITERAL;
+
+		if (ss_stream_reference && memcmp(data + chunkoffs, ss_reference_array + entry->offset + chunkoffs, chunklen) == 0)
+			opcode = CHUNK_REFERENCE;
+
+		stream_write(&opcode, 1);
+		if (opcode == CHUNK_LITERAL)
+			stream_write(data + chunkoffs, chunklen);
+	}
+}
+
+
+/*-------------------------------------------------
+    stream_load_entry - read the chunks of a
+    single entry record into dest
+-------------------------------------------------*/
+
+static int stream_load_entry(ss_entry *entry, UINT8 *dest, int need_convert)
+{
+	UINT32 size = entry->typesize * entry->typecount;
+	UINT32 chunkoffs;
+
+	for (chunkoffs = 0; chunkoffs < size; chunkoffs += CHUNK_SIZE)
+	{
+		UINT32 chunklen = MIN(size - chunkoffs, CHUNK_SIZE);
+		UINT8 opcode;
+
+		if (stream_read(&opcode, 1) != 1)
+			return FALSE;
+
+		/* reference chunks are already in native order */
+		if (opcode == CHUNK_REFERENCE && ss_stream_reference)
+			memcpy(dest + chunkoffs, ss_reference_array + entry->offset + chunkoffs, chunklen);
+
+		/* literal chunks come straight from the stream; CHUNK_SIZE is a multiple of every type size */
+		else if (opcode == CHUNK_LITERAL && stream_read(dest + chunkoffs, chunklen) == chunklen)
+		{
+			if (need_convert && ss_conv[entry->typesize])
+				(*ss_conv[entry->typesize])(dest + chunkoffs, chunklen / entry->typesize);
+		}
+		else
+			return FALSE;
+	}
+	return TRUE;
+}
+
+
+/*-------------------------------------------------
+    stream_free - release the stream state
+-------------------------------------------------*/
+
+static void stream_free(void)
+{
+	if (ss_stream_buffer != NULL)
+		free(ss_stream_buffer);
+	ss_stream_buffer = NULL;
+	ss_stream_active = FALSE;
+	ss_stream_reference = FALSE;
+}
+
+
+
+/***************************************************************************
+    REFERENCE STATES
+***************************************************************************/
+
+/*-------------------------------------------------
+    state_save_set_reference - load a state to
+    delta-compress subsequent saves against
+-------------------------------------------------*/
+
+int state_save_set_reference(mame_file *file)
+{
+	UINT32 signature = get_signature();
+	UINT8 header[HEADER_SIZE];
+	ss_entry **entrylist;
+	ss_entry *entry;
+	int need_convert;
+	UINT32 bytes, crc = 0;
+	UINT32 size;
+
+	/* drop any existing reference */
+	if (ss_reference_array != NULL)
+		free(ss_reference_array);
+	ss_reference_array = NULL;
+
+	/* read and verify the header */
+	mame_fseek(file, 0, SEEK_SET);
+	if (mame_fread(file, header, HEADER_SIZE) != HEADER_SIZE || validate_header(header, NULL, signature, popmessage, "Error: "))
+		return 1;
+
+	/* checksum the whole file; delta states record this so they can't be paired with the wrong reference */
+	ss_stream_buffer = malloc_or_die(STREAM_BUFFER_SIZE);
+	mame_fseek(file, 0, SEEK_SET);
+	while ((bytes = mame_fread(file, ss_stream_buffer, STREAM_BUFFER_SIZE)) > 0)
+		crc = crc32(crc, ss_stream_buffer, bytes);
+
+	/* the reference is kept as a flat, native-order image */
+	size = compute_size_and_offsets();
+	ss_reference_array = malloc_or_die(size);
+	memset(ss_reference_array, 0, size);
+
+#ifdef LSB_FIRST
+	need_convert = (header[9] & SS_MSB_FIRST) != 0;
+#else
+	need_convert = (header[9] & SS_MSB_FIRST) == 0;
+#endif
+
+	/* format 1 files are already flat */
+	if (header[8] == SAVE_VERSION_RAW)
+	{
+		mame_fseek(file, 0, SEEK_SET);
+		if (mame_fread(file, ss_reference_array, size) != size)
+			ss_stream_error = TRUE;
+		else if (need_convert)
+			for (entry = ss_registry; entry; entry = entry->next)
+				if (ss_conv[entry->typesize])
+					(*ss_conv[entry->typesize])(ss_reference_array + entry->offset, entry->typecount);
+	}
+
+	/* otherwise, decode every record into the image */
+	else
+	{
+		UINT32 refcrc, index;
+
+		/* build a lookup from index to entry */
+		entrylist = malloc_or_die(MAX(ss_entry_count, 1) * sizeof(*entrylist));
+		for (entry = ss_registry; entry; entry = entry->next)
+			entrylist[entry->index] = entry;
+
+		/* references can't be chained */
+		mame_fseek(file, HEADER_SIZE, SEEK_SET);
+		if (mame_fread(file, &refcrc, 4) != 4 || refcrc != 0)
+			ss_stream_error = TRUE;
+
+		/* read records until the stream ends */
+		memset(&ss_zstream, 0, sizeof(ss_zstream));
+		ss_dump_file = file;
+		ss_stream_ended = FALSE;
+		if (!ss_stream_error && inflateInit(&ss_zstream) == Z_OK)
+		{
+			while (!ss_stream_error && (bytes = stream_read(&index, 4)) != 0)
+			{
+				index = LITTLE_ENDIANIZE_INT32(index);
+				if (bytes != 4 || index >= ss_entry_count)
+					ss_stream_error = TRUE;
+				else if (!stream_load_entry(entrylist[index], ss_reference_array + entrylist[index]->offset, need_convert))
+					ss_stream_error = TRUE;
+			}
+			if (!ss_stream_ended)
+				ss_stream_error = TRUE;
+			inflateEnd(&ss_zstream);
+		}
+		else
+			ss_stream_error = TRUE;
+		ss_dump_file = NULL;
+		free(entrylist);
+	}
+
+	/* clean up */
+	stream_free();
+	if (ss_stream_error)
+	{
+		popmessage("Error: Unable to read reference state");
+		free(ss_reference_array);
+		ss_reference_array = NULL;
+		ss_stream_error = FALSE;
+		return 1;
+	}
+
+	/* a CRC of 0 means "no reference" in the file, so avoid it */
+	ss_reference_signature = signature;
+	ss_reference_crc = (crc != 0) ? crc : 1;
+	return 0;
+}
+
+
+
 /***************************************************************************
     SAVE STATE PROCESSING
 ***************************************************************************/
@@ -742,6 +1106,10 @@ int state_save_check_file(mame_file *file, const char *gamename, int validate_si
 
 int state_save_save_begin(mame_file *file)
 {
+	UINT8 header[HEADER_SIZE + 4];
+	UINT32 signature, refcrc;
+	UINT8 flags = 0;
+
 	/* if we have illegal registrations, return an error */
 	if (ss_illegal_regs > 0)
 		return 1;
@@ -753,8 +1121,35 @@ int state_save_save_begin(mame_file *file)
 	ss_dump_size = compute_size_and_offsets();
 	TRACE(logerror("   total size %u\n", ss_dump_size));
 
-	/* allocate memory for the array */
-	ss_dump_array = malloc_or_die(ss_dump_size);
+	/* only delta-compress if the reference matches the current layout */
+	signature = get_signature();
+	ss_stream_reference = (ss_reference_array != NULL && ss_reference_signature == signature);
+	refcrc = ss_stream_reference ? ss_reference_crc : 0;
+
+	/* compute the flags */
+#ifndef LSB_FIRST
+	flags |= SS_MSB_FIRST;
+#endif
+
+	/* build up the header; unlike format 1, this goes out first */
+	memcpy(header, ss_magic_num, 8);
+	header[8] = SAVE_VERSION;
+	header[9] = flags;
+	memset(header+0xa, 0, 10);
+	strcpy((char *)header+0xa, Machine->gamedrv->name);
+	*(UINT32 *)&header[0x14] = LITTLE_ENDIANIZE_INT32(signature);
+	*(UINT32 *)&header[0x18] = LITTLE_ENDIANIZE_INT32(refcrc);
+	if (mame_fwrite(file, header, sizeof(header)) != sizeof(header))
+		ss_stream_error = TRUE;
+
+	/* start up the compressor; favor speed to keep saves from hitching */
+	memset(&ss_zstream, 0, sizeof(ss_zstream));
+	if (deflateInit(&ss_zstream, Z_BEST_SPEED) != Z_OK)
+		ss_stream_error = TRUE;
+	ss_stream_buffer = malloc_or_die(STREAM_BUFFER_SIZE);
+	ss_zstream.next_out = ss_stream_buffer;
+	ss_zstream.avail_out = STREAM_BUFFER_SIZE;
+	ss_stream_active = TRUE;
 	return 0;
 }
 
@@ -779,11 +1174,20 @@ void state_save_save_continue(void)
 	/* then copy in all the data */
 	TRACE(logerror("  copying data\n"));
 
-	/* iterate over entries with matching tags */
+	/* rewind snapshots only copy what changed */
+	if (ss_rewind_active)
+	{
+		for (entry = ss_registry; entry; entry = entry->next)
+			if (entry->tag == ss_current_tag)
+				rewind_capture_entry(entry);
+		return;
+	}
+
+	/* iterate over entries with matching tags, streaming them out */
 	for (entry = ss_registry; entry; entry = entry->next)
 		if (entry->tag == ss_current_tag)
 		{
-			memcpy(ss_dump_array + entry->offset, entry->data, entry->typesize * entry->typecount);
+			stream_save_entry(entry);
 			TRACE(logerror("    %s: %x..%x\n", astring_c(entry->name), entry->offset, entry->offset + entry->typesize * entry->typecount - 1));
 		}
 }
@@ -791,40 +1195,33 @@ void state_save_save_continue(void)
 
 /*-------------------------------------------------
     state_save_save_finish - finish saving the
-    file by writing the header and closing
+    file by flushing the compressor
 -------------------------------------------------*/
 
-void state_save_save_finish(void)
+int state_save_save_finish(void)
 {
-	UINT32 signature;
-	UINT8 flags = 0;
+	int result;
+	int zerr;
 
 	TRACE(logerror("Finishing save\n"));
 
-	/* compute the flags */
-#ifndef LSB_FIRST
-	flags |= SS_MSB_FIRST;
-#endif
-
-	/* build up the header */
-	memcpy(ss_dump_array, ss_magic_num, 8);
-	ss_dump_array[8] = SAVE_VERSION;
-	ss_dump_array[9] = flags;
-	memset(ss_dump_array+0xa, 0, 10);
-	strcpy((char *)ss_dump_array+0xa, Machine->gamedrv->name);
-
-	/* copy in the signature */
-	signature = get_signature();
-	*(UINT32 *)&ss_dump_array[0x14] = LITTLE_ENDIANIZE_INT32(signature);
-
-	/* write the file */
-	mame_fwrite(ss_dump_file, ss_dump_array, ss_dump_size);
+	/* flush everything out of the compressor */
+	do
+	{
+		zerr = deflate(&ss_zstream, Z_FINISH);
+		stream_flush_output();
+	} while (zerr == Z_OK && !ss_stream_error);
+	if (zerr != Z_STREAM_END)
+		ss_stream_error = TRUE;
+	deflateEnd(&ss_zstream);
 
 	/* free memory and reset the global states */
-	free(ss_dump_array);
-	ss_dump_array = NULL;
+	result = ss_stream_error ? 1 : 0;
+	stream_free();
+	ss_stream_error = FALSE;
 	ss_dump_size = 0;
 	ss_dump_file = NULL;
+	return result;
 }
 
 
@@ -840,27 +1237,60 @@ void state_save_save_finish(void)
 
 int state_save_load_begin(mame_file *file)
 {
+	UINT8 header[HEADER_SIZE];
+	UINT32 signature = get_signature();
+	UINT32 refcrc;
+
 	TRACE(logerror("Beginning load\n"));
 
-	/* read the file into memory */
-	ss_dump_size = mame_fsize(file);
-	ss_dump_array = malloc_or_die(ss_dump_size);
+	/* read and verify the header and report an error if it doesn't match */
+	mame_fseek(file, 0, SEEK_SET);
+	if (mame_fread(file, header, HEADER_SIZE) != HEADER_SIZE || validate_header(header, NULL, signature, popmessage, "Error: "))
+		return 1;
+
+	/* compute the total size and offset of all the entries */
+	ss_dump_size = compute_size_and_offsets();
 	ss_dump_file = file;
-	mame_fread(ss_dump_file, ss_dump_array, ss_dump_size);
 
-	/* verify the header and report an error if it doesn't match */
-	if (validate_header(ss_dump_array, NULL, get_signature(), popmessage, "Error: "))
+	/* format 1 files are read into memory in one go */
+	if (header[8] == SAVE_VERSION_RAW)
 	{
-		free(ss_dump_array);
-		ss_dump_array = NULL;
-		ss_dump_size = 0;
-		ss_dump_file = NULL;
-		return 1;
+		ss_dump_array = malloc_or_die(ss_dump_size);
+		memcpy(ss_dump_array, header, HEADER_SIZE);
+		mame_fread(ss_dump_file, ss_dump_array + HEADER_SIZE, ss_dump_size - HEADER_SIZE);
+		return 0;
 	}
 
-	/* compute the total size and offset of all the entries */
-	compute_size_and_offsets();
+	/* delta states need the reference they were saved against */
+	if (mame_fread(file, &refcrc, 4) != 4)
+		goto error;
+	refcrc = LITTLE_ENDIANIZE_INT32(refcrc);
+	ss_stream_reference = (refcrc != 0);
+	if (ss_stream_reference && (ss_reference_array == NULL || ss_reference_signature != signature || ss_reference_crc != refcrc))
+	{
+		popmessage("Error: This state requires a reference state that is not loaded");
+		goto error;
+	}
+
+	/* start up the decompressor */
+	memset(&ss_zstream, 0, sizeof(ss_zstream));
+	if (inflateInit(&ss_zstream) != Z_OK)
+		goto error;
+	ss_stream_buffer = malloc_or_die(STREAM_BUFFER_SIZE);
+	ss_stream_active = TRUE;
+	ss_stream_ended = FALSE;
+	ss_stream_error = FALSE;
+
+	/* remember the flags for endian conversion */
+	ss_dump_array = NULL;
+	ss_stream_flags = header[9];
 	return 0;
+
+error:
+	stream_free();
+	ss_dump_size = 0;
+	ss_dump_file = NULL;
+	return 1;
 }
 
 
@@ -872,14 +1302,17 @@ int state_save_load_begin(mame_file *file)
 void state_save_load_continue(void)
 {
 	ss_entry *entry;
+	UINT8 flags;
 	int need_convert;
 	int count;
 
 	/* first determine whether or not we need to convert the endianness of the data */
+	/* rewind snapshots are always in native order */
+	flags = ss_stream_active ? ss_stream_flags : (ss_dump_array != NULL) ? ss_dump_array[9] : 0;
 #ifdef LSB_FIRST
-	need_convert = (ss_dump_array[9] & SS_MSB_FIRST) != 0;
+	need_convert = !ss_rewind_active && (flags & SS_MSB_FIRST) != 0;
 #else
-	need_convert = (ss_dump_array[9] & SS_MSB_FIRST) == 0;
+	need_convert = !ss_rewind_active && (flags & SS_MSB_FIRST) == 0;
 #endif
 
 	TRACE(logerror("Loading tag %d\n", ss_current_tag));
@@ -889,9 +1322,31 @@ void state_save_load_continue(void)
 	for (entry = ss_registry; entry; entry = entry->next)
 		if (entry->tag == ss_current_tag)
 		{
-			memcpy(entry->data, ss_dump_array + entry->offset, entry->typesize * entry->typecount);
-			if (need_convert && ss_conv[entry->typesize])
-				(*ss_conv[entry->typesize])(entry->data, entry->typecount);
+			/* streamed states are decompressed straight into place */
+			if (ss_stream_active)
+			{
+				UINT32 index;
+
+				if (!ss_stream_error && (stream_read(&index, 4) != 4 || LITTLE_ENDIANIZE_INT32(index) != entry->index))
+					ss_stream_error = TRUE;
+				if (!ss_stream_error && !stream_load_entry(entry, entry->data, need_convert))
+					ss_stream_error = TRUE;
+			}
+
+			/* rewind snapshots may keep the data in an older slot */
+			else if (ss_rewind_active)
+			{
+				const ss_rewind_slot *slot = &ss_rewind_slot_list[ss_rewind_target];
+				memcpy(entry->data, ss_rewind_slot_list[slot->owner[entry->index]].data + entry->offset, entry->typesize * entry->typecount);
+			}
+
+			/* format 1 states come from the flat array */
+			else
+			{
+				memcpy(entry->data, ss_dump_array + entry->offset, entry->typesize * entry->typecount);
+				if (need_convert && ss_conv[entry->typesize])
+					(*ss_conv[entry->typesize])(entry->data, entry->typecount);
+			}
 			TRACE(logerror("    %s: %x..%x\n", astring_c(entry->name), entry->offset, entry->offset + entry->typesize * entry->typecount - 1));
 		}
 
@@ -907,15 +1362,241 @@ void state_save_load_continue(void)
     of loading the state
 -------------------------------------------------*/
 
-void state_save_load_finish(void)
+int state_save_load_finish(void)
 {
+	int result = 0;
+
 	TRACE(logerror("Finishing load\n"));
 
+	/* shut down the decompressor */
+	if (ss_stream_active)
+	{
+		result = ss_stream_error ? 1 : 0;
+		inflateEnd(&ss_zstream);
+		stream_free();
+		ss_stream_error = FALSE;
+	}
+
 	/* free memory and reset the global states */
-	free(ss_dump_array);
+	if (ss_dump_array != NULL)
+		free(ss_dump_array);
 	ss_dump_array = NULL;
 	ss_dump_size = 0;
 	ss_dump_file = NULL;
+	return result;
+}
+
+
+
+/***************************************************************************
+    REWIND BUFFER
+***************************************************************************/
+
+/*-------------------------------------------------
+    rewind_free - free all rewind slots
+-------------------------------------------------*/
+
+static void rewind_free(void)
+{
+	int slotnum;
+
+	if (ss_rewind_slot_list != NULL)
+	{
+		for (slotnum = 0; slotnum < ss_rewind_slots; slotnum++)
+		{
+			free(ss_rewind_slot_list[slotnum].data);
+			free(ss_rewind_slot_list[slotnum].owner);
+		}
+		free(ss_rewind_slot_list);
+	}
+	ss_rewind_slot_list = NULL;
+	ss_rewind_size = 0;
+	ss_rewind_entries = 0;
+	ss_rewind_head = 0;
+	ss_rewind_valid = 0;
+}
+
+
+/*-------------------------------------------------
+    rewind_validate - make sure the rewind slots
+    match the current registry, reallocating
+    them if the layout has changed
+-------------------------------------------------*/
+
+static void rewind_validate(void)
+{
+	UINT32 size = compute_size_and_offsets();
+	int slotnum;
+
+	/* if nothing changed, the existing snapshots are still good */
+	if (ss_rewind_slot_list != NULL && ss_rewind_generation == ss_registry_generation)
+		return;
+
+	/* the layout changed; drop everything and start again */
+	if (ss_rewind_slot_list == NULL || size != ss_rewind_size || ss_entry_count != ss_rewind_entries)
+	{
+		int slots = ss_rewind_slots;
+
+		rewind_free();
+		ss_rewind_slots = slots;
+		ss_rewind_slot_list = malloc_or_die(ss_rewind_slots * sizeof(*ss_rewind_slot_list));
+		for (slotnum = 0; slotnum < ss_rewind_slots; slotnum++)
+		{
+			ss_rewind_slot_list[slotnum].data = malloc_or_die(size);
+			ss_rewind_slot_list[slotnum].owner = malloc_or_die(MAX(ss_entry_count, 1) * sizeof(UINT16));
+		}
+		ss_rewind_size = size;
+		ss_rewind_entries = ss_entry_count;
+		TRACE(logerror("Allocated %d rewind slots of %u bytes\n", ss_rewind_slots, size));
+	}
+
+	/* same size but a different layout still invalidates the contents */
+	ss_rewind_head = 0;
+	ss_rewind_valid = 0;
+	ss_rewind_generation = ss_registry_generation;
+}
+
+
+/*-------------------------------------------------
+    rewind_capture_entry - capture a single entry
+    into the target slot if it has changed since
+    the previous snapshot
+-------------------------------------------------*/
+
+static void rewind_capture_entry(ss_entry *entry)
+{
+	UINT32 size = entry->typesize * entry->typecount;
+	ss_rewind_slot *slot = &ss_rewind_slot_list[ss_rewind_target];
+	int target = ss_rewind_target;
+	int index = entry->index;
+
+	/* compare against the most recent snapshot; if unchanged, share its copy */
+	if (ss_rewind_valid > 0 || ss_rewind_evicting)
+	{
+		int owner = ss_rewind_slot_list[ss_rewind_head].owner[index];
+		if (memcmp(entry->data, ss_rewind_slot_list[owner].data + entry->offset, size) == 0)
+		{
+			slot->owner[index] = owner;
+			return;
+		}
+	}
+
+	/* other snapshots may still be pointing at the copy we're about to replace; */
+	/* move it into the oldest of them and repoint the rest */
+	if (ss_rewind_valid > 0)
+	{
+		int slotnum = (ss_rewind_head + ss_rewind_slots - (ss_rewind_valid - 1)) % ss_rewind_slots;
+		int newowner = -1;
+		int count;
+
+		for (count = 0; count < ss_rewind_valid; count++, slotnum = (slotnum + 1) % ss_rewind_slots)
+			if (ss_rewind_slot_list[slotnum].owner[index] == target)
+			{
+				if (newowner == -1)
+				{
+					newowner = slotnum;
+					memcpy(ss_rewind_slot_list[slotnum].data + entry->offset, slot->data + entry->offset, size);
+				}
+				ss_rewind_slot_list[slotnum].owner[index] = newowner;
+			}
+	}
+
+	/* now take our own copy */
+	memcpy(slot->data + entry->offset, entry->data, size);
+	slot->owner[index] = target;
+}
+
+
+/*-------------------------------------------------
+    state_rewind_init - configure the number of
+    in-memory snapshots to keep
+-------------------------------------------------*/
+
+void state_rewind_init(int count)
+{
+	rewind_free();
+	ss_rewind_slots = MIN(count, 0xffff);
+}
+
+
+/*-------------------------------------------------
+    state_rewind_count - return the number of
+    snapshots available to rewind to
+-------------------------------------------------*/
+
+int state_rewind_count(void)
+{
+	return (ss_rewind_generation == ss_registry_generation) ? ss_rewind_valid : 0;
+}
+
+
+/*-------------------------------------------------
+    state_save_rewind_begin - begin capturing
+    a snapshot into the rewind buffer
+-------------------------------------------------*/
+
+int state_save_rewind_begin(void)
+{
+	/* if we have illegal registrations or no buffer, return an error */
+	if (ss_illegal_regs > 0 || ss_rewind_slots == 0)
+		return 1;
+
+	rewind_validate();
+
+	/* pick the slot after the newest; if the ring is full this is the oldest */
+	ss_rewind_target = (ss_rewind_valid == 0) ? ss_rewind_head : (ss_rewind_head + 1) % ss_rewind_slots;
+	ss_rewind_evicting = (ss_rewind_valid == ss_rewind_slots);
+	if (ss_rewind_evicting)
+		ss_rewind_valid--;
+	ss_rewind_active = TRUE;
+	return 0;
+}
+
+
+/*-------------------------------------------------
+    state_save_rewind_finish - commit the new
+    snapshot as the most recent one
+-------------------------------------------------*/
+
+void state_save_rewind_finish(void)
+{
+	ss_rewind_head = ss_rewind_target;
+	ss_rewind_valid++;
+	ss_rewind_evicting = FALSE;
+	ss_rewind_active = FALSE;
+}
+
+
+/*-------------------------------------------------
+    state_save_rewind_load_begin - begin restoring
+    the most recent snapshot
+-------------------------------------------------*/
+
+int state_save_rewind_load_begin(void)
+{
+	/* nothing to do if we have no valid snapshots */
+	if (state_rewind_count() == 0)
+		return 1;
+
+	compute_size_and_offsets();
+	ss_rewind_target = ss_rewind_head;
+	ss_rewind_active = TRUE;
+	return 0;
+}
+
+
+/*-------------------------------------------------
+    state_save_rewind_load_finish - drop the
+    snapshot we just restored so that the next
+    rewind goes further back
+-------------------------------------------------*/
+
+void state_save_rewind_load_finish(void)
+{
+	ss_rewind_valid--;
+	if (ss_rewind_valid > 0)
+		ss_rewind_head = (ss_rewind_head + ss_rewind_slots - 1) % ss_rewind_slots;
+	ss_rewind_active = FALSE;
 }
 
 
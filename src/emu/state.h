@@ -105,8 +105,21 @@ void state_save_pop_tag(void);
 void state_save_save_continue(void);
 void state_save_load_continue(void);
 
-void state_save_save_finish(void);
-void state_save_load_finish(void);
+int  state_save_save_finish(void);
+int  state_save_load_finish(void);
+
+/* Reference state for delta-compressing saves */
+int  state_save_set_reference(mame_file *file);
+
+/* In-memory rewind buffer; uses the same continue functions as above */
+void state_rewind_init(int count);
+int  state_rewind_count(void);
+
+int  state_save_rewind_begin(void);
+void state_save_rewind_finish(void);
+
+int  state_save_rewind_load_begin(void);
+void state_save_rewind_load_finish(void);
 
 /* Display function */
 void state_save_dump_registry(void);
@@ -41,10 +41,26 @@
     These sample buffers can then be further resampled and passed to
     other streams, or output as desired.
 
+    Streams whose callbacks are known not to touch shared state can be
+    placed in a parallel group via streams_set_group. Before the global
+    update pulls on the speakers, streams_update_parallel walks the
+    graph of such streams in dependency order, one level at a time,
+    and brings each level up to date on the work queue. Streams in the
+    same group always run serially on one thread; anything that
+    depends on a stream outside a parallel group is left to the normal
+    on-demand pull.
+
+    When the resample_sinc option is enabled, inputs whose rate differs
+    from their stream's rate are filtered through a windowed-sinc
+    polyphase filter instead of being interpolated or averaged. The
+    filter tables are built whenever the rates are recomputed and are
+    shared between inputs that convert between the same pair of rates.
+
 ***************************************************************************/
 
 #include "driver.h"
 #include "streams.h"
+#include "osdepend.h"
 #include <math.h>
 
 
@@ -73,6 +89,20 @@
 #define FRAC_ONE						(1 << FRAC_BITS)
 #define FRAC_MASK						(FRAC_ONE - 1)
 
+#define SINC_PHASE_BITS					7
+#define SINC_PHASES						(1 << SINC_PHASE_BITS)
+#define SINC_ZERO_CROSSINGS				8			/* sinc lobes on each side of the center */
+#define SINC_ROLLOFF					0.90		/* cutoff, relative to the lower Nyquist frequency */
+#define SINC_MAX_TAPS					512
+
+
+
+/***************************************************************************
+    INCLUDES
+***************************************************************************/
+
+#include "sndsimd.h"
+
 
 
 /***************************************************************************
@@ -81,6 +111,18 @@
 
 typedef struct _stream_input stream_input;
 typedef struct _stream_output stream_output;
+typedef struct _stream_work stream_work;
+typedef struct _sinc_filter sinc_filter;
+
+
+struct _sinc_filter
+{
+	sinc_filter *		next;					/* next filter in the cache */
+	UINT32				input_rate;				/* sample rate being converted from */
+	UINT32				output_rate;			/* sample rate being converted to */
+	int					taps;					/* taps per phase, a multiple of 8 */
+	float *				coeff;					/* SINC_PHASES + 1 rows of coefficients */
+};
 
 struct _stream_input
 {
@@ -96,6 +138,7 @@ struct _stream_input
 	/* resampling information */
 	attoseconds_t		latency_attoseconds;	/* latency between this stream and the input stream */
 	INT16				gain;					/* gain to apply to this input */
+	sinc_filter *		filter;					/* sinc filter, or NULL to interpolate */
 };
 
 
@@ -150,6 +193,18 @@ struct _sound_stream
 	/* callback information */
 	stream_callback 	callback;				/* callback function */
 	void *				param;					/* callback function parameter */
+
+	/* parallel evaluation */
+	int					group;					/* parallel group, or STREAM_GROUP_SERIAL */
+	int					level;					/* level within the parallel graph, or -1 */
+};
+
+
+struct _stream_work
+{
+	streams_private *	strdata;				/* pointer back to the private data */
+	sound_stream **		stream;					/* streams to update, in order */
+	int					streams;				/* number of streams */
 };
 
 
@@ -161,6 +216,20 @@ struct _streams_private
 	int					stream_index;			/* index of the current stream */
 	attoseconds_t		update_attoseconds;		/* attoseconds between global updates */
 	attotime			last_update;			/* last update time */
+
+	/* parallel evaluation */
+	int					current_group;			/* current group to assign to new streams */
+	UINT8				graph_dirty;			/* TRUE if the graph needs rebuilding */
+	osd_work_queue *	queue;					/* queue for running groups in parallel */
+	stream_work *		work;					/* work units, sorted by level */
+	sound_stream **		work_stream;			/* stream pointers referenced by the work units */
+	int *				level_start;			/* index of the first work unit on each level */
+	int					levels;					/* number of levels */
+	attotime			work_time;				/* time the work units are updating to */
+
+	/* resampling */
+	UINT8				sinc;					/* TRUE to resample through sinc filters */
+	sinc_filter *		filter_list;			/* cache of filters */
 };
 
 
@@ -169,11 +238,16 @@ struct _streams_private
     FUNCTION PROTOTYPES
 ***************************************************************************/
 
+static void streams_exit(running_machine *machine);
 static void stream_postload(void *param);
+static void update_stream_to(streams_private *strdata, sound_stream *stream, attotime curtime);
+static void build_graph(streams_private *strdata);
+static void *stream_work_callback(void *param, int threadid);
 static void allocate_resample_buffers(streams_private *strdata, sound_stream *stream);
 static void allocate_output_buffers(streams_private *strdata, sound_stream *stream);
 static void recompute_sample_rate_data(streams_private *strdata, sound_stream *stream);
-static void generate_samples(sound_stream *stream, int samples);
+static sinc_filter *find_sinc_filter(streams_private *strdata, UINT32 input_rate, UINT32 output_rate);
+static void generate_samples(streams_private *strdata, sound_stream *stream, int samples, attotime curtime);
 static stream_sample_t *generate_resampled_data(stream_input *input, UINT32 numsamples);
 
 
@@ -229,16 +303,94 @@ void streams_init(running_machine *machine, attoseconds_t update_attoseconds)
 	/* reset globals */
 	strdata->stream_tailptr = &strdata->stream_head;
 	strdata->update_attoseconds = update_attoseconds;
+	strdata->current_group = STREAM_GROUP_SERIAL;
+	strdata->sinc = options_get_bool(mame_options(), OPTION_RESAMPLE_SINC);
 
 	/* set the global pointer */
 	machine->streams_data = strdata;
 
+	/* allocate a queue for parallel groups; without one, everything is pulled serially */
+	strdata->queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI | WORK_QUEUE_FLAG_HIGH_FREQ);
+	add_exit_callback(machine, streams_exit);
+
 	/* register global states */
 	state_save_register_global(strdata->last_update.seconds);
 	state_save_register_global(strdata->last_update.attoseconds);
 }
 
 
+/*-------------------------------------------------
+    streams_exit - free the parallel graph and
+    the sinc filters
+-------------------------------------------------*/
+
+static void streams_exit(running_machine *machine)
+{
+	streams_private *strdata = machine->streams_data;
+
+	while (strdata->filter_list != NULL)
+	{
+		sinc_filter *filter = strdata->filter_list;
+		strdata->filter_list = filter->next;
+		free(filter->coeff);
+		free(filter);
+	}
+
+	if (strdata->queue != NULL)
+		osd_work_queue_free(strdata->queue);
+	strdata->queue = NULL;
+
+	if (strdata->work != NULL)
+		free(strdata->work);
+	if (strdata->work_stream != NULL)
+		free(strdata->work_stream);
+	if (strdata->level_start != NULL)
+		free(strdata->level_start);
+	strdata->work = NULL;
+	strdata->work_stream = NULL;
+	strdata->level_start = NULL;
+}
+
+
+/*-------------------------------------------------
+    streams_update_parallel - bring all streams
+    in parallel groups up to the current time,
+    running independent groups concurrently
+-------------------------------------------------*/
+
+void streams_update_parallel(running_machine *machine)
+{
+	streams_private *strdata = machine->streams_data;
+	int level;
+
+	/* rebuild the graph if the routing has changed */
+	if (strdata->graph_dirty)
+		build_graph(strdata);
+	if (strdata->queue == NULL || strdata->levels == 0)
+		return;
+
+	/* everyone updates to the same time; the workers don't look at the scheduler */
+	strdata->work_time = timer_get_time();
+
+	/* each level only depends on the ones below it */
+	for (level = 0; level < strdata->levels; level++)
+	{
+		int first = strdata->level_start[level];
+		int count = strdata->level_start[level + 1] - first;
+
+		/* a lone group isn't worth handing off */
+		if (count == 1)
+			stream_work_callback(&strdata->work[first], 0);
+		else
+		{
+			osd_work_item_queue_multiple(strdata->queue, stream_work_callback, count, &strdata->work[first], sizeof(strdata->work[0]), WORK_ITEM_FLAG_AUTO_RELEASE);
+			if (!osd_work_queue_wait(strdata->queue, 100 * osd_ticks_per_second()))
+				fatalerror("streams_update_parallel: stream updates never completed");
+		}
+	}
+}
+
+
 /*-------------------------------------------------
     streams_update - update all the streams
     periodically
@@ -326,6 +478,22 @@ void streams_update(running_machine *machine)
 			/* clear out the buffer */
 			for (outputnum = 0; outputnum < stream->outputs; outputnum++)
 				memset(stream->output[outputnum].buffer, 0, stream->max_samples_per_update * sizeof(stream->output[outputnum].buffer[0]));
+
+			/* streams fed by this one need filters for the new rate */
+			if (strdata->sinc)
+			{
+				sound_stream *dependent;
+				for (dependent = strdata->stream_head; dependent != NULL; dependent = dependent->next)
+				{
+					int inputnum;
+					for (inputnum = 0; inputnum < dependent->inputs; inputnum++)
+						if (dependent->input[inputnum].source != NULL && dependent->input[inputnum].source->owner == stream)
+						{
+							recompute_sample_rate_data(strdata, dependent);
+							break;
+						}
+				}
+			}
 		}
 }
 
@@ -342,6 +510,19 @@ void streams_set_tag(running_machine *machine, void *streamtag)
 }
 
 
+/*-------------------------------------------------
+    streams_set_group - set the parallel group to
+    be associated with all streams allocated from
+    now on
+-------------------------------------------------*/
+
+void streams_set_group(running_machine *machine, int group)
+{
+	streams_private *strdata = machine->streams_data;
+	strdata->current_group = group;
+}
+
+
 /*-------------------------------------------------
     stream_create - create a new stream
 -------------------------------------------------*/
@@ -367,6 +548,9 @@ sound_stream *stream_create(int inputs, int outputs, int sample_rate, void *para
 	stream->outputs = outputs;
 	stream->callback = callback;
 	stream->param = param;
+	stream->group = strdata->current_group;
+	stream->level = -1;
+	strdata->graph_dirty = TRUE;
 
 	/* create a unique tag for saving */
 	sprintf(statetag, "stream.%d", stream->index);
@@ -428,6 +612,7 @@ sound_stream *stream_create(int inputs, int outputs, int sample_rate, void *para
 
 void stream_set_input(sound_stream *stream, int index, sound_stream *input_stream, int output_index, float gain)
 {
+	streams_private *strdata = Machine->streams_data;
 	stream_input *input;
 
 	VPRINTF(("stream_set_input(%p, %d, %p, %d, %f)\n", stream, index, input_stream, output_index, gain));
@@ -454,7 +639,10 @@ void stream_set_input(sound_stream *stream, int index, sound_stream *input_strea
 		input->source->dependents++;
 
 	/* update sample rates now that we know the input */
-	recompute_sample_rate_data(Machine->streams_data, stream);
+	recompute_sample_rate_data(strdata, stream);
+
+	/* the dependency graph has changed */
+	strdata->graph_dirty = TRUE;
 }
 
 
@@ -465,13 +653,23 @@ void stream_set_input(sound_stream *stream, int index, sound_stream *input_strea
 
 void stream_update(sound_stream *stream)
 {
-	streams_private *strdata = Machine->streams_data;
-	INT32 update_sampindex = time_to_sampindex(strdata, stream, timer_get_time());
+	update_stream_to(Machine->streams_data, stream, timer_get_time());
+}
+
+
+/*-------------------------------------------------
+    update_stream_to - update a stream to the
+    given time
+-------------------------------------------------*/
+
+static void update_stream_to(streams_private *strdata, sound_stream *stream, attotime curtime)
+{
+	INT32 update_sampindex = time_to_sampindex(strdata, stream, curtime);
 
 	/* generate samples to get us up to the appropriate time */
 	assert(stream->output_sampindex - stream->output_base_sampindex >= 0);
 	assert(update_sampindex - stream->output_base_sampindex <= stream->output_bufalloc);
-	generate_samples(stream, update_sampindex - stream->output_sampindex);
+	generate_samples(strdata, stream, update_sampindex - stream->output_sampindex, curtime);
 
 	/* remember this info for next time */
 	stream->output_sampindex = update_sampindex;
@@ -705,6 +903,21 @@ static void recompute_sample_rate_data(streams_private *strdata, sound_stream *s
 			else if (input_stream->sample_rate == stream->sample_rate)
 				latency = 0;
 
+			/* a sinc filter looks half its length ahead, and needs as much history; */
+			/* if the update period can't cover that, fall back to interpolating */
+			input->filter = NULL;
+			if (strdata->sinc && input_stream->sample_rate != stream->sample_rate)
+			{
+				sinc_filter *filter = find_sinc_filter(strdata, input_stream->sample_rate, stream->sample_rate);
+				attoseconds_t reach = (filter->taps / 2) * new_attosecs_per_sample;
+
+				if (latency + 2 * reach < strdata->update_attoseconds / 2)
+				{
+					input->filter = filter;
+					latency += reach;
+				}
+			}
+
 			/* we generally don't want to tweak the latency, so we just keep the greatest
                one we've computed thus far */
 			input->latency_attoseconds = MAX(input->latency_attoseconds, latency);
@@ -715,6 +928,221 @@ static void recompute_sample_rate_data(streams_private *strdata, sound_stream *s
 
 
 
+/*-------------------------------------------------
+    find_sinc_filter - find or build the filter
+    for converting between two sample rates
+-------------------------------------------------*/
+
+static sinc_filter *find_sinc_filter(streams_private *strdata, UINT32 input_rate, UINT32 output_rate)
+{
+	double cutoff, halfwidth;
+	sinc_filter *filter;
+	int phase, tap, half;
+
+	/* share filters between inputs converting between the same rates */
+	for (filter = strdata->filter_list; filter != NULL; filter = filter->next)
+		if (filter->input_rate == input_rate && filter->output_rate == output_rate)
+			return filter;
+
+	/* the cutoff, in cycles per input sample, sits just below the lower Nyquist frequency */
+	cutoff = 0.5 * SINC_ROLLOFF;
+	if (output_rate < input_rate)
+		cutoff *= (double)output_rate / (double)input_rate;
+
+	/* cover the same number of lobes whatever the ratio, rounding the length up to a multiple of 8 */
+	halfwidth = ceil(SINC_ZERO_CROSSINGS / (2.0 * cutoff));
+	half = ((int)halfwidth + 3) & ~3;
+	half = MIN(half, SINC_MAX_TAPS / 2);
+	halfwidth = half;
+
+	filter = malloc_or_die(sizeof(*filter));
+	filter->input_rate = input_rate;
+	filter->output_rate = output_rate;
+	filter->taps = 2 * half;
+	filter->coeff = malloc_or_die((SINC_PHASES + 1) * filter->taps * sizeof(*filter->coeff));
+
+	/* tap 0 lines up with the sample (half - 1) before the base sample; the extra */
+	/* final phase lets the phase round up to a whole sample */
+	for (phase = 0; phase <= SINC_PHASES; phase++)
+	{
+		float *row = &filter->coeff[phase * filter->taps];
+		double total = 0;
+
+		for (tap = 0; tap < filter->taps; tap++)
+		{
+			double x = (double)(tap - (half - 1)) - (double)phase / SINC_PHASES;
+			double arg = 2.0 * M_PI * cutoff * x;
+			double value = (x == 0) ? 1.0 : sin(arg) / arg;
+			double window = 0;
+
+			/* Blackman window across the full width */
+			if (fabs(x) < halfwidth)
+				window = 0.42 + 0.5 * cos(M_PI * x / halfwidth) + 0.08 * cos(2.0 * M_PI * x / halfwidth);
+			row[tap] = value * window;
+			total += row[tap];
+		}
+
+		/* normalize each phase for unity gain at DC */
+		for (tap = 0; tap < filter->taps; tap++)
+			row[tap] /= total;
+	}
+
+	VPRINTF(("find_sinc_filter(%d, %d) => %d taps\n", input_rate, output_rate, filter->taps));
+
+	filter->next = strdata->filter_list;
+	strdata->filter_list = filter;
+	return filter;
+}
+
+
+
+/***************************************************************************
+    PARALLEL GRAPH
+***************************************************************************/
+
+/*-------------------------------------------------
+    build_graph - sort the streams in parallel
+    groups into levels by dependency, and gather
+    each level's streams into one work unit per
+    group
+-------------------------------------------------*/
+
+static void build_graph(streams_private *strdata)
+{
+	sound_stream *stream, *other;
+	int count = 0, passes = 0;
+	int level, maxlevel = -1;
+	int units = 0, slots = 0;
+	int changed;
+
+	strdata->graph_dirty = FALSE;
+
+	/* free the old graph */
+	if (strdata->work != NULL)
+		free(strdata->work);
+	if (strdata->work_stream != NULL)
+		free(strdata->work_stream);
+	if (strdata->level_start != NULL)
+		free(strdata->level_start);
+	strdata->work = NULL;
+	strdata->work_stream = NULL;
+	strdata->level_start = NULL;
+	strdata->levels = 0;
+
+	/* start every stream in a parallel group on level 0 */
+	for (stream = strdata->stream_head; stream != NULL; stream = stream->next)
+	{
+		stream->level = (stream->group != STREAM_GROUP_SERIAL) ? 0 : -1;
+		count++;
+	}
+
+	/* push each stream above all of its inputs; depending on a serial stream */
+	/* disqualifies us, since we can't pull on it from another thread */
+	do
+	{
+		changed = FALSE;
+		for (stream = strdata->stream_head; stream != NULL; stream = stream->next)
+			if (stream->level >= 0)
+			{
+				int inputnum;
+
+				for (inputnum = 0; inputnum < stream->inputs; inputnum++)
+					if (stream->input[inputnum].source != NULL)
+					{
+						sound_stream *input_stream = stream->input[inputnum].source->owner;
+
+						if (input_stream->level < 0)
+						{
+							stream->level = -1;
+							changed = TRUE;
+							break;
+						}
+						if (input_stream->level >= stream->level)
+						{
+							stream->level = input_stream->level + 1;
+							changed = TRUE;
+						}
+					}
+			}
+
+		/* a cycle would keep us going forever; give up on parallelism if we see one */
+		if (++passes > count + 1)
+		{
+			for (stream = strdata->stream_head; stream != NULL; stream = stream->next)
+				stream->level = -1;
+			break;
+		}
+	} while (changed);
+
+	/* count the eligible streams and find the top level */
+	for (stream = strdata->stream_head; stream != NULL; stream = stream->next)
+		if (stream->level >= 0)
+		{
+			maxlevel = MAX(maxlevel, stream->level);
+			slots++;
+		}
+	if (slots == 0)
+		return;
+
+	/* allocate worst-case arrays */
+	strdata->levels = maxlevel + 1;
+	strdata->work = malloc_or_die(slots * sizeof(*strdata->work));
+	strdata->work_stream = malloc_or_die(slots * sizeof(*strdata->work_stream));
+	strdata->level_start = malloc_or_die((strdata->levels + 1) * sizeof(*strdata->level_start));
+
+	/* gather the streams on each level into one unit per group, keeping the stream order */
+	slots = 0;
+	for (level = 0; level <= maxlevel; level++)
+	{
+		strdata->level_start[level] = units;
+		for (stream = strdata->stream_head; stream != NULL; stream = stream->next)
+			if (stream->level == level)
+			{
+				stream_work *work = &strdata->work[units++];
+
+				work->strdata = strdata;
+				work->stream = &strdata->work_stream[slots];
+				work->streams = 0;
+
+				/* claim every stream on this level in the same group */
+				for (other = stream; other != NULL; other = other->next)
+					if (other->level == level && other->group == stream->group)
+					{
+						work->stream[work->streams++] = other;
+						slots++;
+						if (other != stream)
+							other->level = -2 - level;
+					}
+			}
+
+		/* restore the levels of the streams we claimed */
+		for (stream = strdata->stream_head; stream != NULL; stream = stream->next)
+			if (stream->level == -2 - level)
+				stream->level = level;
+	}
+	strdata->level_start[strdata->levels] = units;
+
+	VPRINTF(("build_graph: %d streams in %d units over %d levels\n", slots, units, strdata->levels));
+}
+
+
+/*-------------------------------------------------
+    stream_work_callback - update all the streams
+    in a work unit
+-------------------------------------------------*/
+
+static void *stream_work_callback(void *param, int threadid)
+{
+	stream_work *work = param;
+	int streamnum;
+
+	for (streamnum = 0; streamnum < work->streams; streamnum++)
+		update_stream_to(work->strdata, work->stream[streamnum], work->strdata->work_time);
+	return NULL;
+}
+
+
+
 /***************************************************************************
     SOUND GENERATION
 ***************************************************************************/
@@ -726,7 +1154,7 @@ static void recompute_sample_rate_data(streams_private *strdata, sound_stream *s
     samples generated
 -------------------------------------------------*/
 
-static void generate_samples(sound_stream *stream, int samples)
+static void generate_samples(streams_private *strdata, sound_stream *stream, int samples, attotime curtime)
 {
 	int inputnum, outputnum;
 
@@ -743,7 +1171,7 @@ static void generate_samples(sound_stream *stream, int samples)
 
 		/* update the stream to the current time */
 		if (input->source != NULL)
-			stream_update(input->source->owner);
+			update_stream_to(strdata, input->source->owner, curtime);
 
 		/* generate the resampled data */
 		stream->input_array[inputnum] = generate_resampled_data(input, samples);
@@ -773,6 +1201,7 @@ static stream_sample_t *generate_resampled_data(stream_input *input, UINT32 nums
 	stream_sample_t *dest = input->resample;
 	stream_output *output = input->source;
 	sound_stream *stream = input->owner;
+	const sndsimd_ops *ops = sndsimd_get_ops();
 	sound_stream *input_stream;
 	stream_sample_t *source;
 	stream_sample_t sample;
@@ -817,24 +1246,22 @@ static stream_sample_t *generate_resampled_data(stream_input *input, UINT32 nums
 
 	/* if we have equal sample rates, we just need to copy */
 	if (step == FRAC_ONE)
-	{
-		while (numsamples--)
-		{
-			/* compute the sample */
-			sample = *source++;
-			*dest++ = (sample * gain) >> 8;
-		}
-	}
+		(*ops->gain)(dest, source, numsamples, gain);
 
-	/* input is undersampled: use linear interpolation */
-	else if (step < FRAC_ONE)
+	/* if we have a filter for these rates, run it; the rates can change */
+	/* underneath us until the next global update rebuilds the filters */
+	else if (input->filter != NULL && input->filter->input_rate == input_stream->sample_rate && input->filter->output_rate == stream->sample_rate)
 	{
+		const sinc_filter *filter = input->filter;
+
+		source -= filter->taps / 2 - 1;
 		while (numsamples--)
 		{
-			int interp_frac = basefrac >> (FRAC_BITS - 12);
+			int phase = (basefrac + (1 << (FRAC_BITS - SINC_PHASE_BITS - 1))) >> (FRAC_BITS - SINC_PHASE_BITS);
+			float value = (*ops->dot)(source, &filter->coeff[phase * filter->taps], filter->taps);
 
 			/* compute the sample */
-			sample = (source[0] * (0x1000 - interp_frac) + source[1] * interp_frac) >> 12;
+			sample = (stream_sample_t)((value >= 0) ? value + 0.5f : value - 0.5f);
 			*dest++ = (sample * gain) >> 8;
 
 			/* advance */
@@ -844,6 +1271,10 @@ static stream_sample_t *generate_resampled_data(stream_input *input, UINT32 nums
 		}
 	}
 
+	/* input is undersampled: use linear interpolation */
+	else if (step < FRAC_ONE)
+		(*ops->lerp)(dest, source, numsamples, basefrac, step, gain);
+
 	/* input is oversampled: sum the energy */
 	else
 	{
@@ -853,19 +1284,18 @@ static stream_sample_t *generate_resampled_data(stream_input *input, UINT32 nums
 		while (numsamples--)
 		{
 			int remainder = smallstep;
-			int tpos = 0;
+			int whole = 0;
 			int scale;
 
-			/* compute the sample */
+			/* compute the sample: a partial first sample, a run of whole ones, and a partial last */
 			scale = (FRAC_ONE - basefrac) >> (FRAC_BITS - 8);
-			sample = source[tpos++] * scale;
+			sample = source[0] * scale;
 			remainder -= scale;
-			while (remainder > 0x100)
-			{
-				sample += source[tpos++] * 0x100;
-				remainder -= 0x100;
-			}
-			sample += source[tpos] * remainder;
+			if (remainder > 0x100)
+				whole = (remainder - 1) >> 8;
+			sample += (*ops->sum)(&source[1], whole) * 0x100;
+			remainder -= whole * 0x100;
+			sample += source[1 + whole] * remainder;
 			sample /= smallstep;
 
 			*dest++ = (sample * gain) >> 8;
@@ -15,6 +15,14 @@
 #include "mamecore.h"
 
 
+/***************************************************************************
+    CONSTANTS
+***************************************************************************/
+
+/* group for streams that must be updated on demand from the main thread */
+#define STREAM_GROUP_SERIAL		(-1)
+
+
 /***************************************************************************
     TYPE DEFINITIONS
 ***************************************************************************/
@@ -31,6 +39,8 @@ typedef void (*stream_callback)(void *param, stream_sample_t **inputs, stream_sa
 
 void streams_init(running_machine *machine, attoseconds_t update_subseconds);
 void streams_set_tag(running_machine *machine, void *streamtag);
+void streams_set_group(running_machine *machine, int group);
+void streams_update_parallel(running_machine *machine);
 void streams_update(running_machine *machine);
 
 /* core stream configuration and operation */
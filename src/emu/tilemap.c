@@ -12,6 +12,7 @@
 #include "driver.h"
 #include "tilemap.h"
 #include "profiler.h"
+#include "eminline.h"
 
 
 /***************************************************************************
@@ -24,6 +25,12 @@
 /* invalid logical index */
 #define INVALID_LOGICAL_INDEX			((tilemap_logical_index)~0)
 
+/* minimum number of dirty tiles in one update before we rasterize on the work queue */
+#define PARALLEL_UPDATE_MIN_TILES		256
+
+/* approximate number of tiles in each band of rows handed to a work item */
+#define PARALLEL_UPDATE_BAND_TILES		64
+
 
 
 /***************************************************************************
@@ -48,6 +55,31 @@ typedef void (*blitmask_t)(void *dest, const UINT16 *source, const UINT8 *maskpt
 typedef void (*blitopaque_t)(void *dest, const UINT16 *source, int count, UINT8 *pri, UINT32 pcode);
 
 
+/* a dirty tile whose info has been fetched and is waiting to be rasterized */
+typedef struct _tile_job tile_job;
+struct _tile_job
+{
+	tilemap_logical_index	logindex;			/* logical index of the tile */
+	UINT32					x0, y0;				/* pixmap coordinates of the tile */
+	const UINT8 *			pen_data;			/* pen data from the get info callback */
+	const UINT8 *			mask_data;			/* mask data from the get info callback */
+	pen_t					palette_base;		/* palette base from the get info callback */
+	UINT8					category;			/* category from the get info callback */
+	UINT8					group;				/* group from the get info callback */
+	UINT8					flags;				/* flags, with the global flip applied */
+};
+
+
+/* a band of whole tile rows rasterized by a single work item */
+typedef struct _tile_band tile_band;
+struct _tile_band
+{
+	tilemap *				tmap;				/* tilemap being updated */
+	tile_job *				job;				/* first job in the band */
+	UINT32					count;				/* number of jobs in the band */
+};
+
+
 /* blitting parameters for rendering */
 typedef struct _blit_parameters blit_parameters;
 struct _blit_parameters
@@ -113,6 +145,11 @@ struct _tilemap
 	UINT8 *						tileflags;			/* per-tile flags */
 	UINT8 *						pen_to_flags; 		/* mapping of pens to flags */
 	UINT32						max_pen_to_flags;	/* maximum index in each array */
+
+	/* dirty tile tracking */
+	UINT32 *					dirty_bits;			/* one bit per dirty tile, each row padded to whole words */
+	UINT32 *					dirty_rows;			/* one bit per row that may contain dirty tiles */
+	UINT32						dirty_words;		/* number of words per row in dirty_bits */
 };
 
 
@@ -129,6 +166,11 @@ static int				tilemap_instance;
 
 static UINT32			screen_width, screen_height;
 
+static osd_work_queue *	update_queue;
+static tile_job *		update_jobs;
+static tile_band *		update_bands;
+static UINT32			update_max_jobs;
+
 
 
 /***************************************************************************
@@ -147,6 +189,10 @@ static void mappings_update(tilemap *tmap);
 /* tile rendering */
 static void pixmap_update(tilemap *tmap, const rectangle *cliprect);
 static void tile_update(tilemap *tmap, tilemap_logical_index logindex, UINT32 cached_col, UINT32 cached_row);
+static void tile_fetch(tilemap *tmap, tile_job *job, tilemap_logical_index logindex, UINT32 col, UINT32 row);
+static void tile_render(tilemap *tmap, const tile_job *job);
+static void tile_render_parallel(tilemap *tmap, UINT32 numjobs);
+static void *tile_render_band(void *param, int threadid);
 static UINT8 tile_draw(tilemap *tmap, const UINT8 *pendata, UINT32 x0, UINT32 y0, UINT32 palette_base, UINT8 category, UINT8 group, UINT8 flags);
 static UINT8 tile_draw_colortable(tilemap *tmap, const UINT8 *pendata, UINT32 x0, UINT32 y0, UINT32 palette_base, UINT8 category, UINT8 group, UINT8 flags);
 static UINT8 tile_draw_colortrans(tilemap *tmap, const UINT8 *pendata, UINT32 x0, UINT32 y0, UINT32 palette_base, UINT8 category, UINT8 group, UINT8 flags);
@@ -236,6 +282,45 @@ INLINE INT32 effective_colscroll(tilemap *tmap, int index)
 }
 
 
+/*-------------------------------------------------
+    tile_set_dirty_bit - flag a single tile in
+    the dirty bitset and its row summary
+-------------------------------------------------*/
+
+INLINE void tile_set_dirty_bit(tilemap *tmap, UINT32 col, UINT32 row)
+{
+	tmap->dirty_bits[row * tmap->dirty_words + col / 32] |= (UINT32)1 << (col % 32);
+	tmap->dirty_rows[row / 32] |= (UINT32)1 << (row % 32);
+}
+
+
+/*-------------------------------------------------
+    realize_all_tiles_dirty - if the whole map
+    has been marked dirty, apply that to the
+    per-tile flags and dirty bits
+-------------------------------------------------*/
+
+INLINE void realize_all_tiles_dirty(tilemap *tmap)
+{
+	UINT32 row;
+
+	if (!tmap->all_tiles_dirty)
+		return;
+
+	/* mark every tile dirty */
+	memset(tmap->tileflags, TILE_FLAG_DIRTY, tmap->max_logical_index);
+
+	/* set every bit, leaving the padding at the end of each row clear */
+	memset(tmap->dirty_bits, 0xff, tmap->rows * tmap->dirty_words * sizeof(tmap->dirty_bits[0]));
+	if (tmap->cols % 32 != 0)
+		for (row = 0; row < tmap->rows; row++)
+			tmap->dirty_bits[row * tmap->dirty_words + tmap->dirty_words - 1] = ((UINT32)1 << (tmap->cols % 32)) - 1;
+	memset(tmap->dirty_rows, 0xff, ((tmap->rows + 31) / 32) * sizeof(tmap->dirty_rows[0]));
+
+	tmap->all_tiles_dirty = FALSE;
+}
+
+
 /*-------------------------------------------------
     indexed_tilemap - return a tilemap by index
 -------------------------------------------------*/
@@ -272,6 +357,13 @@ void tilemap_init(running_machine *machine)
 	tilemap_instance = 0;
 
 	priority_bitmap = auto_bitmap_alloc(screen_width, screen_height, BITMAP_FORMAT_INDEXED8);
+
+	/* large batches of dirty tiles are rasterized on a work queue */
+	update_queue	 = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI | WORK_QUEUE_FLAG_HIGH_FREQ);
+	update_jobs		 = NULL;
+	update_bands	 = NULL;
+	update_max_jobs  = 0;
+
 	add_exit_callback(machine, tilemap_exit);
 }
 
@@ -327,6 +419,11 @@ tilemap *tilemap_create(tile_get_info_callback tile_get_info, tilemap_mapper_cal
 
 	/* allocate transparency mapping data */
 	tmap->tileflags = malloc_or_die(tmap->max_logical_index);
+	tmap->dirty_words = (tmap->cols + 31) / 32;
+	tmap->dirty_bits = malloc_or_die(tmap->rows * tmap->dirty_words * sizeof(tmap->dirty_bits[0]));
+	tmap->dirty_rows = malloc_or_die(((tmap->rows + 31) / 32) * sizeof(tmap->dirty_rows[0]));
+	memset(tmap->dirty_bits, 0, tmap->rows * tmap->dirty_words * sizeof(tmap->dirty_bits[0]));
+	memset(tmap->dirty_rows, 0, ((tmap->rows + 31) / 32) * sizeof(tmap->dirty_rows[0]));
 	tmap->flagsmap = bitmap_alloc(tmap->width, tmap->height, BITMAP_FORMAT_INDEXED8);
 	tmap->max_pen_to_flags = (tmap->type != TILEMAP_TYPE_COLORTABLE) ? 256 : Machine->drv->color_table_len;
 	tmap->pen_to_flags = malloc_or_die(sizeof(tmap->pen_to_flags[0]) * tmap->max_pen_to_flags * TILEMAP_NUM_GROUPS);
@@ -441,6 +538,7 @@ void tilemap_mark_tile_dirty(tilemap *tmap, tilemap_memory_index memindex)
 		if (logindex != INVALID_LOGICAL_INDEX)
 		{
 			tmap->tileflags[logindex] = TILE_FLAG_DIRTY;
+			tile_set_dirty_bit(tmap, logindex % tmap->cols, logindex / tmap->cols);
 			tmap->all_tiles_clean = FALSE;
 		}
 	}
@@ -726,11 +824,7 @@ profiler_mark(PROFILER_TILEMAP_DRAW);
 	original_cliprect = blit.cliprect;
 
 	/* if the whole map is dirty, mark it as such */
-	if (tmap->all_tiles_dirty)
-	{
-		memset(tmap->tileflags, TILE_FLAG_DIRTY, tmap->max_logical_index);
-		tmap->all_tiles_dirty = FALSE;
-	}
+	realize_all_tiles_dirty(tmap);
 
 	/* XY scrolling playfield */
 	if (tmap->scrollrows == 1 && tmap->scrollcols == 1)
@@ -919,11 +1013,7 @@ void tilemap_draw_by_index(mame_bitmap *dest, int number, UINT32 scrollx, UINT32
 	scrolly = tmap->height - scrolly % tmap->height;
 
 	/* if the whole map is dirty, mark it as such */
-	if (tmap->all_tiles_dirty)
-	{
-		memset(tmap->tileflags, TILE_FLAG_DIRTY, tmap->max_logical_index);
-		tmap->all_tiles_dirty = FALSE;
-	}
+	realize_all_tiles_dirty(tmap);
 
 	/* iterate to handle wraparound */
 	for (ypos = scrolly - tmap->height; ypos <= blit.cliprect.max_y; ypos += tmap->height)
@@ -1015,6 +1105,18 @@ static void tilemap_exit(running_machine *machine)
 		tilemap_list = next;
 	}
 	tilemap_tailptr = NULL;
+
+	/* free the parallel update state */
+	if (update_queue != NULL)
+		osd_work_queue_free(update_queue);
+	update_queue = NULL;
+	if (update_jobs != NULL)
+		free(update_jobs);
+	update_jobs = NULL;
+	if (update_bands != NULL)
+		free(update_bands);
+	update_bands = NULL;
+	update_max_jobs = 0;
 }
 
 
@@ -1049,6 +1151,8 @@ static void tilemap_dispose(tilemap *tmap)
 
 	/* free allocated memory */
 	free(tmap->pen_to_flags);
+	free(tmap->dirty_rows);
+	free(tmap->dirty_bits);
 	free(tmap->tileflags);
 	bitmap_free(tmap->flagsmap);
 	bitmap_free(tmap->pixmap);
@@ -1148,7 +1252,10 @@ static void mappings_update(tilemap *tmap)
 static void pixmap_update(tilemap *tmap, const rectangle *cliprect)
 {
 	int mincol, maxcol, minrow, maxrow;
-	int row, col;
+	int row, word;
+	UINT32 anydirty;
+	UINT32 numjobs = 0;
+	UINT32 jobnum;
 
 	/* if everything is clean, do nothing */
 	if (tmap->all_tiles_clean)
@@ -1172,25 +1279,78 @@ profiler_mark(PROFILER_TILEMAP_DRAW);
 	}
 
 	/* if the whole map is dirty, mark it as such */
-	if (tmap->all_tiles_dirty)
+	realize_all_tiles_dirty(tmap);
+
+	/* make sure there is room to queue every tile in the map */
+	if (update_max_jobs < tmap->max_logical_index)
 	{
-		memset(tmap->tileflags, TILE_FLAG_DIRTY, tmap->max_logical_index);
-		tmap->all_tiles_dirty = FALSE;
+		if (update_jobs != NULL)
+			free(update_jobs);
+		if (update_bands != NULL)
+			free(update_bands);
+		update_max_jobs = tmap->max_logical_index;
+		update_jobs = malloc_or_die(update_max_jobs * sizeof(update_jobs[0]));
+		update_bands = malloc_or_die(update_max_jobs * sizeof(update_bands[0]));
 	}
 
-	/* iterate over rows */
+profiler_mark(PROFILER_TILEMAP_UPDATE);
+
+	/* iterate over rows that may have dirty tiles */
 	for (row = minrow; row <= maxrow; row++)
 	{
-		tilemap_logical_index logindex = row * tmap->cols;
+		UINT32 *rowbits = &tmap->dirty_bits[row * tmap->dirty_words];
+		UINT32 rowdirty = 0;
+
+		/* skip 32 clean rows at a time where we can */
+		if (tmap->dirty_rows[row / 32] == 0)
+		{
+			row |= 31;
+			continue;
+		}
+		if (!(tmap->dirty_rows[row / 32] & ((UINT32)1 << (row % 32))))
+			continue;
+
+		/* visit only the dirty tiles within the columns, a word at a time */
+		for (word = mincol / 32; word <= maxcol / 32; word++)
+		{
+			UINT32 bits = rowbits[word];
+
+			if (word == mincol / 32)
+				bits &= (UINT32)~0 << (mincol % 32);
+			if (word == maxcol / 32)
+				bits &= (UINT32)~0 >> (31 - maxcol % 32);
+
+			while (bits != 0)
+			{
+				UINT32 lowbit = bits & (~bits + 1);
+				int col = word * 32 + 31 - count_leading_zeros(lowbit);
 
-		/* iterate over colums */
-		for (col = mincol; col <= maxcol; col++)
-			if (tmap->tileflags[logindex + col] == TILE_FLAG_DIRTY)
-				tile_update(tmap, logindex + col, col, row);
+				tile_fetch(tmap, &update_jobs[numjobs++], row * tmap->cols + col, col, row);
+				bits ^= lowbit;
+			}
+		}
+
+		/* once a row is entirely clean, drop it from the summary */
+		for (word = 0; word < tmap->dirty_words; word++)
+			rowdirty |= rowbits[word];
+		if (rowdirty == 0)
+			tmap->dirty_rows[row / 32] &= ~((UINT32)1 << (row % 32));
 	}
 
-	/* mark it all clean */
-	if (mincol == 0 && minrow == 0 && maxcol == tmap->cols - 1 && maxcol == tmap->rows - 1)
+	/* rasterize the fetched tiles, spreading large batches across the work queue */
+	if (numjobs >= PARALLEL_UPDATE_MIN_TILES && update_queue != NULL)
+		tile_render_parallel(tmap, numjobs);
+	else
+		for (jobnum = 0; jobnum < numjobs; jobnum++)
+			tile_render(tmap, &update_jobs[jobnum]);
+
+profiler_mark(PROFILER_END);
+
+	/* if no rows are left dirty, the whole map is clean */
+	anydirty = 0;
+	for (word = 0; word < (tmap->rows + 31) / 32; word++)
+		anydirty |= tmap->dirty_rows[word];
+	if (anydirty == 0)
 		tmap->all_tiles_clean = TRUE;
 
 profiler_mark(PROFILER_END);
@@ -1203,36 +1363,120 @@ profiler_mark(PROFILER_END);
 
 static void tile_update(tilemap *tmap, tilemap_logical_index logindex, UINT32 col, UINT32 row)
 {
-	UINT32 x0 = tmap->tilewidth * col;
-	UINT32 y0 = tmap->tileheight * row;
-	tilemap_memory_index memindex;
-	UINT32 flags;
+	tile_job job;
 
 profiler_mark(PROFILER_TILEMAP_UPDATE);
 
+	tile_fetch(tmap, &job, logindex, col, row);
+	tile_render(tmap, &job);
+
+profiler_mark(PROFILER_END);
+}
+
+
+/*-------------------------------------------------
+    tile_fetch - mark a dirty tile clean and call
+    the get info callback for it, capturing the
+    results for a later tile_render
+-------------------------------------------------*/
+
+static void tile_fetch(tilemap *tmap, tile_job *job, tilemap_logical_index logindex, UINT32 col, UINT32 row)
+{
+	tilemap_memory_index memindex;
+
+	/* this tile is clean from here on */
+	tmap->dirty_bits[row * tmap->dirty_words + col / 32] &= ~((UINT32)1 << (col % 32));
+
 	/* call the get info callback for the associated memory index */
 	memindex = tmap->logical_to_memory[logindex];
 	(*tmap->tile_get_info)(Machine, &tmap->tileinfo, memindex, tmap->user_data);
 
-	/* apply the global tilemap flip to the returned flip flags */
-	flags = tmap->tileinfo.flags ^ (tmap->attributes & 0x03);
+	/* capture the results, applying the global tilemap flip to the returned flip flags */
+	job->logindex = logindex;
+	job->x0 = tmap->tilewidth * col;
+	job->y0 = tmap->tileheight * row;
+	job->pen_data = tmap->tileinfo.pen_data;
+	job->mask_data = tmap->tileinfo.mask_data;
+	job->palette_base = tmap->tileinfo.palette_base;
+	job->category = tmap->tileinfo.category;
+	job->group = tmap->tileinfo.group;
+	job->flags = tmap->tileinfo.flags ^ (tmap->attributes & 0x03);
+}
+
+
+/*-------------------------------------------------
+    tile_render - draw a fetched tile into the
+    pixmap and compute its tile flags; this only
+    touches the tile's own pixels and flags, so
+    it may run on any thread
+-------------------------------------------------*/
+
+static void tile_render(tilemap *tmap, const tile_job *job)
+{
+	UINT8 flags = job->flags;
 
 	/* draw the tile, using either direct or transparent */
 	if (Machine->game_colortable != NULL)
 	{
 		if (tmap->type != TILEMAP_TYPE_COLORTABLE)
-			tmap->tileflags[logindex] = tile_draw_colortable(tmap, tmap->tileinfo.pen_data, x0, y0, tmap->tileinfo.palette_base, tmap->tileinfo.category, tmap->tileinfo.group, flags);
+			tmap->tileflags[job->logindex] = tile_draw_colortable(tmap, job->pen_data, job->x0, job->y0, job->palette_base, job->category, job->group, flags);
 		else
-			tmap->tileflags[logindex] = tile_draw_colortrans(tmap, tmap->tileinfo.pen_data, x0, y0, tmap->tileinfo.palette_base, tmap->tileinfo.category, tmap->tileinfo.group, flags);
+			tmap->tileflags[job->logindex] = tile_draw_colortrans(tmap, job->pen_data, job->x0, job->y0, job->palette_base, job->category, job->group, flags);
 	}
 	else
-		tmap->tileflags[logindex] = tile_draw(tmap, tmap->tileinfo.pen_data, x0, y0, tmap->tileinfo.palette_base, tmap->tileinfo.category, tmap->tileinfo.group, flags);
+		tmap->tileflags[job->logindex] = tile_draw(tmap, job->pen_data, job->x0, job->y0, job->palette_base, job->category, job->group, flags);
 
 	/* if mask data is specified, apply it */
-	if ((flags & (TILE_FORCE_LAYER0 | TILE_FORCE_LAYER1 | TILE_FORCE_LAYER2)) == 0 && tmap->tileinfo.mask_data != NULL)
-		tmap->tileflags[logindex] = tile_apply_bitmask(tmap, tmap->tileinfo.mask_data, x0, y0, tmap->tileinfo.category, flags);
+	if ((flags & (TILE_FORCE_LAYER0 | TILE_FORCE_LAYER1 | TILE_FORCE_LAYER2)) == 0 && job->mask_data != NULL)
+		tmap->tileflags[job->logindex] = tile_apply_bitmask(tmap, job->mask_data, job->x0, job->y0, job->category, flags);
+}
 
-profiler_mark(PROFILER_END);
+
+/*-------------------------------------------------
+    tile_render_parallel - split the fetched tiles
+    into bands of whole tile rows and rasterize
+    them on the work queue
+-------------------------------------------------*/
+
+static void tile_render_parallel(tilemap *tmap, UINT32 numjobs)
+{
+	tile_band *band = NULL;
+	UINT32 numbands = 0;
+	UINT32 jobnum;
+
+	/* jobs are in row order; close a band at the first row break past the target size */
+	for (jobnum = 0; jobnum < numjobs; jobnum++)
+	{
+		if (band == NULL || (band->count >= PARALLEL_UPDATE_BAND_TILES && update_jobs[jobnum].y0 != update_jobs[jobnum - 1].y0))
+		{
+			band = &update_bands[numbands++];
+			band->tmap = tmap;
+			band->job = &update_jobs[jobnum];
+			band->count = 0;
+		}
+		band->count++;
+	}
+
+	/* hand the bands to the queue and wait for them all; the next update reuses the band and job arrays */
+	osd_work_item_queue_multiple(update_queue, tile_render_band, numbands, update_bands, sizeof(update_bands[0]), WORK_ITEM_FLAG_AUTO_RELEASE);
+	if (!osd_work_queue_wait(update_queue, 100 * osd_ticks_per_second()))
+		fatalerror("tile_render_parallel: tile bands never completed");
+}
+
+
+/*-------------------------------------------------
+    tile_render_band - work item callback that
+    rasterizes one band of tiles
+-------------------------------------------------*/
+
+static void *tile_render_band(void *param, int threadid)
+{
+	tile_band *band = param;
+	UINT32 jobnum;
+
+	for (jobnum = 0; jobnum < band->count; jobnum++)
+		tile_render(band->tmap, &band->job[jobnum]);
+	return NULL;
 }
 
 
@@ -1693,6 +1937,7 @@ static void tilemap_draw_instance(tilemap *tmap, const blit_parameters *blit, in
 	int mincol, maxcol;
 	int x1, y1, x2, y2;
 	int y, nexty;
+	rectangle region;
 
 	/* clip destination coordinates to the tilemap */
 	/* note that x2/y2 are exclusive, not inclusive */
@@ -1720,6 +1965,13 @@ static void tilemap_draw_instance(tilemap *tmap, const blit_parameters *blit, in
 	x2 -= xpos;
 	y2 -= ypos;
 
+	/* bring the visible tiles up to date in one batch */
+	region.min_x = x1;
+	region.max_x = x2 - 1;
+	region.min_y = y1;
+	region.max_y = y2 - 1;
+	pixmap_update(tmap, &region);
+
 	/* get tilemap pixels */
 	source_baseaddr = BITMAP_ADDR16(tmap->pixmap, y1, 0);
 	mask_baseaddr = BITMAP_ADDR8(tmap->flagsmap, y1, 0);
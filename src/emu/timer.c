@@ -34,7 +34,7 @@
     CONSTANTS
 ***************************************************************************/
 
-#define MAX_TIMERS		256
+#define TIMER_BLOCK_SIZE	256
 
 
 
@@ -42,11 +42,25 @@
     TYPE DEFINITIONS
 ***************************************************************************/
 
+/* per-callback statistics, gathered when -timerstats is enabled */
+typedef struct _timer_stats timer_stats;
+struct _timer_stats
+{
+	timer_stats *	next;
+	const char *	func;
+	UINT64			inserts;
+	UINT64			fires;
+};
+
+
 /* in timer.h: typedef struct _emu_timer emu_timer; */
 struct _emu_timer
 {
-	emu_timer *		next;
-	emu_timer *		prev;
+	emu_timer *		next;			/* next timer in the free list */
+	INT32			heapindex;		/* index in the heap, or -1 if not scheduled */
+	UINT32			sequence;		/* insertion order, to keep equal expirations FIFO */
+	attotime		sortkey;		/* time the heap is ordered on */
+	timer_stats *	stats;			/* statistics record, or NULL */
 	timer_callback	callback;
 	INT32 			param;
 	void *			ptr;
@@ -70,12 +84,30 @@ struct _emu_timer
 attoseconds_t attoseconds_per_cycle[MAX_CPU];
 UINT32 cycles_per_second[MAX_CPU];
 
-/* list of active timers */
-static emu_timer timers[MAX_TIMERS];
-static emu_timer *timer_head;
+/* a block of timers; the pool grows a block at a time */
+typedef struct _timer_block timer_block;
+struct _timer_block
+{
+	timer_block *	next;
+	emu_timer		timer[TIMER_BLOCK_SIZE];
+};
+
+
+/* heap of active timers, ordered by sortkey then sequence */
+static emu_timer **timer_heap;
+static int timer_heap_count;
+static int timer_heap_alloc;
+static UINT32 timer_sequence;
+
+/* pool of timers */
+static timer_block *timer_blocks;
 static emu_timer *timer_free_head;
 static emu_timer *timer_free_tail;
 
+/* statistics */
+static int timer_stats_enabled;
+static timer_stats *timer_stats_list;
+
 /* other internal states */
 static attotime global_basetime;
 static emu_timer *callback_timer;
@@ -88,8 +120,10 @@ static attotime callback_timer_expire_time;
     FUNCTION PROTOTYPES
 ***************************************************************************/
 
+static void timer_exit(running_machine *machine);
 static void timer_postload(void);
 static void timer_logtimers(void);
+static void timer_dump_stats(void);
 static void timer_remove(emu_timer *which);
 
 
@@ -121,19 +155,34 @@ INLINE attotime get_current_time(void)
 
 
 /*-------------------------------------------------
-    timer_new - allocate a new timer
+    timer_new - allocate a new timer, growing
+    the pool if we run out
 -------------------------------------------------*/
 
 INLINE emu_timer *timer_new(void)
 {
 	emu_timer *timer;
 
-	/* remove an empty entry */
+	/* if we're out, add a new block of timers to the free list */
 	if (!timer_free_head)
 	{
-		timer_logtimers();
-		fatalerror("Out of timers!");
+		timer_block *block = malloc_or_die(sizeof(*block));
+		int i;
+
+		memset(block, 0, sizeof(*block));
+		block->next = timer_blocks;
+		timer_blocks = block;
+
+		for (i = 0; i < TIMER_BLOCK_SIZE; i++)
+		{
+			block->timer[i].heapindex = -1;
+			block->timer[i].next = (i < TIMER_BLOCK_SIZE - 1) ? &block->timer[i + 1] : NULL;
+		}
+		timer_free_head = &block->timer[0];
+		timer_free_tail = &block->timer[TIMER_BLOCK_SIZE - 1];
 	}
+
+	/* remove an empty entry */
 	timer = timer_free_head;
 	timer_free_head = timer->next;
 	if (!timer_free_head)
@@ -144,86 +193,198 @@ INLINE emu_timer *timer_new(void)
 
 
 /*-------------------------------------------------
-    timer_list_insert - insert a new timer into
-    the list at the appropriate location
+    timer_find_stats - find or create the
+    statistics record for a callback
 -------------------------------------------------*/
 
-INLINE void timer_list_insert(emu_timer *timer)
+INLINE timer_stats *timer_find_stats(const char *func)
 {
-	attotime expire = timer->enabled ? timer->expire : attotime_never;
-	emu_timer *t, *lt = NULL;
+	timer_stats *stats;
+
+	for (stats = timer_stats_list; stats != NULL; stats = stats->next)
+		if (stats->func == func || strcmp(stats->func, func) == 0)
+			return stats;
+
+	stats = malloc_or_die(sizeof(*stats));
+	memset(stats, 0, sizeof(*stats));
+	stats->func = func;
+	stats->next = timer_stats_list;
+	timer_stats_list = stats;
+	return stats;
+}
 
-	/* sanity checks for the debug build */
-	#ifdef MAME_DEBUG
+
+/*-------------------------------------------------
+    timer_free - return a timer to the free list
+-------------------------------------------------*/
+
+INLINE void timer_free(emu_timer *timer)
+{
+	if (timer_free_tail)
+		timer_free_tail->next = timer;
+	else
+		timer_free_head = timer;
+	timer->next = NULL;
+	timer_free_tail = timer;
+}
+
+
+/*-------------------------------------------------
+    timer_before - return TRUE if timer a should
+    fire before timer b
+-------------------------------------------------*/
+
+INLINE int timer_before(const emu_timer *a, const emu_timer *b)
+{
+	int result = attotime_compare(a->sortkey, b->sortkey);
+	if (result != 0)
+		return (result < 0);
+	return ((INT32)(a->sequence - b->sequence) < 0);
+}
+
+
+/*-------------------------------------------------
+    timer_heap_sift_up - move a timer toward the
+    root until its parent fires before it
+-------------------------------------------------*/
+
+INLINE void timer_heap_sift_up(int index)
+{
+	emu_timer *timer = timer_heap[index];
+
+	while (index > 0)
 	{
-		int tnum = 0;
+		int parent = (index - 1) / 2;
+		if (!timer_before(timer, timer_heap[parent]))
+			break;
+		timer_heap[index] = timer_heap[parent];
+		timer_heap[index]->heapindex = index;
+		index = parent;
+	}
+	timer_heap[index] = timer;
+	timer->heapindex = index;
+}
 
-		/* loop over the timer list */
-		for (t = timer_head; t; t = t->next, tnum++)
-		{
-			if (t == timer)
-				fatalerror("This timer is already inserted in the list!");
-			if (tnum == MAX_TIMERS-1)
-				fatalerror("Timer list is full!");
-		}
+
+/*-------------------------------------------------
+    timer_heap_sift_down - move a timer toward the
+    leaves until it fires before its children
+-------------------------------------------------*/
+
+INLINE void timer_heap_sift_down(int index)
+{
+	emu_timer *timer = timer_heap[index];
+
+	for ( ; ; )
+	{
+		int child = index * 2 + 1;
+		if (child >= timer_heap_count)
+			break;
+		if (child + 1 < timer_heap_count && timer_before(timer_heap[child + 1], timer_heap[child]))
+			child++;
+		if (!timer_before(timer_heap[child], timer))
+			break;
+		timer_heap[index] = timer_heap[child];
+		timer_heap[index]->heapindex = index;
+		index = child;
 	}
+	timer_heap[index] = timer;
+	timer->heapindex = index;
+}
+
+
+/*-------------------------------------------------
+    timer_set_sortkey - compute the key a timer is
+    ordered on; disabled timers sort as never
+-------------------------------------------------*/
+
+INLINE void timer_set_sortkey(emu_timer *timer)
+{
+	timer->sortkey = timer->enabled ? timer->expire : attotime_never;
+	timer->sequence = timer_sequence++;
+	if (timer->stats != NULL)
+		timer->stats->inserts++;
+}
+
+
+/*-------------------------------------------------
+    timer_heap_insert - insert a new timer into
+    the heap at the appropriate location
+-------------------------------------------------*/
+
+INLINE void timer_heap_insert(emu_timer *timer)
+{
+	/* sanity checks for the debug build */
+	#ifdef MAME_DEBUG
+	if (timer->heapindex != -1)
+		fatalerror("This timer is already inserted in the list!");
 	#endif
 
-	/* loop over the timer list */
-	for (t = timer_head; t; lt = t, t = t->next)
+	/* grow the heap if we need to */
+	if (timer_heap_count == timer_heap_alloc)
 	{
-		/* if the current list entry expires after us, we should be inserted before it */
-		if (attotime_compare(t->expire, expire) > 0)
-		{
-			/* link the new guy in before the current list entry */
-			timer->prev = t->prev;
-			timer->next = t;
+		emu_timer **newheap;
 
-			if (t->prev)
-				t->prev->next = timer;
-			else
-				timer_head = timer;
-			t->prev = timer;
-			return;
+		timer_heap_alloc = (timer_heap_alloc == 0) ? TIMER_BLOCK_SIZE : timer_heap_alloc * 2;
+		newheap = malloc_or_die(timer_heap_alloc * sizeof(*newheap));
+		if (timer_heap != NULL)
+		{
+			memcpy(newheap, timer_heap, timer_heap_count * sizeof(*newheap));
+			free(timer_heap);
 		}
+		timer_heap = newheap;
 	}
 
-	/* need to insert after the last one */
-	if (lt)
-		lt->next = timer;
-	else
-		timer_head = timer;
-	timer->prev = lt;
-	timer->next = NULL;
+	/* add at the end and bubble up to where we belong */
+	timer_set_sortkey(timer);
+	timer_heap[timer_heap_count] = timer;
+	timer_heap_sift_up(timer_heap_count++);
 }
 
 
 /*-------------------------------------------------
-    timer_list_remove - remove a timer from the
-    linked list
+    timer_heap_remove - remove a timer from the
+    heap
 -------------------------------------------------*/
 
-INLINE void timer_list_remove(emu_timer *timer)
+INLINE void timer_heap_remove(emu_timer *timer)
 {
+	int index = timer->heapindex;
+
 	/* sanity checks for the debug build */
 	#ifdef MAME_DEBUG
-	{
-		emu_timer *t;
+	if (index < 0 || index >= timer_heap_count || timer_heap[index] != timer)
+		fatalerror("timer (%s from %s:%d) not found in list", timer->func, timer->file, timer->line);
+	#endif
 
-		/* loop over the timer list */
-		for (t = timer_head; t && t != timer; t = t->next) ;
-		if (t == NULL)
-			fatalerror("timer (%s from %s:%d) not found in list", timer->func, timer->file, timer->line);
+	/* move the last entry into the hole and fix up the order around it */
+	timer->heapindex = -1;
+	if (index != --timer_heap_count)
+	{
+		timer_heap[index] = timer_heap[timer_heap_count];
+		if (index > 0 && timer_before(timer_heap[index], timer_heap[(index - 1) / 2]))
+			timer_heap_sift_up(index);
+		else
+			timer_heap_sift_down(index);
 	}
-	#endif
+}
+
 
-	/* remove it from the list */
-	if (timer->prev)
-		timer->prev->next = timer->next;
+/*-------------------------------------------------
+    timer_heap_update - reposition a timer in the
+    heap after its expiration or enable changed;
+    equivalent to a remove followed by an insert
+-------------------------------------------------*/
+
+INLINE void timer_heap_update(emu_timer *timer)
+{
+	attotime oldkey = timer->sortkey;
+
+	timer_set_sortkey(timer);
+	if (attotime_compare(timer->sortkey, oldkey) < 0)
+		timer_heap_sift_up(timer->heapindex);
 	else
-		timer_head = timer->next;
-	if (timer->next)
-		timer->next->prev = timer->prev;
+		timer_heap_sift_down(timer->heapindex);
 }
 
 
@@ -238,8 +399,6 @@ INLINE void timer_list_remove(emu_timer *timer)
 
 void timer_init(running_machine *machine)
 {
-	int i;
-
 	/* we need to wait until the first call to timer_cyclestorun before using real CPU times */
 	global_basetime = attotime_zero;
 	callback_timer = NULL;
@@ -252,16 +411,53 @@ void timer_init(running_machine *machine)
 	state_save_register_func_postload(timer_postload);
 	state_save_pop_tag();
 
-	/* reset the timers */
-	memset(timers, 0, sizeof(timers));
+	/* initialize the heap and the pool; the first block is allocated on demand */
+	timer_heap = NULL;
+	timer_heap_count = 0;
+	timer_heap_alloc = 0;
+	timer_sequence = 0;
+	timer_blocks = NULL;
+	timer_free_head = NULL;
+	timer_free_tail = NULL;
+
+	/* set up statistics if requested */
+	timer_stats_enabled = options_get_bool(mame_options(), OPTION_TIMERSTATS);
+	timer_stats_list = NULL;
 
-	/* initialize the lists */
-	timer_head = NULL;
-	timer_free_head = &timers[0];
-	for (i = 0; i < MAX_TIMERS-1; i++)
-		timers[i].next = &timers[i+1];
-	timers[MAX_TIMERS-1].next = NULL;
-	timer_free_tail = &timers[MAX_TIMERS-1];
+	add_exit_callback(machine, timer_exit);
+}
+
+
+/*-------------------------------------------------
+    timer_exit - free the timer heap and pool
+-------------------------------------------------*/
+
+static void timer_exit(running_machine *machine)
+{
+	/* dump statistics if requested */
+	if (timer_stats_enabled)
+		timer_dump_stats();
+	while (timer_stats_list != NULL)
+	{
+		timer_stats *stats = timer_stats_list;
+		timer_stats_list = stats->next;
+		free(stats);
+	}
+
+	/* free the heap */
+	if (timer_heap != NULL)
+		free(timer_heap);
+	timer_heap = NULL;
+	timer_heap_count = timer_heap_alloc = 0;
+
+	/* free the pool */
+	while (timer_blocks != NULL)
+	{
+		timer_block *block = timer_blocks;
+		timer_blocks = block->next;
+		free(block);
+	}
+	timer_free_head = timer_free_tail = NULL;
 }
 
 
@@ -272,7 +468,9 @@ void timer_init(running_machine *machine)
 
 void timer_destructor(void *ptr, size_t size)
 {
-	timer_remove(ptr);
+	/* the pool is freed at exit before resources are torn down */
+	if (timer_blocks != NULL)
+		timer_remove(ptr);
 }
 
 
@@ -288,7 +486,7 @@ void timer_destructor(void *ptr, size_t size)
 
 attotime timer_next_fire_time(void)
 {
-	return timer_head->expire;
+	return timer_heap[0]->expire;
 }
 
 
@@ -304,15 +502,15 @@ void timer_set_global_time(attotime newbase)
 	/* set the new global offset */
 	global_basetime = newbase;
 
-	LOG(("timer_set_global_time: new=%s head->expire=%s\n", attotime_string(newbase), attotime_string(timer_head->expire)));
+	LOG(("timer_set_global_time: new=%s head->expire=%s\n", attotime_string(newbase), attotime_string(timer_heap[0]->expire)));
 
 	/* now process any timers that are overdue */
-	while (attotime_compare(timer_head->expire, global_basetime) <= 0)
+	while (attotime_compare(timer_heap[0]->expire, global_basetime) <= 0)
 	{
-		int was_enabled = timer_head->enabled;
+		int was_enabled = timer_heap[0]->enabled;
 
 		/* if this is a one-shot timer, disable it now */
-		timer = timer_head;
+		timer = timer_heap[0];
 		if (attotime_compare(timer->period, attotime_zero) == 0 || attotime_compare(timer->period, attotime_never) == 0)
 			timer->enabled = FALSE;
 
@@ -325,6 +523,8 @@ void timer_set_global_time(attotime newbase)
 		if (was_enabled && timer->callback != NULL)
 		{
 			LOG(("Timer %s:%d[%s] fired (expire=%s)\n", timer->file, timer->line, timer->func, attotime_string(timer->expire, 9)));
+			if (timer->stats != NULL)
+				timer->stats->fires++;
 			profiler_mark(PROFILER_TIMER_CALLBACK);
 			(*timer->callback)(Machine, timer->ptr, timer->param);
 			profiler_mark(PROFILER_END);
@@ -345,9 +545,7 @@ void timer_set_global_time(attotime newbase)
 			{
 				timer->start = timer->expire;
 				timer->expire = attotime_add(timer->expire, timer->period);
-
-				timer_list_remove(timer);
-				timer_list_insert(timer);
+				timer_heap_update(timer);
 			}
 		}
 	}
@@ -368,11 +566,11 @@ static void timer_register_save(emu_timer *timer)
 {
 	char buf[256];
 	int count = 0;
-	emu_timer *t;
+	int index;
 
 	/* find other timers that match our func name */
-	for (t = timer_head; t; t = t->next)
-		if (!strcmp(t->func, timer->func))
+	for (index = 0; index < timer_heap_count; index++)
+		if (!strcmp(timer_heap[index]->func, timer->func))
 			count++;
 
 	/* make up a name */
@@ -398,34 +596,28 @@ static void timer_register_save(emu_timer *timer)
 
 static void timer_postload(void)
 {
-	emu_timer *privlist = NULL;
-	emu_timer *t;
+	int oldcount = timer_heap_count;
+	int index;
 
-	/* remove all timers and make a private list */
-	while (timer_head != NULL)
+	/* pull everything out of the heap; temporary timers go away entirely */
+	/* and permanent ones are compacted at the start of the array */
+	timer_heap_count = 0;
+	for (index = 0; index < oldcount; index++)
 	{
-		t = timer_head;
-
-		/* temporary timers go away entirely */
+		emu_timer *t = timer_heap[index];
+		t->heapindex = -1;
 		if (t->temporary)
-			timer_remove(t);
-
-		/* permanent ones get added to our private list */
+			timer_free(t);
 		else
-		{
-			timer_list_remove(t);
-			t->next = privlist;
-			privlist = t;
-		}
+			timer_heap[timer_heap_count++] = t;
 	}
 
 	/* now add them all back in; this effectively re-sorts them by time */
-	while (privlist != NULL)
-	{
-		t = privlist;
-		privlist = t->next;
-		timer_list_insert(t);
-	}
+	/* inserting entry N only ever writes to slots 0..N, so this is safe in place */
+	oldcount = timer_heap_count;
+	timer_heap_count = 0;
+	for (index = 0; index < oldcount; index++)
+		timer_heap_insert(timer_heap[index]);
 }
 
 
@@ -436,16 +628,19 @@ static void timer_postload(void)
 
 int timer_count_anonymous(void)
 {
-	emu_timer *t;
 	int count = 0;
+	int index;
 
 	logerror("timer_count_anonymous:\n");
-	for (t = timer_head; t; t = t->next)
+	for (index = 0; index < timer_heap_count; index++)
+	{
+		emu_timer *t = timer_heap[index];
 		if (t->temporary && t != callback_timer)
 		{
 			count++;
 			logerror("  Temp. timer %p, file %s:%d[%s]\n", (void *) t, t->file, t->line, t->func);
 		}
+	}
 	logerror("%d temporary timers found\n", count);
 
 	return count;
@@ -465,7 +660,11 @@ int timer_count_anonymous(void)
 INLINE emu_timer *_timer_alloc_common(timer_callback callback, void *ptr, const char *file, int line, const char *func, int temp)
 {
 	attotime time = get_current_time();
-	emu_timer *timer = timer_new();
+	emu_timer *timer;
+
+	/* CPU groups running in parallel share the timer pool */
+	cpuexec_lock();
+	timer = timer_new();
 
 	/* fill in the record */
 	timer->callback = callback;
@@ -477,11 +676,12 @@ INLINE emu_timer *_timer_alloc_common(timer_callback callback, void *ptr, const
 	timer->file = file;
 	timer->line = line;
 	timer->func = func;
+	timer->stats = timer_stats_enabled ? timer_find_stats(func) : NULL;
 
-	/* compute the time of the next firing and insert into the list */
+	/* compute the time of the next firing and insert into the heap */
 	timer->start = time;
 	timer->expire = attotime_never;
-	timer_list_insert(timer);
+	timer_heap_insert(timer);
 
 	/* if we're not temporary, register ourselve with the save state system */
 	if (!temp)
@@ -489,6 +689,7 @@ INLINE emu_timer *_timer_alloc_common(timer_callback callback, void *ptr, const
 		timer_register_save(timer);
 		restrack_register_object(OBJTYPE_TIMER, timer, 0, file, line);
 	}
+	cpuexec_unlock();
 
 	/* return a handle */
 	return timer;
@@ -511,16 +712,11 @@ static void timer_remove(emu_timer *which)
 	if (which == callback_timer)
 		callback_timer_modified = TRUE;
 
-	/* remove it from the list */
-	timer_list_remove(which);
-
-	/* free it up by adding it back to the free list */
-	if (timer_free_tail)
-		timer_free_tail->next = which;
-	else
-		timer_free_head = which;
-	which->next = NULL;
-	timer_free_tail = which;
+	/* remove it from the heap and free it up */
+	cpuexec_lock();
+	timer_heap_remove(which);
+	timer_free(which);
+	cpuexec_unlock();
 }
 
 
@@ -538,6 +734,7 @@ static void timer_remove(emu_timer *which)
 void timer_adjust(emu_timer *which, attotime duration, INT32 param, attotime period)
 {
 	attotime time = get_current_time();
+	int ishead;
 
 	/* if this is the callback timer, mark it modified */
 	if (which == callback_timer)
@@ -556,13 +753,15 @@ void timer_adjust(emu_timer *which, attotime duration, INT32 param, attotime per
 	which->expire = attotime_add(time, duration);
 	which->period = period;
 
-	/* remove and re-insert the timer in its new order */
-	timer_list_remove(which);
-	timer_list_insert(which);
+	/* move the timer to its new place in the heap */
+	cpuexec_lock();
+	timer_heap_update(which);
+	ishead = (which == timer_heap[0]);
+	cpuexec_unlock();
 
 	/* if this was inserted as the head, abort the current timeslice and resync */
 	LOG(("timer_adjust %s.%s:%d to expire @ %s\n", which->file, which->func, which->line, attotime_string(which->expire, 9)));
-	if (which == timer_head && cpu_getexecutingcpu() >= 0)
+	if (ishead && cpu_getexecutingcpu() >= 0)
 		activecpu_abort_timeslice();
 }
 
@@ -624,9 +823,10 @@ int timer_enable(emu_timer *which, int enable)
 	old = which->enabled;
 	which->enabled = enable;
 
-	/* remove the timer and insert back into the list */
-	timer_list_remove(which);
-	timer_list_insert(which);
+	/* move the timer to its new place in the heap */
+	cpuexec_lock();
+	timer_heap_update(which);
+	cpuexec_unlock();
 
 	return old;
 }
@@ -732,13 +932,14 @@ attotime timer_firetime(emu_timer *which)
 static void timer_logtimers(void)
 {
 	emu_timer *t;
+	int index;
 
 	logerror("===============\n");
 	logerror("TIMER LOG START\n");
 	logerror("===============\n");
 
 	logerror("Enqueued timers:\n");
-	for (t = timer_head; t; t = t->next)
+	for (index = 0; index < timer_heap_count && (t = timer_heap[index]) != NULL; index++)
 		logerror("  Start=%15.6f Exp=%15.6f Per=%15.6f Ena=%d Tmp=%d (%s:%d[%s])\n",
 			attotime_to_double(t->start), attotime_to_double(t->expire), attotime_to_double(t->period), t->enabled, t->temporary, t->file, t->line, t->func);
 
@@ -751,3 +952,68 @@ static void timer_logtimers(void)
 	logerror("TIMER LOG STOP\n");
 	logerror("==============\n");
 }
+
+
+/*-------------------------------------------------
+    timer_stats_compare - qsort callback that
+    orders statistics by descending insert count
+-------------------------------------------------*/
+
+static int CLIB_DECL timer_stats_compare(const void *item1, const void *item2)
+{
+	const timer_stats *stats1 = *(const timer_stats * const *)item1;
+	const timer_stats *stats2 = *(const timer_stats * const *)item2;
+
+	if (stats1->inserts != stats2->inserts)
+		return (stats1->inserts < stats2->inserts) ? 1 : -1;
+	return strcmp(stats1->func, stats2->func);
+}
+
+
+/*-------------------------------------------------
+    timer_pool_size - return the total number of
+    timers allocated in the pool
+-------------------------------------------------*/
+
+static int timer_pool_size(void)
+{
+	timer_block *block;
+	int count = 0;
+
+	for (block = timer_blocks; block != NULL; block = block->next)
+		count += TIMER_BLOCK_SIZE;
+	return count;
+}
+
+
+/*-------------------------------------------------
+    timer_dump_stats - output the per-callback
+    insert and fire counts, busiest first
+-------------------------------------------------*/
+
+static void timer_dump_stats(void)
+{
+	timer_stats **sorted;
+	timer_stats *stats;
+	int count = 0;
+	int index;
+
+	/* gather and sort the records */
+	for (stats = timer_stats_list; stats != NULL; stats = stats->next)
+		count++;
+	if (count == 0)
+		return;
+	sorted = malloc_or_die(count * sizeof(*sorted));
+	for (stats = timer_stats_list, index = 0; stats != NULL; stats = stats->next)
+		sorted[index++] = stats;
+	qsort(sorted, count, sizeof(*sorted), timer_stats_compare);
+
+	mame_printf_info("Timer statistics (%d timers in pool, %d scheduled):\n", timer_pool_size(), timer_heap_count);
+	mame_printf_info("%12s %12s  %s\n", "Inserts", "Fires", "Callback");
+	for (index = 0; index < count; index++)
+		mame_printf_info("%12.0f %12.0f  %s\n", (double)sorted[index]->inserts, (double)sorted[index]->fires, sorted[index]->func);
+	free(sorted);
+
+	/* the full list goes to the log */
+	timer_logtimers();
+}
@@ -1307,6 +1307,10 @@ static UINT32 handler_ingame(UINT32 state)
 		return ui_set_handler(handler_load_save, LOADSAVE_LOAD);
 	}
 
+	/* handle a rewind request */
+	if (input_ui_pressed(IPT_UI_REWIND))
+		mame_schedule_rewind(Machine);
+
 	/* handle a save snapshot request */
 	if (input_ui_pressed(IPT_UI_SNAPSHOT))
 		video_save_active_screen_snapshots(Machine);
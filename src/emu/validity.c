@@ -649,6 +649,24 @@ static int validate_cpu(int drivnum, const machine_config *drv, const UINT32 *re
 			continue;
 		}
 
+		/* CPUs in different parallel groups must not share a core, since cores keep their context in globals */
+		if (cpu->group < 0 || cpu->group >= MAX_CPU_GROUPS)
+		{
+			mame_printf_error("%s: %s CPU %d has invalid parallel group %d\n", driver->source_file, driver->name, cpunum, cpu->group);
+			error = TRUE;
+		}
+		else
+		{
+			int othernum;
+			for (othernum = 0; othernum < cpunum; othernum++)
+				if (drv->cpu[othernum].type != CPU_DUMMY && drv->cpu[othernum].group != cpu->group &&
+					!strcmp(cputype_core_file(drv->cpu[othernum].type), cputype_core_file(cpu->type)))
+				{
+					mame_printf_error("%s: %s CPUs %d and %d share a CPU core but are in different parallel groups\n", driver->source_file, driver->name, othernum, cpunum);
+					error = TRUE;
+				}
+		}
+
 		/* loop over all address spaces */
 		for (spacenum = 0; spacenum < ADDRESS_SPACES; spacenum++)
 		{
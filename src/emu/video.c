@@ -38,6 +38,9 @@
 
 #define SUBSECONDS_PER_SPEED_UPDATE	(ATTOSECONDS_PER_SECOND / 4)
 #define PAUSED_REFRESH_RATE			30
+#define MOVIE_FRAME_BUFFERS			8			/* movie frames that can be encoding at once */
+#define DECODE_CHUNK_ELEMENTS		256			/* graphics elements decoded by each work item */
+#define DECODE_CHUNKS_PER_PASS		64			/* work items queued between progress updates */
 
 
 
@@ -45,6 +48,28 @@
     TYPE DEFINITIONS
 ***************************************************************************/
 
+typedef struct _movie_frame_buffer movie_frame_buffer;
+struct _movie_frame_buffer
+{
+	mame_bitmap *			bitmap;				/* private copy of the snapshot bitmap */
+	png_info				pnginfo;			/* PNG info, including any text fields */
+	osd_work_item *			item;				/* work item encoding this frame */
+	UINT8 *					data;				/* encoded chunk stream */
+	UINT32					length;				/* length of the encoded data */
+	png_error				error;				/* result of encoding */
+};
+
+
+typedef struct _gfx_decode_chunk gfx_decode_chunk;
+struct _gfx_decode_chunk
+{
+	gfx_element *			gfx;				/* graphics set being decoded */
+	const UINT8 *			src;				/* base of the source data */
+	UINT32					first;				/* first element to decode */
+	UINT32					count;				/* number of elements to decode */
+};
+
+
 typedef struct _internal_screen_info internal_screen_info;
 struct _internal_screen_info
 {
@@ -70,6 +95,11 @@ struct _internal_screen_info
 	/* movie recording */
 	mame_file *				movie_file;			/* handle to the open movie file */
 	UINT32 					movie_frame;		/* current movie frame number */
+	movie_frame_buffer		movie_buffer[MOVIE_FRAME_BUFFERS]; /* ring of frames being encoded */
+	UINT32					movie_head;			/* oldest frame not yet written */
+	UINT32					movie_tail;			/* next frame to be queued */
+	UINT32					movie_stalls;		/* frames that waited for a free buffer */
+	osd_ticks_t				movie_stall_ticks;	/* total time spent waiting */
 };
 
 
@@ -81,6 +111,10 @@ struct _video_private
 	/* snapshot stuff */
 	render_target *			snap_target;		/* screen shapshot target */
 	mame_bitmap *			snap_bitmap;		/* screen snapshot bitmap */
+	osd_work_queue *		snap_queue;			/* work queue for banded snapshot rendering */
+
+	/* movie encoding */
+	osd_work_queue *		movie_queue;		/* work queue for movie frame encoding */
 
 	/* crosshair bits */
 	mame_bitmap *			crosshair_bitmap[MAX_PLAYERS]; /* crosshair bitmap per player */
@@ -171,6 +205,8 @@ static void init_buffered_spriteram(void);
 /* graphics decoding */
 static void allocate_graphics(running_machine *machine, const gfx_decode_entry *gfxdecodeinfo);
 static void decode_graphics(running_machine *machine, const gfx_decode_entry *gfxdecodeinfo);
+static int decode_graphics_pass(osd_work_queue *queue, gfx_decode_chunk *chunk, int numchunks);
+static void *decode_graphics_chunk(void *param, int threadid);
 
 /* global rendering */
 static TIMER_CALLBACK( scanline0_callback );
@@ -188,6 +224,8 @@ static file_error mame_fopen_next(const char *pathoption, const char *extension,
 
 /* movie recording */
 static void movie_record_frame(running_machine *machine, int scrnum);
+static void *movie_encode_frame(void *param, int threadid);
+static png_error movie_write_frames(internal_screen_info *info, UINT32 mincount);
 
 /* crosshair rendering */
 static void crosshair_init(video_private *viddata);
@@ -195,7 +233,7 @@ static void crosshair_render(video_private *viddata);
 static void crosshair_free(video_private *viddata);
 
 /* software rendering */
-static void rgb888_draw_primitives(const render_primitive *primlist, void *dstdata, UINT32 width, UINT32 height, UINT32 pitch);
+static void rgb888_draw_primitives_banded(const render_primitive *primlist, void *dstdata, UINT32 width, UINT32 height, UINT32 pitch, osd_work_queue *queue);
 
 
 
@@ -359,8 +397,14 @@ void video_init(running_machine *machine)
 		if (viddata->snap_target == NULL)
 			fatalerror("Unable to allocate snapshot render target\n");
 		render_target_set_layer_config(viddata->snap_target, 0);
+
+		/* snapshots and movie frames are rendered in bands across worker threads */
+		viddata->snap_queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI);
 	}
 
+	/* movie frames are compressed off the emulation thread */
+	viddata->movie_queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI);
+
 	/* create crosshairs */
 	crosshair_init(viddata);
 
@@ -410,6 +454,10 @@ static void video_exit(running_machine *machine)
 		render_target_free(viddata->snap_target);
 	if (viddata->snap_bitmap != NULL)
 		bitmap_free(viddata->snap_bitmap);
+	if (viddata->snap_queue != NULL)
+		osd_work_queue_free(viddata->snap_queue);
+	if (viddata->movie_queue != NULL)
+		osd_work_queue_free(viddata->movie_queue);
 
 	/* print a final result if we have at least 5 seconds' worth of data */
 	if (global.overall_emutime.seconds >= 5)
@@ -598,7 +646,10 @@ static void allocate_graphics(running_machine *machine, const gfx_decode_entry *
 
 static void decode_graphics(running_machine *machine, const gfx_decode_entry *gfxdecodeinfo)
 {
+	gfx_decode_chunk chunk[DECODE_CHUNKS_PER_PASS];
+	osd_work_queue *queue;
 	int totalgfx = 0, curgfx = 0;
+	int numchunks = 0;
 	char buffer[200];
 	int i;
 
@@ -607,6 +658,9 @@ static void decode_graphics(running_machine *machine, const gfx_decode_entry *gf
 		if (machine->gfx[i])
 			totalgfx += machine->gfx[i]->total_elements;
 
+	/* elements decode independently, so spread them across a work queue */
+	queue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI);
+
 	/* loop over all elements */
 	for (i = 0; i < MAX_GFX_ELEMENTS; i++)
 		if (machine->gfx[i] != NULL)
@@ -619,11 +673,27 @@ static void decode_graphics(running_machine *machine, const gfx_decode_entry *gf
 				int j;
 
 				/* now decode the actual graphics */
-				for (j = 0; j < gfx->total_elements; j += 1024)
+				for (j = 0; j < gfx->total_elements; j += DECODE_CHUNK_ELEMENTS)
 				{
-					int num_to_decode = (j + 1024 < gfx->total_elements) ? 1024 : (gfx->total_elements - j);
-					decodegfx(gfx, region_base + gfxdecodeinfo[i].start, j, num_to_decode);
-					curgfx += num_to_decode;
+					int num_to_decode = (j + DECODE_CHUNK_ELEMENTS < gfx->total_elements) ? DECODE_CHUNK_ELEMENTS : (gfx->total_elements - j);
+
+					/* the first chunk sets up the data pointer for raw sets, so it is always done here */
+					if (j == 0 || queue == NULL)
+					{
+						decodegfx(gfx, region_base + gfxdecodeinfo[i].start, j, num_to_decode);
+						curgfx += num_to_decode;
+					}
+					else
+					{
+						chunk[numchunks].gfx = gfx;
+						chunk[numchunks].src = region_base + gfxdecodeinfo[i].start;
+						chunk[numchunks].first = j;
+						chunk[numchunks].count = num_to_decode;
+						if (++numchunks < DECODE_CHUNKS_PER_PASS)
+							continue;
+						curgfx += decode_graphics_pass(queue, chunk, numchunks);
+						numchunks = 0;
+					}
 
 					/* display some startup text */
 					sprintf(buffer, "Decoding (%d%%)", curgfx * 100 / totalgfx);
@@ -635,6 +705,52 @@ static void decode_graphics(running_machine *machine, const gfx_decode_entry *gf
 			else
 				memset(machine->gfx[i]->gfxdata, 0, machine->gfx[i]->char_modulo * machine->gfx[i]->total_elements);
 		}
+
+	/* finish whatever is left over */
+	if (numchunks > 0)
+	{
+		curgfx += decode_graphics_pass(queue, chunk, numchunks);
+		sprintf(buffer, "Decoding (%d%%)", curgfx * 100 / totalgfx);
+		ui_set_startup_text(buffer, FALSE);
+	}
+	if (queue != NULL)
+		osd_work_queue_free(queue);
+}
+
+
+/*-------------------------------------------------
+    decode_graphics_pass - decode a batch of
+    chunks on the work queue and return the
+    number of elements decoded
+-------------------------------------------------*/
+
+static int decode_graphics_pass(osd_work_queue *queue, gfx_decode_chunk *chunk, int numchunks)
+{
+	int elements = 0;
+	int chunknum;
+
+	/* the chunks live on our caller's stack, so we can't return until they're all done */
+	osd_work_item_queue_multiple(queue, decode_graphics_chunk, numchunks, chunk, sizeof(chunk[0]), WORK_ITEM_FLAG_AUTO_RELEASE);
+	if (!osd_work_queue_wait(queue, 100 * osd_ticks_per_second()))
+		fatalerror("decode_graphics: graphics decoding never completed");
+
+	for (chunknum = 0; chunknum < numchunks; chunknum++)
+		elements += chunk[chunknum].count;
+	return elements;
+}
+
+
+/*-------------------------------------------------
+    decode_graphics_chunk - work item callback to
+    decode one chunk of a graphics set
+-------------------------------------------------*/
+
+static void *decode_graphics_chunk(void *param, int threadid)
+{
+	gfx_decode_chunk *chunk = param;
+
+	decodegfx(chunk->gfx, chunk->src, chunk->first, chunk->count);
+	return NULL;
 }
 
 
@@ -1749,7 +1865,7 @@ static mame_bitmap *get_snapshot_bitmap(running_machine *machine, int scrnum)
 	/* render the screen there */
 	primlist = render_target_get_primitives(viddata->snap_target);
 	osd_lock_acquire(primlist->lock);
-	rgb888_draw_primitives(primlist->head, viddata->snap_bitmap->base, width, height, viddata->snap_bitmap->rowpixels);
+	rgb888_draw_primitives_banded(primlist->head, viddata->snap_bitmap->base, width, height, viddata->snap_bitmap->rowpixels, viddata->snap_queue);
 	osd_lock_release(primlist->lock);
 
 	/* now do the actual work */
@@ -1830,6 +1946,9 @@ void video_movie_begin_recording(running_machine *machine, int scrnum, const cha
 	else
 		filerr = mame_fopen_next(SEARCHPATH_MOVIE, "mng", &info->movie_file);
 	info->movie_frame = 0;
+	info->movie_head = info->movie_tail = 0;
+	info->movie_stalls = 0;
+	info->movie_stall_ticks = 0;
 }
 
 
@@ -1842,15 +1961,31 @@ void video_movie_end_recording(running_machine *machine, int scrnum)
 {
 	video_private *viddata = machine->video_data;
 	internal_screen_info *info = &viddata->scrinfo[scrnum];
+	int bufnum;
 
 	/* close the file if it exists */
 	if (info->movie_file != NULL)
 	{
+		osd_ticks_t tps = osd_ticks_per_second();
+
+		/* wait for the encoders and write out every frame still in flight */
+		movie_write_frames(info, info->movie_tail - info->movie_head);
+		mame_printf_verbose("Movie: %d frames, %d stalls waiting for the encoder (%.1f ms total)\n", info->movie_frame,
+				info->movie_stalls, (double)info->movie_stall_ticks * 1000.0 / (double)tps);
+
 		mng_capture_stop(mame_core_file(info->movie_file));
 		mame_fclose(info->movie_file);
 		info->movie_file = NULL;
 		info->movie_frame = 0;
 	}
+
+	/* free the frame buffers */
+	for (bufnum = 0; bufnum < MOVIE_FRAME_BUFFERS; bufnum++)
+		if (info->movie_buffer[bufnum].bitmap != NULL)
+		{
+			bitmap_free(info->movie_buffer[bufnum].bitmap);
+			info->movie_buffer[bufnum].bitmap = NULL;
+		}
 }
 
 
@@ -1863,14 +1998,14 @@ static void movie_record_frame(running_machine *machine, int scrnum)
 {
 	video_private *viddata = machine->video_data;
 	internal_screen_info *info = &viddata->scrinfo[scrnum];
-	const rgb_t *palette;
 
 	/* only record if we have a file */
 	if (info->movie_file != NULL)
 	{
-		png_info pnginfo = { 0 };
+		movie_frame_buffer *frame;
 		mame_bitmap *bitmap;
 		png_error error;
+		int y;
 
 		profiler_mark(PROFILER_MOVIE_REC);
 
@@ -1879,6 +2014,38 @@ static void movie_record_frame(running_machine *machine, int scrnum)
 		if (bitmap == NULL)
 			return;
 
+		/* write out any frames that have finished encoding */
+		error = movie_write_frames(info, 0);
+
+		/* if every buffer is still busy, we have to wait for the oldest one */
+		if (error == PNGERR_NONE && info->movie_tail - info->movie_head == MOVIE_FRAME_BUFFERS)
+		{
+			osd_ticks_t start = osd_ticks();
+			error = movie_write_frames(info, 1);
+			info->movie_stalls++;
+			info->movie_stall_ticks += osd_ticks() - start;
+			if (info->movie_tail - info->movie_head == MOVIE_FRAME_BUFFERS)
+				error = PNGERR_COMPRESS_ERROR;
+		}
+		if (error != PNGERR_NONE)
+		{
+			video_movie_end_recording(machine, scrnum);
+			return;
+		}
+
+		/* copy the bitmap into the next free buffer */
+		frame = &info->movie_buffer[info->movie_tail % MOVIE_FRAME_BUFFERS];
+		if (frame->bitmap == NULL || frame->bitmap->width != bitmap->width || frame->bitmap->height != bitmap->height)
+		{
+			if (frame->bitmap != NULL)
+				bitmap_free(frame->bitmap);
+			frame->bitmap = bitmap_alloc(bitmap->width, bitmap->height, bitmap->format);
+		}
+		for (y = 0; y < bitmap->height; y++)
+			memcpy(BITMAP_ADDR32(frame->bitmap, y, 0), BITMAP_ADDR32(bitmap, y, 0), bitmap->width * sizeof(UINT32));
+		memset(&frame->pnginfo, 0, sizeof(frame->pnginfo));
+		frame->data = NULL;
+
 		/* track frames */
 		if (info->movie_frame++ == 0)
 		{
@@ -1886,32 +2053,87 @@ static void movie_record_frame(running_machine *machine, int scrnum)
 
 			/* set up the text fields in the movie info */
 			sprintf(text, APPNAME " %s", build_version);
-			png_add_text(&pnginfo, "Software", text);
+			png_add_text(&frame->pnginfo, "Software", text);
 			sprintf(text, "%s %s", machine->gamedrv->manufacturer, machine->gamedrv->description);
-			png_add_text(&pnginfo, "System", text);
+			png_add_text(&frame->pnginfo, "System", text);
 
 			/* start the capture */
 			error = mng_capture_start(mame_core_file(info->movie_file), bitmap, ATTOSECONDS_TO_HZ(viddata->scrinfo[scrnum].state->refresh));
 			if (error != PNGERR_NONE)
 			{
-				png_free(&pnginfo);
+				png_free(&frame->pnginfo);
 				video_movie_end_recording(machine, scrnum);
 				return;
 			}
 		}
 
-		/* write the next frame */
-		palette = (machine->palette != NULL) ? palette_entry_list_adjusted(machine->palette) : NULL;
-		error = mng_capture_frame(mame_core_file(info->movie_file), &pnginfo, bitmap, machine->drv->total_colors, palette);
-		png_free(&pnginfo);
-		if (error != PNGERR_NONE)
+		/* hand the frame to the encoders; without a queue, encode it here */
+		frame->item = NULL;
+		if (viddata->movie_queue != NULL)
+			frame->item = osd_work_item_queue(viddata->movie_queue, movie_encode_frame, frame, 0);
+		if (frame->item == NULL)
+			movie_encode_frame(frame, 0);
+		info->movie_tail++;
+
+		profiler_mark(PROFILER_END);
+	}
+}
+
+
+/*-------------------------------------------------
+    movie_encode_frame - work item callback that
+    compresses a single movie frame
+-------------------------------------------------*/
+
+static void *movie_encode_frame(void *param, int threadid)
+{
+	movie_frame_buffer *frame = param;
+
+	/* the snapshot bitmap is always RGB32, so no palette is needed */
+	frame->error = mng_capture_encode_frame(&frame->pnginfo, frame->bitmap, 0, NULL, &frame->data, &frame->length);
+	png_free(&frame->pnginfo);
+	return NULL;
+}
+
+
+/*-------------------------------------------------
+    movie_write_frames - write encoded frames to
+    the movie file in order, stopping at the
+    first one still being encoded once at least
+    mincount frames have been written
+-------------------------------------------------*/
+
+static png_error movie_write_frames(internal_screen_info *info, UINT32 mincount)
+{
+	png_error error = PNGERR_NONE;
+
+	while (info->movie_head != info->movie_tail)
+	{
+		movie_frame_buffer *frame = &info->movie_buffer[info->movie_head % MOVIE_FRAME_BUFFERS];
+
+		/* wait for the frame only if we still owe the caller some */
+		if (frame->item != NULL)
 		{
-			video_movie_end_recording(machine, scrnum);
-			return;
+			if (!osd_work_item_wait(frame->item, (mincount > 0) ? 100 * osd_ticks_per_second() : 0))
+				break;
+			osd_work_item_release(frame->item);
+			frame->item = NULL;
 		}
 
-		profiler_mark(PROFILER_END);
+		/* write it out; after an error, keep draining without writing */
+		if (error == PNGERR_NONE)
+			error = frame->error;
+		if (error == PNGERR_NONE)
+			error = mng_capture_write_frame(mame_core_file(info->movie_file), frame->data, frame->length);
+		if (frame->data != NULL)
+			free(frame->data);
+		frame->data = NULL;
+
+		info->movie_head++;
+		if (mincount > 0)
+			mincount--;
 	}
+	return error;
 }
 
 
@@ -3509,16 +3509,24 @@ static void raster_##name(void *destbase, INT32 y, const poly_extent *extent, co
 	INT32 scry;																	\
 	INT32 x;																	\
 																				\
+	/* read the modes once; they are constants in the fixed rasterizers */		\
+	const UINT32 mode_fbzcp = (FBZCOLORPATH);									\
+	const UINT32 mode_fbz = (FBZMODE);											\
+	const UINT32 mode_alpha = (ALPHAMODE);										\
+	const UINT32 mode_fog = (FOGMODE);											\
+	const UINT32 mode_tex0 = (TEXMODE0);										\
+	const UINT32 mode_tex1 = (TEXMODE1);										\
+																				\
 	/* determine the screen Y */												\
 	scry = y;																	\
-	if (FBZMODE_Y_ORIGIN(FBZMODE))												\
+	if (FBZMODE_Y_ORIGIN(mode_fbz))												\
 		scry = (v->fbi.yorigin - y) & 0x3ff;									\
 																				\
 	/* compute dithering */														\
-	COMPUTE_DITHER_POINTERS(FBZMODE, y);										\
+	COMPUTE_DITHER_POINTERS(mode_fbz, y);										\
 																				\
 	/* apply clipping */														\
-	if (FBZMODE_ENABLE_CLIPPING(FBZMODE))										\
+	if (FBZMODE_ENABLE_CLIPPING(mode_fbz))										\
 	{																			\
 		INT32 tempclip;															\
 																				\
@@ -3581,13 +3589,13 @@ static void raster_##name(void *destbase, INT32 y, const poly_extent *extent, co
 		rgb_union texel = { 0 };												\
 																				\
 		/* pixel pipeline part 1 handles depth testing and stippling */			\
-		PIXEL_PIPELINE_BEGIN(v, stats, x, y, FBZCOLORPATH, FBZMODE, 			\
+		PIXEL_PIPELINE_BEGIN(v, stats, x, y, mode_fbzcp, mode_fbz,				\
 								iterz, iterw);									\
 																				\
 		/* run the texture pipeline on TMU1 to produce a value in texel */		\
 		/* note that they set LOD min to 8 to "disable" a TMU */				\
 		if (TMUS >= 2 && v->tmu[1].lodmin < (8 << 8))							\
-			TEXTURE_PIPELINE(&v->tmu[1], x, dither4, TEXMODE1, texel,			\
+			TEXTURE_PIPELINE(&v->tmu[1], x, dither4, mode_tex1, texel,			\
 								v->tmu[1].lookup, extra->lodbase1,				\
 								iters1, itert1, iterw1, texel);					\
 																				\
@@ -3595,18 +3603,18 @@ static void raster_##name(void *destbase, INT32 y, const poly_extent *extent, co
 		/* result in texel */													\
 		/* note that they set LOD min to 8 to "disable" a TMU */				\
 		if (TMUS >= 1 && v->tmu[0].lodmin < (8 << 8))							\
-			TEXTURE_PIPELINE(&v->tmu[0], x, dither4, TEXMODE0, texel,			\
+			TEXTURE_PIPELINE(&v->tmu[0], x, dither4, mode_tex0, texel,			\
 								v->tmu[0].lookup, extra->lodbase0,				\
 								iters0, itert0, iterw0, texel);					\
 																				\
 		/* colorpath pipeline selects source colors and does blending */		\
-		CLAMPED_ARGB(iterr, iterg, iterb, itera, FBZCOLORPATH, iterargb);		\
-		COLORPATH_PIPELINE(v, stats, FBZCOLORPATH, FBZMODE, ALPHAMODE, texel,	\
+		CLAMPED_ARGB(iterr, iterg, iterb, itera, mode_fbzcp, iterargb);			\
+		COLORPATH_PIPELINE(v, stats, mode_fbzcp, mode_fbz, mode_alpha, texel,	\
 							iterz, iterw, iterargb);							\
 																				\
 		/* pixel pipeline part 2 handles fog, alpha, and final output */		\
 		PIXEL_PIPELINE_END(v, stats, dither, dither4, dither_lookup, x, dest, depth, \
-							FBZMODE, FBZCOLORPATH, ALPHAMODE, FOGMODE, 			\
+							mode_fbz, mode_fbzcp, mode_alpha, mode_fog,			\
 							iterz, iterw, iterargb);							\
 																				\
 		/* update the iterated parameters */									\
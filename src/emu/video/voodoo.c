@@ -165,6 +165,8 @@ bits(7:4) and bit(24)), X, and Y:
 #define LOG_CMDFIFO			(0)
 #define LOG_CMDFIFO_VERBOSE	(0)
 
+#define SPECIALIZE_GENERIC	(1)
+
 #define MODIFY_PIXEL(VV)
 
 
@@ -236,6 +238,7 @@ static void raster_fastfill(void *dest, INT32 scanline, const poly_extent *exten
 static void raster_generic_0tmu(void *dest, INT32 scanline, const poly_extent *extent, const void *extradata, int threadid);
 static void raster_generic_1tmu(void *dest, INT32 scanline, const poly_extent *extent, const void *extradata, int threadid);
 static void raster_generic_2tmu(void *dest, INT32 scanline, const poly_extent *extent, const void *extradata, int threadid);
+static const poly_draw_scanline specialized_raster_table[3][16];
 
 
 
@@ -5144,8 +5147,20 @@ static raster_info *find_rasterizer(voodoo_state *v, int texcount)
 			return info;
 		}
 
-	/* generate a new one using the generic entry */
-	curinfo.callback = (texcount == 0) ? raster_generic_0tmu : (texcount == 1) ? raster_generic_1tmu : raster_generic_2tmu;
+	/* generate a new one using the generic entry, picking the version built */
+	/* for the stages this combination enables */
+	if (SPECIALIZE_GENERIC)
+	{
+		int spec = 0;
+
+		if (FBZMODE_ENABLE_DEPTHBUF(curinfo.eff_fbz_mode)) spec |= 1;
+		if (FBZMODE_ENABLE_DITHERING(curinfo.eff_fbz_mode)) spec |= 2;
+		if (ALPHAMODE_ALPHABLEND(curinfo.eff_alpha_mode)) spec |= 4;
+		if (FOGMODE_ENABLE_FOG(curinfo.eff_fog_mode)) spec |= 8;
+		curinfo.callback = specialized_raster_table[texcount][spec];
+	}
+	else
+		curinfo.callback = (texcount == 0) ? raster_generic_0tmu : (texcount == 1) ? raster_generic_1tmu : raster_generic_2tmu;
 	curinfo.is_generic = TRUE;
 	curinfo.display = 0;
 	curinfo.polys = 0;
@@ -5284,6 +5299,51 @@ RASTERIZER(generic_2tmu, 2, v->reg[fbzColorPath].u, v->reg[fbzMode].u, v->reg[al
 			v->reg[fogMode].u, v->tmu[0].reg[textureMode].u, v->tmu[1].reg[textureMode].u)
 
 
+/*-------------------------------------------------
+    specialized generic rasterizers - generic
+    rasterizers with the depth buffer, dithering,
+    alpha blending and fog enables fixed, so the
+    compiler drops the stages that are off; the
+    other mode bits are read from the registers
+-------------------------------------------------*/
+
+#define SPEC_FBZ_MASK		((1 << 4) | (1 << 8))
+#define SPEC_FBZ_BITS(s)	((((s) & 1) ? (1 << 4) : 0) | (((s) & 2) ? (1 << 8) : 0))
+#define SPEC_ALPHA_BITS(s)	(((s) & 4) ? (1 << 4) : 0)
+#define SPEC_FOG_BITS(s)	(((s) & 8) ? 1 : 0)
+
+#define SPECIALIZED_RASTERIZER(tmus, s) \
+	RASTERIZER(generic_##tmus##tmu_##s, tmus, v->reg[fbzColorPath].u, \
+			(v->reg[fbzMode].u & ~SPEC_FBZ_MASK) | SPEC_FBZ_BITS(s), \
+			(v->reg[alphaMode].u & ~(1 << 4)) | SPEC_ALPHA_BITS(s), \
+			(v->reg[fogMode].u & ~1) | SPEC_FOG_BITS(s), \
+			((tmus) >= 1) ? v->tmu[0].reg[textureMode].u : 0, \
+			((tmus) >= 2) ? v->tmu[1].reg[textureMode].u : 0)
+
+#define SPECIALIZED_RASTERIZER_SET(tmus) \
+	SPECIALIZED_RASTERIZER(tmus, 0)  SPECIALIZED_RASTERIZER(tmus, 1)  SPECIALIZED_RASTERIZER(tmus, 2)  SPECIALIZED_RASTERIZER(tmus, 3) \
+	SPECIALIZED_RASTERIZER(tmus, 4)  SPECIALIZED_RASTERIZER(tmus, 5)  SPECIALIZED_RASTERIZER(tmus, 6)  SPECIALIZED_RASTERIZER(tmus, 7) \
+	SPECIALIZED_RASTERIZER(tmus, 8)  SPECIALIZED_RASTERIZER(tmus, 9)  SPECIALIZED_RASTERIZER(tmus, 10) SPECIALIZED_RASTERIZER(tmus, 11) \
+	SPECIALIZED_RASTERIZER(tmus, 12) SPECIALIZED_RASTERIZER(tmus, 13) SPECIALIZED_RASTERIZER(tmus, 14) SPECIALIZED_RASTERIZER(tmus, 15)
+
+#define SPECIALIZED_RASTERIZER_ENTRIES(tmus) \
+	{ raster_generic_##tmus##tmu_0,  raster_generic_##tmus##tmu_1,  raster_generic_##tmus##tmu_2,  raster_generic_##tmus##tmu_3, \
+	  raster_generic_##tmus##tmu_4,  raster_generic_##tmus##tmu_5,  raster_generic_##tmus##tmu_6,  raster_generic_##tmus##tmu_7, \
+	  raster_generic_##tmus##tmu_8,  raster_generic_##tmus##tmu_9,  raster_generic_##tmus##tmu_10, raster_generic_##tmus##tmu_11, \
+	  raster_generic_##tmus##tmu_12, raster_generic_##tmus##tmu_13, raster_generic_##tmus##tmu_14, raster_generic_##tmus##tmu_15 }
+
+SPECIALIZED_RASTERIZER_SET(0)
+SPECIALIZED_RASTERIZER_SET(1)
+SPECIALIZED_RASTERIZER_SET(2)
+
+static const poly_draw_scanline specialized_raster_table[3][16] =
+{
+	SPECIALIZED_RASTERIZER_ENTRIES(0),
+	SPECIALIZED_RASTERIZER_ENTRIES(1),
+	SPECIALIZED_RASTERIZER_ENTRIES(2)
+};
+
+
 #else
 
 
@@ -53,6 +53,12 @@
 
 #define NO_MATCH					(~0)
 
+#define CACHE_DEFAULT_MB			16			/* default size of the LRU hunk cache */
+#define CACHE_PREFETCH_HUNKS		8			/* max hunks to read ahead of a sequential reader */
+#define CACHE_SEQUENTIAL_RUN		2			/* sequential reads seen before we read ahead */
+
+#define MAX_COMPRESS_WORKERS		32			/* max hunks compressed in parallel */
+
 
 
 /***************************************************************************
@@ -77,7 +83,7 @@ struct _codec_interface
 	chd_error	(*init)(chd_file *chd);		/* codec initialize */
 	void 		(*free)(chd_file *chd);		/* codec free */
 	chd_error	(*compress)(chd_file *chd, const void *src, UINT32 *complen); /* compress data */
-	chd_error	(*decompress)(chd_file *chd, UINT32 complen, void *dst); /* decompress data */
+	chd_error	(*decompress)(chd_file *chd, const void *src, UINT32 complen, void *dst); /* decompress data */
 	chd_error	(*config)(chd_file *chd, int param, void *config); /* configure */
 };
 
@@ -102,6 +108,33 @@ struct _crcmap_entry
 };
 
 
+/* a single entry in the LRU hunk cache */
+typedef struct _cache_entry cache_entry;
+struct _cache_entry
+{
+	cache_entry *			hashnext;		/* next entry in the hash chain */
+	cache_entry *			prev;			/* previous (more recently used) entry */
+	cache_entry *			next;			/* next (less recently used) entry */
+	UINT32					hunknum;		/* hunk number, or ~0 if empty */
+	UINT32					length;			/* bytes of data (raw entries only) */
+	UINT8 *					data;			/* pointer to the hunk data */
+};
+
+
+/* a hunk being compressed by a worker, with its own copy of the codec state */
+typedef struct _compress_slot compress_slot;
+struct _compress_slot
+{
+	chd_file *				worker;			/* private CHD copy holding the codec state and buffers */
+	osd_work_item *			workitem;		/* work item compressing this hunk, or NULL if idle */
+	UINT8 *					data;			/* copy of the raw hunk data */
+	UINT32					crc;			/* CRC of the (decompressed, if lossy) data */
+	UINT32					length;			/* compressed length */
+	UINT8					mini;			/* can this be stored as a mini hunk? */
+	chd_error				err;			/* result of compression */
+};
+
+
 /* a single metadata entry */
 typedef struct _metadata_entry metadata_entry;
 struct _metadata_entry
@@ -147,6 +180,10 @@ struct _chd_file
 	struct MD5Context		compmd5; 		/* running MD5 during compression */
 	struct sha1_ctx			compsha1; 		/* running SHA1 during compression */
 	UINT32					comphunk;		/* next hunk we will compress */
+	osd_work_queue *		compqueue;		/* work queue for parallel compression */
+	compress_slot *			compslot;		/* ring of parallel compression slots */
+	UINT32					compslots;		/* number of compression slots, or 0 if serial */
+	UINT32					compwrite;		/* next hunk to be written by the pipeline */
 
 	UINT8					verifying;		/* are we verifying? */
 	struct MD5Context		vermd5; 		/* running MD5 during verification */
@@ -157,6 +194,20 @@ struct _chd_file
 	osd_work_item *			workitem;		/* active work item, or NULL if none */
 	UINT32					async_hunknum;	/* hunk index for asynchronous operations */
 	void *					async_buffer;	/* buffer pointer for asynchronous operations */
+
+	cache_entry *			lrulist;		/* array of LRU hunk cache entries */
+	cache_entry **			lruhash;		/* hash table of cached hunks */
+	cache_entry *			lruhead;		/* most recently used entry */
+	cache_entry *			lrutail;		/* least recently used entry */
+	UINT32					lrucount;		/* number of LRU cache entries, or 0 if disabled */
+	UINT32					lruhashmask;	/* mask for the LRU hash table */
+	UINT8					lruraw;			/* cache raw file data instead of decoded hunks? */
+	UINT32					seqnext;		/* next hunk expected by a sequential reader */
+	UINT32					seqcount;		/* length of the current sequential run */
+	osd_work_item *			prefetchitem;	/* active read-ahead work item, or NULL if none */
+	UINT32					prefetchhunk;	/* first hunk to read ahead */
+	UINT32					prefetchcount;	/* number of hunks to read ahead */
+	volatile UINT8			prefetchabort;	/* set to stop a read-ahead early */
 };
 
 
@@ -187,6 +238,9 @@ struct _av_codec_data
 static const UINT8 nullmd5[CHD_MD5_BYTES] = { 0 };
 static const UINT8 nullsha1[CHD_SHA1_BYTES] = { 0 };
 
+static UINT32 cache_megabytes = CACHE_DEFAULT_MB;
+static UINT32 compress_workers = 0;
+
 
 
 /***************************************************************************
@@ -196,6 +250,8 @@ static const UINT8 nullsha1[CHD_SHA1_BYTES] = { 0 };
 /* internal async operations */
 static void *async_read_callback(void *param, int threadid);
 static void *async_write_callback(void *param, int threadid);
+static void *prefetch_callback(void *param, int threadid);
+static void *compress_hunk_callback(void *param, int threadid);
 
 /* internal header operations */
 static chd_error header_validate(const chd_header *header);
@@ -206,6 +262,24 @@ static chd_error header_write(core_file *file, const chd_header *header);
 static chd_error hunk_read_into_cache(chd_file *chd, UINT32 hunknum);
 static chd_error hunk_read_into_memory(chd_file *chd, UINT32 hunknum, UINT8 *dest);
 static chd_error hunk_write_from_memory(chd_file *chd, UINT32 hunknum, const UINT8 *src);
+static chd_error hunk_write_entry(chd_file *chd, UINT32 hunknum, map_entry *newentry, const void *data);
+static chd_error hunk_read_raw(chd_file *chd, UINT32 hunknum, UINT8 *dest, UINT32 *length);
+static chd_error hunk_decode_raw(chd_file *chd, UINT32 hunknum, const UINT8 *source, UINT32 length, UINT8 *dest);
+
+/* internal LRU hunk cache */
+static chd_error cache_init(chd_file *chd);
+static void cache_free(chd_file *chd);
+static chd_error cache_read(chd_file *chd, UINT32 hunknum, UINT8 *dest);
+static chd_error cache_fill(chd_file *chd, cache_entry *entry, UINT32 hunknum);
+static void cache_invalidate(chd_file *chd, UINT32 hunknum);
+static void cache_start_prefetch(chd_file *chd);
+
+/* internal compression pipeline */
+static chd_error compress_pipeline_init(chd_file *chd);
+static chd_error compress_pipeline_free(chd_file *chd);
+static chd_error compress_pipeline_retire(chd_file *chd);
+static chd_error compress_pipeline_write(chd_file *chd, UINT32 hunknum, compress_slot *slot);
+static void compress_log_hunk(chd_file *chd, UINT32 hunknum, const UINT8 *crcdata);
 
 /* internal map access */
 static chd_error map_write_initial(core_file *file, chd_file *parent, const chd_header *header);
@@ -225,7 +299,7 @@ static chd_error metadata_set_length(chd_file *chd, UINT64 offset, UINT32 length
 static chd_error zlib_codec_init(chd_file *chd);
 static void zlib_codec_free(chd_file *chd);
 static chd_error zlib_codec_compress(chd_file *chd, const void *src, UINT32 *length);
-static chd_error zlib_codec_decompress(chd_file *chd, UINT32 srclength, void *dest);
+static chd_error zlib_codec_decompress(chd_file *chd, const void *src, UINT32 srclength, void *dest);
 static voidpf zlib_fast_alloc(voidpf opaque, uInt items, uInt size);
 static void zlib_fast_free(voidpf opaque, voidpf address);
 
@@ -233,7 +307,7 @@ static void zlib_fast_free(voidpf opaque, voidpf address);
 static chd_error av_codec_init(chd_file *chd);
 static void av_codec_free(chd_file *chd);
 static chd_error av_codec_compress(chd_file *chd, const void *src, UINT32 *length);
-static chd_error av_codec_decompress(chd_file *chd, UINT32 srclength, void *dest);
+static chd_error av_codec_decompress(chd_file *chd, const void *src, UINT32 srclength, void *dest);
 static chd_error av_codec_config(chd_file *chd, int param, void *config);
 static chd_error av_codec_postinit(chd_file *chd);
 
@@ -426,6 +500,104 @@ INLINE void map_extract_old(const UINT8 *base, map_entry *entry, UINT32 hunkbyte
 }
 
 
+/*-------------------------------------------------
+    cache_unlink - remove an entry from the LRU
+    list
+-------------------------------------------------*/
+
+INLINE void cache_unlink(chd_file *chd, cache_entry *entry)
+{
+	if (entry->prev != NULL)
+		entry->prev->next = entry->next;
+	else
+		chd->lruhead = entry->next;
+	if (entry->next != NULL)
+		entry->next->prev = entry->prev;
+	else
+		chd->lrutail = entry->prev;
+}
+
+
+/*-------------------------------------------------
+    cache_touch - move an entry to the head of
+    the LRU list
+-------------------------------------------------*/
+
+INLINE void cache_touch(chd_file *chd, cache_entry *entry)
+{
+	if (chd->lruhead == entry)
+		return;
+	cache_unlink(chd, entry);
+	entry->prev = NULL;
+	entry->next = chd->lruhead;
+	chd->lruhead->prev = entry;
+	chd->lruhead = entry;
+}
+
+
+/*-------------------------------------------------
+    cache_lookup - find the cache entry holding
+    a given hunk, or NULL if not cached
+-------------------------------------------------*/
+
+INLINE cache_entry *cache_lookup(chd_file *chd, UINT32 hunknum)
+{
+	cache_entry *entry;
+
+	for (entry = chd->lruhash[hunknum & chd->lruhashmask]; entry != NULL; entry = entry->hashnext)
+		if (entry->hunknum == hunknum)
+			return entry;
+	return NULL;
+}
+
+
+/*-------------------------------------------------
+    cache_unhash - remove an entry from its hash
+    chain and mark it empty
+-------------------------------------------------*/
+
+INLINE void cache_unhash(chd_file *chd, cache_entry *entry)
+{
+	cache_entry **linkptr;
+
+	for (linkptr = &chd->lruhash[entry->hunknum & chd->lruhashmask]; *linkptr != NULL; linkptr = &(*linkptr)->hashnext)
+		if (*linkptr == entry)
+		{
+			*linkptr = entry->hashnext;
+			break;
+		}
+	entry->hashnext = NULL;
+	entry->hunknum = ~0;
+}
+
+
+/*-------------------------------------------------
+    cache_is_cacheable - return TRUE if the given
+    hunk is worth holding in the LRU cache
+-------------------------------------------------*/
+
+INLINE int cache_is_cacheable(chd_file *chd, UINT32 hunknum)
+{
+	const map_entry *entry = &chd->map[hunknum];
+	UINT8 type = entry->flags & MAP_ENTRY_FLAG_TYPE_MASK;
+
+	/* mini hunks are cheaper to rebuild than to copy */
+	if (chd->lrucount == 0 || type == MAP_ENTRY_TYPE_MINI)
+		return FALSE;
+
+	/* raw caching only helps data that actually comes off the disk */
+	if (chd->lruraw)
+	{
+		if (type == MAP_ENTRY_TYPE_COMPRESSED)
+			return (core_fmap(chd->file, entry->offset, entry->length) == NULL);
+		if (type == MAP_ENTRY_TYPE_UNCOMPRESSED)
+			return (core_fmap(chd->file, entry->offset, chd->header.hunkbytes) == NULL);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+
 /*-------------------------------------------------
     queue_async_operation - queue a new work
     item
@@ -461,6 +633,16 @@ INLINE int queue_async_operation(chd_file *chd, osd_work_callback callback)
 
 INLINE void wait_for_pending_async(chd_file *chd)
 {
+	/* stop any read-ahead at the next hunk boundary and wait for it */
+	if (chd->prefetchitem != NULL)
+	{
+		chd->prefetchabort = TRUE;
+		if (!osd_work_item_wait(chd->prefetchitem, 10 * osd_ticks_per_second()))
+			osd_break_into_debugger("Pending read-ahead never completed!");
+		osd_work_item_release(chd->prefetchitem);
+		chd->prefetchitem = NULL;
+	}
+
 	/* if something is pending, wait for it */
 	if (chd->workitem != NULL)
 	{
@@ -670,6 +852,11 @@ chd_error chd_open_file(core_file *file, int mode, chd_file *parent, chd_file **
 	if (err != CHDERR_NONE)
 		EARLY_EXIT(err);
 
+	/* set up the LRU hunk cache */
+	err = cache_init(newchd);
+	if (err != CHDERR_NONE)
+		EARLY_EXIT(err);
+
 	/* all done */
 	*chd = newchd;
 	return CHDERR_NONE;
@@ -774,6 +961,9 @@ void chd_close(chd_file *chd)
 	/* wait for any pending async operations */
 	wait_for_pending_async(chd);
 
+	/* abandon any compression in progress */
+	compress_pipeline_free(chd);
+
 	/* kill the work queue and any work item */
 	if (chd->workitem != NULL)
 		osd_work_item_release(chd->workitem);
@@ -788,6 +978,9 @@ void chd_close(chd_file *chd)
 	if (chd->compressed != NULL)
 		free(chd->compressed);
 
+	/* free the LRU hunk cache */
+	cache_free(chd);
+
 	/* free the hunk cache and compare data */
 	if (chd->compare != NULL)
 		free(chd->compare);
@@ -830,6 +1023,29 @@ core_file *chd_core_file(chd_file *chd)
 }
 
 
+/*-------------------------------------------------
+    chd_set_cache_size - set the size of the LRU
+    hunk cache for files opened from now on
+-------------------------------------------------*/
+
+void chd_set_cache_size(UINT32 megabytes)
+{
+	cache_megabytes = megabytes;
+}
+
+
+/*-------------------------------------------------
+    chd_set_compress_workers - set how many hunks
+    are compressed in parallel, each with its
+    own codec state
+-------------------------------------------------*/
+
+void chd_set_compress_workers(UINT32 workers)
+{
+	compress_workers = MIN(workers, MAX_COMPRESS_WORKERS);
+}
+
+
 /*-------------------------------------------------
     chd_multi_filename - compute the indexed CHD
     filename
@@ -969,6 +1185,8 @@ cleanup:
 
 chd_error chd_read(chd_file *chd, UINT32 hunknum, void *buffer)
 {
+	chd_error err;
+
 	/* punt if NULL or invalid */
 	if (chd == NULL || chd->cookie != COOKIE_VALUE)
 		return CHDERR_INVALID_PARAMETER;
@@ -980,8 +1198,11 @@ chd_error chd_read(chd_file *chd, UINT32 hunknum, void *buffer)
 	/* wait for any pending async operations */
 	wait_for_pending_async(chd);
 
-	/* perform the read */
-	return hunk_read_into_memory(chd, hunknum, buffer);
+	/* perform the read, then read ahead if the access looks sequential */
+	err = cache_read(chd, hunknum, buffer);
+	if (err == CHDERR_NONE)
+		cache_start_prefetch(chd);
+	return err;
 }
 
 
@@ -1092,6 +1313,9 @@ chd_error chd_async_complete(chd_file *chd)
 	osd_work_item_release(chd->workitem);
 	chd->workitem = NULL;
 
+	/* use the idle time until the next request to read ahead */
+	cache_start_prefetch(chd);
+
 	return (chd_error)result;
 }
 
@@ -1342,7 +1566,8 @@ chd_error chd_compress_begin(chd_file *chd)
 	chd->compressing = TRUE;
 	chd->comphunk = 0;
 
-	return CHDERR_NONE;
+	/* spread the work across multiple codecs if asked to */
+	return compress_pipeline_init(chd);
 }
 
 
@@ -1354,49 +1579,49 @@ chd_error chd_compress_begin(chd_file *chd)
 chd_error chd_compress_hunk(chd_file *chd, const void *data, double *curratio)
 {
 	UINT32 thishunk = chd->comphunk++;
-	UINT64 sourceoffset = (UINT64)thishunk * (UINT64)chd->header.hunkbytes;
-	UINT32 bytestochecksum;
-	const void *crcdata;
+	UINT32 hunkswritten = chd->comphunk;
+	compress_slot *slot;
 	chd_error err;
 
 	/* error if in the wrong state */
 	if (!chd->compressing)
 		return CHDERR_INVALID_STATE;
 
-	/* write out the hunk */
-	err = hunk_write_from_memory(chd, thishunk, data);
-	if (err != CHDERR_NONE)
-		return err;
-
-	/* if we are lossy, then we need to use the decompressed version in */
-	/* the cache as our MD5/SHA1 source */
-	crcdata = chd->codecintf->lossy ? chd->cache : data;
-
-	/* update the MD5/SHA1 */
-	bytestochecksum = chd->header.hunkbytes;
-	if (sourceoffset + chd->header.hunkbytes > chd->header.logicalbytes)
+	/* serial case: write out the hunk and log it right away */
+	if (chd->compslots == 0)
 	{
-		if (sourceoffset >= chd->header.logicalbytes)
-			bytestochecksum = 0;
-		else
-			bytestochecksum = chd->header.logicalbytes - sourceoffset;
+		err = hunk_write_from_memory(chd, thishunk, data);
+		if (err != CHDERR_NONE)
+			return err;
+
+		/* if we are lossy, then we need to use the decompressed version in */
+		/* the cache as our MD5/SHA1 source */
+		compress_log_hunk(chd, thishunk, chd->codecintf->lossy ? chd->cache : data);
 	}
-	if (bytestochecksum > 0)
+
+	/* parallel case: hand the hunk to a worker, writing out older hunks to free its slot */
+	else
 	{
-		MD5Update(&chd->compmd5, crcdata, bytestochecksum);
-		sha1_update(&chd->compsha1, bytestochecksum, crcdata);
-	}
+		while (chd->compwrite + chd->compslots <= thishunk)
+		{
+			err = compress_pipeline_retire(chd);
+			if (err != CHDERR_NONE)
+				return err;
+		}
 
-	/* update our CRC map */
-	if ((chd->map[thishunk].flags & MAP_ENTRY_FLAG_TYPE_MASK) != MAP_ENTRY_TYPE_SELF_HUNK &&
-		(chd->map[thishunk].flags & MAP_ENTRY_FLAG_TYPE_MASK) != MAP_ENTRY_TYPE_PARENT_HUNK)
-		crcmap_add_entry(chd, thishunk);
+		slot = &chd->compslot[thishunk % chd->compslots];
+		memcpy(slot->data, data, chd->header.hunkbytes);
+		slot->workitem = osd_work_item_queue(chd->compqueue, compress_hunk_callback, slot, 0);
+		if (slot->workitem == NULL)
+			compress_hunk_callback(slot, 0);
+		hunkswritten = chd->compwrite;
+	}
 
 	/* update the ratio */
-	if (curratio != NULL)
+	if (curratio != NULL && hunkswritten > 0)
 	{
 		UINT64 curlength = core_fsize(chd->file);
-		*curratio = 1.0 - (double)curlength / (double)((UINT64)chd->comphunk * (UINT64)chd->header.hunkbytes);
+		*curratio = 1.0 - (double)curlength / (double)((UINT64)hunkswritten * (UINT64)chd->header.hunkbytes);
 	}
 
 	return CHDERR_NONE;
@@ -1410,10 +1635,22 @@ chd_error chd_compress_hunk(chd_file *chd, const void *data, double *curratio)
 
 chd_error chd_compress_finish(chd_file *chd)
 {
+	chd_error err = CHDERR_NONE;
+	chd_error freeerr;
+
 	/* error if in the wrong state */
 	if (!chd->compressing)
 		return CHDERR_INVALID_STATE;
 
+	/* drain the pipeline */
+	while (chd->compslots != 0 && chd->compwrite < chd->comphunk && err == CHDERR_NONE)
+		err = compress_pipeline_retire(chd);
+	freeerr = compress_pipeline_free(chd);
+	if (err == CHDERR_NONE)
+		err = freeerr;
+	if (err != CHDERR_NONE)
+		return err;
+
 	/* compute the final MD5/SHA1 values */
 	MD5Final(chd->header.md5, &chd->compmd5);
 	sha1_final(&chd->compsha1);
@@ -1584,8 +1821,8 @@ static void *async_read_callback(void *param, int threadid)
 	chd_file *chd = param;
 	chd_error err;
 
-	/* read the hunk into the cache */
-	err = hunk_read_into_memory(chd, chd->async_hunknum, chd->async_buffer);
+	/* read the hunk through the cache */
+	err = cache_read(chd, chd->async_hunknum, chd->async_buffer);
 
 	/* return the error */
 	return (void *)err;
@@ -1610,6 +1847,70 @@ static void *async_write_callback(void *param, int threadid)
 }
 
 
+/*-------------------------------------------------
+    compress_hunk_callback - compress one hunk
+    of a parallel compression
+-------------------------------------------------*/
+
+static void *compress_hunk_callback(void *param, int threadid)
+{
+	compress_slot *slot = param;
+	chd_file *worker = slot->worker;
+	UINT32 bytes;
+
+	/* first compute the CRC of the original data */
+	slot->crc = crc32(0, slot->data, worker->header.hunkbytes);
+	slot->mini = FALSE;
+
+	/* see if we can mini-compress; matching other hunks is left to the writer */
+	if (!worker->codecintf->lossy && worker->header.compression >= CHDCOMPRESSION_ZLIB_PLUS)
+	{
+		for (bytes = 8; bytes < worker->header.hunkbytes; bytes++)
+			if (slot->data[bytes] != slot->data[bytes - 8])
+				break;
+		if (bytes == worker->header.hunkbytes)
+		{
+			slot->mini = TRUE;
+			return NULL;
+		}
+	}
+
+	/* compress into the worker's buffer */
+	slot->err = CHDERR_COMPRESSION_ERROR;
+	if (worker->codecintf->compress != NULL)
+		slot->err = (*worker->codecintf->compress)(worker, slot->data, &slot->length);
+
+	/* if that worked, and we're lossy, decompress and CRC the result */
+	if (slot->err == CHDERR_NONE && worker->codecintf->lossy)
+	{
+		slot->err = (*worker->codecintf->decompress)(worker, worker->compressed, slot->length, worker->cache);
+		if (slot->err == CHDERR_NONE)
+			slot->crc = crc32(0, worker->cache, worker->header.hunkbytes);
+	}
+	return NULL;
+}
+
+
+/*-------------------------------------------------
+    prefetch_callback - read ahead of a
+    sequential reader into the LRU cache
+-------------------------------------------------*/
+
+static void *prefetch_callback(void *param, int threadid)
+{
+	chd_file *chd = param;
+	UINT32 hunknum;
+
+	/* fill entries until done or asked to stop */
+	for (hunknum = chd->prefetchhunk; hunknum < chd->prefetchhunk + chd->prefetchcount && !chd->prefetchabort; hunknum++)
+		if (cache_is_cacheable(chd, hunknum) && cache_lookup(chd, hunknum) == NULL)
+			if (cache_fill(chd, chd->lrutail, hunknum) != CHDERR_NONE)
+				break;
+
+	return NULL;
+}
+
+
 
 /***************************************************************************
     INTERNAL HEADER OPERATIONS
@@ -1855,28 +2156,44 @@ static chd_error hunk_read_into_memory(chd_file *chd, UINT32 hunknum, UINT8 *des
 	{
 		/* compressed data */
 		case MAP_ENTRY_TYPE_COMPRESSED:
+		{
+			/* decompress straight out of the file mapping if we have one */
+			const void *source = core_fmap(chd->file, entry->offset, entry->length);
 
-			/* read it into the decompression buffer */
-			core_fseek(chd->file, entry->offset, SEEK_SET);
-			bytes = core_fread(chd->file, chd->compressed, entry->length);
-			if (bytes != entry->length)
-				return CHDERR_READ_ERROR;
+			/* otherwise, read it into the decompression buffer */
+			if (source == NULL)
+			{
+				core_fseek(chd->file, entry->offset, SEEK_SET);
+				bytes = core_fread(chd->file, chd->compressed, entry->length);
+				if (bytes != entry->length)
+					return CHDERR_READ_ERROR;
+				source = chd->compressed;
+			}
 
 			/* now decompress using the codec */
 			err = CHDERR_NONE;
 			if (chd->codecintf->decompress != NULL)
-				err = (*chd->codecintf->decompress)(chd, entry->length, dest);
+				err = (*chd->codecintf->decompress)(chd, source, entry->length, dest);
 			if (err != CHDERR_NONE)
 				return err;
 			break;
+		}
 
 		/* uncompressed data */
 		case MAP_ENTRY_TYPE_UNCOMPRESSED:
-			core_fseek(chd->file, entry->offset, SEEK_SET);
-			bytes = core_fread(chd->file, dest, chd->header.hunkbytes);
-			if (bytes != chd->header.hunkbytes)
-				return CHDERR_READ_ERROR;
+		{
+			const void *source = core_fmap(chd->file, entry->offset, chd->header.hunkbytes);
+			if (source != NULL)
+				memcpy(dest, source, chd->header.hunkbytes);
+			else
+			{
+				core_fseek(chd->file, entry->offset, SEEK_SET);
+				bytes = core_fread(chd->file, dest, chd->header.hunkbytes);
+				if (bytes != chd->header.hunkbytes)
+					return CHDERR_READ_ERROR;
+			}
 			break;
+		}
 
 		/* mini-compressed data */
 		case MAP_ENTRY_TYPE_MINI:
@@ -1909,17 +2226,11 @@ static chd_error hunk_read_into_memory(chd_file *chd, UINT32 hunknum, UINT8 *des
 
 static chd_error hunk_write_from_memory(chd_file *chd, UINT32 hunknum, const UINT8 *src)
 {
-	map_entry *entry = &chd->map[hunknum];
 	map_entry newentry;
-	UINT8 fileentry[MAP_ENTRY_SIZE];
 	const void *data = src;
 	UINT32 bytes = 0, match;
 	chd_error err;
 
-	/* track the max */
-	if (hunknum > chd->maxhunk)
-		chd->maxhunk = hunknum;
-
 	/* first compute the CRC of the original data */
 	newentry.crc = crc32(0, &src[0], chd->header.hunkbytes);
 
@@ -1940,7 +2251,7 @@ static chd_error hunk_write_from_memory(chd_file *chd, UINT32 hunknum, const UIN
 				newentry.offset = get_bigendian_uint64(&src[0]);
 				newentry.length = 0;
 				newentry.flags = MAP_ENTRY_TYPE_MINI;
-				goto write_entry;
+				return hunk_write_entry(chd, hunknum, &newentry, NULL);
 			}
 
 			/* otherwise, see if we can find a match in the current file */
@@ -1950,7 +2261,7 @@ static chd_error hunk_write_from_memory(chd_file *chd, UINT32 hunknum, const UIN
 				newentry.offset = match;
 				newentry.length = 0;
 				newentry.flags = MAP_ENTRY_TYPE_SELF_HUNK;
-				goto write_entry;
+				return hunk_write_entry(chd, hunknum, &newentry, NULL);
 			}
 
 			/* if we have a parent, see if we can find a match in there */
@@ -1962,7 +2273,7 @@ static chd_error hunk_write_from_memory(chd_file *chd, UINT32 hunknum, const UIN
 					newentry.offset = match;
 					newentry.length = 0;
 					newentry.flags = MAP_ENTRY_TYPE_PARENT_HUNK;
-					goto write_entry;
+					return hunk_write_entry(chd, hunknum, &newentry, NULL);
 				}
 			}
 		}
@@ -1976,7 +2287,7 @@ static chd_error hunk_write_from_memory(chd_file *chd, UINT32 hunknum, const UIN
 	/* if that worked, and we're lossy, decompress and CRC the result */
 	if (err == CHDERR_NONE && chd->codecintf->lossy)
 	{
-		err = (*chd->codecintf->decompress)(chd, bytes, chd->cache);
+		err = (*chd->codecintf->decompress)(chd, chd->compressed, bytes, chd->cache);
 		if (err == CHDERR_NONE)
 			newentry.crc = crc32(0, chd->cache, chd->header.hunkbytes);
 	}
@@ -1995,21 +2306,44 @@ static chd_error hunk_write_from_memory(chd_file *chd, UINT32 hunknum, const UIN
 		newentry.length = chd->header.hunkbytes;
 		newentry.flags = MAP_ENTRY_TYPE_UNCOMPRESSED;
 	}
+	return hunk_write_entry(chd, hunknum, &newentry, data);
+}
 
-	/* if the data doesn't fit into the previous entry, make a new one at the eof */
-	newentry.offset = entry->offset;
-	if (newentry.offset == 0 || newentry.length > entry->length)
-		newentry.offset = core_fsize(chd->file);
 
-	/* write the data */
-	core_fseek(chd->file, newentry.offset, SEEK_SET);
-	bytes = core_fwrite(chd->file, data, newentry.length);
-	if (bytes != newentry.length)
-		return CHDERR_WRITE_ERROR;
+/*-------------------------------------------------
+    hunk_write_entry - write a hunk's data (if
+    any) and its new map entry to the CHD
+-------------------------------------------------*/
+
+static chd_error hunk_write_entry(chd_file *chd, UINT32 hunknum, map_entry *newentry, const void *data)
+{
+	map_entry *entry = &chd->map[hunknum];
+	UINT8 fileentry[MAP_ENTRY_SIZE];
+	UINT32 bytes;
+
+	/* track the max */
+	if (hunknum > chd->maxhunk)
+		chd->maxhunk = hunknum;
+
+	/* any cached copy is about to go stale */
+	cache_invalidate(chd, hunknum);
+
+	/* write the data if there is any */
+	if (data != NULL)
+	{
+		/* if the data doesn't fit into the previous entry, make a new one at the eof */
+		newentry->offset = entry->offset;
+		if (newentry->offset == 0 || newentry->length > entry->length)
+			newentry->offset = core_fsize(chd->file);
+
+		core_fseek(chd->file, newentry->offset, SEEK_SET);
+		bytes = core_fwrite(chd->file, data, newentry->length);
+		if (bytes != newentry->length)
+			return CHDERR_WRITE_ERROR;
+	}
 
 	/* update the entry in memory */
-write_entry:
-	*entry = newentry;
+	*entry = *newentry;
 
 	/* update the map on file */
 	map_assemble(&fileentry[0], &chd->map[hunknum]);
@@ -2022,6 +2356,526 @@ write_entry:
 }
 
 
+/*-------------------------------------------------
+    hunk_read_raw - read the on-disk bytes of a
+    compressed or uncompressed hunk without
+    decoding them
+-------------------------------------------------*/
+
+static chd_error hunk_read_raw(chd_file *chd, UINT32 hunknum, UINT8 *dest, UINT32 *length)
+{
+	map_entry *entry = &chd->map[hunknum];
+	UINT32 bytes;
+
+	/* compressed hunks store their length; uncompressed hunks are always full size */
+	*length = ((entry->flags & MAP_ENTRY_FLAG_TYPE_MASK) == MAP_ENTRY_TYPE_COMPRESSED) ? entry->length : chd->header.hunkbytes;
+
+	core_fseek(chd->file, entry->offset, SEEK_SET);
+	bytes = core_fread(chd->file, dest, *length);
+	if (bytes != *length)
+		return CHDERR_READ_ERROR;
+	return CHDERR_NONE;
+}
+
+
+/*-------------------------------------------------
+    hunk_decode_raw - decode bytes previously
+    fetched by hunk_read_raw into memory
+-------------------------------------------------*/
+
+static chd_error hunk_decode_raw(chd_file *chd, UINT32 hunknum, const UINT8 *source, UINT32 length, UINT8 *dest)
+{
+	/* uncompressed data is just a copy */
+	if ((chd->map[hunknum].flags & MAP_ENTRY_FLAG_TYPE_MASK) != MAP_ENTRY_TYPE_COMPRESSED)
+	{
+		memcpy(dest, source, chd->header.hunkbytes);
+		return CHDERR_NONE;
+	}
+
+	/* everything else goes through the codec */
+	if (chd->codecintf->decompress != NULL)
+		return (*chd->codecintf->decompress)(chd, source, length, dest);
+	return CHDERR_NONE;
+}
+
+
+
+/***************************************************************************
+    INTERNAL HUNK CACHE
+***************************************************************************/
+
+/*-------------------------------------------------
+    cache_init - set up the LRU hunk cache;
+    hunk buffers are allocated as they are
+    first used
+-------------------------------------------------*/
+
+static chd_error cache_init(chd_file *chd)
+{
+	UINT64 maxhunks = ((UINT64)cache_megabytes << 20) / chd->header.hunkbytes;
+	UINT32 count = (maxhunks < chd->header.totalhunks) ? (UINT32)maxhunks : chd->header.totalhunks;
+	UINT32 hashsize, entnum;
+
+	/* a cache of one hunk is no better than none */
+	if (count < 2)
+		return CHDERR_NONE;
+
+	/* allocate the entries and a power-of-two hash table */
+	for (hashsize = 1; hashsize < count; hashsize <<= 1) ;
+	chd->lrulist = malloc(count * sizeof(chd->lrulist[0]));
+	chd->lruhash = malloc(hashsize * sizeof(chd->lruhash[0]));
+	if (chd->lrulist == NULL || chd->lruhash == NULL)
+		return CHDERR_OUT_OF_MEMORY;
+	memset(chd->lruhash, 0, hashsize * sizeof(chd->lruhash[0]));
+
+	/* link all the entries, empty, into the LRU list */
+	for (entnum = 0; entnum < count; entnum++)
+	{
+		cache_entry *entry = &chd->lrulist[entnum];
+		entry->hashnext = NULL;
+		entry->prev = (entnum == 0) ? NULL : &chd->lrulist[entnum - 1];
+		entry->next = (entnum == count - 1) ? NULL : &chd->lrulist[entnum + 1];
+		entry->hunknum = ~0;
+		entry->length = 0;
+		entry->data = NULL;
+	}
+	chd->lruhead = &chd->lrulist[0];
+	chd->lrutail = &chd->lrulist[count - 1];
+	chd->lrucount = count;
+	chd->lruhashmask = hashsize - 1;
+
+	/* the A/V codec decodes into buffers configured by the caller, so only its raw data can be shared */
+	chd->lruraw = (chd->codecintf->config != NULL);
+	chd->seqnext = ~0;
+	return CHDERR_NONE;
+}
+
+
+/*-------------------------------------------------
+    cache_free - free the LRU hunk cache
+-------------------------------------------------*/
+
+static void cache_free(chd_file *chd)
+{
+	UINT32 entnum;
+
+	if (chd->lrulist != NULL)
+	{
+		for (entnum = 0; entnum < chd->lrucount; entnum++)
+			if (chd->lrulist[entnum].data != NULL)
+				free(chd->lrulist[entnum].data);
+		free(chd->lrulist);
+	}
+	if (chd->lruhash != NULL)
+		free(chd->lruhash);
+}
+
+
+/*-------------------------------------------------
+    cache_read - read a hunk into memory by way
+    of the LRU cache
+-------------------------------------------------*/
+
+static chd_error cache_read(chd_file *chd, UINT32 hunknum, UINT8 *dest)
+{
+	cache_entry *entry;
+	chd_error err;
+
+	/* track sequential runs; re-reading the current hunk doesn't break one */
+	if (hunknum == chd->seqnext)
+		chd->seqcount++;
+	else if (hunknum + 1 != chd->seqnext)
+		chd->seqcount = 0;
+	chd->seqnext = hunknum + 1;
+
+	/* anything we don't cache is read directly */
+	if (!cache_is_cacheable(chd, hunknum))
+		return hunk_read_into_memory(chd, hunknum, dest);
+
+	/* on a miss, recycle the least recently used entry */
+	entry = cache_lookup(chd, hunknum);
+	if (entry == NULL)
+	{
+		entry = chd->lrutail;
+		err = cache_fill(chd, entry, hunknum);
+		if (err == CHDERR_OUT_OF_MEMORY)
+			return hunk_read_into_memory(chd, hunknum, dest);
+		if (err != CHDERR_NONE)
+			return err;
+	}
+	else
+		cache_touch(chd, entry);
+
+	/* raw entries still need decoding; everything else is a straight copy */
+	if (chd->lruraw)
+		return hunk_decode_raw(chd, hunknum, entry->data, entry->length, dest);
+	memcpy(dest, entry->data, chd->header.hunkbytes);
+	return CHDERR_NONE;
+}
+
+
+/*-------------------------------------------------
+    cache_fill - load a hunk into the given
+    entry and make it most recently used
+-------------------------------------------------*/
+
+static chd_error cache_fill(chd_file *chd, cache_entry *entry, UINT32 hunknum)
+{
+	chd_error err;
+
+	/* evict whatever was there before */
+	if (entry->hunknum != ~0)
+		cache_unhash(chd, entry);
+
+	/* allocate the buffer the first time the entry is used */
+	if (entry->data == NULL)
+	{
+		entry->data = malloc(chd->header.hunkbytes);
+		if (entry->data == NULL)
+			return CHDERR_OUT_OF_MEMORY;
+	}
+
+	/* read the raw or decoded data */
+	if (chd->lruraw)
+		err = hunk_read_raw(chd, hunknum, entry->data, &entry->length);
+	else
+		err = hunk_read_into_memory(chd, hunknum, entry->data);
+	if (err != CHDERR_NONE)
+		return err;
+
+	/* hash it and move it to the head of the list */
+	entry->hunknum = hunknum;
+	entry->hashnext = chd->lruhash[hunknum & chd->lruhashmask];
+	chd->lruhash[hunknum & chd->lruhashmask] = entry;
+	cache_touch(chd, entry);
+	return CHDERR_NONE;
+}
+
+
+/*-------------------------------------------------
+    cache_invalidate - drop any cached copy of a
+    hunk
+-------------------------------------------------*/
+
+static void cache_invalidate(chd_file *chd, UINT32 hunknum)
+{
+	cache_entry *entry;
+
+	if (chd->lrucount == 0)
+		return;
+
+	entry = cache_lookup(chd, hunknum);
+	if (entry == NULL)
+		return;
+	cache_unhash(chd, entry);
+
+	/* move it to the tail so it is recycled first */
+	if (entry == chd->lrutail)
+		return;
+	cache_unlink(chd, entry);
+	entry->next = NULL;
+	entry->prev = chd->lrutail;
+	chd->lrutail->next = entry;
+	chd->lrutail = entry;
+}
+
+
+/*-------------------------------------------------
+    cache_start_prefetch - if the reader looks
+    sequential, queue a read-ahead of the next
+    few hunks
+-------------------------------------------------*/
+
+static void cache_start_prefetch(chd_file *chd)
+{
+	UINT32 count, hunknum;
+
+	/* only read ahead once a sequential run is established */
+	if (chd->lrucount == 0 || chd->prefetchitem != NULL || chd->seqcount < CACHE_SEQUENTIAL_RUN)
+		return;
+	if (chd->seqnext >= chd->header.totalhunks)
+		return;
+
+	/* never read far enough ahead to evict what the reader is working on */
+	count = MIN(CACHE_PREFETCH_HUNKS, chd->lrucount / 2);
+	count = MIN(count, chd->header.totalhunks - chd->seqnext);
+
+	/* nothing to do if it's all cached already */
+	for (hunknum = chd->seqnext; hunknum < chd->seqnext + count; hunknum++)
+		if (cache_is_cacheable(chd, hunknum) && cache_lookup(chd, hunknum) == NULL)
+			break;
+	if (hunknum == chd->seqnext + count)
+		return;
+
+	/* if no queue yet, create one on the fly */
+	if (chd->workqueue == NULL)
+	{
+		chd->workqueue = osd_work_queue_alloc(WORK_QUEUE_FLAG_IO);
+		if (chd->workqueue == NULL)
+			return;
+	}
+
+	/* queue the read-ahead; it stops early if a foreground request comes in */
+	chd->prefetchhunk = hunknum;
+	chd->prefetchcount = chd->seqnext + count - hunknum;
+	chd->prefetchabort = FALSE;
+	chd->prefetchitem = osd_work_item_queue(chd->workqueue, prefetch_callback, chd, 0);
+}
+
+
+
+/***************************************************************************
+    INTERNAL COMPRESSION PIPELINE
+***************************************************************************/
+
+/*-------------------------------------------------
+    compress_pipeline_init - set up the slots
+    for parallel compression, each with a
+    private copy of the codec
+-------------------------------------------------*/
+
+static chd_error compress_pipeline_init(chd_file *chd)
+{
+	UINT32 slotnum;
+	chd_error err;
+
+	/* nothing to do if compressing serially or not compressing at all */
+	if (compress_workers < 2 || chd->codecintf->compress == NULL)
+		return CHDERR_NONE;
+
+	/* allocate the queue and the slots */
+	chd->compqueue = osd_work_queue_alloc(WORK_QUEUE_FLAG_MULTI);
+	chd->compslot = malloc(compress_workers * sizeof(chd->compslot[0]));
+	if (chd->compqueue == NULL || chd->compslot == NULL)
+		EARLY_EXIT(err = CHDERR_OUT_OF_MEMORY);
+	memset(chd->compslot, 0, compress_workers * sizeof(chd->compslot[0]));
+	chd->compslots = compress_workers;
+	chd->compwrite = 0;
+
+	/* each slot gets a copy of the CHD with its own buffers and codec state */
+	for (slotnum = 0; slotnum < chd->compslots; slotnum++)
+	{
+		compress_slot *slot = &chd->compslot[slotnum];
+		chd_file *worker;
+
+		slot->data = malloc(chd->header.hunkbytes);
+		slot->worker = worker = malloc(sizeof(*worker));
+		if (slot->data == NULL || worker == NULL)
+			EARLY_EXIT(err = CHDERR_OUT_OF_MEMORY);
+
+		/* the copy shares the header, file and map but owns nothing else */
+		memcpy(worker, chd, sizeof(*worker));
+		worker->codecdata = NULL;
+		worker->workitem = NULL;
+		worker->prefetchitem = NULL;
+		worker->lrucount = 0;
+		worker->compqueue = NULL;
+		worker->compslot = NULL;
+		worker->compslots = 0;
+		worker->compressed = malloc(chd->header.hunkbytes);
+		worker->cache = malloc(chd->header.hunkbytes);
+		if (worker->compressed == NULL || worker->cache == NULL)
+			EARLY_EXIT(err = CHDERR_OUT_OF_MEMORY);
+
+		/* initialize the codec here, where it is still safe to read metadata */
+		if (worker->codecintf->init != NULL)
+		{
+			err = (*worker->codecintf->init)(worker);
+			if (err != CHDERR_NONE)
+			{
+				worker->codecdata = NULL;
+				EARLY_EXIT(err);
+			}
+		}
+	}
+	return CHDERR_NONE;
+
+cleanup:
+	compress_pipeline_free(chd);
+	return err;
+}
+
+
+/*-------------------------------------------------
+    compress_pipeline_free - wait for any
+    outstanding workers and free the slots
+-------------------------------------------------*/
+
+static chd_error compress_pipeline_free(chd_file *chd)
+{
+	UINT32 slotnum;
+
+	/* wait for everything to finish */
+	if (chd->compqueue != NULL)
+	{
+		/* if a worker is stuck, abandon the queue and slots rather than free them under it */
+		if (!osd_work_queue_wait(chd->compqueue, 100 * osd_ticks_per_second()))
+		{
+			osd_break_into_debugger("Pending compression never completed!");
+			chd->compqueue = NULL;
+			chd->compslot = NULL;
+			chd->compslots = 0;
+			return CHDERR_OPERATION_PENDING;
+		}
+		osd_work_queue_free(chd->compqueue);
+		chd->compqueue = NULL;
+	}
+
+	/* free the slots and their codecs */
+	if (chd->compslot != NULL)
+	{
+		for (slotnum = 0; slotnum < chd->compslots; slotnum++)
+		{
+			compress_slot *slot = &chd->compslot[slotnum];
+			chd_file *worker = slot->worker;
+
+			if (slot->workitem != NULL)
+				osd_work_item_release(slot->workitem);
+			if (worker != NULL)
+			{
+				if (worker->codecdata != NULL && worker->codecintf->free != NULL)
+					(*worker->codecintf->free)(worker);
+				if (worker->compressed != NULL)
+					free(worker->compressed);
+				if (worker->cache != NULL)
+					free(worker->cache);
+				free(worker);
+			}
+			if (slot->data != NULL)
+				free(slot->data);
+		}
+		free(chd->compslot);
+		chd->compslot = NULL;
+	}
+	chd->compslots = 0;
+	return CHDERR_NONE;
+}
+
+
+/*-------------------------------------------------
+    compress_pipeline_retire - wait for the
+    oldest hunk in the pipeline and write it out
+-------------------------------------------------*/
+
+static chd_error compress_pipeline_retire(chd_file *chd)
+{
+	UINT32 thishunk = chd->compwrite++;
+	compress_slot *slot = &chd->compslot[thishunk % chd->compslots];
+	chd_error err;
+
+	/* wait for the worker to finish; if it never does, leave the slot to compress_pipeline_free */
+	if (slot->workitem != NULL)
+	{
+		if (!osd_work_item_wait(slot->workitem, 100 * osd_ticks_per_second()))
+		{
+			osd_break_into_debugger("Compression worker never completed!");
+			return CHDERR_OPERATION_PENDING;
+		}
+		osd_work_item_release(slot->workitem);
+		slot->workitem = NULL;
+	}
+
+	/* write it, then log it; lossy data is checksummed as decompressed */
+	err = compress_pipeline_write(chd, thishunk, slot);
+	if (err != CHDERR_NONE)
+		return err;
+	compress_log_hunk(chd, thishunk, chd->codecintf->lossy ? slot->worker->cache : slot->data);
+	return CHDERR_NONE;
+}
+
+
+/*-------------------------------------------------
+    compress_pipeline_write - match a compressed
+    hunk against earlier ones and write it out;
+    this must happen in hunk order
+-------------------------------------------------*/
+
+static chd_error compress_pipeline_write(chd_file *chd, UINT32 hunknum, compress_slot *slot)
+{
+	map_entry newentry;
+	UINT32 match;
+
+	newentry.crc = slot->crc;
+
+	/* mini hunks need no data */
+	if (slot->mini)
+	{
+		newentry.offset = get_bigendian_uint64(&slot->data[0]);
+		newentry.length = 0;
+		newentry.flags = MAP_ENTRY_TYPE_MINI;
+		return hunk_write_entry(chd, hunknum, &newentry, NULL);
+	}
+
+	/* look for a match in this file or the parent; only now are all earlier hunks in the CRC map */
+	if (!chd->codecintf->lossy && chd->header.compression >= CHDCOMPRESSION_ZLIB_PLUS)
+	{
+		match = crcmap_find_hunk(chd, hunknum, newentry.crc, slot->data);
+		if (match != NO_MATCH)
+		{
+			newentry.offset = match;
+			newentry.length = 0;
+			newentry.flags = MAP_ENTRY_TYPE_SELF_HUNK;
+			return hunk_write_entry(chd, hunknum, &newentry, NULL);
+		}
+
+		if (chd->header.flags & CHDFLAGS_HAS_PARENT)
+		{
+			match = crcmap_find_hunk(chd->parent, ~0, newentry.crc, slot->data);
+			if (match != NO_MATCH)
+			{
+				newentry.offset = match;
+				newentry.length = 0;
+				newentry.flags = MAP_ENTRY_TYPE_PARENT_HUNK;
+				return hunk_write_entry(chd, hunknum, &newentry, NULL);
+			}
+		}
+	}
+
+	/* otherwise write the compressed data, or the raw data if that failed */
+	if (slot->err == CHDERR_NONE)
+	{
+		newentry.length = slot->length;
+		newentry.flags = MAP_ENTRY_TYPE_COMPRESSED;
+		return hunk_write_entry(chd, hunknum, &newentry, slot->worker->compressed);
+	}
+	newentry.length = chd->header.hunkbytes;
+	newentry.flags = MAP_ENTRY_TYPE_UNCOMPRESSED;
+	return hunk_write_entry(chd, hunknum, &newentry, slot->data);
+}
+
+
+/*-------------------------------------------------
+    compress_log_hunk - fold a written hunk into
+    the running MD5/SHA1 and the CRC map
+-------------------------------------------------*/
+
+static void compress_log_hunk(chd_file *chd, UINT32 hunknum, const UINT8 *crcdata)
+{
+	UINT64 sourceoffset = (UINT64)hunknum * (UINT64)chd->header.hunkbytes;
+	UINT32 bytestochecksum;
+
+	/* update the MD5/SHA1 */
+	bytestochecksum = chd->header.hunkbytes;
+	if (sourceoffset + chd->header.hunkbytes > chd->header.logicalbytes)
+	{
+		if (sourceoffset >= chd->header.logicalbytes)
+			bytestochecksum = 0;
+		else
+			bytestochecksum = chd->header.logicalbytes - sourceoffset;
+	}
+	if (bytestochecksum > 0)
+	{
+		MD5Update(&chd->compmd5, crcdata, bytestochecksum);
+		sha1_update(&chd->compsha1, bytestochecksum, crcdata);
+	}
+
+	/* update our CRC map */
+	if ((chd->map[hunknum].flags & MAP_ENTRY_FLAG_TYPE_MASK) != MAP_ENTRY_TYPE_SELF_HUNK &&
+		(chd->map[hunknum].flags & MAP_ENTRY_FLAG_TYPE_MASK) != MAP_ENTRY_TYPE_PARENT_HUNK)
+		crcmap_add_entry(chd, hunknum);
+}
+
+
 
 /***************************************************************************
     INTERNAL MAP ACCESS
@@ -2560,13 +3414,13 @@ static chd_error zlib_codec_compress(chd_file *chd, const void *src, UINT32 *len
     the ZLIB codec
 -------------------------------------------------*/
 
-static chd_error zlib_codec_decompress(chd_file *chd, UINT32 srclength, void *dest)
+static chd_error zlib_codec_decompress(chd_file *chd, const void *src, UINT32 srclength, void *dest)
 {
 	zlib_codec_data *data = chd->codecdata;
 	int zerr;
 
 	/* reset the decompressor */
-	data->inflater.next_in = chd->compressed;
+	data->inflater.next_in = (Bytef *)src;
 	data->inflater.avail_in = srclength;
 	data->inflater.total_in = 0;
 	data->inflater.next_out = dest;
@@ -2766,7 +3620,7 @@ static chd_error av_codec_compress(chd_file *chd, const void *src, UINT32 *lengt
     the A/V codec
 -------------------------------------------------*/
 
-static chd_error av_codec_decompress(chd_file *chd, UINT32 srclength, void *dest)
+static chd_error av_codec_decompress(chd_file *chd, const void *src, UINT32 srclength, void *dest)
 {
 	av_codec_data *data = chd->codecdata;
 	const UINT8 *source;
@@ -2782,7 +3636,7 @@ static chd_error av_codec_decompress(chd_file *chd, UINT32 srclength, void *dest
 	}
 
 	/* decode the audio and video */
-	source = chd->compressed;
+	source = src;
 	averr = avcomp_decode_data(data->compstate, source, srclength, dest);
 	if (averr != AVCERR_NONE)
 		return CHDERR_DECOMPRESSION_ERROR;
@@ -240,6 +240,12 @@ void chd_close(chd_file *chd);
 /* return the associated core_file */
 core_file *chd_core_file(chd_file *chd);
 
+/* set the size of the hunk cache, in megabytes, for CHD files opened afterwards */
+void chd_set_cache_size(UINT32 megabytes);
+
+/* set how many hunks are compressed in parallel by compressions begun afterwards */
+void chd_set_compress_workers(UINT32 workers);
+
 
 
 /* ----- CHD header management ----- */
@@ -60,6 +60,8 @@ struct _core_file
 	UINT32			openflags;					/* flags we were opened with */
 	UINT8			data_allocated;				/* was the data allocated by us? */
 	UINT8 *			data;						/* file data, if RAM-based */
+	const void *	mapping;					/* read-only mapping of the whole file */
+	UINT8			map_failed;					/* did mapping fail once already? */
 	UINT64			offset;						/* current file offset */
 	UINT64			length;						/* total file length */
 	text_file_type	text_type;					/* text output format */
@@ -167,6 +169,8 @@ file_error core_fopen_ram(const void *data, size_t length, UINT32 openflags, cor
 void core_fclose(core_file *file)
 {
 	/* close files and free memory */
+	if (file->mapping != NULL)
+		osd_unmap(file->mapping, file->length);
 	if (file->file != NULL)
 		osd_close(file->file);
 	if (file->data != NULL && file->data_allocated)
@@ -517,6 +521,15 @@ const void *core_fbuffer(core_file *file)
 	if (file->data != NULL)
 		return file->data;
 
+	/* read-only files are mapped rather than copied */
+	if (file->length > 0 && core_fmap(file, 0, file->length) != NULL)
+	{
+		file->data = (UINT8 *)file->mapping;
+		osd_close(file->file);
+		file->file = NULL;
+		return file->data;
+	}
+
 	/* allocate some memory */
 	file->data = malloc(file->length);
 	if (file->data == NULL)
@@ -540,6 +553,40 @@ const void *core_fbuffer(core_file *file)
 
 
 
+/*-------------------------------------------------
+    core_fmap - return a pointer to a region of
+    a read-only file without copying it, or NULL
+    if the file can't be mapped; the pointer is
+    valid until the file is closed
+-------------------------------------------------*/
+
+const void *core_fmap(core_file *file, UINT64 offset, UINT64 length)
+{
+	/* the region must be entirely within the file */
+	if (offset > file->length || length > file->length - offset)
+		return NULL;
+
+	/* RAM-based files are already in memory */
+	if (file->data != NULL)
+		return file->data + offset;
+
+	/* map the whole file the first time through; writable files are never mapped */
+	if (file->mapping == NULL)
+	{
+		if ((file->openflags & OPEN_FLAG_WRITE) != 0 || file->map_failed || file->length == 0)
+			return NULL;
+		if (osd_map_readonly(file->file, 0, file->length, &file->mapping) != FILERR_NONE)
+		{
+			file->mapping = NULL;
+			file->map_failed = TRUE;
+			return NULL;
+		}
+	}
+	return (const UINT8 *)file->mapping + offset;
+}
+
+
+
 /***************************************************************************
     FILE WRITE
 ***************************************************************************/
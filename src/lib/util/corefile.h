@@ -88,6 +88,9 @@ char *core_fgets(char *s, int n, core_file *file);
 /* this function may cause the full file data to be read */
 const void *core_fbuffer(core_file *file);
 
+/* get a pointer to a region of a read-only file without copying it; NULL if it can't be mapped */
+const void *core_fmap(core_file *file, UINT64 offset, UINT64 length);
+
 
 
 /* ----- file write ----- */
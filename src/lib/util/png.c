@@ -781,88 +781,23 @@ static png_error write_chunk(core_file *fp, const UINT8 *data, UINT32 type, UINT
 
 
 /*-------------------------------------------------
-    write_deflated_chunk - write an in-memory
-    chunk to the given file by deflating it
+    put_chunk - store a chunk into an in-memory
+    chunk stream, returning the number of bytes
+    consumed; the data may already be in place
+    immediately after the chunk header
 -------------------------------------------------*/
 
-static png_error write_deflated_chunk(core_file *fp, UINT8 *data, UINT32 type, UINT32 length)
+static UINT32 put_chunk(UINT8 *dest, const UINT8 *data, UINT32 type, UINT32 length)
 {
-	UINT64 lengthpos = core_ftell(fp);
-	UINT8 tempbuff[8192];
-    UINT32 zlength = 0;
-    z_stream stream;
-	UINT32 crc;
-	int zerr;
-
-	/* stuff the length/type into the buffer */
-	put_32bit(tempbuff + 0, length);
-	put_32bit(tempbuff + 4, type);
-	crc = crc32(0, tempbuff + 4, 4);
-
-	/* write that data */
-	if (core_fwrite(fp, tempbuff, 8) != 8)
-		return PNGERR_FILE_ERROR;
-
-	/* initialize the stream */
-	memset(&stream, 0, sizeof(stream));
-	stream.next_in = data;
-	stream.avail_in = length;
-    zerr = deflateInit(&stream, Z_DEFAULT_COMPRESSION);
-    if (zerr != Z_OK)
-    	return PNGERR_COMPRESS_ERROR;
-
-	/* now loop until we run out of data */
-	for ( ; ; )
-	{
-		/* compress this chunk */
-		stream.next_out = tempbuff;
-		stream.avail_out = sizeof(tempbuff);
-		zerr = deflate(&stream, Z_FINISH);
-
-		/* if there's data to write, do it */
-		if (stream.avail_out < sizeof(tempbuff))
-		{
-			int bytes = sizeof(tempbuff) - stream.avail_out;
-			if (core_fwrite(fp, tempbuff, bytes) != bytes)
-			{
-				deflateEnd(&stream);
-				return PNGERR_FILE_ERROR;
-			}
-			crc = crc32(crc, tempbuff, bytes);
-			zlength += bytes;
-		}
-
-		/* stop at the end of the stream */
-		if (zerr == Z_STREAM_END)
-			break;
-
-		/* other errors are fatal */
-		if (zerr != Z_OK)
-		{
-			deflateEnd(&stream);
-			return PNGERR_COMPRESS_ERROR;
-		}
-	}
-
-	/* clean up deflater(maus) */
-	zerr = deflateEnd(&stream);
-	if (zerr != Z_OK)
-		return PNGERR_COMPRESS_ERROR;
-
-	/* write the CRC */
-	put_32bit(tempbuff, crc);
-	if (core_fwrite(fp, tempbuff, 4) != 4)
-		return PNGERR_FILE_ERROR;
-
-	/* seek back and update the length */
-	core_fseek(fp, lengthpos, SEEK_SET);
-	put_32bit(tempbuff + 0, zlength);
-	if (core_fwrite(fp, tempbuff, 4) != 4)
-		return PNGERR_FILE_ERROR;
-
-	/* return to the end */
-	core_fseek(fp, lengthpos + 8 + zlength + 4, SEEK_SET);
-	return PNGERR_NONE;
+	/* stuff the length/type, then the data */
+	put_32bit(dest + 0, length);
+	put_32bit(dest + 4, type);
+	if (length > 0 && data != dest + 8)
+		memcpy(dest + 8, data, length);
+
+	/* the CRC covers the type and the data */
+	put_32bit(dest + 8 + length, crc32(0, dest + 4, length + 4));
+	return length + 12;
 }
 
 
@@ -1015,15 +950,21 @@ static png_error convert_bitmap_to_image_rgb(png_info *pnginfo, const bitmap_t *
 
 
 /*-------------------------------------------------
-    write_png_stream - stream a series of PNG
-    chunks to the given file
+    encode_png_stream - encode a series of PNG
+    chunks into a newly allocated buffer
 -------------------------------------------------*/
 
-static png_error write_png_stream(core_file *fp, png_info *pnginfo, const bitmap_t *bitmap, int palette_length, const rgb_t *palette)
+static png_error encode_png_stream(png_info *pnginfo, const bitmap_t *bitmap, int palette_length, const rgb_t *palette, UINT8 **buffer, UINT32 *length)
 {
 	UINT8 tempbuff[16];
+	UINT32 imagelength, offset;
+	uLongf zlength, total;
 	png_text *text;
 	png_error error;
+	UINT8 *dest;
+
+	*buffer = NULL;
+	*length = 0;
 
 	/* create an unfiltered image in either palette or RGB form */
 	if (bitmap->format == BITMAP_FORMAT_INDEXED16 && palette_length <= 256)
@@ -1031,10 +972,20 @@ static png_error write_png_stream(core_file *fp, png_info *pnginfo, const bitmap
 	else
 		error = convert_bitmap_to_image_rgb(pnginfo, bitmap, palette_length, palette);
 	if (error != PNGERR_NONE)
-		goto handle_error;
+		return error;
 
 	/* if we wanted to get clever and do filtering, we would do it here */
 
+	/* size the worst case: IHDR, PLTE, IDAT, tEXt and IEND chunks */
+	imagelength = pnginfo->height * (compute_rowbytes(pnginfo) + 1);
+	zlength = compressBound(imagelength);
+	total = (12 + 13) + (12 + pnginfo->num_palette * 3) + (12 + zlength) + 12;
+	for (text = pnginfo->textlist; text != NULL; text = text->next)
+		total += 12 + strlen(text->keyword) + 1 + strlen(text->text);
+	dest = malloc(total);
+	if (dest == NULL)
+		return PNGERR_OUT_OF_MEMORY;
+
 	/* write the IHDR chunk */
 	put_32bit(tempbuff + 0, pnginfo->width);
 	put_32bit(tempbuff + 4, pnginfo->height);
@@ -1043,33 +994,51 @@ static png_error write_png_stream(core_file *fp, png_info *pnginfo, const bitmap
 	put_8bit(tempbuff + 10, pnginfo->compression_method);
 	put_8bit(tempbuff + 11, pnginfo->filter_method);
 	put_8bit(tempbuff + 12, pnginfo->interlace_method);
-	error = write_chunk(fp, tempbuff, PNG_CN_IHDR, 13);
-	if (error != PNGERR_NONE)
-		goto handle_error;
+	offset = put_chunk(dest, tempbuff, PNG_CN_IHDR, 13);
 
 	/* write the PLTE chunk */
 	if (pnginfo->num_palette > 0)
-		error = write_chunk(fp, pnginfo->palette, PNG_CN_PLTE, pnginfo->num_palette * 3);
-	if (error != PNGERR_NONE)
-		goto handle_error;
+		offset += put_chunk(dest + offset, pnginfo->palette, PNG_CN_PLTE, pnginfo->num_palette * 3);
 
-	/* write a single IDAT chunk */
-	error = write_deflated_chunk(fp, pnginfo->image, PNG_CN_IDAT, pnginfo->height * (compute_rowbytes(pnginfo) + 1));
-	if (error != PNGERR_NONE)
-		goto handle_error;
+	/* write a single IDAT chunk, deflating straight into place */
+	if (compress2(dest + offset + 8, &zlength, pnginfo->image, imagelength, Z_DEFAULT_COMPRESSION) != Z_OK)
+	{
+		free(dest);
+		return PNGERR_COMPRESS_ERROR;
+	}
+	offset += put_chunk(dest + offset, dest + offset + 8, PNG_CN_IDAT, zlength);
 
 	/* write TEXT chunks */
 	for (text = pnginfo->textlist; text != NULL; text = text->next)
-	{
-		error = write_chunk(fp, (UINT8 *)text->keyword, PNG_CN_tEXt, (UINT32)strlen(text->keyword) + 1 + (UINT32)strlen(text->text));
-		if (error != PNGERR_NONE)
-			goto handle_error;
-	}
+		offset += put_chunk(dest + offset, (const UINT8 *)text->keyword, PNG_CN_tEXt, (UINT32)strlen(text->keyword) + 1 + (UINT32)strlen(text->text));
 
 	/* write an IEND chunk */
-	error = write_chunk(fp, NULL, PNG_CN_IEND, 0);
+	offset += put_chunk(dest + offset, NULL, PNG_CN_IEND, 0);
 
-handle_error:
+	*buffer = dest;
+	*length = offset;
+	return PNGERR_NONE;
+}
+
+
+/*-------------------------------------------------
+    write_png_stream - stream a series of PNG
+    chunks to the given file
+-------------------------------------------------*/
+
+static png_error write_png_stream(core_file *fp, png_info *pnginfo, const bitmap_t *bitmap, int palette_length, const rgb_t *palette)
+{
+	png_error error;
+	UINT8 *buffer;
+	UINT32 length;
+
+	error = encode_png_stream(pnginfo, bitmap, palette_length, palette, &buffer, &length);
+	if (error != PNGERR_NONE)
+		return error;
+
+	if (core_fwrite(fp, buffer, length) != length)
+		error = PNGERR_FILE_ERROR;
+	free(buffer);
 	return error;
 }
 
@@ -1137,6 +1106,26 @@ png_error mng_capture_frame(core_file *fp, png_info *info, bitmap_t *bitmap, int
 	return write_png_stream(fp, info, bitmap, palette_length, palette);
 }
 
+/*-------------------------------------------------
+    mng_capture_encode_frame - encode a movie
+    frame into a newly allocated buffer, to be
+    written later by mng_capture_write_frame;
+    this touches no file state, so it can run on
+    any thread
+-------------------------------------------------*/
+
+png_error mng_capture_encode_frame(png_info *info, bitmap_t *bitmap, int palette_length, const UINT32 *palette, UINT8 **buffer, UINT32 *length)
+{
+	return encode_png_stream(info, bitmap, palette_length, palette, buffer, length);
+}
+
+png_error mng_capture_write_frame(core_file *fp, const UINT8 *buffer, UINT32 length)
+{
+	if (core_fwrite(fp, buffer, length) != length)
+		return PNGERR_FILE_ERROR;
+	return PNGERR_NONE;
+}
+
 png_error mng_capture_stop(core_file *fp)
 {
 	return write_chunk(fp, NULL, MNG_CN_MEND, 0);
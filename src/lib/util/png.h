@@ -132,6 +132,8 @@ png_error png_write_bitmap(core_file *fp, png_info *info, bitmap_t *bitmap, int
 
 png_error mng_capture_start(core_file *fp, bitmap_t *bitmap, double rate);
 png_error mng_capture_frame(core_file *fp, png_info *info, bitmap_t *bitmap, int palette_length, const UINT32 *palette);
+png_error mng_capture_encode_frame(png_info *info, bitmap_t *bitmap, int palette_length, const UINT32 *palette, UINT8 **buffer, UINT32 *length);
+png_error mng_capture_write_frame(core_file *fp, const UINT8 *buffer, UINT32 length);
 png_error mng_capture_stop(core_file *fp);
 
 #endif	/* __PNG_H__ */
@@ -3131,6 +3131,7 @@ static MACHINE_DRIVER_START( system16b )
 	MDRV_CPU_ADD_TAG("sound", Z80, MASTER_CLOCK_10MHz/2)
 	MDRV_CPU_PROGRAM_MAP(sound_map,0)
 	MDRV_CPU_IO_MAP(sound_portmap,0)
+	MDRV_CPU_GROUP(1)
 
 	MDRV_SCREEN_REFRESH_RATE(60)
 
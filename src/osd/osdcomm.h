@@ -63,6 +63,17 @@
 #endif
 
 
+/* Thread-local storage, where the compiler supports it */
+#if defined(__GNUC__) && (__GNUC__ >= 3)
+#define DECL_THREAD_LOCAL		__thread
+#elif defined(_MSC_VER) && (_MSC_VER >= 1200)
+#define DECL_THREAD_LOCAL		__declspec(thread)
+#else
+#define DECL_THREAD_LOCAL
+#define NO_THREAD_LOCAL
+#endif
+
+
 
 /***************************************************************************
     FUNDAMENTAL TYPES
@@ -180,6 +180,51 @@ file_error osd_write(osd_file *file, const void *buffer, UINT64 offset, UINT32 l
 file_error osd_rmfile(const char *filename);
 
 
+/*-----------------------------------------------------------------------------
+    osd_map_readonly: map a read-only view of an open file into memory
+
+    Parameters:
+
+        file - handle to a file previously opened via osd_open
+
+        offset - offset within the file of the start of the view
+
+        length - number of bytes to map
+
+        base - pointer to a const void * to receive the address of the
+            first mapped byte; valid only if the function returns FILERR_NONE
+
+    Return value:
+
+        a file_error describing any error that occurred while mapping the
+        file, or FILERR_NONE if no error occurred
+
+    Notes:
+
+        Mapping is optional; callers must fall back to osd_read if this
+        returns an error. The view stays valid until released with
+        osd_unmap, even after the file itself has been closed.
+-----------------------------------------------------------------------------*/
+file_error osd_map_readonly(osd_file *file, UINT64 offset, UINT64 length, const void **base);
+
+
+/*-----------------------------------------------------------------------------
+    osd_unmap: release a view created by osd_map_readonly
+
+    Parameters:
+
+        base - the address returned by osd_map_readonly
+
+        length - the length originally passed to osd_map_readonly
+
+    Return value:
+
+        a file_error describing any error that occurred while unmapping
+        the view, or FILERR_NONE if no error occurred
+-----------------------------------------------------------------------------*/
+file_error osd_unmap(const void *base, UINT64 length);
+
+
 /*-----------------------------------------------------------------------------
     osd_get_physical_drive_geometry: if the given path points to a physical
         drive, return the geometry of that drive
@@ -534,6 +579,27 @@ typedef struct _osd_work_item osd_work_item;
 typedef void *(*osd_work_callback)(void *param, int threadid);
 
 
+/*-----------------------------------------------------------------------------
+    osd_get_num_processors: return the number of processors that work
+        queues created with WORK_QUEUE_FLAG_MULTI will use
+
+    Parameters:
+
+        None.
+
+    Return value:
+
+        The number of processors, always at least 1.
+
+    Notes:
+
+        Callers that keep their own pools of work items in flight can use
+        this to size them. Any user override of the processor count is
+        already applied to the value returned.
+-----------------------------------------------------------------------------*/
+int osd_get_num_processors(void);
+
+
 /*-----------------------------------------------------------------------------
     osd_work_queue_alloc: create a new work queue
 
@@ -7,44 +7,135 @@
 //
 //============================================================
 
+// we need 64-bit file offsets even on 32-bit hosts
+#define _FILE_OFFSET_BITS		64
+
+// standard POSIX headers
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+// MAME headers
 #include "osdcore.h"
 
 
+//============================================================
+//  TYPE DEFINITIONS
+//============================================================
+
+struct _osd_file
+{
+	int			fd;
+};
+
+
+
+//============================================================
+//  FUNCTION PROTOTYPES
+//============================================================
+
+static int create_path_recursive(char *path);
+
+
+
+//============================================================
+//  errno_to_file_error
+//============================================================
+
+static file_error errno_to_file_error(int error)
+{
+	switch (error)
+	{
+		case ENOENT:
+		case ENOTDIR:
+			return FILERR_NOT_FOUND;
+
+		case EACCES:
+		case EPERM:
+		case EROFS:
+			return FILERR_ACCESS_DENIED;
+
+		case ENOMEM:
+			return FILERR_OUT_OF_MEMORY;
+
+		case EMFILE:
+		case ENFILE:
+			return FILERR_TOO_MANY_FILES;
+
+		case EBUSY:
+		case ETXTBSY:
+			return FILERR_ALREADY_OPEN;
+
+		default:
+			return FILERR_FAILURE;
+	}
+}
+
+
 //============================================================
 //  osd_open
 //============================================================
 
 file_error osd_open(const char *path, UINT32 openflags, osd_file **file, UINT64 *filesize)
 {
-	const char *mode;
-	FILE *fileptr;
+	struct stat st;
+	int access;
+	int fd;
 
 	// based on the flags, choose a mode
 	if (openflags & OPEN_FLAG_WRITE)
 	{
-		if (openflags & OPEN_FLAG_READ)
-			mode = (openflags & OPEN_FLAG_CREATE) ? "w+b" : "r+b";
-		else
-			mode = "wb";
+		access = (openflags & OPEN_FLAG_READ) ? O_RDWR : O_WRONLY;
+		if (openflags & OPEN_FLAG_CREATE)
+			access |= O_CREAT | O_TRUNC;
 	}
 	else if (openflags & OPEN_FLAG_READ)
-		mode = "rb";
+		access = O_RDONLY;
 	else
 		return FILERR_INVALID_ACCESS;
 
-	// open the file
-	fileptr = fopen(path, mode);
-	if (fileptr == NULL)
-		return FILERR_NOT_FOUND;
+	// open the file, creating the path if we need to
+	fd = open(path, access, 0666);
+	if (fd == -1 && errno == ENOENT && (openflags & OPEN_FLAG_CREATE) && (openflags & OPEN_FLAG_CREATE_PATHS))
+	{
+		char *pathcopy = malloc(strlen(path) + 1);
+		char *sep;
 
-	// store the file pointer directly as an osd_file
-	*file = (osd_file *)fileptr;
+		if (pathcopy == NULL)
+			return FILERR_OUT_OF_MEMORY;
+		strcpy(pathcopy, path);
+		sep = strrchr(pathcopy, '/');
+		if (sep != NULL && sep != pathcopy)
+		{
+			*sep = 0;
+			if (create_path_recursive(pathcopy) == 0)
+				fd = open(path, access, 0666);
+		}
+		free(pathcopy);
+	}
+	if (fd == -1)
+		return errno_to_file_error(errno);
 
-	// get the size -- note that most fseek/ftell implementations are limited to 32 bits
-	fseek(fileptr, 0, SEEK_END);
-	*filesize = ftell(fileptr);
-	fseek(fileptr, 0, SEEK_SET);
+	// get the size with 64-bit precision
+	if (fstat(fd, &st) != 0)
+	{
+		file_error filerr = errno_to_file_error(errno);
+		close(fd);
+		return filerr;
+	}
 
+	// allocate a file object
+	*file = malloc(sizeof(**file));
+	if (*file == NULL)
+	{
+		close(fd);
+		return FILERR_OUT_OF_MEMORY;
+	}
+	(*file)->fd = fd;
+	*filesize = st.st_size;
 	return FILERR_NONE;
 }
 
@@ -55,16 +146,25 @@ file_error osd_open(const char *path, UINT32 openflags, osd_file **file, UINT64
 
 file_error osd_read(osd_file *file, void *buffer, UINT64 offset, UINT32 length, UINT32 *actual)
 {
-	size_t count;
+	UINT32 count = 0;
 
-	// seek to the new location; note that most fseek implementations are limited to 32 bits
-	fseek((FILE *)file, offset, SEEK_SET);
+	// pread doesn't touch a shared file position, so concurrent reads are safe
+	while (count < length)
+	{
+		ssize_t result = pread(file->fd, (UINT8 *)buffer + count, length - count, offset + count);
+		if (result < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return errno_to_file_error(errno);
+		}
+		if (result == 0)
+			break;
+		count += result;
+	}
 
-	// perform the read
-	count = fread(buffer, 1, length, (FILE *)file);
 	if (actual != NULL)
 		*actual = count;
-
 	return FILERR_NONE;
 }
 
@@ -75,16 +175,23 @@ file_error osd_read(osd_file *file, void *buffer, UINT64 offset, UINT32 length,
 
 file_error osd_write(osd_file *file, const void *buffer, UINT64 offset, UINT32 length, UINT32 *actual)
 {
-	size_t count;
+	UINT32 count = 0;
 
-	// seek to the new location; note that most fseek implementations are limited to 32 bits
-	fseek((FILE *)file, offset, SEEK_SET);
+	// pwrite may complete partially, so loop until everything is written
+	while (count < length)
+	{
+		ssize_t result = pwrite(file->fd, (const UINT8 *)buffer + count, length - count, offset + count);
+		if (result < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return errno_to_file_error(errno);
+		}
+		count += result;
+	}
 
-	// perform the write
-	count = fwrite(buffer, 1, length, (FILE *)file);
 	if (actual != NULL)
 		*actual = count;
-
 	return FILERR_NONE;
 }
 
@@ -95,12 +202,98 @@ file_error osd_write(osd_file *file, const void *buffer, UINT64 offset, UINT32 l
 
 file_error osd_close(osd_file *file)
 {
-	// close the file handle
-	fclose((FILE *)file);
+	// close the file descriptor and free the file structure
+	close(file->fd);
+	free(file);
 	return FILERR_NONE;
 }
 
 
+//============================================================
+//  osd_map_readonly
+//============================================================
+
+file_error osd_map_readonly(osd_file *file, UINT64 offset, UINT64 length, const void **base)
+{
+	UINT64 pagemask = sysconf(_SC_PAGESIZE) - 1;
+	UINT64 delta = offset & pagemask;
+	void *view;
+
+	// empty views can't be mapped, nor can views too large for our address space
+	if (length == 0)
+		return FILERR_INVALID_ACCESS;
+	if ((size_t)(length + delta) != length + delta)
+		return FILERR_OUT_OF_MEMORY;
+
+	// mmap wants a page-aligned offset, so map from the start of the page
+	view = mmap(NULL, length + delta, PROT_READ, MAP_SHARED, file->fd, offset - delta);
+	if (view == MAP_FAILED)
+		return errno_to_file_error(errno);
+
+	*base = (const UINT8 *)view + delta;
+	return FILERR_NONE;
+}
+
+
+//============================================================
+//  osd_unmap
+//============================================================
+
+file_error osd_unmap(const void *base, UINT64 length)
+{
+	UINT64 pagemask = sysconf(_SC_PAGESIZE) - 1;
+	UINT64 delta = (size_t)base & pagemask;
+
+	// undo the alignment we applied when mapping
+	if (munmap((void *)((size_t)base - delta), length + delta) != 0)
+		return errno_to_file_error(errno);
+	return FILERR_NONE;
+}
+
+
+//============================================================
+//  osd_rmfile
+//============================================================
+
+file_error osd_rmfile(const char *filename)
+{
+	if (unlink(filename) != 0)
+		return errno_to_file_error(errno);
+	return FILERR_NONE;
+}
+
+
+//============================================================
+//  create_path_recursive
+//============================================================
+
+static int create_path_recursive(char *path)
+{
+	char *sep = strrchr(path, '/');
+	struct stat st;
+
+	// if the path already exists, we're done
+	if (stat(path, &st) == 0)
+		return 0;
+
+	// create the parent first
+	if (sep != NULL && sep != path)
+	{
+		int result;
+		*sep = 0;
+		result = create_path_recursive(path);
+		*sep = '/';
+		if (result != 0)
+			return result;
+	}
+
+	// then create this directory
+	if (mkdir(path, 0777) != 0 && errno != EEXIST)
+		return errno;
+	return 0;
+}
+
+
 //============================================================
 //  osd_get_physical_drive_geometry
 //============================================================
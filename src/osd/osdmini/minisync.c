@@ -7,18 +7,43 @@
 //
 //============================================================
 
+// standard POSIX headers
+#include <pthread.h>
+
+// MAME headers
 #include "osdcore.h"
 
 
+//============================================================
+//  TYPE DEFINITIONS
+//============================================================
+
+struct _osd_lock
+{
+	pthread_mutex_t		mutex;
+};
+
+
+
 //============================================================
 //  osd_lock_alloc
 //============================================================
 
 osd_lock *osd_lock_alloc(void)
 {
-	// the minimal implementation does not support threading
-	// just return a dummy value here
-	return (osd_lock *)1;
+	pthread_mutexattr_t attr;
+	osd_lock *lock;
+
+	lock = malloc(sizeof(*lock));
+	if (lock == NULL)
+		return NULL;
+
+	// locks must be recursive to match the semantics of other OSD layers
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&lock->mutex, &attr);
+	pthread_mutexattr_destroy(&attr);
+	return lock;
 }
 
 
@@ -28,8 +53,7 @@ osd_lock *osd_lock_alloc(void)
 
 void osd_lock_acquire(osd_lock *lock)
 {
-	// the minimal implementation does not support threading
-	// the acquire always "succeeds"
+	pthread_mutex_lock(&lock->mutex);
 }
 
 
@@ -39,9 +63,7 @@ void osd_lock_acquire(osd_lock *lock)
 
 int osd_lock_try(osd_lock *lock)
 {
-	// the minimal implementation does not support threading
-	// the acquire always "succeeds"
-	return TRUE;
+	return (pthread_mutex_trylock(&lock->mutex) == 0);
 }
 
 
@@ -51,8 +73,7 @@ int osd_lock_try(osd_lock *lock)
 
 void osd_lock_release(osd_lock *lock)
 {
-	// the minimal implementation does not support threading
-	// do nothing here
+	pthread_mutex_unlock(&lock->mutex);
 }
 
 
@@ -62,6 +83,6 @@ void osd_lock_release(osd_lock *lock)
 
 void osd_lock_free(osd_lock *lock)
 {
-	// the minimal implementation does not support threading
-	// do nothing here
+	pthread_mutex_destroy(&lock->mutex);
+	free(lock);
 }
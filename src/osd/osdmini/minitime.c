@@ -9,6 +9,20 @@
 
 #include "osdepend.h"
 #include <time.h>
+#include <errno.h>
+
+
+
+//============================================================
+//  CONSTANTS
+//============================================================
+
+// osd_ticks are monotonic nanoseconds
+#define TICKS_PER_SECOND		((osd_ticks_t)1000000000)
+
+// the kernel usually wakes us a bit late; nanosleep() until this
+// long before the target and spin for the remainder
+#define SLEEP_SPIN_TICKS		((osd_ticks_t)200000)
 
 
 
@@ -18,8 +32,12 @@
 
 osd_ticks_t osd_ticks(void)
 {
-	// use the standard library clock function
-	return clock();
+	struct timespec now;
+
+	// CLOCK_MONOTONIC is unaffected by wall-clock adjustments and has
+	// nanosecond resolution on all modern systems
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (osd_ticks_t)now.tv_sec * TICKS_PER_SECOND + now.tv_nsec;
 }
 
 
@@ -29,7 +47,7 @@ osd_ticks_t osd_ticks(void)
 
 osd_ticks_t osd_ticks_per_second(void)
 {
-	return CLOCKS_PER_SEC;
+	return TICKS_PER_SECOND;
 }
 
 
@@ -37,14 +55,32 @@ osd_ticks_t osd_ticks_per_second(void)
 //  osd_profiling_ticks
 //============================================================
 
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+
 osd_ticks_t osd_profiling_ticks(void)
 {
-	// on x86 platforms, we should return the value of RDTSC here
-	// generically, we fall back to clock(), which hopefully is
-	// fast
-	return clock();
+	UINT32 lo, hi;
+
+	// use RDTSC; the profiler only compares deltas, so the counter
+	// does not need to be calibrated against osd_ticks
+	__asm__ __volatile__ (
+		"rdtsc"
+		: "=a" (lo), "=d" (hi)
+	);
+
+	return ((osd_ticks_t)hi << 32) | lo;
 }
 
+#else
+
+osd_ticks_t osd_profiling_ticks(void)
+{
+	// no cheap cycle counter; the monotonic clock is the next best thing
+	return osd_ticks();
+}
+
+#endif
+
 
 //============================================================
 //  osd_sleep
@@ -52,6 +88,23 @@ osd_ticks_t osd_profiling_ticks(void)
 
 void osd_sleep(osd_ticks_t duration)
 {
-	// if there was a generic, cross-platform way to give up
-	// time, this is where we would do it
+	osd_ticks_t target = osd_ticks() + duration;
+
+	// give the bulk of the time back to the system
+	if (duration > SLEEP_SPIN_TICKS)
+	{
+		struct timespec request, remaining;
+
+		duration -= SLEEP_SPIN_TICKS;
+		request.tv_sec = duration / TICKS_PER_SECOND;
+		request.tv_nsec = duration % TICKS_PER_SECOND;
+
+		// restart if a signal interrupts us
+		while (nanosleep(&request, &remaining) != 0 && errno == EINTR)
+			request = remaining;
+	}
+
+	// spin out the last few microseconds for accuracy
+	while (osd_ticks() < target)
+		;
 }
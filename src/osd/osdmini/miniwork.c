@@ -7,29 +7,347 @@
 //
 //============================================================
 
+// standard POSIX headers
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <errno.h>
+
+// MAME headers
 #include "osdcore.h"
 
 
+//============================================================
+//  DEBUGGING
+//============================================================
+
+#define KEEP_STATISTICS			(0)
+
+
+
+//============================================================
+//  PARAMETERS
+//============================================================
+
+#define SPIN_LOOP_TIME			(osd_ticks_per_second() / 1000)
+#define INITIAL_DEQUE_SIZE		64
+
+
+
+//============================================================
+//  MACROS
+//============================================================
+
+#if KEEP_STATISTICS
+#define add_to_stat(v,x)		do { atomic_add32((v), (x)); } while (0)
+#else
+#define add_to_stat(v,x)		do { } while (0)
+#endif
+
+#if defined(__i386__) || defined(__x86_64__)
+INLINE void yield_processor(void)
+{
+	__asm__ __volatile__ ( "rep; nop" );
+}
+#else
+INLINE void yield_processor(void)
+{
+	__sync_synchronize();
+}
+#endif
+
+
+
 //============================================================
 //  TYPE DEFINITIONS
 //============================================================
 
+typedef struct _work_deque work_deque;
+struct _work_deque
+{
+	pthread_mutex_t		lock;			// lock protecting this deque
+	osd_work_item **	ring;			// circular array of items
+	UINT32				size;			// size of the ring (power of 2)
+	UINT32				head;			// index of the oldest item (stolen from here)
+	UINT32				tail;			// index past the newest item (owner pops here)
+};
+
+
+typedef struct _work_thread_info work_thread_info;
+struct _work_thread_info
+{
+	osd_work_queue *	queue;			// pointer back to the queue
+	pthread_t			handle;			// handle to the thread
+	int					created;		// was the thread successfully created?
+	volatile INT32		active;			// are we actively processing work?
+	work_deque			deque;			// per-thread deque of pending items
+
+#if KEEP_STATISTICS
+	INT32				itemsdone;		// items processed by this thread
+	INT32				itemsstolen;	// items stolen from other threads
+#endif
+};
+
+
+struct _osd_work_queue
+{
+	pthread_mutex_t		wakelock;		// lock protecting the wake condition
+	pthread_cond_t		wakecond;		// condition signalled when work is queued
+	pthread_mutex_t		donelock;		// lock protecting the done condition
+	pthread_cond_t		donecond;		// condition signalled when items complete
+	pthread_mutex_t		freelock;		// lock protecting the free list
+	osd_work_item *		free;			// free list of work items
+	volatile INT32		items;			// items in the queue (queued or running)
+	volatile INT32		pending;		// items queued but not yet claimed
+	volatile INT32		waiting;		// number of threads waiting on completion
+	volatile INT32		nextthread;		// round-robin index for distributing work
+	volatile UINT8		exiting;		// should the threads exit on their next opportunity?
+	UINT32				threads;		// number of threads in this queue
+	UINT32				flags;			// creation flags
+	work_thread_info *	thread;			// array of thread information (+1 for the caller)
+
+#if KEEP_STATISTICS
+	volatile INT32		itemsqueued;	// total items queued
+	volatile INT32		wakeups;		// number of times we signalled the wake condition
+	volatile INT32		spinloops;		// how many times spinning bought us more items
+#endif
+};
+
+
 struct _osd_work_item
 {
-	void *result;
+	osd_work_item *		next;			// pointer to next item (free list)
+	osd_work_queue *	queue;			// pointer back to the owning queue
+	osd_work_callback 	callback;		// callback function
+	void *				param;			// callback parameter
+	void *				result;			// callback result
+	UINT32				flags;			// creation flags
+	volatile INT32		done;			// is the item done?
 };
 
 
 
+//============================================================
+//  FUNCTION PROTOTYPES
+//============================================================
+
+static int effective_num_processors(void);
+static void *worker_thread_entry(void *param);
+static void worker_thread_process(osd_work_queue *queue, work_thread_info *thread);
+static void worker_execute_item(osd_work_queue *queue, osd_work_item *item, int threadid);
+static int deque_init(work_deque *deque);
+static void deque_free(work_deque *deque);
+
+
+
+//============================================================
+//  INLINE FUNCTIONS
+//============================================================
+
+INLINE INT32 atomic_exchange32(INT32 volatile *ptr, INT32 value)
+{
+	// test_and_set is only an acquire barrier, so make it a full one
+	INT32 result = __sync_lock_test_and_set(ptr, value);
+	__sync_synchronize();
+	return result;
+}
+
+
+INLINE INT32 atomic_increment32(INT32 volatile *ptr)
+{
+	return __sync_add_and_fetch(ptr, 1);
+}
+
+
+INLINE INT32 atomic_decrement32(INT32 volatile *ptr)
+{
+	return __sync_sub_and_fetch(ptr, 1);
+}
+
+
+INLINE INT32 atomic_add32(INT32 volatile *ptr, INT32 add)
+{
+	return __sync_add_and_fetch(ptr, add);
+}
+
+
+INLINE void compute_deadline(struct timespec *deadline, osd_ticks_t timeout)
+{
+	osd_ticks_t tps = osd_ticks_per_second();
+	struct timeval now;
+	UINT64 nsec;
+
+	// convert the relative timeout into an absolute wall-clock time
+	gettimeofday(&now, NULL);
+	nsec = (UINT64)now.tv_usec * 1000 + (UINT64)(timeout % tps) * 1000000000 / tps;
+	deadline->tv_sec = now.tv_sec + timeout / tps + nsec / 1000000000;
+	deadline->tv_nsec = nsec % 1000000000;
+}
+
+
+
+//============================================================
+//  Work deques
+//============================================================
+
+INLINE int deque_push(work_deque *deque, osd_work_item *item)
+{
+	pthread_mutex_lock(&deque->lock);
+
+	// grow the ring if we're full
+	if (deque->tail - deque->head == deque->size)
+	{
+		osd_work_item **newring = malloc(deque->size * 2 * sizeof(newring[0]));
+		UINT32 index;
+
+		// if we can't grow, let the caller deal with it
+		if (newring == NULL)
+		{
+			pthread_mutex_unlock(&deque->lock);
+			return FALSE;
+		}
+		for (index = deque->head; index != deque->tail; index++)
+			newring[index & (deque->size * 2 - 1)] = deque->ring[index & (deque->size - 1)];
+		free(deque->ring);
+		deque->ring = newring;
+		deque->size *= 2;
+	}
+
+	deque->ring[deque->tail++ & (deque->size - 1)] = item;
+	pthread_mutex_unlock(&deque->lock);
+	return TRUE;
+}
+
+
+INLINE osd_work_item *deque_pop(work_deque *deque)
+{
+	osd_work_item *item = NULL;
+
+	// the owner takes the most recently queued item, which is the one
+	// most likely to still be in cache
+	pthread_mutex_lock(&deque->lock);
+	if (deque->tail != deque->head)
+		item = deque->ring[--deque->tail & (deque->size - 1)];
+	pthread_mutex_unlock(&deque->lock);
+	return item;
+}
+
+
+INLINE osd_work_item *deque_steal(work_deque *deque)
+{
+	osd_work_item *item = NULL;
+
+	// don't bother contending for the lock on an empty deque
+	if (deque->tail == deque->head)
+		return NULL;
+
+	// thieves take the oldest item, away from where the owner works
+	if (pthread_mutex_trylock(&deque->lock) != 0)
+		return NULL;
+	if (deque->tail != deque->head)
+		item = deque->ring[deque->head++ & (deque->size - 1)];
+	pthread_mutex_unlock(&deque->lock);
+	return item;
+}
+
+
+static int deque_init(work_deque *deque)
+{
+	deque->ring = malloc(INITIAL_DEQUE_SIZE * sizeof(deque->ring[0]));
+	if (deque->ring == NULL)
+		return FALSE;
+	deque->size = INITIAL_DEQUE_SIZE;
+	deque->head = deque->tail = 0;
+	pthread_mutex_init(&deque->lock, NULL);
+	return TRUE;
+}
+
+
+static void deque_free(work_deque *deque)
+{
+	if (deque->ring != NULL)
+	{
+		pthread_mutex_destroy(&deque->lock);
+		free(deque->ring);
+		deque->ring = NULL;
+	}
+}
+
+
+
+//============================================================
+//  osd_get_num_processors
+//============================================================
+
+int osd_get_num_processors(void)
+{
+	return effective_num_processors();
+}
+
+
 //============================================================
 //  osd_work_queue_alloc
 //============================================================
 
 osd_work_queue *osd_work_queue_alloc(int flags)
 {
-	// this minimal implementation doesn't need to keep any state
-	// so we just return a non-NULL pointer
-	return (osd_work_queue *)1;
+	int numprocs = effective_num_processors();
+	osd_work_queue *queue;
+	int threadnum;
+
+	// allocate a new queue
+	queue = malloc(sizeof(*queue));
+	if (queue == NULL)
+		return NULL;
+	memset(queue, 0, sizeof(*queue));
+
+	// initialize basic queue members
+	queue->flags = flags;
+	pthread_mutex_init(&queue->wakelock, NULL);
+	pthread_cond_init(&queue->wakecond, NULL);
+	pthread_mutex_init(&queue->donelock, NULL);
+	pthread_cond_init(&queue->donecond, NULL);
+	pthread_mutex_init(&queue->freelock, NULL);
+
+	// determine how many threads to create...
+	// on a single-CPU system, create 1 thread for I/O queues, and 0 threads for everything else
+	if (numprocs == 1)
+		queue->threads = (flags & WORK_QUEUE_FLAG_IO) ? 1 : 0;
+
+	// on an n-CPU system, create (n-1) threads for multi queues, and 1 thread for everything else
+	else
+		queue->threads = (flags & WORK_QUEUE_FLAG_MULTI) ? (numprocs - 1) : 1;
+
+	// clamp to the maximum, leaving a thread ID for the caller
+	queue->threads = MIN(queue->threads, WORK_MAX_THREADS - 1);
+
+	// allocate memory for thread array (+1 to count the calling thread)
+	queue->thread = malloc((queue->threads + 1) * sizeof(queue->thread[0]));
+	if (queue->thread == NULL)
+		goto error;
+	memset(queue->thread, 0, (queue->threads + 1) * sizeof(queue->thread[0]));
+
+	// set up the deques for every thread, including the caller's slot
+	for (threadnum = 0; threadnum <= queue->threads; threadnum++)
+	{
+		queue->thread[threadnum].queue = queue;
+		if (!deque_init(&queue->thread[threadnum].deque))
+			goto error;
+	}
+
+	// create the worker threads
+	for (threadnum = 0; threadnum < queue->threads; threadnum++)
+	{
+		work_thread_info *thread = &queue->thread[threadnum];
+		if (pthread_create(&thread->handle, NULL, worker_thread_entry, thread) != 0)
+			goto error;
+		thread->created = TRUE;
+	}
+	return queue;
+
+error:
+	osd_work_queue_free(queue);
+	return NULL;
 }
 
 
@@ -39,8 +357,8 @@ osd_work_queue *osd_work_queue_alloc(int flags)
 
 int osd_work_queue_items(osd_work_queue *queue)
 {
-	// we never have pending items
-	return 0;
+	// return the number of items currently in the queue
+	return queue->items;
 }
 
 
@@ -50,8 +368,46 @@ int osd_work_queue_items(osd_work_queue *queue)
 
 int osd_work_queue_wait(osd_work_queue *queue, osd_ticks_t timeout)
 {
-	// never anything to wait for, so do nothing
-	return TRUE;
+	struct timespec deadline;
+
+	// if no threads, no waiting
+	if (queue->threads == 0)
+		return TRUE;
+
+	// if no items, we're done
+	if (queue->items == 0)
+		return TRUE;
+
+	// if this is a multi queue, help out rather than doing nothing
+	if (queue->flags & WORK_QUEUE_FLAG_MULTI)
+	{
+		work_thread_info *thread = &queue->thread[queue->threads];
+
+		// process what we can as a worker thread
+		worker_thread_process(queue, thread);
+
+		// if we're a high frequency queue, spin until done
+		if (queue->flags & WORK_QUEUE_FLAG_HIGH_FREQ)
+		{
+			osd_ticks_t stopspin = osd_ticks() + timeout;
+			while (queue->items != 0 && osd_ticks() < stopspin)
+				yield_processor();
+			return (queue->items == 0);
+		}
+	}
+
+	// block on the done condition until the count hits 0 or we time out
+	compute_deadline(&deadline, timeout);
+	pthread_mutex_lock(&queue->donelock);
+	atomic_increment32(&queue->waiting);
+	while (queue->items != 0)
+		if (pthread_cond_timedwait(&queue->donecond, &queue->donelock, &deadline) == ETIMEDOUT)
+			break;
+	atomic_decrement32(&queue->waiting);
+	pthread_mutex_unlock(&queue->donelock);
+
+	// return TRUE if we actually hit 0
+	return (queue->items == 0);
 }
 
 
@@ -61,26 +417,148 @@ int osd_work_queue_wait(osd_work_queue *queue, osd_ticks_t timeout)
 
 void osd_work_queue_free(osd_work_queue *queue)
 {
-	// never allocated anything, so nothing to do
+	// if we have threads, clean them up
+	if (queue->thread != NULL)
+	{
+		int threadnum;
+
+		// signal all the threads to exit
+		pthread_mutex_lock(&queue->wakelock);
+		queue->exiting = TRUE;
+		pthread_cond_broadcast(&queue->wakecond);
+		pthread_mutex_unlock(&queue->wakelock);
+
+		// wait for all the threads to go away
+		for (threadnum = 0; threadnum < queue->threads; threadnum++)
+			if (queue->thread[threadnum].created)
+				pthread_join(queue->thread[threadnum].handle, NULL);
+
+#if KEEP_STATISTICS
+		// output per-thread statistics
+		for (threadnum = 0; threadnum <= queue->threads; threadnum++)
+		{
+			work_thread_info *thread = &queue->thread[threadnum];
+			printf("Thread %d:  items=%9d  stolen=%9d\n", threadnum, thread->itemsdone, thread->itemsstolen);
+		}
+#endif
+
+		// free the deques and any items left in them
+		for (threadnum = 0; threadnum <= queue->threads; threadnum++)
+		{
+			work_deque *deque = &queue->thread[threadnum].deque;
+			if (deque->ring != NULL)
+				for ( ; deque->head != deque->tail; deque->head++)
+					free(deque->ring[deque->head & (deque->size - 1)]);
+			deque_free(deque);
+		}
+
+		// free the list
+		free(queue->thread);
+	}
+
+	// free all items in the free list
+	while (queue->free != NULL)
+	{
+		osd_work_item *item = queue->free;
+		queue->free = item->next;
+		free(item);
+	}
+
+#if KEEP_STATISTICS
+	printf("Items queued   = %9d\n", queue->itemsqueued);
+	printf("Wakeups        = %9d\n", queue->wakeups);
+	printf("Spin loops     = %9d\n", queue->spinloops);
+#endif
+
+	// free the synchronization objects and the queue itself
+	pthread_mutex_destroy(&queue->wakelock);
+	pthread_cond_destroy(&queue->wakecond);
+	pthread_mutex_destroy(&queue->donelock);
+	pthread_cond_destroy(&queue->donecond);
+	pthread_mutex_destroy(&queue->freelock);
+	free(queue);
 }
 
 
 //============================================================
-//  osd_work_item_queue
+//  osd_work_item_queue_multiple
 //============================================================
 
-osd_work_item *osd_work_item_queue(osd_work_queue *queue, osd_work_callback callback, void *param, UINT32 flags)
+osd_work_item *osd_work_item_queue_multiple(osd_work_queue *queue, osd_work_callback callback, INT32 numitems, void *parambase, INT32 paramstep, UINT32 flags)
 {
-	osd_work_item *item;
+	osd_work_item *lastitem = NULL;
+	int itemnum;
 
-	// allocate memory to hold the result
-	item = malloc(sizeof(*item));
-	if (item == NULL)
-		return NULL;
+	// account for the items up front so waiters never see a false zero
+	atomic_add32(&queue->items, numitems);
+	add_to_stat(&queue->itemsqueued, numitems);
 
-	// execute the call directly
-	item->result = (*callback)(param, 0);
-	return item;
+	// loop over items, distributing them across the worker deques
+	for (itemnum = 0; itemnum < numitems; itemnum++)
+	{
+		osd_work_item *item;
+
+		// first allocate a new work item; try the free list first
+		pthread_mutex_lock(&queue->freelock);
+		item = queue->free;
+		if (item != NULL)
+			queue->free = item->next;
+		pthread_mutex_unlock(&queue->freelock);
+
+		// if nothing, allocate something new
+		if (item == NULL)
+		{
+			item = malloc(sizeof(*item));
+			if (item == NULL)
+			{
+				atomic_add32(&queue->items, itemnum - numitems);
+				return NULL;
+			}
+			item->queue = queue;
+		}
+
+		// fill in the basics
+		item->next = NULL;
+		item->callback = callback;
+		item->param = parambase;
+		item->result = NULL;
+		item->flags = flags;
+		item->done = FALSE;
+		lastitem = item;
+		parambase = (UINT8 *)parambase + paramstep;
+
+		// if no threads, run the item now on this thread
+		if (queue->threads == 0)
+			worker_execute_item(queue, item, 0);
+
+		// otherwise, hand it to the next thread in round-robin order; if its
+		// deque can't grow, just do the work ourselves
+		else
+		{
+			INT32 target = (UINT32)atomic_increment32(&queue->nextthread) % queue->threads;
+			atomic_increment32(&queue->pending);
+			if (!deque_push(&queue->thread[target].deque, item))
+			{
+				atomic_decrement32(&queue->pending);
+				worker_execute_item(queue, item, queue->threads);
+			}
+		}
+	}
+
+	// wake up sleeping threads to do the work
+	if (queue->threads > 0)
+	{
+		pthread_mutex_lock(&queue->wakelock);
+		if (numitems == 1)
+			pthread_cond_signal(&queue->wakecond);
+		else
+			pthread_cond_broadcast(&queue->wakecond);
+		add_to_stat(&queue->wakeups, 1);
+		pthread_mutex_unlock(&queue->wakelock);
+	}
+
+	// only return the item if it won't get released automatically
+	return (flags & WORK_ITEM_FLAG_AUTO_RELEASE) ? NULL : lastitem;
 }
 
 
@@ -90,8 +568,34 @@ osd_work_item *osd_work_item_queue(osd_work_queue *queue, osd_work_callback call
 
 int osd_work_item_wait(osd_work_item *item, osd_ticks_t timeout)
 {
-	// never anything to wait for, so do nothing
-	return TRUE;
+	osd_work_queue *queue = item->queue;
+	struct timespec deadline;
+
+	// if we're done already, just return
+	if (item->done)
+		return TRUE;
+
+	// high frequency queues are expected to finish quickly, so spin
+	if (queue->flags & WORK_QUEUE_FLAG_HIGH_FREQ)
+	{
+		osd_ticks_t stopspin = osd_ticks() + timeout;
+		while (!item->done && osd_ticks() < stopspin)
+			yield_processor();
+		return item->done;
+	}
+
+	// otherwise, block on the done condition until the item completes
+	compute_deadline(&deadline, timeout);
+	pthread_mutex_lock(&queue->donelock);
+	atomic_increment32(&queue->waiting);
+	while (!item->done)
+		if (pthread_cond_timedwait(&queue->donecond, &queue->donelock, &deadline) == ETIMEDOUT)
+			break;
+	atomic_decrement32(&queue->waiting);
+	pthread_mutex_unlock(&queue->donelock);
+
+	// return TRUE if the item actually completed
+	return item->done;
 }
 
 
@@ -111,5 +615,148 @@ void *osd_work_item_result(osd_work_item *item)
 
 void osd_work_item_release(osd_work_item *item)
 {
-	free(item);
+	osd_work_queue *queue = item->queue;
+
+	// make sure we're done first
+	osd_work_item_wait(item, 100 * osd_ticks_per_second());
+
+	// add us to the free list on our queue
+	pthread_mutex_lock(&queue->freelock);
+	item->next = queue->free;
+	queue->free = item;
+	pthread_mutex_unlock(&queue->freelock);
+}
+
+
+//============================================================
+//  effective_num_processors
+//============================================================
+
+static int effective_num_processors(void)
+{
+	char *procsoverride;
+	int numprocs = 0;
+
+	// if the OSDPROCESSORS environment variable is set, use that value if valid
+	procsoverride = getenv("OSDPROCESSORS");
+	if (procsoverride != NULL && sscanf(procsoverride, "%d", &numprocs) == 1 && numprocs > 0)
+		return numprocs;
+
+	// otherwise, fetch the info from the system
+	numprocs = sysconf(_SC_NPROCESSORS_ONLN);
+	return (numprocs > 0) ? numprocs : 1;
+}
+
+
+//============================================================
+//  worker_thread_entry
+//============================================================
+
+static void *worker_thread_entry(void *param)
+{
+	work_thread_info *thread = param;
+	osd_work_queue *queue = thread->queue;
+
+	// loop until we exit
+	for ( ;; )
+	{
+		// block waiting for work or exit
+		pthread_mutex_lock(&queue->wakelock);
+		while (!queue->exiting && queue->pending == 0)
+			pthread_cond_wait(&queue->wakecond, &queue->wakelock);
+		pthread_mutex_unlock(&queue->wakelock);
+		if (queue->exiting)
+			break;
+
+		// indicate that we are live
+		atomic_exchange32(&thread->active, TRUE);
+
+		// process work items
+		for ( ;; )
+		{
+			// process as much as we can
+			worker_thread_process(queue, thread);
+
+			// if we're a high frequency queue, spin for a while before giving up
+			if (queue->flags & WORK_QUEUE_FLAG_HIGH_FREQ)
+			{
+				osd_ticks_t stopspin = osd_ticks() + SPIN_LOOP_TIME;
+				while (queue->pending == 0 && !queue->exiting && osd_ticks() < stopspin)
+					yield_processor();
+			}
+
+			// if nothing more, release the processor
+			if (queue->pending == 0 || queue->exiting)
+				break;
+			add_to_stat(&queue->spinloops, 1);
+		}
+
+		// no longer live
+		atomic_exchange32(&thread->active, FALSE);
+	}
+	return NULL;
+}
+
+
+//============================================================
+//  worker_thread_process
+//============================================================
+
+static void worker_thread_process(osd_work_queue *queue, work_thread_info *thread)
+{
+	int threadid = thread - queue->thread;
+
+	// loop until there is nothing left for us to claim
+	while (queue->pending != 0)
+	{
+		osd_work_item *item;
+
+		// take from our own deque first
+		item = deque_pop(&thread->deque);
+
+		// if empty, try to steal from the other threads, starting with our neighbor
+		if (item == NULL)
+		{
+			int victim;
+			for (victim = 1; victim <= queue->threads && item == NULL; victim++)
+				item = deque_steal(&queue->thread[(threadid + victim) % (queue->threads + 1)].deque);
+			if (item == NULL)
+			{
+				yield_processor();
+				continue;
+			}
+			add_to_stat(&thread->itemsstolen, 1);
+		}
+		atomic_decrement32(&queue->pending);
+
+		// do the work
+		worker_execute_item(queue, item, threadid);
+	}
+}
+
+
+//============================================================
+//  worker_execute_item
+//============================================================
+
+static void worker_execute_item(osd_work_queue *queue, osd_work_item *item, int threadid)
+{
+	UINT32 flags = item->flags;
+
+	// call the callback and stash the result
+	item->result = (*item->callback)(item->param, threadid);
+	add_to_stat(&queue->thread[threadid].itemsdone, 1);
+
+	// if it's an auto-release item, release it; nobody may touch it afterwards
+	atomic_exchange32(&item->done, TRUE);
+	if (flags & WORK_ITEM_FLAG_AUTO_RELEASE)
+		osd_work_item_release(item);
+
+	// decrement the item count after we are done, and wake any waiters
+	if ((atomic_decrement32(&queue->items) == 0 || !(flags & WORK_ITEM_FLAG_AUTO_RELEASE)) && queue->waiting)
+	{
+		pthread_mutex_lock(&queue->donelock);
+		pthread_cond_broadcast(&queue->donecond);
+		pthread_mutex_unlock(&queue->donelock);
+	}
 }
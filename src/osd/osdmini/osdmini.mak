@@ -21,3 +21,9 @@ OSDCOREOBJS = \
 	$(OBJ)/$(MAMEOS)/minisync.o \
 	$(OBJ)/$(MAMEOS)/minitime.o \
 	$(OBJ)/$(MAMEOS)/miniwork.o \
+
+# the work queue and lock implementations are built on pthreads
+LIBS += -lpthread
+
+# clock_gettime lives in librt on older C libraries
+LIBS += -lrt
@@ -231,8 +231,8 @@ OSDOBJS = \
 	$(WINOBJ)/winmain.o
 
 # extra dependencies
-$(WINOBJ)/drawdd.o : 	$(SRC)/emu/rendersw.c
-$(WINOBJ)/drawgdi.o :	$(SRC)/emu/rendersw.c
+$(WINOBJ)/drawdd.o : 	$(SRC)/emu/rendersw.c $(SRC)/emu/rendsimd.h
+$(WINOBJ)/drawgdi.o :	$(SRC)/emu/rendersw.c $(SRC)/emu/rendsimd.h
 
 # add debug-specific files
 ifdef DEBUG
@@ -209,6 +209,58 @@ file_error osd_close(osd_file *file)
 }
 
 
+//============================================================
+//  osd_map_readonly
+//============================================================
+
+file_error osd_map_readonly(osd_file *file, UINT64 offset, UINT64 length, const void **base)
+{
+	SYSTEM_INFO sysinfo;
+	UINT64 delta, start;
+	HANDLE mapping;
+	void *view;
+
+	// empty views can't be mapped, nor can views too large for our address space
+	if (length == 0)
+		return FILERR_INVALID_ACCESS;
+	GetSystemInfo(&sysinfo);
+	delta = offset % sysinfo.dwAllocationGranularity;
+	start = offset - delta;
+	if ((SIZE_T)(length + delta) != length + delta)
+		return FILERR_OUT_OF_MEMORY;
+
+	// create a mapping object; the view keeps it alive after we close the handle
+	mapping = CreateFileMapping(file->handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+		return win_error_to_file_error(GetLastError());
+
+	// views must start on an allocation granularity boundary
+	view = MapViewOfFile(mapping, FILE_MAP_READ, (DWORD)(start >> 32), (DWORD)start, (SIZE_T)(length + delta));
+	CloseHandle(mapping);
+	if (view == NULL)
+		return win_error_to_file_error(GetLastError());
+
+	*base = (const UINT8 *)view + delta;
+	return FILERR_NONE;
+}
+
+
+//============================================================
+//  osd_unmap
+//============================================================
+
+file_error osd_unmap(const void *base, UINT64 length)
+{
+	SYSTEM_INFO sysinfo;
+
+	// views start on an allocation granularity boundary, so round back down to it
+	GetSystemInfo(&sysinfo);
+	if (!UnmapViewOfFile((const UINT8 *)base - ((UINT_PTR)base % sysinfo.dwAllocationGranularity)))
+		return win_error_to_file_error(GetLastError());
+	return FILERR_NONE;
+}
+
+
 //============================================================
 //  osd_rmfile
 //============================================================
@@ -225,6 +225,16 @@ INLINE void scalable_lock_release(scalable_lock *lock, INT32 myslot)
 
 
 
+//============================================================
+//  osd_get_num_processors
+//============================================================
+
+int osd_get_num_processors(void)
+{
+	return effective_num_processors();
+}
+
+
 //============================================================
 //  osd_work_queue_alloc
 //============================================================
@@ -2611,6 +2611,7 @@ int CLIB_DECL main(int argc, char **argv)
 		{ "-setchs",		do_setchs, 0 }
 	};
 	extern char build_version[];
+	int numprocs;
 	int i;
 
 	/* print the header */
@@ -2620,6 +2621,10 @@ int CLIB_DECL main(int argc, char **argv)
 	if (argc < 2)
 		return usage();
 
+	/* on multi-core machines, keep two hunks in flight per processor so no thread waits on the writer */
+	numprocs = osd_get_num_processors();
+	chd_set_compress_workers((numprocs < 2) ? 1 : numprocs * 2);
+
 	/* handle the appropriate command */
 	for (i = 0; i < ARRAY_LENGTH(option_list); i++)
 		if (strcmp(argv[1], option_list[i].option) == 0)
@@ -0,0 +1,249 @@
+/***************************************************************************
+
+    rendbench.c
+
+    Timing harness for the software rasterizer's SIMD span kernels.
+
+    Copyright (c) 1996-2007, Nicola Salmoria and the MAME Team.
+    Visit http://mamedev.org for licensing and usage restrictions.
+
+****************************************************************************
+
+    Each case draws a full-screen quad to a 32bpp xRGB buffer twice:
+    once through the C span operations, which define the exact results,
+    and once through the vector operations the rasterizer picks for the
+    running CPU. The outputs are compared bit for bit, and then each
+    path is timed over a number of frames.
+
+***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "osdcore.h"
+#include "mamecore.h"
+#include "render.h"
+#include "rendsimd.h"
+
+
+#ifdef RENDSIMD_AVAILABLE
+
+/***************************************************************************
+    CONSTANTS & DEFINES
+***************************************************************************/
+
+#define DEST_WIDTH				640
+#define DEST_HEIGHT				480
+#define TEX_WIDTH				1024
+#define TEX_HEIGHT				512
+
+#define DEFAULT_FRAMES			200
+
+
+
+/***************************************************************************
+    TYPE DEFINITIONS
+***************************************************************************/
+
+typedef struct _bench_case bench_case;
+struct _bench_case
+{
+	const char *	name;					/* description of the case */
+	int				fetch;					/* RENDSIMD_FETCH_* texel type */
+	int				blend;					/* RENDSIMD_BLEND_* mode */
+	float			r, g, b, a;				/* primitive color */
+	float			scale;					/* texels per destination pixel */
+};
+
+
+
+/***************************************************************************
+    GLOBAL VARIABLES
+***************************************************************************/
+
+static const bench_case case_list[] =
+{
+	{ "rgb32 copy 1:1",			RENDSIMD_FETCH_RGB32,		RENDSIMD_BLEND_NONE,		1.0f,  1.0f,  1.0f,  1.0f, 1.0f },
+	{ "rgb32 copy scaled",		RENDSIMD_FETCH_RGB32,		RENDSIMD_BLEND_NONE,		1.0f,  1.0f,  1.0f,  1.0f, 0.75f },
+	{ "rgb32 colored",			RENDSIMD_FETCH_RGB32,		RENDSIMD_BLEND_NONE,		0.75f, 0.5f,  0.25f, 1.0f, 0.75f },
+	{ "rgb32 constant alpha",	RENDSIMD_FETCH_RGB32,		RENDSIMD_BLEND_NONE,		1.0f,  0.8f,  0.6f,  0.5f, 0.75f },
+	{ "rgb32 overbright alpha",	RENDSIMD_FETCH_RGB32,		RENDSIMD_BLEND_NONE,		2.0f,  1.5f,  1.0f,  0.5f, 0.75f },
+	{ "argb32 alpha",			RENDSIMD_FETCH_RGB32,		RENDSIMD_BLEND_ALPHA,		1.0f,  1.0f,  1.0f,  1.0f, 0.75f },
+	{ "rgb32 multiply",			RENDSIMD_FETCH_RGB32,		RENDSIMD_BLEND_MULTIPLY,	1.0f,  1.0f,  1.0f,  1.0f, 0.75f },
+	{ "argb32 add",				RENDSIMD_FETCH_RGB32,		RENDSIMD_BLEND_ADD_ALPHA,	1.0f,  1.0f,  1.0f,  1.0f, 0.75f },
+	{ "rgb32 add",				RENDSIMD_FETCH_RGB32,		RENDSIMD_BLEND_ADD,			1.0f,  1.0f,  1.0f,  1.0f, 0.75f },
+	{ "palette16 copy",			RENDSIMD_FETCH_PALETTE16,	RENDSIMD_BLEND_NONE,		1.0f,  1.0f,  1.0f,  1.0f, 0.75f },
+	{ "palette16 add",			RENDSIMD_FETCH_PALETTE16,	RENDSIMD_BLEND_ADD,			1.0f,  1.0f,  1.0f,  1.0f, 0.75f }
+};
+
+/* the C span operations that the vector versions must match */
+static const rendsimd_ops c_ops =
+{
+	rendsimd_fetch_rgb32_c,
+	rendsimd_modulate_c,
+	rendsimd_blend_const_c,
+	rendsimd_blend_alpha_c,
+	rendsimd_multiply_c,
+	rendsimd_add_alpha_c,
+	rendsimd_add_c
+};
+
+static UINT32 random_seed = 0x12345678;
+
+
+
+/***************************************************************************
+    IMPLEMENTATION
+***************************************************************************/
+
+/*-------------------------------------------------
+    random_value - return a repeatable
+    pseudo-random 32-bit value
+-------------------------------------------------*/
+
+static UINT32 random_value(void)
+{
+	random_seed = random_seed * 1664525 + 1013904223;
+	return random_seed;
+}
+
+
+/*-------------------------------------------------
+    draw_case - draw one case with the given ops,
+    or with the rasterizer's choice if NULL
+-------------------------------------------------*/
+
+static int draw_case(const rendsimd_ops *ops, const bench_case *bc, const render_primitive *prim, UINT32 *dest)
+{
+	INT32 step = (INT32)(bc->scale * 65536.0f);
+
+	if (ops == NULL)
+		return rendsimd_draw_quad(prim, dest, DEST_WIDTH, 0, 0, DEST_WIDTH, DEST_HEIGHT, 0, 0, step, 0, 0, step, bc->fetch, bc->blend);
+	return rendsimd_draw_quad_ops(ops, prim, dest, DEST_WIDTH, 0, 0, DEST_WIDTH, DEST_HEIGHT, 0, 0, step, 0, 0, step, bc->fetch, bc->blend);
+}
+
+
+/*-------------------------------------------------
+    time_case - return the number of ticks taken
+    to draw a case the given number of times
+-------------------------------------------------*/
+
+static osd_ticks_t time_case(const rendsimd_ops *ops, const bench_case *bc, const render_primitive *prim, UINT32 *dest, int frames)
+{
+	osd_ticks_t start = osd_ticks();
+	int frame;
+
+	/* blending over the previous frame's result costs the same as over the background */
+	for (frame = 0; frame < frames; frame++)
+		draw_case(ops, bc, prim, dest);
+	return osd_ticks() - start;
+}
+
+
+/*-------------------------------------------------
+    main - main entry point
+-------------------------------------------------*/
+
+int CLIB_DECL main(int argc, char *argv[])
+{
+	UINT32 *rgbtex, *background, *refdest, *simddest;
+	UINT16 *paltex;
+	rgb_t *palette;
+	osd_ticks_t tps = osd_ticks_per_second();
+	int frames = DEFAULT_FRAMES;
+	int failures = 0;
+	int casenum, i;
+
+	/* parse the optional frame count */
+	if (argc > 2 || (argc == 2 && (frames = atoi(argv[1])) <= 0))
+	{
+		fprintf(stderr, "Usage:\n  rendbench [frames]\n");
+		return 1;
+	}
+
+	/* allocate and fill the textures and the background */
+	rgbtex = malloc(TEX_WIDTH * TEX_HEIGHT * sizeof(*rgbtex));
+	paltex = malloc(TEX_WIDTH * TEX_HEIGHT * sizeof(*paltex));
+	palette = malloc(65536 * sizeof(*palette));
+	background = malloc(DEST_WIDTH * DEST_HEIGHT * sizeof(*background));
+	refdest = malloc(DEST_WIDTH * DEST_HEIGHT * sizeof(*refdest));
+	simddest = malloc(DEST_WIDTH * DEST_HEIGHT * sizeof(*simddest));
+	if (rgbtex == NULL || paltex == NULL || palette == NULL || background == NULL || refdest == NULL || simddest == NULL)
+	{
+		fprintf(stderr, "Out of memory!\n");
+		return 1;
+	}
+	for (i = 0; i < TEX_WIDTH * TEX_HEIGHT; i++)
+	{
+		rgbtex[i] = random_value();
+		paltex[i] = random_value();
+	}
+	for (i = 0; i < 65536; i++)
+		palette[i] = random_value() & 0xffffff;
+	for (i = 0; i < DEST_WIDTH * DEST_HEIGHT; i++)
+		background[i] = random_value() & 0xffffff;
+
+	printf("%-24s %12s %12s %8s\n", "case", "C ms/frame", "SIMD ms/frame", "speedup");
+	for (casenum = 0; casenum < ARRAY_LENGTH(case_list); casenum++)
+	{
+		const bench_case *bc = &case_list[casenum];
+		osd_ticks_t cticks, simdticks;
+		render_primitive prim;
+
+		/* set up the primitive */
+		memset(&prim, 0, sizeof(prim));
+		prim.color.r = bc->r;
+		prim.color.g = bc->g;
+		prim.color.b = bc->b;
+		prim.color.a = bc->a;
+		prim.texture.base = (bc->fetch == RENDSIMD_FETCH_RGB32) ? (void *)rgbtex : (void *)paltex;
+		prim.texture.rowpixels = TEX_WIDTH;
+		prim.texture.width = TEX_WIDTH;
+		prim.texture.height = TEX_HEIGHT;
+		prim.texture.palette = palette;
+
+		/* make sure both paths handle the case and agree when drawn over the same background */
+		memcpy(refdest, background, DEST_WIDTH * DEST_HEIGHT * sizeof(*refdest));
+		memcpy(simddest, background, DEST_WIDTH * DEST_HEIGHT * sizeof(*simddest));
+		if (!draw_case(&c_ops, bc, &prim, refdest) || !draw_case(NULL, bc, &prim, simddest))
+		{
+			printf("%-24s not handled by the span kernels\n", bc->name);
+			continue;
+		}
+		if (memcmp(refdest, simddest, DEST_WIDTH * DEST_HEIGHT * sizeof(*refdest)) != 0)
+		{
+			printf("%-24s MISMATCH\n", bc->name);
+			failures++;
+			continue;
+		}
+
+		/* time each path */
+		cticks = time_case(&c_ops, bc, &prim, refdest, frames);
+		simdticks = time_case(NULL, bc, &prim, simddest, frames);
+		printf("%-24s %12.3f %12.3f %7.2fx\n", bc->name,
+				1000.0 * (double)cticks / (double)tps / frames, 1000.0 * (double)simdticks / (double)tps / frames,
+				(simdticks > 0) ? (double)cticks / (double)simdticks : 0.0);
+	}
+
+	free(rgbtex);
+	free(paltex);
+	free(palette);
+	free(background);
+	free(refdest);
+	free(simddest);
+	return (failures == 0) ? 0 : 1;
+}
+
+#else
+
+/*-------------------------------------------------
+    main - main entry point
+-------------------------------------------------*/
+
+int CLIB_DECL main(int argc, char *argv[])
+{
+	printf("The SIMD span kernels are not available in this build.\n");
+	return 0;
+}
+
+#endif
@@ -30,6 +30,7 @@ TOOLS += \
 	regrep$(EXE) \
 	srcclean$(EXE) \
 	src2html$(EXE) \
+	rendbench$(EXE) \
 
 
 
@@ -122,3 +123,16 @@ SRC2HTMLOBJS = \
 src2html$(EXE): $(SRC2HTMLOBJS) $(LIBUTIL) $(LIBOCORE) $(ZLIB) $(EXPAT)
 	@echo Linking $@...
 	$(LD) $(LDFLAGS) $^ $(LIBS) -o $@
+
+
+
+#-------------------------------------------------
+# rendbench
+#-------------------------------------------------
+
+RENDBENCHOBJS = \
+	$(TOOLSOBJ)/rendbench.o \
+
+rendbench$(EXE): $(RENDBENCHOBJS) $(LIBOCORE)
+	@echo Linking $@...
+	$(LD) $(LDFLAGS) $^ $(LIBS) -o $@